@@ -25,6 +25,10 @@
 
 #include <math.h>
 
+#ifdef HAVE_X86_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
 /**
  * SECTION:cairo_interaction
  * @Short_description: Functions to support using cairo
@@ -175,25 +179,222 @@ gdk_cairo_region (cairo_t         *cr,
     }
 }
 
-/**
- * gdk_cairo_set_source_pixbuf:
- * @cr: a cairo context
- * @pixbuf: a #GdkPixbuf
- * @pixbuf_x: X coordinate of location to place upper left corner of @pixbuf
- * @pixbuf_y: Y coordinate of location to place upper left corner of @pixbuf
- *
- * Sets the given pixbuf as the source pattern for @cr.
- *
- * The pattern has an extend mode of %CAIRO_EXTEND_NONE and is aligned
- * so that the origin of @pixbuf is @pixbuf_x, @pixbuf_y.
- *
- * Since: 2.8
+typedef void (* ConvertRowFunc) (guint32      *dest,
+                                 const guchar *src,
+                                 int           width);
+
+/* Cairo pixels are native endian 32 bit words, so assemble each
+ * pixel in a register and store it with a single write.
  */
-void
-gdk_cairo_set_source_pixbuf (cairo_t         *cr,
-                             const GdkPixbuf *pixbuf,
-                             gdouble          pixbuf_x,
-                             gdouble          pixbuf_y)
+static void
+convert_rgb_row (guint32      *dest,
+                 const guchar *src,
+                 int           width)
+{
+  int i;
+
+  for (i = 0; i < width; i++, src += 3)
+    dest[i] = (src[0] << 16) | (src[1] << 8) | src[2];
+}
+
+#define MULT(d,c,a,t) G_STMT_START { t = c * a + 0x7f; d = ((t >> 8) + t) >> 8; } G_STMT_END
+
+static void
+convert_rgba_row (guint32      *dest,
+                  const guchar *src,
+                  int           width)
+{
+  guint t1,t2,t3;
+  int i;
+
+  for (i = 0; i < width; i++, src += 4)
+    {
+      guint alpha = src[3];
+
+      /* Most pixels of icons are either fully opaque or fully
+       * transparent, MULT() is the identity or zero for those.
+       */
+      if (alpha == 0xff)
+        dest[i] = 0xff000000 | (src[0] << 16) | (src[1] << 8) | src[2];
+      else if (alpha == 0)
+        dest[i] = 0;
+      else
+        {
+          guint r, g, b;
+
+          MULT(r, src[0], alpha, t1);
+          MULT(g, src[1], alpha, t2);
+          MULT(b, src[2], alpha, t3);
+
+          dest[i] = (alpha << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+}
+
+#undef MULT
+
+#ifdef HAVE_X86_CPU_DISPATCH
+
+/* The vector versions compute MULT() on 16 bit lanes, which gives
+ * the same results as the scalar code for every input, so they can
+ * be used interchangeably.
+ */
+
+/* Reorders RGB to BGR, so the pixel reads as a native endian word */
+__attribute__((target("ssse3"))) static void
+convert_rgb_row_ssse3 (guint32      *dest,
+                       const guchar *src,
+                       int           width)
+{
+  const __m128i order = _mm_setr_epi8 (2, 1, 0, -1, 5, 4, 3, -1,
+                                       8, 7, 6, -1, 11, 10, 9, -1);
+  int i;
+
+  /* Each load reads 16 bytes to convert 4 pixels, stop early
+   * enough not to read past the end of the row.
+   */
+  for (i = 0; i + 6 <= width; i += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (src + 3 * i));
+
+      _mm_storeu_si128 ((__m128i *) (dest + i), _mm_shuffle_epi8 (v, order));
+    }
+
+  convert_rgb_row (dest + i, src + 3 * i, width - i);
+}
+
+/* Premultiplies two RGBA pixels held in 16 bit lanes,
+ * and reorders them to BGRA.
+ */
+__attribute__((target("sse2"))) static inline __m128i
+premultiply_sse2 (__m128i c)
+{
+  const __m128i alpha_lanes = _mm_set_epi16 (-1, 0, 0, 0, -1, 0, 0, 0);
+  __m128i a, t;
+
+  a = _mm_shufflelo_epi16 (c, _MM_SHUFFLE (3, 3, 3, 3));
+  a = _mm_shufflehi_epi16 (a, _MM_SHUFFLE (3, 3, 3, 3));
+
+  t = _mm_add_epi16 (_mm_mullo_epi16 (c, a), _mm_set1_epi16 (0x7f));
+  t = _mm_srli_epi16 (_mm_add_epi16 (_mm_srli_epi16 (t, 8), t), 8);
+  t = _mm_or_si128 (_mm_andnot_si128 (alpha_lanes, t),
+                    _mm_and_si128 (alpha_lanes, c));
+
+  t = _mm_shufflelo_epi16 (t, _MM_SHUFFLE (3, 0, 1, 2));
+  return _mm_shufflehi_epi16 (t, _MM_SHUFFLE (3, 0, 1, 2));
+}
+
+__attribute__((target("sse2"))) static void
+convert_rgba_row_sse2 (guint32      *dest,
+                       const guchar *src,
+                       int           width)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  int i;
+
+  for (i = 0; i + 4 <= width; i += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (src + 4 * i));
+      __m128i lo = premultiply_sse2 (_mm_unpacklo_epi8 (v, zero));
+      __m128i hi = premultiply_sse2 (_mm_unpackhi_epi8 (v, zero));
+
+      _mm_storeu_si128 ((__m128i *) (dest + i), _mm_packus_epi16 (lo, hi));
+    }
+
+  convert_rgba_row (dest + i, src + 4 * i, width - i);
+}
+
+/* Same as premultiply_sse2(), on each 128 bit half */
+__attribute__((target("avx2"))) static inline __m256i
+premultiply_avx2 (__m256i c)
+{
+  const __m256i alpha_lanes = _mm256_set_epi16 (-1, 0, 0, 0, -1, 0, 0, 0,
+                                                -1, 0, 0, 0, -1, 0, 0, 0);
+  __m256i a, t;
+
+  a = _mm256_shufflelo_epi16 (c, _MM_SHUFFLE (3, 3, 3, 3));
+  a = _mm256_shufflehi_epi16 (a, _MM_SHUFFLE (3, 3, 3, 3));
+
+  t = _mm256_add_epi16 (_mm256_mullo_epi16 (c, a), _mm256_set1_epi16 (0x7f));
+  t = _mm256_srli_epi16 (_mm256_add_epi16 (_mm256_srli_epi16 (t, 8), t), 8);
+  t = _mm256_or_si256 (_mm256_andnot_si256 (alpha_lanes, t),
+                       _mm256_and_si256 (alpha_lanes, c));
+
+  t = _mm256_shufflelo_epi16 (t, _MM_SHUFFLE (3, 0, 1, 2));
+  return _mm256_shufflehi_epi16 (t, _MM_SHUFFLE (3, 0, 1, 2));
+}
+
+__attribute__((target("avx2"))) static void
+convert_rgba_row_avx2 (guint32      *dest,
+                       const guchar *src,
+                       int           width)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  int i;
+
+  /* Unpacking and packing work within 128 bit halves,
+   * so the pixels come out in their original order.
+   */
+  for (i = 0; i + 8 <= width; i += 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (src + 4 * i));
+      __m256i lo = premultiply_avx2 (_mm256_unpacklo_epi8 (v, zero));
+      __m256i hi = premultiply_avx2 (_mm256_unpackhi_epi8 (v, zero));
+
+      _mm256_storeu_si256 ((__m256i *) (dest + i), _mm256_packus_epi16 (lo, hi));
+    }
+
+  convert_rgba_row_sse2 (dest + i, src + 4 * i, width - i);
+}
+
+#endif /* HAVE_X86_CPU_DISPATCH */
+
+static ConvertRowFunc
+get_convert_rgb_row (void)
+{
+  static gsize func = 0;
+
+  if (g_once_init_enter (&func))
+    {
+      ConvertRowFunc f = convert_rgb_row;
+
+#ifdef HAVE_X86_CPU_DISPATCH
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("ssse3"))
+        f = convert_rgb_row_ssse3;
+#endif
+
+      g_once_init_leave (&func, (gsize) f);
+    }
+
+  return (ConvertRowFunc) func;
+}
+
+static ConvertRowFunc
+get_convert_rgba_row (void)
+{
+  static gsize func = 0;
+
+  if (g_once_init_enter (&func))
+    {
+      ConvertRowFunc f = convert_rgba_row;
+
+#ifdef HAVE_X86_CPU_DISPATCH
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))
+        f = convert_rgba_row_avx2;
+      else if (__builtin_cpu_supports ("sse2"))
+        f = convert_rgba_row_sse2;
+#endif
+
+      g_once_init_leave (&func, (gsize) f);
+    }
+
+  return (ConvertRowFunc) func;
+}
+
+static cairo_surface_t *
+gdk_cairo_surface_create_from_pixbuf (const GdkPixbuf *pixbuf)
 {
   gint width = gdk_pixbuf_get_width (pixbuf);
   gint height = gdk_pixbuf_get_height (pixbuf);
@@ -204,13 +405,20 @@ gdk_cairo_set_source_pixbuf (cairo_t         *cr,
   guchar *cairo_pixels;
   cairo_format_t format;
   cairo_surface_t *surface;
+  ConvertRowFunc convert_row;
   static const cairo_user_data_key_t key;
   int j;
 
   if (n_channels == 3)
-    format = CAIRO_FORMAT_RGB24;
+    {
+      format = CAIRO_FORMAT_RGB24;
+      convert_row = get_convert_rgb_row ();
+    }
   else
-    format = CAIRO_FORMAT_ARGB32;
+    {
+      format = CAIRO_FORMAT_ARGB32;
+      convert_row = get_convert_rgba_row ();
+    }
 
   cairo_stride = cairo_format_stride_for_width (format, width);
   cairo_pixels = g_malloc (height * cairo_stride);
@@ -223,62 +431,84 @@ gdk_cairo_set_source_pixbuf (cairo_t         *cr,
 
   for (j = height; j; j--)
     {
-      guchar *p = gdk_pixels;
-      guchar *q = cairo_pixels;
+      convert_row ((guint32 *) cairo_pixels, gdk_pixels, width);
 
-      if (n_channels == 3)
-        {
-          guchar *end = p + 3 * width;
+      gdk_pixels += gdk_rowstride;
+      cairo_pixels += cairo_stride;
+    }
 
-          while (p < end)
-            {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-              q[0] = p[2];
-              q[1] = p[1];
-              q[2] = p[0];
-#else
-              q[1] = p[0];
-              q[2] = p[1];
-              q[3] = p[2];
-#endif
-              p += 3;
-              q += 4;
-            }
-        }
-      else
-        {
-          guchar *end = p + 4 * width;
-          guint t1,t2,t3;
+  return surface;
+}
 
-#define MULT(d,c,a,t) G_STMT_START { t = c * a + 0x7f; d = ((t >> 8) + t) >> 8; } G_STMT_END
+/**
+ * gdk_cairo_set_source_pixbuf:
+ * @cr: a cairo context
+ * @pixbuf: a #GdkPixbuf
+ * @pixbuf_x: X coordinate of location to place upper left corner of @pixbuf
+ * @pixbuf_y: Y coordinate of location to place upper left corner of @pixbuf
+ *
+ * Sets the given pixbuf as the source pattern for @cr.
+ *
+ * The pattern has an extend mode of %CAIRO_EXTEND_NONE and is aligned
+ * so that the origin of @pixbuf is @pixbuf_x, @pixbuf_y.
+ *
+ * The pixel data of @pixbuf is converted on every call. When drawing
+ * the same pixbuf repeatedly, consider using the surface returned
+ * by gdk_pixbuf_get_cairo_surface() instead.
+ *
+ * Since: 2.8
+ */
+void
+gdk_cairo_set_source_pixbuf (cairo_t         *cr,
+                             const GdkPixbuf *pixbuf,
+                             gdouble          pixbuf_x,
+                             gdouble          pixbuf_y)
+{
+  cairo_surface_t *surface;
 
-          while (p < end)
-            {
-#if G_BYTE_ORDER == G_LITTLE_ENDIAN
-              MULT(q[0], p[2], p[3], t1);
-              MULT(q[1], p[1], p[3], t2);
-              MULT(q[2], p[0], p[3], t3);
-              q[3] = p[3];
-#else
-              q[0] = p[3];
-              MULT(q[1], p[0], p[3], t1);
-              MULT(q[2], p[1], p[3], t2);
-              MULT(q[3], p[2], p[3], t3);
-#endif
+  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf);
+  cairo_set_source_surface (cr, surface, pixbuf_x, pixbuf_y);
+  cairo_surface_destroy (surface);
+}
 
-              p += 4;
-              q += 4;
-            }
+/**
+ * gdk_pixbuf_get_cairo_surface:
+ * @pixbuf: a #GdkPixbuf
+ *
+ * Returns a cairo image surface with the contents of @pixbuf, in a
+ * format suitable for use as a source, e.g. with
+ * cairo_set_source_surface().
+ *
+ * The surface is created on the first call and kept with @pixbuf
+ * until @pixbuf is finalized, so later calls return the same surface
+ * without converting the pixel data again. Because of that, the pixel
+ * data of @pixbuf must not be changed after calling this function.
+ *
+ * Returns: (transfer none): the surface for @pixbuf. It is owned by
+ *     @pixbuf and must not be modified.
+ *
+ * Since: 3.2
+ */
+cairo_surface_t *
+gdk_pixbuf_get_cairo_surface (GdkPixbuf *pixbuf)
+{
+  static GQuark quark = 0;
+  cairo_surface_t *surface;
 
-#undef MULT
-        }
+  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
 
-      gdk_pixels += gdk_rowstride;
-      cairo_pixels += cairo_stride;
+  if (G_UNLIKELY (quark == 0))
+    quark = g_quark_from_static_string ("gdk-cairo-surface");
+
+  surface = g_object_get_qdata (G_OBJECT (pixbuf), quark);
+  if (surface == NULL)
+    {
+      surface = gdk_cairo_surface_create_from_pixbuf (pixbuf);
+      g_object_set_qdata_full (G_OBJECT (pixbuf), quark, surface,
+                               (GDestroyNotify) cairo_surface_destroy);
     }
 
-  cairo_set_source_surface (cr, surface, pixbuf_x, pixbuf_y);
-  cairo_surface_destroy (surface);
+  return surface;
 }
 
 /**
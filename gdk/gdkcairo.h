@@ -43,6 +43,8 @@ void       gdk_cairo_set_source_pixbuf  (cairo_t              *cr,
                                          const GdkPixbuf      *pixbuf,
                                          gdouble               pixbuf_x,
                                          gdouble               pixbuf_y);
+cairo_surface_t *
+           gdk_pixbuf_get_cairo_surface (GdkPixbuf            *pixbuf);
 void       gdk_cairo_set_source_window  (cairo_t              *cr,
                                          GdkWindow            *window,
                                          gdouble               x,
@@ -307,6 +307,8 @@ gdk_display_get_event (GdkDisplay *display)
   g_return_val_if_fail (GDK_IS_DISPLAY (display), NULL);
 
   GDK_DISPLAY_GET_CLASS (display)->queue_events (display);
+  _gdk_event_queue_handle_motion_compression (display);
+
   return _gdk_event_unqueue (display);
 }
 
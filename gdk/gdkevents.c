@@ -250,6 +250,89 @@ _gdk_event_unqueue (GdkDisplay *display)
   return event;
 }
 
+static gboolean
+is_compressible_motion (GdkEvent *event)
+{
+  GdkEventPrivate *private = (GdkEventPrivate *) event;
+
+  return event->any.type == GDK_MOTION_NOTIFY &&
+         (private->flags & GDK_EVENT_PENDING) == 0 &&
+         event->any.window != NULL &&
+         event->any.window->event_compression;
+}
+
+/**
+ * _gdk_event_queue_tail_is_motion:
+ * @display: a #GdkDisplay
+ *
+ * Checks whether the last event in the queue is a motion event
+ * that later motion events could be compressed into. Backends use
+ * this to keep reading from the windowing system while the queue
+ * only holds compressible motion.
+ *
+ * Return value: %TRUE if the last queued event is compressible motion
+ **/
+gboolean
+_gdk_event_queue_tail_is_motion (GdkDisplay *display)
+{
+  return display->queued_tail != NULL &&
+         is_compressible_motion (display->queued_tail->data);
+}
+
+/**
+ * _gdk_event_queue_handle_motion_compression:
+ * @display: a #GdkDisplay
+ *
+ * Coalesces the run of motion events at the end of the queue that
+ * share window, device and source device into the last one. The
+ * dropped events are kept, oldest first, as the motion history of
+ * the surviving event; see gdk_event_get_motion_history().
+ **/
+void
+_gdk_event_queue_handle_motion_compression (GdkDisplay *display)
+{
+  GList *tmp_list, *prev;
+  GdkEvent *last_motion;
+  GdkEventPrivate *last_private;
+  GdkDevice *device, *source_device;
+  GList *history = NULL;
+
+  tmp_list = display->queued_tail;
+
+  if (tmp_list == NULL || !is_compressible_motion (tmp_list->data))
+    return;
+
+  last_motion = tmp_list->data;
+  last_private = (GdkEventPrivate *) last_motion;
+  device = gdk_event_get_device (last_motion);
+  source_device = gdk_event_get_source_device (last_motion);
+
+  for (tmp_list = tmp_list->prev; tmp_list; tmp_list = prev)
+    {
+      GdkEvent *event = tmp_list->data;
+      GdkEventPrivate *private = (GdkEventPrivate *) event;
+
+      prev = tmp_list->prev;
+
+      if (!is_compressible_motion (event) ||
+          event->any.window != last_motion->any.window ||
+          gdk_event_get_device (event) != device ||
+          gdk_event_get_source_device (event) != source_device)
+        break;
+
+      _gdk_event_queue_remove_link (display, tmp_list);
+      g_list_free_1 (tmp_list);
+
+      /* Events that were compressed before keep their own samples */
+      history = g_list_prepend (history, event);
+      history = g_list_concat (private->motion_history, history);
+      private->motion_history = NULL;
+    }
+
+  if (history)
+    last_private->motion_history = g_list_concat (history, last_private->motion_history);
+}
+
 /**
  * gdk_event_handler_set:
  * @func: the function to call to handle events from GDK.
@@ -520,6 +603,16 @@ gdk_event_copy (const GdkEvent *event)
       new_private->screen = private->screen;
       new_private->device = private->device;
       new_private->source_device = private->source_device;
+
+      if (private->motion_history)
+        {
+          GList *l;
+
+          for (l = private->motion_history; l; l = l->next)
+            new_private->motion_history = g_list_prepend (new_private->motion_history,
+                                                          gdk_event_copy (l->data));
+          new_private->motion_history = g_list_reverse (new_private->motion_history);
+        }
     }
 
   switch (event->any.type)
@@ -603,8 +696,13 @@ gdk_event_copy (const GdkEvent *event)
 void
 gdk_event_free (GdkEvent *event)
 {
+  GdkEventPrivate *private;
+
   g_return_if_fail (event != NULL);
 
+  private = (GdkEventPrivate *) event;
+  g_list_free_full (private->motion_history, (GDestroyNotify) gdk_event_free);
+
   if (event->any.window)
     g_object_unref (event->any.window);
   
@@ -1214,6 +1312,91 @@ gdk_event_get_source_device (const GdkEvent *event)
   return gdk_event_get_device (event);
 }
 
+/**
+ * gdk_event_get_motion_history:
+ * @event: a #GdkEvent of type %GDK_MOTION_NOTIFY
+ * @events: (array length=n_events) (out) (transfer full): location to store
+ *     a newly-allocated array of #GdkTimeCoord, or %NULL
+ * @n_events: location to store the length of @events, or %NULL
+ *
+ * Retrieves the motion events that were compressed into @event.
+ * GDK coalesces consecutive motion events for the same window and
+ * device into the most recent one; applications that need every
+ * sample, such as drawing programs, can get the dropped positions
+ * from here, oldest first. The @event itself is not included.
+ *
+ * Each #GdkTimeCoord holds the axes of the device, or the x and y
+ * coordinates of the event if it carries no axes.
+ *
+ * See gdk_window_set_event_compression() to turn compression off
+ * for a window. The returned array must be freed with
+ * gdk_device_free_history().
+ *
+ * Returns: %TRUE if @event has a motion history
+ *
+ * Since: 3.2
+ **/
+gboolean
+gdk_event_get_motion_history (const GdkEvent   *event,
+                              GdkTimeCoord   ***events,
+                              gint             *n_events)
+{
+  GdkEventPrivate *private;
+  GdkTimeCoord **coords;
+  GList *l;
+  gint n_coords, i;
+
+  g_return_val_if_fail (event != NULL, FALSE);
+
+  if (events)
+    *events = NULL;
+  if (n_events)
+    *n_events = 0;
+
+  if (event->type != GDK_MOTION_NOTIFY ||
+      !gdk_event_is_allocated (event))
+    return FALSE;
+
+  private = (GdkEventPrivate *) event;
+
+  if (!private->motion_history)
+    return FALSE;
+
+  n_coords = g_list_length (private->motion_history);
+  coords = g_new (GdkTimeCoord *, n_coords);
+
+  for (l = private->motion_history, i = 0; l; l = l->next, i++)
+    {
+      GdkEventMotion *motion = l->data;
+
+      coords[i] = g_new0 (GdkTimeCoord, 1);
+      coords[i]->time = motion->time;
+
+      if (motion->axes && motion->device)
+        {
+          gint n_axes;
+
+          n_axes = MIN (gdk_device_get_n_axes (motion->device), GDK_MAX_TIMECOORD_AXES);
+          memcpy (coords[i]->axes, motion->axes, sizeof (gdouble) * n_axes);
+        }
+      else
+        {
+          coords[i]->axes[0] = motion->x;
+          coords[i]->axes[1] = motion->y;
+        }
+    }
+
+  if (events)
+    *events = coords;
+  else
+    gdk_device_free_history (coords, n_coords);
+
+  if (n_events)
+    *n_events = n_coords;
+
+  return TRUE;
+}
+
 /**
  * gdk_event_request_motions:
  * @event: a valid #GdkEvent
@@ -1066,6 +1066,9 @@ GdkDevice* gdk_event_get_device         (const GdkEvent  *event);
 void       gdk_event_set_source_device  (GdkEvent        *event,
                                          GdkDevice       *device);
 GdkDevice* gdk_event_get_source_device  (const GdkEvent  *event);
+gboolean   gdk_event_get_motion_history (const GdkEvent  *event,
+                                         GdkTimeCoord  ***events,
+                                         gint            *n_events);
 void      gdk_event_request_motions     (const GdkEventMotion *event);
 
 gboolean  gdk_events_get_distance       (GdkEvent        *event1,
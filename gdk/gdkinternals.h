@@ -155,6 +155,7 @@ struct _GdkEventPrivate
   gpointer   windowing_data;
   GdkDevice *device;
   GdkDevice *source_device;
+  GList     *motion_history;
 };
 
 typedef struct _GdkWindowPaint GdkWindowPaint;
@@ -202,6 +203,7 @@ struct _GdkWindow
   guint focus_on_map : 1;
   guint shaped : 1;
   guint support_multidevice : 1;
+  guint event_compression : 1;
   
   GdkEventMask event_mask;
 
@@ -268,6 +270,8 @@ GList* _gdk_event_queue_append       (GdkDisplay *display,
 GList* _gdk_event_queue_insert_after (GdkDisplay *display,
                                       GdkEvent   *after_event,
                                       GdkEvent   *event);
+void   _gdk_event_queue_handle_motion_compression (GdkDisplay *display);
+gboolean _gdk_event_queue_tail_is_motion (GdkDisplay *display);
 GList* _gdk_event_queue_insert_before(GdkDisplay *display,
                                       GdkEvent   *after_event,
                                       GdkEvent   *event);
@@ -32,6 +32,12 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include <string.h>
+
+#ifdef HAVE_X86_CPU_DISPATCH
+#include <immintrin.h>
+#endif
+
 /**
  * SECTION:pixbufs
  * @Short_description: Functions for obtaining pixbufs
@@ -143,6 +149,227 @@ gdk_cairo_surface_coerce_to_image (cairo_surface_t *surface,
   return copy;
 }
 
+/* Unpremultiplying divides by alpha; (x * unpremultiply_factor[alpha]) >> 24
+ * equals x / alpha for all x <= 255 * 255 + 127, so the division can be
+ * replaced by a multiplication.
+ */
+static const guint32 *
+get_unpremultiply_factors (void)
+{
+  static guint32 factors[256];
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      guint alpha;
+
+      factors[0] = 0;
+      for (alpha = 1; alpha < 256; alpha++)
+        factors[alpha] = ((1 << 24) + alpha - 1) / alpha;
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return factors;
+}
+
+#define UNPREMULTIPLY(c,alpha,factor) ((((guint64) (c) * 255 + (alpha) / 2) * (factor)) >> 24)
+
+typedef void (* ConvertRowFunc) (guchar        *dest,
+                                 const guint32 *src,
+                                 int            width);
+
+static void
+convert_alpha_row (guchar        *dest,
+                   const guint32 *src,
+                   int            width)
+{
+  const guint32 *factors = get_unpremultiply_factors ();
+  int x;
+
+  for (x = 0; x < width; x++) {
+    guint alpha = src[x] >> 24;
+
+    if (alpha == 0)
+      {
+        dest[x * 4 + 0] = 0;
+        dest[x * 4 + 1] = 0;
+        dest[x * 4 + 2] = 0;
+      }
+    else if (alpha == 0xff)
+      {
+        dest[x * 4 + 0] = src[x] >> 16;
+        dest[x * 4 + 1] = src[x] >>  8;
+        dest[x * 4 + 2] = src[x];
+      }
+    else
+      {
+        guint32 factor = factors[alpha];
+
+        dest[x * 4 + 0] = UNPREMULTIPLY ((src[x] & 0xff0000) >> 16, alpha, factor);
+        dest[x * 4 + 1] = UNPREMULTIPLY ((src[x] & 0x00ff00) >>  8, alpha, factor);
+        dest[x * 4 + 2] = UNPREMULTIPLY ((src[x] & 0x0000ff) >>  0, alpha, factor);
+      }
+    dest[x * 4 + 3] = alpha;
+  }
+}
+
+static void
+convert_no_alpha_row (guchar        *dest,
+                      const guint32 *src,
+                      int            width)
+{
+  int x;
+
+  for (x = 0; x < width; x++) {
+    dest[x * 3 + 0] = src[x] >> 16;
+    dest[x * 3 + 1] = src[x] >>  8;
+    dest[x * 3 + 2] = src[x];
+  }
+}
+
+#ifdef HAVE_X86_CPU_DISPATCH
+
+/* Unpremultiplying needs a division per channel, which doesn't
+ * vectorize well. The vector versions copy blocks of fully opaque
+ * or fully transparent pixels, which are by far the most common,
+ * and leave the other blocks to the scalar code.
+ */
+
+__attribute__((target("sse2"))) static void
+convert_alpha_row_sse2 (guchar        *dest,
+                        const guint32 *src,
+                        int            width)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i opaque = _mm_set1_epi32 (0xff000000);
+  int x;
+
+  for (x = 0; x + 4 <= width; x += 4)
+    {
+      __m128i v = _mm_loadu_si128 ((const __m128i *) (src + x));
+      __m128i alpha = _mm_and_si128 (v, opaque);
+
+      if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (alpha, opaque)) == 0xffff)
+        {
+          /* BGRA -> RGBA, on 16 bit lanes */
+          __m128i lo = _mm_unpacklo_epi8 (v, zero);
+          __m128i hi = _mm_unpackhi_epi8 (v, zero);
+
+          lo = _mm_shufflelo_epi16 (lo, _MM_SHUFFLE (3, 0, 1, 2));
+          lo = _mm_shufflehi_epi16 (lo, _MM_SHUFFLE (3, 0, 1, 2));
+          hi = _mm_shufflelo_epi16 (hi, _MM_SHUFFLE (3, 0, 1, 2));
+          hi = _mm_shufflehi_epi16 (hi, _MM_SHUFFLE (3, 0, 1, 2));
+
+          _mm_storeu_si128 ((__m128i *) (dest + x * 4), _mm_packus_epi16 (lo, hi));
+        }
+      else if (_mm_movemask_epi8 (_mm_cmpeq_epi32 (alpha, zero)) == 0xffff)
+        _mm_storeu_si128 ((__m128i *) (dest + x * 4), zero);
+      else
+        convert_alpha_row (dest + x * 4, src + x, 4);
+    }
+
+  convert_alpha_row (dest + x * 4, src + x, width - x);
+}
+
+__attribute__((target("avx2"))) static void
+convert_alpha_row_avx2 (guchar        *dest,
+                        const guint32 *src,
+                        int            width)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i opaque = _mm256_set1_epi32 (0xff000000);
+  const __m256i order = _mm256_setr_epi8 (2, 1, 0, 3, 6, 5, 4, 7,
+                                          10, 9, 8, 11, 14, 13, 12, 15,
+                                          2, 1, 0, 3, 6, 5, 4, 7,
+                                          10, 9, 8, 11, 14, 13, 12, 15);
+  int x;
+
+  for (x = 0; x + 8 <= width; x += 8)
+    {
+      __m256i v = _mm256_loadu_si256 ((const __m256i *) (src + x));
+      __m256i alpha = _mm256_and_si256 (v, opaque);
+
+      if (_mm256_movemask_epi8 (_mm256_cmpeq_epi32 (alpha, opaque)) == -1)
+        _mm256_storeu_si256 ((__m256i *) (dest + x * 4), _mm256_shuffle_epi8 (v, order));
+      else if (_mm256_movemask_epi8 (_mm256_cmpeq_epi32 (alpha, zero)) == -1)
+        _mm256_storeu_si256 ((__m256i *) (dest + x * 4), zero);
+      else
+        convert_alpha_row_sse2 (dest + x * 4, src + x, 8);
+    }
+
+  convert_alpha_row_sse2 (dest + x * 4, src + x, width - x);
+}
+
+/* Drops the unused byte and reorders BGR to RGB, 4 pixels at a time */
+__attribute__((target("ssse3"))) static void
+convert_no_alpha_row_ssse3 (guchar        *dest,
+                            const guint32 *src,
+                            int            width)
+{
+  const __m128i order = _mm_setr_epi8 (2, 1, 0, 6, 5, 4, 10, 9,
+                                       8, 14, 13, 12, -1, -1, -1, -1);
+  int x;
+
+  for (x = 0; x + 4 <= width; x += 4)
+    {
+      __m128i v = _mm_shuffle_epi8 (_mm_loadu_si128 ((const __m128i *) (src + x)), order);
+      guint32 last = _mm_cvtsi128_si32 (_mm_srli_si128 (v, 8));
+
+      /* Only 12 bytes belong to these pixels */
+      _mm_storel_epi64 ((__m128i *) (dest + x * 3), v);
+      memcpy (dest + x * 3 + 8, &last, 4);
+    }
+
+  convert_no_alpha_row (dest + x * 3, src + x, width - x);
+}
+
+#endif /* HAVE_X86_CPU_DISPATCH */
+
+static ConvertRowFunc
+get_convert_alpha_row (void)
+{
+  static gsize func = 0;
+
+  if (g_once_init_enter (&func))
+    {
+      ConvertRowFunc f = convert_alpha_row;
+
+#ifdef HAVE_X86_CPU_DISPATCH
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("avx2"))
+        f = convert_alpha_row_avx2;
+      else if (__builtin_cpu_supports ("sse2"))
+        f = convert_alpha_row_sse2;
+#endif
+
+      g_once_init_leave (&func, (gsize) f);
+    }
+
+  return (ConvertRowFunc) func;
+}
+
+static ConvertRowFunc
+get_convert_no_alpha_row (void)
+{
+  static gsize func = 0;
+
+  if (g_once_init_enter (&func))
+    {
+      ConvertRowFunc f = convert_no_alpha_row;
+
+#ifdef HAVE_X86_CPU_DISPATCH
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("ssse3"))
+        f = convert_no_alpha_row_ssse3;
+#endif
+
+      g_once_init_leave (&func, (gsize) f);
+    }
+
+  return (ConvertRowFunc) func;
+}
+
 static void
 convert_alpha (guchar *dest_data,
                int     dest_stride,
@@ -153,30 +380,13 @@ convert_alpha (guchar *dest_data,
                int     width,
                int     height)
 {
-  int x, y;
+  ConvertRowFunc convert_row = get_convert_alpha_row ();
+  int y;
 
   src_data += src_stride * src_y + src_x * 4;
 
   for (y = 0; y < height; y++) {
-    guint32 *src = (guint32 *) src_data;
-
-    for (x = 0; x < width; x++) {
-      guint alpha = src[x] >> 24;
-
-      if (alpha == 0)
-        {
-          dest_data[x * 4 + 0] = 0;
-          dest_data[x * 4 + 1] = 0;
-          dest_data[x * 4 + 2] = 0;
-        }
-      else
-        {
-          dest_data[x * 4 + 0] = (((src[x] & 0xff0000) >> 16) * 255 + alpha / 2) / alpha;
-          dest_data[x * 4 + 1] = (((src[x] & 0x00ff00) >>  8) * 255 + alpha / 2) / alpha;
-          dest_data[x * 4 + 2] = (((src[x] & 0x0000ff) >>  0) * 255 + alpha / 2) / alpha;
-        }
-      dest_data[x * 4 + 3] = alpha;
-    }
+    convert_row (dest_data, (guint32 *) src_data, width);
 
     src_data += src_stride;
     dest_data += dest_stride;
@@ -193,18 +403,13 @@ convert_no_alpha (guchar *dest_data,
                   int     width,
                   int     height)
 {
-  int x, y;
+  ConvertRowFunc convert_row = get_convert_no_alpha_row ();
+  int y;
 
   src_data += src_stride * src_y + src_x * 4;
 
   for (y = 0; y < height; y++) {
-    guint32 *src = (guint32 *) src_data;
-
-    for (x = 0; x < width; x++) {
-      dest_data[x * 3 + 0] = src[x] >> 16;
-      dest_data[x * 3 + 1] = src[x] >>  8;
-      dest_data[x * 3 + 2] = src[x];
-    }
+    convert_row (dest_data, (guint32 *) src_data, width);
 
     src_data += src_stride;
     dest_data += dest_stride;
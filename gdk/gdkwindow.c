@@ -313,6 +313,7 @@ gdk_window_init (GdkWindow *window)
   window->visibility = GDK_VISIBILITY_FULLY_OBSCURED;
   /* Default to unobscured since some backends don't send visibility events */
   window->native_visibility = GDK_VISIBILITY_UNOBSCURED;
+  window->event_compression = TRUE;
 }
 
 /* Stop and return on the first non-NULL parent */
@@ -8052,6 +8053,50 @@ gdk_window_get_support_multidevice (GdkWindow *window)
   return window->support_multidevice;
 }
 
+/**
+ * gdk_window_set_event_compression:
+ * @window: a #GdkWindow
+ * @event_compression: %TRUE if motion events should be compressed
+ *
+ * Determines whether or not extra unprocessed motion events in
+ * the event queue can be discarded. If %TRUE only the most recent
+ * event will be delivered, and the positions it replaced are
+ * available from gdk_event_get_motion_history().
+ *
+ * Some types of applications, e.g. paint programs, need to see all
+ * motion events and will want to turn event compression off.
+ *
+ * Event compression is enabled by default.
+ *
+ * Since: 3.2
+ **/
+void
+gdk_window_set_event_compression (GdkWindow *window,
+                                  gboolean   event_compression)
+{
+  g_return_if_fail (GDK_IS_WINDOW (window));
+
+  window->event_compression = !!event_compression;
+}
+
+/**
+ * gdk_window_get_event_compression:
+ * @window: a #GdkWindow
+ *
+ * Get the current event compression setting for this window.
+ *
+ * Returns: %TRUE if motion events will be compressed
+ *
+ * Since: 3.2
+ **/
+gboolean
+gdk_window_get_event_compression (GdkWindow *window)
+{
+  g_return_val_if_fail (GDK_IS_WINDOW (window), TRUE);
+
+  return window->event_compression;
+}
+
 static const guint type_masks[] = {
   GDK_SUBSTRUCTURE_MASK, /* GDK_DELETE                 = 0  */
   GDK_STRUCTURE_MASK, /* GDK_DESTROY                   = 1  */
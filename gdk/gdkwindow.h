@@ -862,6 +862,10 @@ void       gdk_window_set_support_multidevice (GdkWindow *window,
                                                gboolean   support_multidevice);
 gboolean   gdk_window_get_support_multidevice (GdkWindow *window);
 
+void       gdk_window_set_event_compression   (GdkWindow *window,
+                                               gboolean   event_compression);
+gboolean   gdk_window_get_event_compression   (GdkWindow *window);
+
 G_END_DECLS
 
 #endif /* __GDK_WINDOW_H__ */
@@ -0,0 +1,198 @@
+#include <gdk/gdk.h>
+
+static GdkWindow *
+create_window (void)
+{
+  GdkWindowAttr attributes;
+
+  attributes.window_type = GDK_WINDOW_TOPLEVEL;
+  attributes.wclass = GDK_INPUT_OUTPUT;
+  attributes.x = 0;
+  attributes.y = 0;
+  attributes.width = 100;
+  attributes.height = 100;
+  attributes.event_mask = GDK_POINTER_MOTION_MASK;
+
+  return gdk_window_new (NULL, &attributes, GDK_WA_X | GDK_WA_Y);
+}
+
+static void
+put_motion (GdkWindow *window,
+            GdkDevice *device,
+            guint32    time,
+            gdouble    x,
+            gdouble    y)
+{
+  GdkEvent *event;
+
+  event = gdk_event_new (GDK_MOTION_NOTIFY);
+  event->motion.window = g_object_ref (window);
+  event->motion.time = time;
+  event->motion.x = x;
+  event->motion.y = y;
+  event->motion.device = device;
+  gdk_event_set_device (event, device);
+
+  gdk_display_put_event (gdk_window_get_display (window), event);
+  gdk_event_free (event);
+}
+
+static void
+put_button (GdkWindow *window,
+            GdkDevice *device,
+            guint32    time)
+{
+  GdkEvent *event;
+
+  event = gdk_event_new (GDK_BUTTON_PRESS);
+  event->button.window = g_object_ref (window);
+  event->button.time = time;
+  event->button.button = 1;
+  event->button.device = device;
+  gdk_event_set_device (event, device);
+
+  gdk_display_put_event (gdk_window_get_display (window), event);
+  gdk_event_free (event);
+}
+
+static GdkDevice *
+get_pointer (void)
+{
+  GdkDeviceManager *manager;
+
+  manager = gdk_display_get_device_manager (gdk_display_get_default ());
+
+  return gdk_device_manager_get_client_pointer (manager);
+}
+
+static void
+test_compress (void)
+{
+  GdkDisplay *display;
+  GdkDevice *device;
+  GdkWindow *window;
+  GdkEvent *event;
+  GdkTimeCoord **coords;
+  gint n_coords;
+
+  display = gdk_display_get_default ();
+  device = get_pointer ();
+  window = create_window ();
+
+  put_motion (window, device, 1, 1, 10);
+  put_button (window, device, 2);
+  put_motion (window, device, 3, 2, 20);
+  put_motion (window, device, 4, 3, 30);
+  put_motion (window, device, 5, 4, 40);
+
+  /* The motion before the button press can't be merged */
+  event = gdk_display_get_event (display);
+  g_assert_cmpint (event->type, ==, GDK_MOTION_NOTIFY);
+  g_assert_cmpuint (event->motion.time, ==, 1);
+  g_assert (!gdk_event_get_motion_history (event, &coords, &n_coords));
+  g_assert (coords == NULL);
+  g_assert_cmpint (n_coords, ==, 0);
+  gdk_event_free (event);
+
+  event = gdk_display_get_event (display);
+  g_assert_cmpint (event->type, ==, GDK_BUTTON_PRESS);
+  gdk_event_free (event);
+
+  event = gdk_display_get_event (display);
+  g_assert_cmpint (event->type, ==, GDK_MOTION_NOTIFY);
+  g_assert_cmpuint (event->motion.time, ==, 5);
+  g_assert_cmpfloat (event->motion.x, ==, 4);
+
+  g_assert (gdk_event_get_motion_history (event, &coords, &n_coords));
+  g_assert_cmpint (n_coords, ==, 2);
+  g_assert_cmpuint (coords[0]->time, ==, 3);
+  g_assert_cmpfloat (coords[0]->axes[0], ==, 2);
+  g_assert_cmpfloat (coords[0]->axes[1], ==, 20);
+  g_assert_cmpuint (coords[1]->time, ==, 4);
+  g_assert_cmpfloat (coords[1]->axes[0], ==, 3);
+  g_assert_cmpfloat (coords[1]->axes[1], ==, 30);
+  gdk_device_free_history (coords, n_coords);
+
+  gdk_event_free (event);
+
+  g_assert (gdk_display_peek_event (display) == NULL);
+
+  gdk_window_destroy (window);
+}
+
+static void
+test_history_copy (void)
+{
+  GdkDisplay *display;
+  GdkDevice *device;
+  GdkWindow *window;
+  GdkEvent *event, *copy;
+  GdkTimeCoord **coords;
+  gint n_coords;
+
+  display = gdk_display_get_default ();
+  device = get_pointer ();
+  window = create_window ();
+
+  put_motion (window, device, 1, 1, 10);
+  put_motion (window, device, 2, 2, 20);
+
+  event = gdk_display_get_event (display);
+  copy = gdk_event_copy (event);
+  gdk_event_free (event);
+
+  g_assert (gdk_event_get_motion_history (copy, &coords, &n_coords));
+  g_assert_cmpint (n_coords, ==, 1);
+  g_assert_cmpuint (coords[0]->time, ==, 1);
+  gdk_device_free_history (coords, n_coords);
+
+  gdk_event_free (copy);
+
+  gdk_window_destroy (window);
+}
+
+static void
+test_no_compression (void)
+{
+  GdkDisplay *display;
+  GdkDevice *device;
+  GdkWindow *window;
+  GdkEvent *event;
+  gint i;
+
+  display = gdk_display_get_default ();
+  device = get_pointer ();
+  window = create_window ();
+
+  g_assert (gdk_window_get_event_compression (window));
+  gdk_window_set_event_compression (window, FALSE);
+  g_assert (!gdk_window_get_event_compression (window));
+
+  put_motion (window, device, 1, 1, 10);
+  put_motion (window, device, 2, 2, 20);
+  put_motion (window, device, 3, 3, 30);
+
+  for (i = 1; i <= 3; i++)
+    {
+      event = gdk_display_get_event (display);
+      g_assert_cmpint (event->type, ==, GDK_MOTION_NOTIFY);
+      g_assert_cmpuint (event->motion.time, ==, i);
+      g_assert (!gdk_event_get_motion_history (event, NULL, NULL));
+      gdk_event_free (event);
+    }
+
+  gdk_window_destroy (window);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  gdk_init (&argc, &argv);
+
+  g_test_add_func ("/motion-compression/compress", test_compress);
+  g_test_add_func ("/motion-compression/history-copy", test_history_copy);
+  g_test_add_func ("/motion-compression/no-compression", test_no_compression);
+
+  return g_test_run ();
+}
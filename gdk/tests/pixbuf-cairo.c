@@ -0,0 +1,401 @@
+#include <gdk/gdk.h>
+#include <string.h>
+
+/* Reference implementations of the conversions done by
+ * gdk_cairo_set_source_pixbuf() and gdk_pixbuf_get_from_surface().
+ */
+static guint
+premultiply (guint c,
+             guint alpha)
+{
+  guint t = c * alpha + 0x7f;
+
+  return ((t >> 8) + t) >> 8;
+}
+
+static guint
+unpremultiply (guint c,
+               guint alpha)
+{
+  if (alpha == 0)
+    return 0;
+
+  return (c * 255 + alpha / 2) / alpha;
+}
+
+/* A pixbuf whose pixel at (x, y) has alpha y and a mix of color
+ * values derived from x, covering all channel/alpha combinations.
+ */
+static GdkPixbuf *
+create_pixbuf (gboolean has_alpha)
+{
+  GdkPixbuf *pixbuf;
+  guchar *pixels;
+  gint rowstride, n_channels;
+  gint x, y;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, 256, 256);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+
+  for (y = 0; y < 256; y++)
+    for (x = 0; x < 256; x++)
+      {
+        guchar *p = pixels + y * rowstride + x * n_channels;
+
+        p[0] = x;
+        p[1] = 255 - x;
+        p[2] = (x * 7) & 0xff;
+        if (has_alpha)
+          p[3] = y;
+      }
+
+  return pixbuf;
+}
+
+static void
+check_set_source_pixbuf (gboolean has_alpha)
+{
+  cairo_surface_t *target, *surface;
+  GdkPixbuf *pixbuf;
+  cairo_t *cr;
+  guchar *pixels, *data;
+  gint rowstride, n_channels, stride;
+  gint x, y;
+
+  pixbuf = create_pixbuf (has_alpha);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+
+  target = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+  cr = cairo_create (target);
+  gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+
+  g_assert (cairo_pattern_get_surface (cairo_get_source (cr), &surface) == CAIRO_STATUS_SUCCESS);
+  g_assert_cmpint (cairo_image_surface_get_format (surface), ==,
+                   has_alpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24);
+
+  cairo_surface_flush (surface);
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  for (y = 0; y < 256; y++)
+    for (x = 0; x < 256; x++)
+      {
+        guchar *p = pixels + y * rowstride + x * n_channels;
+        guint32 pixel = *(guint32 *) (data + y * stride + x * 4);
+        guint alpha = has_alpha ? p[3] : 0xff;
+
+        g_assert_cmpuint ((pixel >> 16) & 0xff, ==, premultiply (p[0], alpha));
+        g_assert_cmpuint ((pixel >>  8) & 0xff, ==, premultiply (p[1], alpha));
+        g_assert_cmpuint ((pixel >>  0) & 0xff, ==, premultiply (p[2], alpha));
+        if (has_alpha)
+          g_assert_cmpuint (pixel >> 24, ==, alpha);
+      }
+
+  cairo_destroy (cr);
+  cairo_surface_destroy (target);
+  g_object_unref (pixbuf);
+}
+
+static void
+test_set_source_pixbuf_alpha (void)
+{
+  check_set_source_pixbuf (TRUE);
+}
+
+static void
+test_set_source_pixbuf_no_alpha (void)
+{
+  check_set_source_pixbuf (FALSE);
+}
+
+static void
+test_get_from_surface_alpha (void)
+{
+  cairo_surface_t *surface;
+  GdkPixbuf *pixbuf;
+  guchar *data, *pixels;
+  gint stride, rowstride;
+  guint x, alpha;
+
+  /* Every premultiplied channel value that is valid for the alpha
+   * value of the row.
+   */
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 256, 256);
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  for (alpha = 0; alpha < 256; alpha++)
+    for (x = 0; x < 256; x++)
+      {
+        guint c = MIN (x, alpha);
+
+        *(guint32 *) (data + alpha * stride + x * 4) =
+          (alpha << 24) | (c << 16) | ((alpha - c) << 8) | (c / 2);
+      }
+  cairo_surface_mark_dirty (surface);
+
+  pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0, 256, 256);
+  g_assert (gdk_pixbuf_get_has_alpha (pixbuf));
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  for (alpha = 0; alpha < 256; alpha++)
+    for (x = 0; x < 256; x++)
+      {
+        guchar *p = pixels + alpha * rowstride + x * 4;
+        guint c = MIN (x, alpha);
+
+        g_assert_cmpuint (p[0], ==, unpremultiply (c, alpha));
+        g_assert_cmpuint (p[1], ==, unpremultiply (alpha - c, alpha));
+        g_assert_cmpuint (p[2], ==, unpremultiply (c / 2, alpha));
+        g_assert_cmpuint (p[3], ==, alpha);
+      }
+
+  g_object_unref (pixbuf);
+  cairo_surface_destroy (surface);
+}
+
+static void
+test_get_from_surface_no_alpha (void)
+{
+  cairo_surface_t *surface;
+  GdkPixbuf *pixbuf;
+  guchar *data, *pixels;
+  gint stride, rowstride;
+  guint x, y;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_RGB24, 256, 16);
+  data = cairo_image_surface_get_data (surface);
+  stride = cairo_image_surface_get_stride (surface);
+
+  for (y = 0; y < 16; y++)
+    for (x = 0; x < 256; x++)
+      *(guint32 *) (data + y * stride + x * 4) = (x << 16) | ((255 - x) << 8) | (y * 16);
+  cairo_surface_mark_dirty (surface);
+
+  pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0, 256, 16);
+  g_assert (!gdk_pixbuf_get_has_alpha (pixbuf));
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+  for (y = 0; y < 16; y++)
+    for (x = 0; x < 256; x++)
+      {
+        guchar *p = pixels + y * rowstride + x * 3;
+
+        g_assert_cmpuint (p[0], ==, x);
+        g_assert_cmpuint (p[1], ==, 255 - x);
+        g_assert_cmpuint (p[2], ==, y * 16);
+      }
+
+  g_object_unref (pixbuf);
+  cairo_surface_destroy (surface);
+}
+
+static void
+surface_destroyed (gpointer data)
+{
+  *(gboolean *) data = TRUE;
+}
+
+static void
+test_get_cairo_surface (void)
+{
+  static const cairo_user_data_key_t key;
+  cairo_surface_t *surface, *reference;
+  GdkPixbuf *pixbuf;
+  cairo_t *cr;
+  gboolean destroyed;
+  guchar *data, *reference_data;
+  gint stride, y;
+
+  pixbuf = create_pixbuf (TRUE);
+
+  /* The surface is converted once, and kept with the pixbuf */
+  surface = gdk_pixbuf_get_cairo_surface (pixbuf);
+  g_assert (surface != NULL);
+  g_assert (gdk_pixbuf_get_cairo_surface (pixbuf) == surface);
+  g_assert_cmpint (cairo_surface_status (surface), ==, CAIRO_STATUS_SUCCESS);
+  g_assert_cmpint (cairo_image_surface_get_format (surface), ==, CAIRO_FORMAT_ARGB32);
+  g_assert_cmpint (cairo_image_surface_get_width (surface), ==, 256);
+  g_assert_cmpint (cairo_image_surface_get_height (surface), ==, 256);
+
+  /* It has the same contents as the source set by
+   * gdk_cairo_set_source_pixbuf()
+   */
+  cr = cairo_create (cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1));
+  gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+  cairo_pattern_get_surface (cairo_get_source (cr), &reference);
+  g_assert (reference != surface);
+
+  cairo_surface_flush (surface);
+  cairo_surface_flush (reference);
+  data = cairo_image_surface_get_data (surface);
+  reference_data = cairo_image_surface_get_data (reference);
+  stride = cairo_image_surface_get_stride (surface);
+  g_assert_cmpint (stride, ==, cairo_image_surface_get_stride (reference));
+
+  for (y = 0; y < 256; y++)
+    g_assert (memcmp (data + y * stride, reference_data + y * stride, 256 * 4) == 0);
+
+  cairo_surface_destroy (cairo_get_target (cr));
+  cairo_destroy (cr);
+
+  /* The surface goes away with the pixbuf, unless it is referenced */
+  destroyed = FALSE;
+  cairo_surface_set_user_data (surface, &key, &destroyed, surface_destroyed);
+  cairo_surface_reference (surface);
+  g_object_unref (pixbuf);
+  g_assert (!destroyed);
+  g_assert_cmpint (cairo_surface_status (surface), ==, CAIRO_STATUS_SUCCESS);
+  cairo_surface_destroy (surface);
+  g_assert (destroyed);
+
+  pixbuf = create_pixbuf (FALSE);
+  surface = gdk_pixbuf_get_cairo_surface (pixbuf);
+  g_assert_cmpint (cairo_image_surface_get_format (surface), ==, CAIRO_FORMAT_RGB24);
+
+  destroyed = FALSE;
+  cairo_surface_set_user_data (surface, &key, &destroyed, surface_destroyed);
+  g_object_unref (pixbuf);
+  g_assert (destroyed);
+}
+
+/* The conversions process several pixels at once where the CPU
+ * allows it, check widths that leave a partial block at the end
+ * of each row, with rows of opaque, transparent and mixed pixels.
+ */
+static guint
+pixel_alpha (guint x,
+             guint y)
+{
+  switch (y % 3)
+    {
+    case 0:
+      return 0xff;
+    case 1:
+      return 0;
+    default:
+      return (x * 37) & 0xff;
+    }
+}
+
+static void
+test_odd_widths (void)
+{
+  gint width, x, y;
+
+  for (width = 1; width <= 40; width++)
+    {
+      cairo_surface_t *target, *surface;
+      GdkPixbuf *pixbuf;
+      cairo_t *cr;
+      guchar *pixels, *data;
+      gint rowstride, stride;
+      gboolean has_alpha;
+
+      for (has_alpha = FALSE; has_alpha <= TRUE; has_alpha++)
+        {
+          gint n_channels = has_alpha ? 4 : 3;
+
+          pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, width, 6);
+          pixels = gdk_pixbuf_get_pixels (pixbuf);
+          rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+          for (y = 0; y < 6; y++)
+            for (x = 0; x < width; x++)
+              {
+                guchar *p = pixels + y * rowstride + x * n_channels;
+
+                p[0] = x * 7 + y;
+                p[1] = 255 - x;
+                p[2] = x * 13;
+                if (has_alpha)
+                  p[3] = pixel_alpha (x, y);
+              }
+
+          target = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+          cr = cairo_create (target);
+          gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+          cairo_pattern_get_surface (cairo_get_source (cr), &surface);
+          cairo_surface_flush (surface);
+          data = cairo_image_surface_get_data (surface);
+          stride = cairo_image_surface_get_stride (surface);
+
+          for (y = 0; y < 6; y++)
+            for (x = 0; x < width; x++)
+              {
+                guchar *p = pixels + y * rowstride + x * n_channels;
+                guint32 pixel = *(guint32 *) (data + y * stride + x * 4);
+                guint alpha = has_alpha ? p[3] : 0xff;
+
+                g_assert_cmpuint ((pixel >> 16) & 0xff, ==, premultiply (p[0], alpha));
+                g_assert_cmpuint ((pixel >>  8) & 0xff, ==, premultiply (p[1], alpha));
+                g_assert_cmpuint ((pixel >>  0) & 0xff, ==, premultiply (p[2], alpha));
+                if (has_alpha)
+                  g_assert_cmpuint (pixel >> 24, ==, alpha);
+              }
+
+          cairo_destroy (cr);
+          cairo_surface_destroy (target);
+          g_object_unref (pixbuf);
+
+          surface = cairo_image_surface_create (has_alpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+                                                width, 6);
+          data = cairo_image_surface_get_data (surface);
+          stride = cairo_image_surface_get_stride (surface);
+
+          for (y = 0; y < 6; y++)
+            for (x = 0; x < width; x++)
+              {
+                guint alpha = has_alpha ? pixel_alpha (x, y) : 0xff;
+                guint c = (x * 7 + y) % (alpha + 1);
+
+                *(guint32 *) (data + y * stride + x * 4) =
+                  (alpha << 24) | (c << 16) | ((alpha - c) << 8) | (c / 2);
+              }
+          cairo_surface_mark_dirty (surface);
+
+          pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0, width, 6);
+          pixels = gdk_pixbuf_get_pixels (pixbuf);
+          rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+
+          for (y = 0; y < 6; y++)
+            for (x = 0; x < width; x++)
+              {
+                guchar *p = pixels + y * rowstride + x * n_channels;
+                guint alpha = has_alpha ? pixel_alpha (x, y) : 0xff;
+                guint c = (x * 7 + y) % (alpha + 1);
+
+                g_assert_cmpuint (p[0], ==, unpremultiply (c, alpha));
+                g_assert_cmpuint (p[1], ==, unpremultiply (alpha - c, alpha));
+                g_assert_cmpuint (p[2], ==, unpremultiply (c / 2, alpha));
+                if (has_alpha)
+                  g_assert_cmpuint (p[3], ==, alpha);
+              }
+
+          g_object_unref (pixbuf);
+          cairo_surface_destroy (surface);
+        }
+    }
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+  g_type_init ();
+
+  g_test_add_func ("/pixbuf-cairo/set-source-pixbuf/alpha", test_set_source_pixbuf_alpha);
+  g_test_add_func ("/pixbuf-cairo/set-source-pixbuf/no-alpha", test_set_source_pixbuf_no_alpha);
+  g_test_add_func ("/pixbuf-cairo/get-from-surface/alpha", test_get_from_surface_alpha);
+  g_test_add_func ("/pixbuf-cairo/get-from-surface/no-alpha", test_get_from_surface_no_alpha);
+  g_test_add_func ("/pixbuf-cairo/odd-widths", test_odd_widths);
+  g_test_add_func ("/pixbuf-cairo/get-cairo-surface", test_get_cairo_surface);
+
+  return g_test_run ();
+}
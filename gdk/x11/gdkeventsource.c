@@ -275,7 +275,12 @@ _gdk_x11_display_queue_events (GdkDisplay *display)
   display_x11 = GDK_X11_DISPLAY (display);
   event_source = (GdkEventSource *) display_x11->event_source;
 
-  while (!_gdk_event_queue_find_first (display) && XPending (xdisplay))
+  /* Keep reading while the queue ends in motion, so that a burst of
+   * XI_Motion events can be compressed before it is dispatched.
+   */
+  while ((!_gdk_event_queue_find_first (display) ||
+          _gdk_event_queue_tail_is_motion (display)) &&
+         XPending (xdisplay))
     {
       XNextEvent (xdisplay, &xevent);
 
@@ -845,7 +845,18 @@ gtk_cell_renderer_pixbuf_render (GtkCellRenderer      *cell,
         pixbuf = symbolic;
     }
 
-  gdk_cairo_set_source_pixbuf (cr, pixbuf, pix_rect.x, pix_rect.y);
+  /* Pixbufs loaded from a stock id, icon name or GIcon are owned by
+   * GTK+ and drawn for many rows, so reuse their converted surface.
+   * Pixbufs set by the application may be changed in place, and the
+   * ones created above only live for this call, so convert those
+   * every time.
+   */
+  if (pixbuf == priv->pixbuf &&
+      (priv->stock_id || priv->icon_name || priv->gicon))
+    cairo_set_source_surface (cr, gdk_pixbuf_get_cairo_surface (pixbuf),
+                              pix_rect.x, pix_rect.y);
+  else
+    gdk_cairo_set_source_pixbuf (cr, pixbuf, pix_rect.x, pix_rect.y);
   gdk_cairo_rectangle (cr, &draw_rect);
   cairo_fill (cr);
 
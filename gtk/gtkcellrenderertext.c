@@ -2080,6 +2080,49 @@ gtk_cell_renderer_text_set_fixed_height_from_font (GtkCellRendererText *renderer
     }
 }
 
+/*
+ * _gtk_cell_renderer_text_get_size_layout:
+ * @celltext: a #GtkCellRendererText
+ * @widget: the #GtkWidget @celltext is rendering to
+ *
+ * Creates the layout @celltext measures its size with, if its size
+ * only depends on the size of that layout: the cell has no fixed
+ * size, does not wrap or ellipsize its text and doesn't limit its
+ * width to a number of characters. The layout is not laid out yet,
+ * so it can be measured in a worker thread with #GtkPangoMeasure.
+ * Its unwrapped logical extents give the sizes computed by the
+ * #GtkCellRenderer size request functions.
+ *
+ * Return value: a new #PangoLayout, or %NULL if the size of
+ *     @celltext depends on more than its layout
+ */
+PangoLayout *
+_gtk_cell_renderer_text_get_size_layout (GtkCellRendererText *celltext,
+                                         GtkWidget           *widget)
+{
+  GtkCellRendererTextPrivate *priv;
+  GtkCellRenderer *cell;
+  gint width, height;
+
+  g_return_val_if_fail (GTK_IS_CELL_RENDERER_TEXT (celltext), NULL);
+
+  cell = GTK_CELL_RENDERER (celltext);
+  priv = celltext->priv;
+
+  gtk_cell_renderer_get_fixed_size (cell, &width, &height);
+
+  if (!gtk_cell_renderer_get_visible (cell) ||
+      width != -1 || height != -1 ||
+      priv->fixed_height_rows != -1 ||
+      (priv->ellipsize_set && priv->ellipsize != PANGO_ELLIPSIZE_NONE) ||
+      priv->wrap_width != -1 ||
+      priv->width_chars > 0 ||
+      priv->max_width_chars > 0)
+    return NULL;
+
+  return get_layout (celltext, widget, NULL, 0);
+}
+
 static void
 gtk_cell_renderer_text_get_preferred_width (GtkCellRenderer *cell,
                                             GtkWidget       *widget,
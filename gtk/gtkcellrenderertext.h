@@ -71,6 +71,8 @@ GtkCellRenderer *gtk_cell_renderer_text_new      (void);
 void             gtk_cell_renderer_text_set_fixed_height_from_font (GtkCellRendererText *renderer,
 								    gint                 number_of_rows);
 
+PangoLayout     *_gtk_cell_renderer_text_get_size_layout (GtkCellRendererText *celltext,
+                                                          GtkWidget           *widget);
 
 G_END_DECLS
 
@@ -736,6 +736,7 @@ typedef struct GtkCssProviderPrivate GtkCssProviderPrivate;
 typedef struct SelectorElement SelectorElement;
 typedef struct SelectorPath SelectorPath;
 typedef struct SelectorStyleInfo SelectorStyleInfo;
+typedef struct SelectorIndex SelectorIndex;
 typedef enum SelectorElementType SelectorElementType;
 typedef enum CombinatorType CombinatorType;
 typedef enum ParserScope ParserScope;
@@ -786,6 +787,21 @@ struct SelectorStyleInfo
   GHashTable *style;
 };
 
+/* Rules are indexed by the rightmost element in their
+ * selector, as that element has to match some element in
+ * the widget path for the whole selector to match. Rules
+ * that can't be indexed this way (globs, unresolved type
+ * names, interfaces) are always checked.
+ */
+struct SelectorIndex
+{
+  GHashTable *types;
+  GHashTable *names;
+  GHashTable *classes;
+  GHashTable *regions;
+  GArray *generic;
+};
+
 struct GtkCssProviderPrivate
 {
   GScanner *scanner;
@@ -797,6 +813,7 @@ struct GtkCssProviderPrivate
   GHashTable *symbolic_colors;
 
   GPtrArray *selectors_info;
+  SelectorIndex *selectors_index;
 
   /* Current parser state */
   GSList *state;
@@ -1038,6 +1055,208 @@ selector_style_info_set_style (SelectorStyleInfo *info,
     info->style = NULL;
 }
 
+static void
+selector_index_bucket_free (GArray *bucket)
+{
+  g_array_free (bucket, TRUE);
+}
+
+static SelectorIndex *
+selector_index_new (void)
+{
+  SelectorIndex *index;
+
+  index = g_slice_new0 (SelectorIndex);
+  index->types = g_hash_table_new_full (NULL, NULL, NULL,
+                                        (GDestroyNotify) selector_index_bucket_free);
+  index->names = g_hash_table_new_full (NULL, NULL, NULL,
+                                        (GDestroyNotify) selector_index_bucket_free);
+  index->classes = g_hash_table_new_full (NULL, NULL, NULL,
+                                          (GDestroyNotify) selector_index_bucket_free);
+  index->regions = g_hash_table_new_full (NULL, NULL, NULL,
+                                          (GDestroyNotify) selector_index_bucket_free);
+  index->generic = g_array_new (FALSE, FALSE, sizeof (guint));
+
+  return index;
+}
+
+static void
+selector_index_free (SelectorIndex *index)
+{
+  g_hash_table_destroy (index->types);
+  g_hash_table_destroy (index->names);
+  g_hash_table_destroy (index->classes);
+  g_hash_table_destroy (index->regions);
+  g_array_free (index->generic, TRUE);
+
+  g_slice_free (SelectorIndex, index);
+}
+
+static void
+selector_index_bucket_add (GHashTable *table,
+                           gpointer    key,
+                           guint       rule)
+{
+  GArray *bucket;
+
+  bucket = g_hash_table_lookup (table, key);
+
+  if (!bucket)
+    {
+      bucket = g_array_new (FALSE, FALSE, sizeof (guint));
+      g_hash_table_insert (table, key, bucket);
+    }
+
+  g_array_append_val (bucket, rule);
+}
+
+static void
+selector_index_add (SelectorIndex *index,
+                    SelectorPath  *path,
+                    guint          rule)
+{
+  SelectorElement *elem = NULL;
+
+  if (path->elements)
+    elem = path->elements->data;
+
+  if (!elem)
+    g_array_append_val (index->generic, rule);
+  else if (elem->elem_type == SELECTOR_GTYPE &&
+           !G_TYPE_IS_INTERFACE (elem->type))
+    selector_index_bucket_add (index->types, GSIZE_TO_POINTER (elem->type), rule);
+  else if (elem->elem_type == SELECTOR_NAME)
+    selector_index_bucket_add (index->names, GUINT_TO_POINTER (elem->name), rule);
+  else if (elem->elem_type == SELECTOR_CLASS)
+    selector_index_bucket_add (index->classes, GUINT_TO_POINTER (elem->name), rule);
+  else if (elem->elem_type == SELECTOR_REGION)
+    selector_index_bucket_add (index->regions, GUINT_TO_POINTER (elem->region.name), rule);
+  else
+    g_array_append_val (index->generic, rule);
+}
+
+static void
+selector_index_collect_bucket (GHashTable *table,
+                               gpointer    key,
+                               GArray     *rules)
+{
+  GArray *bucket;
+
+  bucket = g_hash_table_lookup (table, key);
+
+  if (bucket)
+    g_array_append_vals (rules, bucket->data, bucket->len);
+}
+
+static void
+selector_index_collect_quarks (GHashTable *table,
+                               GSList     *list,
+                               GArray     *rules)
+{
+  GSList *l;
+
+  for (l = list; l; l = l->next)
+    {
+      GQuark quark;
+
+      quark = g_quark_try_string (l->data);
+
+      if (quark != 0)
+        selector_index_collect_bucket (table, GUINT_TO_POINTER (quark), rules);
+    }
+
+  g_slist_free (list);
+}
+
+static gint
+compare_rule_position (gconstpointer a,
+                       gconstpointer b)
+{
+  guint rule_a = *(const guint *) a;
+  guint rule_b = *(const guint *) b;
+
+  if (rule_a < rule_b)
+    return -1;
+  else if (rule_a > rule_b)
+    return 1;
+
+  return 0;
+}
+
+/* Returns the positions, in ascending order and without
+ * duplicates, of the rules that could possibly match @path.
+ */
+static GArray *
+selector_index_lookup (SelectorIndex *index,
+                       GtkWidgetPath *path)
+{
+  GArray *rules;
+  guint i, j;
+  gint pos, len;
+
+  rules = g_array_new (FALSE, FALSE, sizeof (guint));
+  g_array_append_vals (rules, index->generic->data, index->generic->len);
+
+  len = gtk_widget_path_length (path);
+
+  for (pos = 0; pos < len; pos++)
+    {
+      const gchar *name;
+      GType type;
+
+      type = gtk_widget_path_iter_get_object_type (path, pos);
+
+      while (type != G_TYPE_INVALID)
+        {
+          selector_index_collect_bucket (index->types, GSIZE_TO_POINTER (type), rules);
+          type = g_type_parent (type);
+        }
+
+      name = gtk_widget_path_iter_get_name (path, pos);
+
+      if (name)
+        {
+          GQuark quark;
+
+          quark = g_quark_try_string (name);
+
+          if (quark != 0)
+            selector_index_collect_bucket (index->names, GUINT_TO_POINTER (quark), rules);
+        }
+
+      if (g_hash_table_size (index->classes) > 0)
+        selector_index_collect_quarks (index->classes,
+                                       gtk_widget_path_iter_list_classes (path, pos),
+                                       rules);
+
+      if (g_hash_table_size (index->regions) > 0)
+        selector_index_collect_quarks (index->regions,
+                                       gtk_widget_path_iter_list_regions (path, pos),
+                                       rules);
+    }
+
+  if (rules->len < 2)
+    return rules;
+
+  /* Rules are matched in stylesheet order, so
+   * sort candidates and drop any duplicates
+   */
+  g_array_sort (rules, compare_rule_position);
+
+  for (i = 1, j = 0; i < rules->len; i++)
+    {
+      if (g_array_index (rules, guint, i) != g_array_index (rules, guint, j))
+        {
+          j++;
+          g_array_index (rules, guint, j) = g_array_index (rules, guint, i);
+        }
+    }
+
+  g_array_set_size (rules, j + 1);
+
+  return rules;
+}
+
 static GScanner *
 create_scanner (void)
 {
@@ -1288,25 +1507,83 @@ struct StylePriorityInfo
   GtkStateFlags state;
 };
 
+static SelectorIndex *
+css_provider_get_selectors_index (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv;
+  guint i;
+
+  priv = css_provider->priv;
+
+  if (priv->selectors_index)
+    return priv->selectors_index;
+
+  priv->selectors_index = selector_index_new ();
+
+  for (i = 0; i < priv->selectors_info->len; i++)
+    {
+      SelectorStyleInfo *info;
+
+      info = g_ptr_array_index (priv->selectors_info, i);
+      selector_index_add (priv->selectors_index, info->path, i);
+    }
+
+  return priv->selectors_index;
+}
+
+static void
+css_provider_invalidate_selectors_index (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv;
+
+  priv = css_provider->priv;
+
+  if (priv->selectors_index)
+    {
+      selector_index_free (priv->selectors_index);
+      priv->selectors_index = NULL;
+    }
+}
+
+static void
+css_provider_clear_selectors (GtkCssProvider *css_provider)
+{
+  GtkCssProviderPrivate *priv;
+
+  priv = css_provider->priv;
+
+  if (priv->selectors_info->len > 0)
+    g_ptr_array_remove_range (priv->selectors_info, 0, priv->selectors_info->len);
+
+  css_provider_invalidate_selectors_index (css_provider);
+  _gtk_style_context_invalidate_style_cache ();
+}
+
 static GArray *
 css_provider_get_selectors (GtkCssProvider *css_provider,
                             GtkWidgetPath  *path)
 {
   GtkCssProviderPrivate *priv;
+  SelectorIndex *index;
   GArray *priority_info;
+  GArray *candidates;
   guint i, j;
 
   priv = css_provider->priv;
   priority_info = g_array_new (FALSE, FALSE, sizeof (StylePriorityInfo));
 
-  for (i = 0; i < priv->selectors_info->len; i++)
+  index = css_provider_get_selectors_index (css_provider);
+  candidates = selector_index_lookup (index, path);
+
+  for (i = 0; i < candidates->len; i++)
     {
       SelectorStyleInfo *info;
       StylePriorityInfo new;
       gboolean added = FALSE;
       guint64 score;
 
-      info = g_ptr_array_index (priv->selectors_info, i);
+      info = g_ptr_array_index (priv->selectors_info,
+                                g_array_index (candidates, guint, i));
       score = compare_selector (path, info->path);
 
       if (score <= 0)
@@ -1334,6 +1611,8 @@ css_provider_get_selectors (GtkCssProvider *css_provider,
         g_array_append_val (priority_info, new);
     }
 
+  g_array_free (candidates, TRUE);
+
   return priority_info;
 }
 
@@ -1474,6 +1753,9 @@ gtk_css_provider_finalize (GObject *object)
 
   g_ptr_array_free (priv->selectors_info, TRUE);
 
+  if (priv->selectors_index)
+    selector_index_free (priv->selectors_index);
+
   g_slist_foreach (priv->cur_selectors, (GFunc) selector_path_unref, NULL);
   g_slist_free (priv->cur_selectors);
 
@@ -1631,6 +1913,8 @@ css_provider_commit (GtkCssProvider *css_provider)
       g_ptr_array_add (priv->selectors_info, info);
       l = l->next;
     }
+
+  css_provider_invalidate_selectors_index (css_provider);
 }
 
 static GTokenType
@@ -3596,8 +3880,7 @@ gtk_css_provider_load_from_data (GtkCssProvider  *css_provider,
   if (length < 0)
     length = strlen (data);
 
-  if (priv->selectors_info->len > 0)
-    g_ptr_array_remove_range (priv->selectors_info, 0, priv->selectors_info->len);
+  css_provider_clear_selectors (css_provider);
 
   priv->scanner->input_name = "-";
   priv->buffer = data;
@@ -3645,8 +3928,7 @@ gtk_css_provider_load_from_file (GtkCssProvider  *css_provider,
       return FALSE;
     }
 
-  if (priv->selectors_info->len > 0)
-    g_ptr_array_remove_range (priv->selectors_info, 0, priv->selectors_info->len);
+  css_provider_clear_selectors (css_provider);
 
   g_free (priv->filename);
   priv->filename = g_file_get_path (file);
@@ -3694,8 +3976,7 @@ gtk_css_provider_load_from_path_internal (GtkCssProvider  *css_provider,
 
   if (reset)
     {
-      if (priv->selectors_info->len > 0)
-        g_ptr_array_remove_range (priv->selectors_info, 0, priv->selectors_info->len);
+      css_provider_clear_selectors (css_provider);
 
       g_free (priv->filename);
       priv->filename = g_strdup (path);
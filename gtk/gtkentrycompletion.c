@@ -82,6 +82,7 @@
 #include "gtkvbox.h"
 #include "gtkwindow.h"
 #include "gtkentry.h"
+#include "gtktreestore.h"
 #include "gtkmainprivate.h"
 #include "gtkmarshalers.h"
 
@@ -136,6 +137,7 @@ static void     gtk_entry_completion_dispose             (GObject      *object);
 static gboolean gtk_entry_completion_visible_func        (GtkTreeModel       *model,
                                                           GtkTreeIter        *iter,
                                                           gpointer            data);
+static void     match_index_free                         (GtkEntryCompletionIndex *index);
 static gboolean gtk_entry_completion_popup_key_event     (GtkWidget          *widget,
                                                           GdkEventKey        *event,
                                                           gpointer            user_data);
@@ -802,6 +804,12 @@ gtk_entry_completion_dispose (GObject *object)
       priv->cell_area = NULL;
     }
 
+  if (priv->match_index)
+    {
+      match_index_free (priv->match_index);
+      priv->match_index = NULL;
+    }
+
   G_OBJECT_CLASS (gtk_entry_completion_parent_class)->dispose (object);
 }
 
@@ -822,6 +830,322 @@ gtk_entry_completion_get_area (GtkCellLayout *cell_layout)
   return priv->cell_area;
 }
 
+/* Match index
+ *
+ * With the default match function, every refilter used to normalize
+ * and casefold the text of every row. Instead, we keep the casefolded
+ * text of each row, sorted so that the rows matching a key form a
+ * contiguous range, and mark that range before refiltering; the
+ * visible function then only has to look up the row.
+ *
+ * Rows are identified by their iter's user_data, which is only known
+ * to be stable and unique for GtkListStore and GtkTreeStore. Other
+ * models keep using gtk_entry_completion_default_completion_func().
+ */
+typedef struct
+{
+  gpointer row;
+  gchar *key;
+  guint serial;
+} MatchKey;
+
+struct _GtkEntryCompletionIndex
+{
+  GtkTreeModel *model;
+  gint column;
+
+  gulong row_inserted_id;
+  gulong row_changed_id;
+  gulong row_deleted_id;
+
+  GHashTable *rows;
+  GPtrArray *sorted;
+
+  guint valid        : 1;
+  guint sorted_valid : 1;
+
+  /* The range of sorted matching last_key, as long as sorted_valid */
+  gchar *last_key;
+  guint start;
+  guint end;
+  guint serial;
+};
+
+static gchar *
+normalize_key (const gchar *text)
+{
+  gchar *normalized, *key;
+
+  normalized = g_utf8_normalize (text, -1, G_NORMALIZE_ALL);
+  if (normalized == NULL)
+    return NULL;
+
+  key = g_utf8_casefold (normalized, -1);
+  g_free (normalized);
+
+  return key;
+}
+
+static void
+match_key_free (MatchKey *match)
+{
+  g_free (match->key);
+  g_slice_free (MatchKey, match);
+}
+
+static gint
+match_key_compare (gconstpointer a,
+                   gconstpointer b)
+{
+  const MatchKey *match_a = *(const MatchKey **)a;
+  const MatchKey *match_b = *(const MatchKey **)b;
+
+  return strcmp (match_a->key, match_b->key);
+}
+
+static void
+match_index_set_row (GtkEntryCompletionIndex *index,
+                     GtkTreeIter             *iter)
+{
+  MatchKey *match;
+  gchar *text = NULL;
+  gchar *key = NULL;
+
+  gtk_tree_model_get (index->model, iter, index->column, &text, -1);
+  if (text)
+    key = normalize_key (text);
+  g_free (text);
+
+  match = g_hash_table_lookup (index->rows, iter->user_data);
+
+  if (key == NULL)
+    {
+      if (match)
+        {
+          g_ptr_array_remove_fast (index->sorted, match);
+          g_hash_table_remove (index->rows, iter->user_data);
+          index->sorted_valid = FALSE;
+        }
+      return;
+    }
+
+  if (match == NULL)
+    {
+      match = g_slice_new0 (MatchKey);
+      match->row = iter->user_data;
+      g_hash_table_insert (index->rows, match->row, match);
+      g_ptr_array_add (index->sorted, match);
+    }
+  else if (strcmp (match->key, key) == 0)
+    {
+      g_free (key);
+      return;
+    }
+
+  g_free (match->key);
+  match->key = key;
+
+  /* Keep the row's state right for the current key, since
+   * the filter model asks about it right after we return
+   */
+  if (index->last_key && g_str_has_prefix (key, index->last_key))
+    match->serial = index->serial;
+  else
+    match->serial = 0;
+
+  index->sorted_valid = FALSE;
+}
+
+static void
+match_index_row_changed (GtkTreeModel            *model,
+                         GtkTreePath             *path,
+                         GtkTreeIter             *iter,
+                         GtkEntryCompletionIndex *index)
+{
+  if (index->valid)
+    match_index_set_row (index, iter);
+}
+
+static void
+match_index_row_deleted (GtkTreeModel            *model,
+                         GtkTreePath             *path,
+                         GtkEntryCompletionIndex *index)
+{
+  /* The row is gone, and with it the means to find its entry;
+   * rebuild on the next completion.
+   */
+  index->valid = FALSE;
+}
+
+static GtkEntryCompletionIndex *
+match_index_new (GtkTreeModel *model)
+{
+  GtkEntryCompletionIndex *index;
+
+  if (!GTK_IS_LIST_STORE (model) && !GTK_IS_TREE_STORE (model))
+    return NULL;
+
+  index = g_slice_new0 (GtkEntryCompletionIndex);
+  index->model = g_object_ref (model);
+  index->column = -1;
+  index->rows = g_hash_table_new_full (NULL, NULL,
+                                       NULL, (GDestroyNotify) match_key_free);
+  index->sorted = g_ptr_array_new ();
+
+  /* Connected before the filter model is created, so that the
+   * index is up to date when the filter model looks at the row
+   */
+  index->row_inserted_id =
+    g_signal_connect (model, "row-inserted",
+                      G_CALLBACK (match_index_row_changed), index);
+  index->row_changed_id =
+    g_signal_connect (model, "row-changed",
+                      G_CALLBACK (match_index_row_changed), index);
+  index->row_deleted_id =
+    g_signal_connect (model, "row-deleted",
+                      G_CALLBACK (match_index_row_deleted), index);
+
+  return index;
+}
+
+static void
+match_index_free (GtkEntryCompletionIndex *index)
+{
+  g_signal_handler_disconnect (index->model, index->row_inserted_id);
+  g_signal_handler_disconnect (index->model, index->row_changed_id);
+  g_signal_handler_disconnect (index->model, index->row_deleted_id);
+  g_object_unref (index->model);
+
+  g_ptr_array_free (index->sorted, TRUE);
+  g_hash_table_destroy (index->rows);
+  g_free (index->last_key);
+
+  g_slice_free (GtkEntryCompletionIndex, index);
+}
+
+static gboolean
+match_index_add_row (GtkTreeModel *model,
+                     GtkTreePath  *path,
+                     GtkTreeIter  *iter,
+                     gpointer      data)
+{
+  match_index_set_row (data, iter);
+
+  return FALSE;
+}
+
+static void
+match_index_rebuild (GtkEntryCompletionIndex *index,
+                     gint                     column)
+{
+  g_ptr_array_set_size (index->sorted, 0);
+  g_hash_table_remove_all (index->rows);
+  g_free (index->last_key);
+  index->last_key = NULL;
+
+  index->column = column;
+  index->valid = TRUE;
+
+  gtk_tree_model_foreach (index->model, match_index_add_row, index);
+
+  index->sorted_valid = FALSE;
+}
+
+/* Marks the rows matching @key, and returns whether the index
+ * can answer for the visible function.
+ */
+static gboolean
+match_index_update (GtkEntryCompletionIndex *index,
+                    gint                     column,
+                    const gchar             *key)
+{
+  guint lo, hi, start, end;
+  gsize len;
+
+  if (gtk_tree_model_get_column_type (index->model, column) != G_TYPE_STRING)
+    return FALSE;
+
+  if (!index->valid || index->column != column)
+    match_index_rebuild (index, column);
+
+  if (!index->sorted_valid)
+    {
+      g_ptr_array_sort (index->sorted, match_key_compare);
+      index->sorted_valid = TRUE;
+
+      g_free (index->last_key);
+      index->last_key = NULL;
+    }
+
+  /* A key that extends the previous one can only match a
+   * subset of what that matched
+   */
+  if (index->last_key && g_str_has_prefix (key, index->last_key))
+    {
+      lo = index->start;
+      hi = index->end;
+    }
+  else
+    {
+      lo = 0;
+      hi = index->sorted->len;
+    }
+
+  /* Find the first key >= @key */
+  while (lo < hi)
+    {
+      guint mid = lo + (hi - lo) / 2;
+      MatchKey *match = g_ptr_array_index (index->sorted, mid);
+
+      if (strcmp (match->key, key) < 0)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+  start = lo;
+  len = strlen (key);
+
+  index->serial++;
+  if (index->serial == 0)
+    index->serial++;
+
+  for (end = start; end < index->sorted->len; end++)
+    {
+      MatchKey *match = g_ptr_array_index (index->sorted, end);
+
+      if (strncmp (match->key, key, len) != 0)
+        break;
+
+      match->serial = index->serial;
+    }
+
+  g_free (index->last_key);
+  index->last_key = g_strdup (key);
+  index->start = start;
+  index->end = end;
+
+  return TRUE;
+}
+
+static gboolean
+match_index_lookup (GtkEntryCompletionIndex *index,
+                    GtkTreeIter             *iter,
+                    gboolean                *matches)
+{
+  MatchKey *match;
+
+  if (!index->valid || index->last_key == NULL)
+    return FALSE;
+
+  match = g_hash_table_lookup (index->rows, iter->user_data);
+
+  /* Rows without text are not in the index */
+  *matches = match != NULL && match->serial == index->serial;
+
+  return TRUE;
+}
+
 /* all those callbacks */
 static gboolean
 gtk_entry_completion_default_completion_func (GtkEntryCompletion *completion,
@@ -884,10 +1208,14 @@ gtk_entry_completion_visible_func (GtkTreeModel *model,
                                             iter,
                                             completion->priv->match_data);
   else if (completion->priv->text_column >= 0)
-    ret = gtk_entry_completion_default_completion_func (completion,
-                                                        completion->priv->case_normalized_key,
-                                                        iter,
-                                                        NULL);
+    {
+      if (!completion->priv->match_index ||
+          !match_index_lookup (completion->priv->match_index, iter, &ret))
+        ret = gtk_entry_completion_default_completion_func (completion,
+                                                            completion->priv->case_normalized_key,
+                                                            iter,
+                                                            NULL);
+    }
 
   return ret;
 }
@@ -1120,6 +1448,12 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
   g_return_if_fail (GTK_IS_ENTRY_COMPLETION (completion));
   g_return_if_fail (model == NULL || GTK_IS_TREE_MODEL (model));
 
+  if (completion->priv->match_index)
+    {
+      match_index_free (completion->priv->match_index);
+      completion->priv->match_index = NULL;
+    }
+
   if (!model)
     {
       gtk_tree_view_set_model (GTK_TREE_VIEW (completion->priv->tree_view),
@@ -1129,6 +1463,8 @@ gtk_entry_completion_set_model (GtkEntryCompletion *completion,
       return;
     }
 
+  completion->priv->match_index = match_index_new (model);
+
   /* code will unref the old filter model (if any) */
   completion->priv->filter_model =
     GTK_TREE_MODEL_FILTER (gtk_tree_model_filter_new (model, NULL));
@@ -1271,6 +1607,18 @@ gtk_entry_completion_complete (GtkEntryCompletion *completion)
   completion->priv->case_normalized_key = g_utf8_casefold (tmp, -1);
   g_free (tmp);
 
+  if (completion->priv->match_index &&
+      !completion->priv->match_func &&
+      completion->priv->text_column >= 0 &&
+      !match_index_update (completion->priv->match_index,
+                           completion->priv->text_column,
+                           completion->priv->case_normalized_key))
+    {
+      /* Not a string column; leave it to the default match function */
+      match_index_free (completion->priv->match_index);
+      completion->priv->match_index = NULL;
+    }
+
   gtk_tree_model_filter_refilter (completion->priv->filter_model);
 
   if (gtk_widget_get_visible (completion->priv->popup_window))
@@ -28,6 +28,8 @@
 
 G_BEGIN_DECLS
 
+typedef struct _GtkEntryCompletionIndex GtkEntryCompletionIndex;
+
 struct _GtkEntryCompletionPrivate
 {
   GtkWidget *entry;
@@ -48,6 +50,7 @@ struct _GtkEntryCompletionPrivate
   gint current_selected;
 
   gchar *case_normalized_key;
+  GtkEntryCompletionIndex *match_index;
 
   /* only used by GtkEntry when attached: */
   GtkWidget *popup_window;
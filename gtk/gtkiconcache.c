@@ -58,19 +58,21 @@ struct _GtkIconCache {
   guint32 last_chain_offset;
 };
 
+/* Pixbufs pointing into the cache hold a reference on it, and
+ * may be released by the icon loader threads, so the reference
+ * count is atomic.
+ */
 GtkIconCache *
 _gtk_icon_cache_ref (GtkIconCache *cache)
 {
-  cache->ref_count++;
+  g_atomic_int_inc (&cache->ref_count);
   return cache;
 }
 
 void
 _gtk_icon_cache_unref (GtkIconCache *cache)
 {
-  cache->ref_count --;
-
-  if (cache->ref_count == 0)
+  if (g_atomic_int_dec_and_test (&cache->ref_count))
     {
       GTK_NOTE (ICONTHEME, 
 		g_print ("unmapping icon cache\n"));
@@ -157,6 +159,151 @@ _gtk_icon_cache_new_for_path (const gchar *path)
   return cache;
 }
 
+static gchar *
+get_index_filename (const gchar *path)
+{
+  gchar *checksum, *basename, *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, path, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  filename = g_build_filename (g_get_user_cache_dir (),
+                               "gtk-3.0", "icon-index", basename,
+                               NULL);
+  g_free (basename);
+  g_free (checksum);
+
+  return filename;
+}
+
+/* Returns the modification time recorded for @path (index -1)
+ * or for the directory at @index when the index was written.
+ * The times follow the offsets in the directory list.
+ */
+static gboolean
+get_index_mtime (GtkIconCache *cache,
+                 gsize         cache_size,
+                 gint          index,
+                 guint32      *mtime)
+{
+  guint32 dir_list_offset, n_dirs;
+  gsize offset;
+
+  dir_list_offset = GET_UINT32 (cache->buffer, 8);
+  n_dirs = GET_UINT32 (cache->buffer, dir_list_offset);
+
+  if (n_dirs > cache_size / 4)
+    return FALSE;
+
+  offset = (gsize) dir_list_offset + 4 + 4 * n_dirs + 4 * (index + 1);
+  if (offset + 4 > cache_size)
+    return FALSE;
+
+  *mtime = GET_UINT32 (cache->buffer, offset);
+
+  return TRUE;
+}
+
+/* Per-user indexes are written by _gtk_icon_cache_write_index() for
+ * theme directories that have no icon-theme.cache. They use the same
+ * format, but carry no image data, so they only replace the directory
+ * scan. Since adding or removing an icon only changes the mtime of the
+ * subdirectory it lives in, the index records the mtime of @path and
+ * of each of its subdirectories, and is only used while all of them
+ * are unchanged.
+ */
+GtkIconCache *
+_gtk_icon_cache_new_for_index (const gchar  *path,
+                               gchar       **subdirs)
+{
+  GtkIconCache *cache = NULL;
+  GMappedFile *map = NULL;
+  gchar *index_filename;
+  struct stat st;
+  struct stat path_st;
+  CacheInfo info;
+  guint32 mtime;
+  gint i;
+
+  index_filename = get_index_filename (path);
+
+  if (g_stat (path, &path_st) < 0)
+    goto done;
+
+  if (g_stat (index_filename, &st) < 0 || st.st_size < 12)
+    goto done;
+
+  map = g_mapped_file_new (index_filename, FALSE, NULL);
+
+  if (!map)
+    goto done;
+
+  /* The index lives in a user-writable location, so always check it */
+  info.cache = g_mapped_file_get_contents (map);
+  info.cache_size = g_mapped_file_get_length (map);
+  info.n_directories = 0;
+  info.flags = CHECK_OFFSETS|CHECK_STRINGS;
+
+  if (!_gtk_icon_cache_validate (&info))
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("index %s is invalid\n", index_filename));
+      goto done;
+    }
+
+  cache = g_new0 (GtkIconCache, 1);
+  cache->ref_count = 1;
+  cache->map = map;
+  cache->buffer = g_mapped_file_get_contents (map);
+
+  if (!get_index_mtime (cache, info.cache_size, -1, &mtime) ||
+      mtime != (guint32) path_st.st_mtime)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("index for %s outdated\n", path));
+      goto outdated;
+    }
+
+  for (i = 0; subdirs[i] != NULL; i++)
+    {
+      struct stat dir_st;
+      gchar *full_dir;
+      gboolean exists;
+      gint index;
+
+      full_dir = g_build_filename (path, subdirs[i], NULL);
+      exists = g_stat (full_dir, &dir_st) == 0 && S_ISDIR (dir_st.st_mode);
+      g_free (full_dir);
+
+      index = get_directory_index (cache, subdirs[i]);
+
+      if (exists != (index >= 0) ||
+          (exists && (!get_index_mtime (cache, info.cache_size, index, &mtime) ||
+                      mtime != (guint32) dir_st.st_mtime)))
+        {
+          GTK_NOTE (ICONTHEME,
+		    g_print ("index for %s outdated (%s)\n", path, subdirs[i]));
+          goto outdated;
+        }
+    }
+
+  GTK_NOTE (ICONTHEME, g_print ("found index for %s\n", path));
+
+  map = NULL;
+  goto done;
+
+ outdated:
+  cache->map = NULL;
+  _gtk_icon_cache_unref (cache);
+  cache = NULL;
+
+ done:
+  if (map)
+    g_mapped_file_unref (map);
+  g_free (index_filename);
+
+  return cache;
+}
+
 GtkIconCache *
 _gtk_icon_cache_new (const gchar *data)
 {
@@ -565,3 +712,265 @@ _gtk_icon_cache_get_icon_data  (GtkIconCache *cache,
   return data;
 }
 
+
+typedef struct
+{
+  guint16 directory_index;
+  guint16 flags;
+} IndexImage;
+
+static void
+append_uint16 (GString *buffer,
+               guint16  value)
+{
+  value = GUINT16_TO_BE (value);
+  g_string_append_len (buffer, (gchar *)&value, 2);
+}
+
+static void
+append_uint32 (GString *buffer,
+               guint32  value)
+{
+  value = GUINT32_TO_BE (value);
+  g_string_append_len (buffer, (gchar *)&value, 4);
+}
+
+static void
+set_uint32 (GString *buffer,
+            gsize    offset,
+            guint32  value)
+{
+  value = GUINT32_TO_BE (value);
+  memcpy (buffer->str + offset, &value, 4);
+}
+
+static void
+append_string (GString     *buffer,
+               const gchar *string)
+{
+  g_string_append_len (buffer, string, strlen (string) + 1);
+  while (buffer->len % 4 != 0)
+    g_string_append_c (buffer, '\0');
+}
+
+static void
+free_image_array (gpointer data)
+{
+  g_array_free (data, TRUE);
+}
+
+/* Gets the mtime of @path, failing if it may have changed
+ * after @scan_start. Modification times only have a resolution
+ * of one second, so a change in the second the scan started in
+ * can't be told apart from one before the scan.
+ */
+static gboolean
+get_scanned_mtime (const gchar *path,
+                   time_t       scan_start,
+                   guint32     *mtime)
+{
+  struct stat st;
+
+  if (g_stat (path, &st) < 0 || st.st_mtime >= scan_start)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("not writing index, %s changed recently\n", path));
+      return FALSE;
+    }
+
+  *mtime = st.st_mtime;
+
+  return TRUE;
+}
+
+/**
+ * _gtk_icon_cache_write_index:
+ * @path: the theme directory that was scanned
+ * @subdirs: the subdirectories of @path that exist
+ * @icons: for each of @subdirs, a hash table mapping icon names
+ *     to their cache flags
+ * @n_subdirs: the number of elements in @subdirs and @icons
+ * @scan_start: the time at which the scan of @subdirs started
+ *
+ * Writes a per-user index for @path, to be picked up by
+ * _gtk_icon_cache_new_for_index() in later processes. No index
+ * is written if any of the directories was modified since
+ * @scan_start, or in the same second.
+ *
+ * Returns: %TRUE if the index was written
+ */
+gboolean
+_gtk_icon_cache_write_index (const gchar  *path,
+                             const gchar **subdirs,
+                             GHashTable  **icons,
+                             gint          n_subdirs,
+                             time_t        scan_start)
+{
+  GHashTable *images;
+  GHashTableIter iter;
+  gpointer key, value;
+  GSList **buckets;
+  GString *buffer;
+  guint32 n_buckets, hash_offset, dir_list_offset;
+  guint32 *mtimes;
+  gchar *index_filename, *index_dir;
+  gboolean retval;
+  GError *error = NULL;
+  gint i;
+
+  mtimes = g_new (guint32, n_subdirs + 1);
+
+  if (!get_scanned_mtime (path, scan_start, &mtimes[0]))
+    {
+      g_free (mtimes);
+      return FALSE;
+    }
+
+  for (i = 0; i < n_subdirs; i++)
+    {
+      gchar *full_dir;
+      gboolean ok;
+
+      full_dir = g_build_filename (path, subdirs[i], NULL);
+      ok = get_scanned_mtime (full_dir, scan_start, &mtimes[i + 1]);
+      g_free (full_dir);
+
+      if (!ok)
+        {
+          g_free (mtimes);
+          return FALSE;
+        }
+    }
+
+  images = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                  NULL, free_image_array);
+
+  for (i = 0; i < n_subdirs; i++)
+    {
+      g_hash_table_iter_init (&iter, icons[i]);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          GArray *array;
+          IndexImage image;
+
+          array = g_hash_table_lookup (images, key);
+          if (array == NULL)
+            {
+              array = g_array_new (FALSE, FALSE, sizeof (IndexImage));
+              g_hash_table_insert (images, key, array);
+            }
+
+          image.directory_index = i;
+          image.flags = GPOINTER_TO_UINT (value);
+          g_array_append_val (array, image);
+        }
+    }
+
+  n_buckets = g_spaced_primes_closest (g_hash_table_size (images) / 3);
+  buckets = g_new0 (GSList *, n_buckets);
+
+  g_hash_table_iter_init (&iter, images);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      guint hash = icon_name_hash (key) % n_buckets;
+
+      buckets[hash] = g_slist_prepend (buckets[hash], key);
+    }
+
+  buffer = g_string_new (NULL);
+
+  /* Header, filled in at the end */
+  append_uint16 (buffer, MAJOR_VERSION);
+  append_uint16 (buffer, MINOR_VERSION);
+  append_uint32 (buffer, 0);
+  append_uint32 (buffer, 0);
+
+  hash_offset = buffer->len;
+  append_uint32 (buffer, n_buckets);
+  for (i = 0; i < n_buckets; i++)
+    append_uint32 (buffer, 0xffffffff);
+
+  for (i = 0; i < n_buckets; i++)
+    {
+      gsize chain_field = hash_offset + 4 + 4 * i;
+      GSList *l;
+
+      for (l = buckets[i]; l; l = l->next)
+        {
+          const gchar *name = l->data;
+          GArray *array = g_hash_table_lookup (images, name);
+          gsize node_offset = buffer->len;
+          gint j;
+
+          set_uint32 (buffer, chain_field, node_offset);
+          chain_field = node_offset;
+
+          append_uint32 (buffer, 0xffffffff);
+          append_uint32 (buffer, 0);
+          append_uint32 (buffer, 0);
+
+          set_uint32 (buffer, node_offset + 4, buffer->len);
+          append_string (buffer, name);
+
+          set_uint32 (buffer, node_offset + 8, buffer->len);
+          append_uint32 (buffer, array->len);
+          for (j = 0; j < array->len; j++)
+            {
+              IndexImage *image = &g_array_index (array, IndexImage, j);
+
+              append_uint16 (buffer, image->directory_index);
+              append_uint16 (buffer, image->flags);
+              append_uint32 (buffer, 0);
+            }
+        }
+
+      g_slist_free (buckets[i]);
+    }
+
+  dir_list_offset = buffer->len;
+  append_uint32 (buffer, n_subdirs);
+  for (i = 0; i < n_subdirs; i++)
+    append_uint32 (buffer, 0);
+
+  /* The mtimes of @path and of the subdirectories, which
+   * regular caches don't have.
+   */
+  for (i = 0; i < n_subdirs + 1; i++)
+    append_uint32 (buffer, mtimes[i]);
+
+  for (i = 0; i < n_subdirs; i++)
+    {
+      set_uint32 (buffer, dir_list_offset + 4 + 4 * i, buffer->len);
+      append_string (buffer, subdirs[i]);
+    }
+
+  set_uint32 (buffer, 4, hash_offset);
+  set_uint32 (buffer, 8, dir_list_offset);
+
+  index_filename = get_index_filename (path);
+  index_dir = g_path_get_dirname (index_filename);
+
+  retval = g_mkdir_with_parents (index_dir, 0700) == 0 &&
+           g_file_set_contents (index_filename, buffer->str, buffer->len, &error);
+
+  if (error)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("could not write index for %s: %s\n", path, error->message));
+      g_error_free (error);
+    }
+  else if (retval)
+    {
+      GTK_NOTE (ICONTHEME,
+		g_print ("wrote index for %s to %s\n", path, index_filename));
+    }
+
+  g_free (index_dir);
+  g_free (index_filename);
+  g_string_free (buffer, TRUE);
+  g_free (buckets);
+  g_free (mtimes);
+  g_hash_table_destroy (images);
+
+  return retval;
+}
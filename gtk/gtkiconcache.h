@@ -38,6 +38,13 @@ struct _GtkIconData
 
 GtkIconCache *_gtk_icon_cache_new            (const gchar  *data);
 GtkIconCache *_gtk_icon_cache_new_for_path   (const gchar  *path);
+GtkIconCache *_gtk_icon_cache_new_for_index  (const gchar  *path,
+                                              gchar       **subdirs);
+gboolean      _gtk_icon_cache_write_index    (const gchar  *path,
+                                              const gchar **subdirs,
+                                              GHashTable  **icons,
+                                              gint          n_subdirs,
+                                              time_t        scan_start);
 gint          _gtk_icon_cache_get_directory_index  (GtkIconCache *cache,
 					            const gchar  *directory);
 gboolean      _gtk_icon_cache_has_icon       (GtkIconCache *cache,
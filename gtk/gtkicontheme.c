@@ -215,6 +215,7 @@ static void         theme_subdir_load (GtkIconTheme     *icon_theme,
 static void         do_theme_change   (GtkIconTheme     *icon_theme);
 
 static void     blow_themes               (GtkIconTheme    *icon_themes);
+static void     pixbuf_cache_clear        (void);
 static gboolean rescan_themes             (GtkIconTheme    *icon_themes);
 
 static void  icon_data_free            (GtkIconData     *icon_data);
@@ -624,6 +625,7 @@ do_theme_change (GtkIconTheme *icon_theme)
   GTK_NOTE (ICONTHEME, 
 	    g_print ("change to icon theme \"%s\"\n", priv->current_theme));
   blow_themes (icon_theme);
+  pixbuf_cache_clear ();
   g_signal_emit (icon_theme, signal_changed, 0);
 
   if (!priv->reset_styles_idle)
@@ -880,6 +882,68 @@ gtk_icon_theme_set_custom_theme (GtkIconTheme *icon_theme,
     }
 }
 
+/* Records what scan_directory() found in the directories of @theme
+ * below @dir_mtime, so that the next process can map the result
+ * instead of reading the directories again.
+ */
+static void
+write_theme_index (IconTheme         *theme,
+                   IconThemeDirMtime *dir_mtime,
+                   time_t             scan_start)
+{
+  GPtrArray *subdirs;
+  GPtrArray *icons;
+  GList *l;
+
+  subdirs = g_ptr_array_new ();
+  icons = g_ptr_array_new_with_free_func ((GDestroyNotify)g_hash_table_unref);
+
+  for (l = theme->dirs; l != NULL; l = l->next)
+    {
+      IconThemeDir *dir = l->data;
+      GHashTable *flags;
+      GHashTableIter iter;
+      gpointer key, value;
+      gchar *full_dir;
+      gboolean matches;
+
+      if (dir->cache != NULL || dir->icons == NULL)
+        continue;
+
+      full_dir = g_build_filename (dir_mtime->dir, dir->subdir, NULL);
+      matches = strcmp (full_dir, dir->dir) == 0;
+      g_free (full_dir);
+
+      if (!matches)
+        continue;
+
+      flags = g_hash_table_new (g_str_hash, g_str_equal);
+      g_hash_table_iter_init (&iter, dir->icons);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          IconSuffix suffix = GPOINTER_TO_UINT (value);
+
+          if (dir->icon_data && g_hash_table_lookup (dir->icon_data, key))
+            suffix |= HAS_ICON_FILE;
+
+          g_hash_table_insert (flags, key, GUINT_TO_POINTER (suffix));
+        }
+
+      g_ptr_array_add (subdirs, dir->subdir);
+      g_ptr_array_add (icons, flags);
+    }
+
+  if (subdirs->len > 0)
+    _gtk_icon_cache_write_index (dir_mtime->dir,
+                                 (const gchar **)subdirs->pdata,
+                                 (GHashTable **)icons->pdata,
+                                 subdirs->len,
+                                 scan_start);
+
+  g_ptr_array_free (icons, TRUE);
+  g_ptr_array_free (subdirs, TRUE);
+}
+
 static void
 insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 {
@@ -893,6 +957,8 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
   GKeyFile *theme_file;
   GError *error = NULL;
   IconThemeDirMtime *dir_mtime;
+  GList *theme_mtimes;
+  time_t scan_start;
   struct stat stat_buf;
   
   priv = icon_theme->priv;
@@ -904,6 +970,7 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 	return;
     }
   
+  theme_mtimes = NULL;
   for (i = 0; i < priv->search_path_len; i++)
     {
       path = g_build_filename (priv->search_path[i],
@@ -918,8 +985,10 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 	dir_mtime->mtime = 0;
 
       priv->dir_mtimes = g_list_prepend (priv->dir_mtimes, dir_mtime);
+      theme_mtimes = g_list_prepend (theme_mtimes, dir_mtime);
     }
   priv->dir_mtimes = g_list_reverse (priv->dir_mtimes);
+  theme_mtimes = g_list_reverse (theme_mtimes);
 
   theme_file = NULL;
   for (i = 0; i < priv->search_path_len && !theme_file; i++)
@@ -952,7 +1021,10 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
     }
 
   if (theme_file == NULL)
-    return;
+    {
+      g_list_free (theme_mtimes);
+      return;
+    }
 
   theme->display_name = 
     g_key_file_get_locale_string (theme_file, "Icon Theme", "Name", NULL, NULL);
@@ -968,6 +1040,7 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
       g_free (theme->display_name);
       g_free (theme);
       g_key_file_free (theme_file);
+      g_list_free (theme_mtimes);
       return;
     }
   
@@ -980,6 +1053,23 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 			   "Icon Theme", "Example",
 			   NULL);
 
+  /* Without an icon-theme.cache, fall back to the index we wrote
+   * the last time the directory was scanned.
+   */
+  for (l = theme_mtimes; l != NULL; l = l->next)
+    {
+      dir_mtime = l->data;
+
+      if (dir_mtime->mtime == 0)
+        continue;
+
+      dir_mtime->cache = _gtk_icon_cache_new_for_path (dir_mtime->dir);
+      if (dir_mtime->cache == NULL)
+        dir_mtime->cache = _gtk_icon_cache_new_for_index (dir_mtime->dir, dirs);
+    }
+
+  scan_start = time (NULL);
+
   theme->dirs = NULL;
   for (i = 0; dirs[i] != NULL; i++)
     theme_subdir_load (icon_theme, theme, theme_file, dirs[i]);
@@ -988,6 +1078,15 @@ insert_theme (GtkIconTheme *icon_theme, const char *theme_name)
 
   theme->dirs = g_list_reverse (theme->dirs);
 
+  for (l = theme_mtimes; l != NULL; l = l->next)
+    {
+      dir_mtime = l->data;
+
+      if (dir_mtime->mtime != 0 && dir_mtime->cache == NULL)
+        write_theme_index (theme, dir_mtime, scan_start);
+    }
+  g_list_free (theme_mtimes);
+
   themes = g_key_file_get_string_list (theme_file,
 				       "Icon Theme",
 				       "Inherits",
@@ -2725,6 +2824,170 @@ gtk_icon_info_get_builtin_pixbuf (GtkIconInfo *icon_info)
 
 static gboolean icon_info_ensure_scale_and_pixbuf (GtkIconInfo*, gboolean);
 
+/* Scaled pixbufs are kept in a small LRU cache shared by all icon
+ * infos, so that looking up the same icon again, or loading it from
+ * several places at once, only decodes the file once. The cache is
+ * bounded by the pixel data it holds as well as by the number of
+ * pixbufs, and pixbufs that would take a large share of it on their
+ * own are not cached at all.
+ */
+#define MAX_CACHED_PIXBUFS 256
+#define MAX_CACHED_PIXBUF_BYTES (8 * 1024 * 1024)
+#define MAX_CACHED_PIXBUF_SIZE (MAX_CACHED_PIXBUF_BYTES / 8)
+
+typedef struct
+{
+  gchar *key;
+  GdkPixbuf *pixbuf;
+  gdouble scale;
+  gsize size;
+  GList link;
+} PixbufCacheEntry;
+
+G_LOCK_DEFINE_STATIC (pixbuf_cache);
+static GHashTable *pixbuf_cache = NULL;
+static GQueue pixbuf_cache_lru = G_QUEUE_INIT;
+static gsize pixbuf_cache_bytes = 0;
+
+static gsize
+pixbuf_get_byte_size (GdkPixbuf *pixbuf)
+{
+  return (gsize) gdk_pixbuf_get_rowstride (pixbuf) * gdk_pixbuf_get_height (pixbuf);
+}
+
+static void
+pixbuf_cache_entry_free (PixbufCacheEntry *entry)
+{
+  g_free (entry->key);
+  g_object_unref (entry->pixbuf);
+  g_slice_free (PixbufCacheEntry, entry);
+}
+
+static gchar *
+icon_info_get_cache_key (GtkIconInfo *icon_info)
+{
+  /* Icons that don't come from a file have nothing to share */
+  if (icon_info->filename == NULL)
+    return NULL;
+
+  return g_strdup_printf ("%s:%d:%d:%d:%d:%d",
+                          icon_info->filename,
+                          icon_info->desired_size,
+                          icon_info->forced_size,
+                          icon_info->dir_type,
+                          icon_info->dir_size,
+                          icon_info->threshold);
+}
+
+static gboolean
+pixbuf_cache_lookup (const gchar  *key,
+                     GdkPixbuf   **pixbuf,
+                     gdouble      *scale)
+{
+  PixbufCacheEntry *entry = NULL;
+
+  G_LOCK (pixbuf_cache);
+
+  if (pixbuf_cache)
+    entry = g_hash_table_lookup (pixbuf_cache, key);
+
+  if (entry)
+    {
+      g_queue_unlink (&pixbuf_cache_lru, &entry->link);
+      g_queue_push_head_link (&pixbuf_cache_lru, &entry->link);
+
+      *pixbuf = g_object_ref (entry->pixbuf);
+      if (scale)
+        *scale = entry->scale;
+    }
+
+  G_UNLOCK (pixbuf_cache);
+
+  return entry != NULL;
+}
+
+static void
+pixbuf_cache_insert (const gchar *key,
+                     GdkPixbuf   *pixbuf,
+                     gdouble      scale)
+{
+  PixbufCacheEntry *entry;
+  gsize size;
+
+  size = pixbuf_get_byte_size (pixbuf);
+
+  G_LOCK (pixbuf_cache);
+
+  if (pixbuf_cache == NULL)
+    pixbuf_cache = g_hash_table_new (g_str_hash, g_str_equal);
+
+  entry = g_hash_table_lookup (pixbuf_cache, key);
+  if (entry)
+    {
+      g_queue_unlink (&pixbuf_cache_lru, &entry->link);
+      pixbuf_cache_bytes -= entry->size;
+
+      if (size > MAX_CACHED_PIXBUF_SIZE)
+        {
+          g_hash_table_remove (pixbuf_cache, entry->key);
+          pixbuf_cache_entry_free (entry);
+          G_UNLOCK (pixbuf_cache);
+          return;
+        }
+
+      g_object_unref (entry->pixbuf);
+    }
+  else
+    {
+      if (size > MAX_CACHED_PIXBUF_SIZE)
+        {
+          G_UNLOCK (pixbuf_cache);
+          return;
+        }
+
+      entry = g_slice_new0 (PixbufCacheEntry);
+      entry->key = g_strdup (key);
+      entry->link.data = entry;
+      g_hash_table_insert (pixbuf_cache, entry->key, entry);
+    }
+
+  entry->pixbuf = g_object_ref (pixbuf);
+  entry->scale = scale;
+  entry->size = size;
+  pixbuf_cache_bytes += size;
+  g_queue_push_head_link (&pixbuf_cache_lru, &entry->link);
+
+  while (pixbuf_cache_lru.length > MAX_CACHED_PIXBUFS ||
+         pixbuf_cache_bytes > MAX_CACHED_PIXBUF_BYTES)
+    {
+      GList *last = g_queue_pop_tail_link (&pixbuf_cache_lru);
+
+      entry = last->data;
+      pixbuf_cache_bytes -= entry->size;
+      g_hash_table_remove (pixbuf_cache, entry->key);
+      pixbuf_cache_entry_free (entry);
+    }
+
+  G_UNLOCK (pixbuf_cache);
+}
+
+static void
+pixbuf_cache_clear (void)
+{
+  GList *link;
+
+  G_LOCK (pixbuf_cache);
+
+  if (pixbuf_cache)
+    g_hash_table_remove_all (pixbuf_cache);
+
+  while ((link = g_queue_pop_head_link (&pixbuf_cache_lru)) != NULL)
+    pixbuf_cache_entry_free (link->data);
+  pixbuf_cache_bytes = 0;
+
+  G_UNLOCK (pixbuf_cache);
+}
+
 /* Combine the icon with all emblems, the first emblem is placed 
  * in the southeast corner. Scale emblems to be at most 3/4 of the
  * size of the icon itself.
@@ -2810,31 +3073,17 @@ apply_emblems (GtkIconInfo *info)
 
 /* This function contains the complicated logic for deciding
  * on the size at which to load the icon and loading it at
- * that size.
+ * that size. It does not touch any shared state, so it can
+ * be run on a private copy of the icon info in a thread.
  */
 static gboolean
-icon_info_ensure_scale_and_pixbuf (GtkIconInfo  *icon_info,
-				   gboolean      scale_only)
+icon_info_load_pixbuf (GtkIconInfo  *icon_info,
+                       gboolean      scale_only)
 {
   int image_width, image_height;
   GdkPixbuf *source_pixbuf;
   gboolean is_svg;
 
-  /* First check if we already succeeded have the necessary
-   * information (or failed earlier)
-   */
-  if (scale_only && icon_info->scale >= 0)
-    return TRUE;
-
-  if (icon_info->pixbuf)
-    {
-      apply_emblems (icon_info);
-      return TRUE;
-    }
-
-  if (icon_info->load_error)
-    return FALSE;
-
   /* SVG icons are a special case - we just immediately scale them
    * to the desired size
    */
@@ -2894,12 +3143,7 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo  *icon_info,
           g_object_unref (stream);
         }
 
-      if (!icon_info->pixbuf)
-        return FALSE;
-
-      apply_emblems (icon_info);
-        
-      return TRUE;
+      return icon_info->pixbuf != NULL;
     }
 
   /* In many cases, the scale can be determined without actual access
@@ -2990,7 +3234,54 @@ icon_info_ensure_scale_and_pixbuf (GtkIconInfo  *icon_info,
       g_object_unref (source_pixbuf);
     }
 
-  apply_emblems (icon_info);
+  return TRUE;
+}
+
+static gboolean
+icon_info_ensure_scale_and_pixbuf (GtkIconInfo  *icon_info,
+				   gboolean      scale_only)
+{
+  gchar *key;
+
+  /* First check if we already succeeded have the necessary
+   * information (or failed earlier)
+   */
+  if (scale_only && icon_info->scale >= 0)
+    return TRUE;
+
+  if (icon_info->pixbuf)
+    {
+      apply_emblems (icon_info);
+      return TRUE;
+    }
+
+  if (icon_info->load_error)
+    return FALSE;
+
+  key = icon_info_get_cache_key (icon_info);
+
+  if (!scale_only && key &&
+      pixbuf_cache_lookup (key, &icon_info->pixbuf, &icon_info->scale))
+    {
+      g_free (key);
+      apply_emblems (icon_info);
+      return TRUE;
+    }
+
+  if (!icon_info_load_pixbuf (icon_info, scale_only))
+    {
+      g_free (key);
+      return FALSE;
+    }
+
+  if (icon_info->pixbuf)
+    {
+      if (key)
+        pixbuf_cache_insert (key, icon_info->pixbuf, icon_info->scale);
+      apply_emblems (icon_info);
+    }
+
+  g_free (key);
 
   return TRUE;
 }
@@ -3043,6 +3334,273 @@ gtk_icon_info_load_icon (GtkIconInfo *icon_info,
   return g_object_ref (icon_info->pixbuf);
 }
 
+#define N_LOAD_THREADS 4
+
+/* One decode in flight, shared by everyone asking for the same
+ * icon at the same size while it runs.
+ */
+typedef struct
+{
+  gchar *key;
+  GtkIconInfo *info;
+  GSList *waiters;
+} IconLoad;
+
+typedef struct
+{
+  GSimpleAsyncResult *result;
+  GCancellable *cancellable;
+} IconLoadWaiter;
+
+typedef struct
+{
+  GdkPixbuf *pixbuf;
+  gdouble scale;
+} IconLoadResult;
+
+G_LOCK_DEFINE_STATIC (icon_loads);
+static GHashTable *icon_loads = NULL;
+static GThreadPool *icon_load_pool = NULL;
+
+static void
+icon_load_result_free (IconLoadResult *result)
+{
+  g_object_unref (result->pixbuf);
+  g_slice_free (IconLoadResult, result);
+}
+
+static void
+icon_load_waiter_complete (IconLoadWaiter *waiter,
+                           GdkPixbuf      *pixbuf,
+                           gdouble         scale,
+                           const GError   *error)
+{
+  GError *cancelled = NULL;
+
+  if (g_cancellable_set_error_if_cancelled (waiter->cancellable, &cancelled))
+    {
+      g_simple_async_result_set_from_error (waiter->result, cancelled);
+      g_error_free (cancelled);
+    }
+  else if (pixbuf)
+    {
+      IconLoadResult *result;
+
+      result = g_slice_new (IconLoadResult);
+      result->pixbuf = g_object_ref (pixbuf);
+      result->scale = scale;
+      g_simple_async_result_set_op_res_gpointer (waiter->result, result,
+                                                 (GDestroyNotify) icon_load_result_free);
+    }
+  else if (error)
+    g_simple_async_result_set_from_error (waiter->result, error);
+  else
+    g_simple_async_result_set_error (waiter->result,
+                                     GTK_ICON_THEME_ERROR,
+                                     GTK_ICON_THEME_NOT_FOUND,
+                                     _("Failed to load icon"));
+
+  g_simple_async_result_complete_in_idle (waiter->result);
+
+  g_object_unref (waiter->result);
+  if (waiter->cancellable)
+    g_object_unref (waiter->cancellable);
+  g_slice_free (IconLoadWaiter, waiter);
+}
+
+/* Copies what icon_info_load_pixbuf() needs, so that the loader
+ * thread never shares an icon info with the caller.
+ */
+static GtkIconInfo *
+icon_info_dup_for_load (GtkIconInfo *icon_info)
+{
+  GtkIconInfo *dup;
+
+  dup = icon_info_new ();
+  dup->filename = g_strdup (icon_info->filename);
+  if (icon_info->loadable)
+    dup->loadable = g_object_ref (icon_info->loadable);
+  if (icon_info->cache_pixbuf)
+    dup->cache_pixbuf = g_object_ref (icon_info->cache_pixbuf);
+  dup->dir_type = icon_info->dir_type;
+  dup->dir_size = icon_info->dir_size;
+  dup->threshold = icon_info->threshold;
+  dup->desired_size = icon_info->desired_size;
+  dup->forced_size = icon_info->forced_size;
+
+  return dup;
+}
+
+static void
+icon_load_thread (gpointer data,
+                  gpointer user_data)
+{
+  IconLoad *load = data;
+  GtkIconInfo *info = load->info;
+  GSList *waiters, *l;
+
+  icon_info_load_pixbuf (info, FALSE);
+
+  /* Publish the pixbuf before retiring the load, so that
+   * nobody starts decoding the same file again in between
+   */
+  if (info->pixbuf)
+    pixbuf_cache_insert (load->key, info->pixbuf, info->scale);
+
+  G_LOCK (icon_loads);
+  g_hash_table_remove (icon_loads, load->key);
+  waiters = load->waiters;
+  G_UNLOCK (icon_loads);
+
+  for (l = waiters; l; l = l->next)
+    icon_load_waiter_complete (l->data, info->pixbuf, info->scale, info->load_error);
+  g_slist_free (waiters);
+
+  g_clear_error (&info->load_error);
+  gtk_icon_info_free (info);
+  g_free (load->key);
+  g_slice_free (IconLoad, load);
+}
+
+/**
+ * gtk_icon_info_load_icon_async:
+ * @icon_info: a #GtkIconInfo structure from gtk_icon_theme_lookup_icon()
+ * @cancellable: (allow-none): optional #GCancellable object,
+ *     %NULL to ignore
+ * @callback: (scope async): a #GAsyncReadyCallback to call when the
+ *     request is satisfied
+ * @user_data: (closure): the data to pass to callback function
+ *
+ * Asynchronously load, render and scale an icon previously looked up
+ * from the icon theme using gtk_icon_theme_lookup_icon().
+ *
+ * The icon file is decoded and scaled in a thread. Requests for the
+ * same icon at the same size share a single decode, and the result is
+ * kept in a cache that gtk_icon_info_load_icon() uses as well.
+ *
+ * For more details, see gtk_icon_info_load_icon() which is the
+ * synchronous version of this call.
+ *
+ * Since: 3.2
+ **/
+void
+gtk_icon_info_load_icon_async (GtkIconInfo         *icon_info,
+                               GCancellable        *cancellable,
+                               GAsyncReadyCallback  callback,
+                               gpointer             user_data)
+{
+  IconLoadWaiter *waiter;
+  IconLoad *load;
+  GdkPixbuf *pixbuf;
+  gdouble scale;
+  gchar *key;
+
+  g_return_if_fail (icon_info != NULL);
+  g_return_if_fail (cancellable == NULL || G_IS_CANCELLABLE (cancellable));
+
+  waiter = g_slice_new (IconLoadWaiter);
+  waiter->result = g_simple_async_result_new (NULL, callback, user_data,
+                                              gtk_icon_info_load_icon_async);
+  waiter->cancellable = cancellable ? g_object_ref (cancellable) : NULL;
+
+  key = icon_info_get_cache_key (icon_info);
+
+  /* Already done, or nothing that can be handed to a thread */
+  if (icon_info->pixbuf || icon_info->load_error || key == NULL ||
+      !g_thread_supported () || g_cancellable_is_cancelled (cancellable))
+    {
+      if (g_cancellable_is_cancelled (cancellable))
+        icon_load_waiter_complete (waiter, NULL, 0, NULL);
+      else if (icon_info_ensure_scale_and_pixbuf (icon_info, FALSE))
+        icon_load_waiter_complete (waiter, icon_info->pixbuf, icon_info->scale, NULL);
+      else
+        icon_load_waiter_complete (waiter, NULL, 0, icon_info->load_error);
+
+      g_free (key);
+      return;
+    }
+
+  if (pixbuf_cache_lookup (key, &pixbuf, &scale))
+    {
+      icon_load_waiter_complete (waiter, pixbuf, scale, NULL);
+      g_object_unref (pixbuf);
+      g_free (key);
+      return;
+    }
+
+  G_LOCK (icon_loads);
+
+  if (icon_loads == NULL)
+    icon_loads = g_hash_table_new (g_str_hash, g_str_equal);
+
+  load = g_hash_table_lookup (icon_loads, key);
+  if (load)
+    {
+      load->waiters = g_slist_prepend (load->waiters, waiter);
+      G_UNLOCK (icon_loads);
+      g_free (key);
+      return;
+    }
+
+  load = g_slice_new (IconLoad);
+  load->key = key;
+  load->info = icon_info_dup_for_load (icon_info);
+  load->waiters = g_slist_prepend (NULL, waiter);
+  g_hash_table_insert (icon_loads, load->key, load);
+
+  if (icon_load_pool == NULL)
+    icon_load_pool = g_thread_pool_new (icon_load_thread, NULL,
+                                        N_LOAD_THREADS, FALSE, NULL);
+
+  G_UNLOCK (icon_loads);
+
+  g_thread_pool_push (icon_load_pool, load, NULL);
+}
+
+/**
+ * gtk_icon_info_load_icon_finish:
+ * @icon_info: a #GtkIconInfo structure from gtk_icon_theme_lookup_icon()
+ * @result: a #GAsyncResult
+ * @error: (allow-none): location to store error information on failure,
+ *     or %NULL.
+ *
+ * Finishes an async icon load, see gtk_icon_info_load_icon_async().
+ *
+ * Return value: (transfer full): the rendered icon; this may be a newly
+ *     created icon or a new reference to an internal icon, so you must
+ *     not modify the icon. Use g_object_unref() to release your reference
+ *     to the icon.
+ *
+ * Since: 3.2
+ **/
+GdkPixbuf *
+gtk_icon_info_load_icon_finish (GtkIconInfo   *icon_info,
+                                GAsyncResult  *result,
+                                GError       **error)
+{
+  GSimpleAsyncResult *simple;
+  IconLoadResult *load_result;
+
+  g_return_val_if_fail (icon_info != NULL, NULL);
+  g_return_val_if_fail (g_simple_async_result_is_valid (result, NULL, gtk_icon_info_load_icon_async), NULL);
+
+  simple = G_SIMPLE_ASYNC_RESULT (result);
+
+  if (g_simple_async_result_propagate_error (simple, error))
+    return NULL;
+
+  load_result = g_simple_async_result_get_op_res_gpointer (simple);
+
+  if (icon_info->pixbuf == NULL)
+    {
+      icon_info->pixbuf = g_object_ref (load_result->pixbuf);
+      icon_info->scale = load_result->scale;
+    }
+
+  /* Takes care of the emblems */
+  return gtk_icon_info_load_icon (icon_info, error);
+}
+
 static gchar *
 gdk_color_to_css (GdkColor *color)
 {
@@ -3071,14 +3629,34 @@ _gtk_icon_info_load_symbolic_internal (GtkIconInfo  *icon_info,
                                        GError      **error)
 {
   GInputStream *stream;
-  GdkPixbuf *pixbuf;
+  GdkPixbuf *pixbuf, *cached;
   gchar *data;
   gchar *success, *warning, *err;
+  gchar *key;
 
   /* css_fg can't possibly have failed, otherwise
    * that would mean we have a broken style */
   g_return_val_if_fail (css_fg != NULL, NULL);
 
+  key = g_strdup_printf ("%s:%d:symbolic:%s:%s:%s:%s",
+                         icon_info->filename,
+                         icon_info->desired_size,
+                         css_fg,
+                         css_success ? css_success : "",
+                         css_warning ? css_warning : "",
+                         css_error ? css_error : "");
+
+  /* The symbolic functions have always handed out a pixbuf
+   * of its own, which callers are free to modify.
+   */
+  if (pixbuf_cache_lookup (key, &cached, NULL))
+    {
+      g_free (key);
+      pixbuf = gdk_pixbuf_copy (cached);
+      g_object_unref (cached);
+      return pixbuf;
+    }
+
   success = warning = err = NULL;
 
   if (!css_success)
@@ -3134,6 +3712,17 @@ _gtk_icon_info_load_symbolic_internal (GtkIconInfo  *icon_info,
                                                 error);
   g_object_unref (stream);
 
+  if (pixbuf)
+    {
+      cached = gdk_pixbuf_copy (pixbuf);
+      if (cached)
+        {
+          pixbuf_cache_insert (key, cached, 1.0);
+          g_object_unref (cached);
+        }
+    }
+  g_free (key);
+
   return pixbuf;
 }
 
@@ -178,6 +178,13 @@ G_CONST_RETURN gchar *gtk_icon_info_get_filename       (GtkIconInfo   *icon_info
 GdkPixbuf *           gtk_icon_info_get_builtin_pixbuf (GtkIconInfo   *icon_info);
 GdkPixbuf *           gtk_icon_info_load_icon          (GtkIconInfo   *icon_info,
 							GError       **error);
+void                  gtk_icon_info_load_icon_async    (GtkIconInfo          *icon_info,
+                                                        GCancellable         *cancellable,
+                                                        GAsyncReadyCallback   callback,
+                                                        gpointer              user_data);
+GdkPixbuf *           gtk_icon_info_load_icon_finish   (GtkIconInfo          *icon_info,
+                                                        GAsyncResult         *result,
+                                                        GError              **error);
 GdkPixbuf *           gtk_icon_info_load_symbolic      (GtkIconInfo   *icon_info,
                                                         GdkRGBA       *fg,
                                                         GdkRGBA       *success_color,
@@ -1774,7 +1774,18 @@ gtk_image_draw (GtkWidget *widget,
               pixbuf = rendered;
             }
 
-          gdk_cairo_set_source_pixbuf (cr, pixbuf, x, y);
+          /* Pixbufs set by the application, and animation frames,
+           * may be changed in place, and state transformed pixbufs
+           * are only drawn once, so they are converted every time.
+           * The others are owned by GTK+ and get reused, so keep
+           * their surface around.
+           */
+          if (needs_state_transform ||
+              priv->storage_type == GTK_IMAGE_PIXBUF ||
+              priv->storage_type == GTK_IMAGE_ANIMATION)
+            gdk_cairo_set_source_pixbuf (cr, pixbuf, x, y);
+          else
+            cairo_set_source_surface (cr, gdk_pixbuf_get_cairo_surface (pixbuf), x, y);
           cairo_paint (cr);
 
           g_object_unref (pixbuf);
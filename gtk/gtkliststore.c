@@ -23,6 +23,7 @@
 #include <string.h>
 #include <gobject/gvaluecollector.h>
 #include "gtktreemodel.h"
+#include "gtktreemodelprivate.h"
 #include "gtkliststore.h"
 #include "gtktreedatalist.h"
 #include "gtktreednd.h"
@@ -2174,6 +2175,112 @@ gtk_list_store_insert_with_valuesv (GtkListStore *list_store,
   gtk_tree_path_free (path);
 }
 
+/**
+ * gtk_list_store_insert_rows_with_valuesv:
+ * @list_store: A #GtkListStore
+ * @position: position to insert the new rows
+ * @n_rows: the number of rows to insert
+ * @columns: (array length=n_values): an array of column numbers
+ * @values: (array): an array of @n_rows * @n_values GValues, the
+ *     values of the first row, followed by those of the second row,
+ *     and so on
+ * @n_values: the length of the @columns array
+ *
+ * Inserts @n_rows new rows at @position, setting the values of
+ * @columns in each row. If @position is -1 or larger than the
+ * number of rows in the list, the rows are appended to the list.
+ *
+ * This is more efficient than calling gtk_list_store_insert_with_valuesv()
+ * for each row. If the list is not sorted and the only thing watching
+ * it for inserted rows is a #GtkTreeView, no #GtkTreeModel::row-inserted
+ * signals are emitted; the view is told about all the rows at once
+ * instead. If nothing is watching at all, no signals are emitted either.
+ * Otherwise, #GtkTreeModel::row-inserted is emitted for every row.
+ *
+ * Since: 3.2
+ */
+void
+gtk_list_store_insert_rows_with_valuesv (GtkListStore *list_store,
+                                         gint          position,
+                                         gint          n_rows,
+                                         gint         *columns,
+                                         GValue       *values,
+                                         gint          n_values)
+{
+  GtkListStorePrivate *priv;
+  GSequenceIter *ptr = NULL;
+  GtkTreeIter iter;
+  gboolean batched;
+  gboolean emit_signals;
+  gint i;
+
+  g_return_if_fail (GTK_IS_LIST_STORE (list_store));
+  g_return_if_fail (n_rows >= 0);
+
+  priv = list_store->priv;
+
+  if (n_rows == 0)
+    return;
+
+  priv->columns_dirty = TRUE;
+
+  if (position < 0 || position > priv->length)
+    position = priv->length;
+
+  /* Sorted rows don't end up next to each other, so they
+   * can't be announced as a range.
+   */
+  batched = !GTK_LIST_STORE_IS_SORTED (list_store) &&
+            _gtk_tree_model_begin_rows_inserted (GTK_TREE_MODEL (list_store));
+  emit_signals = !batched &&
+                 _gtk_tree_model_has_row_inserted_listeners (GTK_TREE_MODEL (list_store));
+
+  /* When nobody is watching, the row at @position stays in place,
+   * and all rows can be inserted in front of it.
+   */
+  if (!emit_signals)
+    ptr = g_sequence_get_iter_at_pos (priv->seq, position);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      gboolean changed = FALSE;
+      gboolean maybe_need_sort = FALSE;
+
+      /* Signal handlers may have changed the list */
+      if (emit_signals)
+        ptr = g_sequence_get_iter_at_pos (priv->seq,
+                                          MIN (position + i, priv->length));
+
+      iter.stamp = priv->stamp;
+      iter.user_data = g_sequence_insert_before (ptr, NULL);
+
+      priv->length++;
+
+      gtk_list_store_set_vector_internal (list_store, &iter,
+                                          &changed, &maybe_need_sort,
+                                          columns, values + i * n_values,
+                                          n_values);
+
+      if (maybe_need_sort && GTK_LIST_STORE_IS_SORTED (list_store))
+        g_sequence_sort_changed_iter (iter.user_data,
+                                      gtk_list_store_compare_func,
+                                      list_store);
+
+      if (emit_signals)
+        {
+          GtkTreePath *path;
+
+          path = gtk_list_store_get_path (GTK_TREE_MODEL (list_store), &iter);
+          gtk_tree_model_row_inserted (GTK_TREE_MODEL (list_store), path, &iter);
+          gtk_tree_path_free (path);
+        }
+    }
+
+  if (batched)
+    _gtk_tree_model_end_rows_inserted (GTK_TREE_MODEL (list_store),
+                                       position, n_rows);
+}
+
 /* GtkBuildable custom tag implementation
  *
  * <columns>
@@ -25,6 +25,8 @@
 
 #include "config.h"
 #include <pango/pangocairo.h>
+#include <gdk/gdk.h>
+#include "gtkpango.h"
 #include "gtkintl.h"
 
 #define GTK_TYPE_FILL_LAYOUT_RENDERER            (_gtk_fill_layout_renderer_get_type())
@@ -231,3 +233,397 @@ _gtk_pango_fill_layout (cairo_t     *cr,
     cairo_move_to (cr, current_x, current_y);
 }
 
+
+
+/* Measuring layouts in worker threads
+ *
+ * The text of a #PangoLayout is copied together with everything
+ * that influences its size, and the copy is laid out in a worker
+ * thread. The default pango font map must only be used from one
+ * thread, so each worker gets its own font map, the same way the
+ * threaded page drawing of GtkPrintOperation does.
+ */
+
+#define N_MEASURE_THREADS 4
+#define MEASURE_CHUNK_SIZE 64
+
+typedef struct _MeasureItem MeasureItem;
+typedef struct _MeasureChunk MeasureChunk;
+
+struct _MeasureItem
+{
+  gpointer item;
+
+  gchar *text;
+  PangoAttrList *attrs;
+  PangoFontDescription *font_desc;
+  PangoTabArray *tabs;
+  PangoDirection base_dir;
+  gint width;
+  gint indent;
+  gint spacing;
+  PangoWrapMode wrap;
+  PangoEllipsizeMode ellipsize;
+  PangoAlignment alignment;
+  guint justify          : 1;
+  guint auto_dir         : 1;
+  guint single_paragraph : 1;
+
+  PangoRectangle logical_rect;
+};
+
+struct _GtkPangoMeasure
+{
+  /* Settings of the context the layouts were created for */
+  PangoFontDescription *font_desc;
+  PangoLanguage *language;
+  PangoGravity base_gravity;
+  PangoGravityHint gravity_hint;
+  PangoMatrix *matrix;
+  gdouble resolution;
+  cairo_font_options_t *font_options;
+
+  GArray *items;
+
+  GtkPangoMeasureFunc func;
+  gpointer data;
+
+  gint pending_chunks;
+  volatile gint cancelled;
+  guint started : 1;
+};
+
+struct _MeasureChunk
+{
+  GtkPangoMeasure *measure;
+  guint start;
+  guint end;
+};
+
+static GThreadPool *measure_pool = NULL;
+static GPrivate *measure_fontmap_key = NULL;
+
+/**
+ * _gtk_pango_measure_supported:
+ * @context: a #PangoContext
+ *
+ * Checks whether layouts created for @context can be measured
+ * in worker threads. This is only the case for contexts using
+ * the default pango cairo font map, since the worker threads
+ * need to create font maps giving the same results.
+ *
+ * Returns: %TRUE if a #GtkPangoMeasure can be used for @context
+ */
+gboolean
+_gtk_pango_measure_supported (PangoContext *context)
+{
+  return g_thread_supported () &&
+         pango_context_get_font_map (context) == pango_cairo_font_map_get_default ();
+}
+
+/**
+ * _gtk_pango_measure_new:
+ * @context: the #PangoContext of the layouts that will be measured
+ * @func: function to call in the main thread once all layouts
+ *     have been measured
+ * @data: data to pass to @func
+ *
+ * Creates a batch of layouts to measure in worker threads. Add
+ * layouts with _gtk_pango_measure_add() and hand the batch over
+ * to the worker threads with _gtk_pango_measure_start().
+ *
+ * Returns: a new #GtkPangoMeasure
+ */
+GtkPangoMeasure *
+_gtk_pango_measure_new (PangoContext        *context,
+                        GtkPangoMeasureFunc  func,
+                        gpointer             data)
+{
+  GtkPangoMeasure *measure;
+  const cairo_font_options_t *font_options;
+  const PangoMatrix *matrix;
+
+  g_return_val_if_fail (_gtk_pango_measure_supported (context), NULL);
+
+  measure = g_slice_new0 (GtkPangoMeasure);
+
+  measure->font_desc = pango_font_description_copy (pango_context_get_font_description (context));
+  measure->language = pango_context_get_language (context);
+  measure->base_gravity = pango_context_get_base_gravity (context);
+  measure->gravity_hint = pango_context_get_gravity_hint (context);
+  matrix = pango_context_get_matrix (context);
+  measure->matrix = matrix ? pango_matrix_copy (matrix) : NULL;
+  measure->resolution = pango_cairo_context_get_resolution (context);
+  font_options = pango_cairo_context_get_font_options (context);
+  measure->font_options = font_options ? cairo_font_options_copy (font_options) : NULL;
+
+  measure->items = g_array_new (FALSE, TRUE, sizeof (MeasureItem));
+  measure->func = func;
+  measure->data = data;
+
+  return measure;
+}
+
+static void
+gtk_pango_measure_free (GtkPangoMeasure *measure)
+{
+  guint i;
+
+  for (i = 0; i < measure->items->len; i++)
+    {
+      MeasureItem *item = &g_array_index (measure->items, MeasureItem, i);
+
+      g_free (item->text);
+      if (item->attrs)
+        pango_attr_list_unref (item->attrs);
+      if (item->font_desc)
+        pango_font_description_free (item->font_desc);
+      if (item->tabs)
+        pango_tab_array_free (item->tabs);
+    }
+  g_array_free (measure->items, TRUE);
+
+  if (measure->font_desc)
+    pango_font_description_free (measure->font_desc);
+  if (measure->matrix)
+    pango_matrix_free (measure->matrix);
+  if (measure->font_options)
+    cairo_font_options_destroy (measure->font_options);
+
+  g_slice_free (GtkPangoMeasure, measure);
+}
+
+/**
+ * _gtk_pango_measure_add:
+ * @measure: a #GtkPangoMeasure that has not been started
+ * @layout: a #PangoLayout created for the context of @measure
+ * @item: data identifying @layout, for the caller
+ *
+ * Adds the text, attributes and paragraph settings of @layout to
+ * the layouts to measure. @layout itself is not used afterwards,
+ * so this is cheap as long as @layout hasn't been laid out yet.
+ */
+void
+_gtk_pango_measure_add (GtkPangoMeasure *measure,
+                        PangoLayout     *layout,
+                        gpointer         item)
+{
+  MeasureItem *mi;
+  const PangoFontDescription *font_desc;
+  PangoAttrList *attrs;
+
+  g_return_if_fail (!measure->started);
+
+  g_array_set_size (measure->items, measure->items->len + 1);
+  mi = &g_array_index (measure->items, MeasureItem, measure->items->len - 1);
+
+  mi->item = item;
+  mi->text = g_strdup (pango_layout_get_text (layout));
+  attrs = pango_layout_get_attributes (layout);
+  mi->attrs = attrs ? pango_attr_list_copy (attrs) : NULL;
+  font_desc = pango_layout_get_font_description (layout);
+  mi->font_desc = font_desc ? pango_font_description_copy (font_desc) : NULL;
+  mi->tabs = pango_layout_get_tabs (layout);
+  mi->base_dir = pango_context_get_base_dir (pango_layout_get_context (layout));
+  mi->width = pango_layout_get_width (layout);
+  mi->indent = pango_layout_get_indent (layout);
+  mi->spacing = pango_layout_get_spacing (layout);
+  mi->wrap = pango_layout_get_wrap (layout);
+  mi->ellipsize = pango_layout_get_ellipsize (layout);
+  mi->alignment = pango_layout_get_alignment (layout);
+  mi->justify = pango_layout_get_justify (layout);
+  mi->auto_dir = pango_layout_get_auto_dir (layout);
+  mi->single_paragraph = pango_layout_get_single_paragraph_mode (layout);
+}
+
+/**
+ * _gtk_pango_measure_get_n_items:
+ * @measure: a #GtkPangoMeasure
+ *
+ * Returns: the number of layouts added to @measure
+ */
+guint
+_gtk_pango_measure_get_n_items (GtkPangoMeasure *measure)
+{
+  return measure->items->len;
+}
+
+/**
+ * _gtk_pango_measure_get_item:
+ * @measure: a #GtkPangoMeasure
+ * @i: index of a layout added to @measure
+ * @logical_rect: (out) (allow-none): return location for the
+ *     logical extents of the layout, as returned by
+ *     pango_layout_get_extents()
+ *
+ * Gets the data passed to _gtk_pango_measure_add() for the
+ * @i-th layout, and the result of measuring it. The result
+ * is only available in the function passed to
+ * _gtk_pango_measure_new().
+ *
+ * Returns: the data identifying the layout
+ */
+gpointer
+_gtk_pango_measure_get_item (GtkPangoMeasure *measure,
+                             guint            i,
+                             PangoRectangle  *logical_rect)
+{
+  MeasureItem *mi;
+
+  g_return_val_if_fail (i < measure->items->len, NULL);
+
+  mi = &g_array_index (measure->items, MeasureItem, i);
+
+  if (logical_rect)
+    *logical_rect = mi->logical_rect;
+
+  return mi->item;
+}
+
+static gboolean
+measure_done_idle (gpointer data)
+{
+  GtkPangoMeasure *measure = data;
+
+  if (measure->func)
+    measure->func (measure, measure->data);
+
+  gtk_pango_measure_free (measure);
+
+  return FALSE;
+}
+
+static void
+measure_thread (gpointer chunk_data,
+                gpointer user_data)
+{
+  MeasureChunk *chunk = chunk_data;
+  GtkPangoMeasure *measure = chunk->measure;
+  PangoFontMap *fontmap;
+  PangoContext *context;
+  guint i;
+
+  fontmap = g_private_get (measure_fontmap_key);
+  if (!fontmap)
+    {
+      fontmap = pango_cairo_font_map_new ();
+      g_private_set (measure_fontmap_key, fontmap);
+    }
+
+  context = pango_font_map_create_context (fontmap);
+  pango_context_set_font_description (context, measure->font_desc);
+  pango_context_set_language (context, measure->language);
+  pango_context_set_base_gravity (context, measure->base_gravity);
+  pango_context_set_gravity_hint (context, measure->gravity_hint);
+  pango_context_set_matrix (context, measure->matrix);
+  pango_cairo_context_set_resolution (context, measure->resolution);
+  pango_cairo_context_set_font_options (context, measure->font_options);
+
+  for (i = chunk->start;
+       i < chunk->end && !g_atomic_int_get (&measure->cancelled);
+       i++)
+    {
+      MeasureItem *mi = &g_array_index (measure->items, MeasureItem, i);
+      PangoLayout *layout;
+
+      pango_context_set_base_dir (context, mi->base_dir);
+
+      layout = pango_layout_new (context);
+      pango_layout_set_text (layout, mi->text, -1);
+      pango_layout_set_attributes (layout, mi->attrs);
+      pango_layout_set_font_description (layout, mi->font_desc);
+      pango_layout_set_tabs (layout, mi->tabs);
+      pango_layout_set_width (layout, mi->width);
+      pango_layout_set_indent (layout, mi->indent);
+      pango_layout_set_spacing (layout, mi->spacing);
+      pango_layout_set_wrap (layout, mi->wrap);
+      pango_layout_set_ellipsize (layout, mi->ellipsize);
+      pango_layout_set_alignment (layout, mi->alignment);
+      pango_layout_set_justify (layout, mi->justify);
+      pango_layout_set_auto_dir (layout, mi->auto_dir);
+      pango_layout_set_single_paragraph_mode (layout, mi->single_paragraph);
+
+      pango_layout_get_extents (layout, NULL, &mi->logical_rect);
+
+      g_object_unref (layout);
+    }
+
+  g_object_unref (context);
+
+  if (g_atomic_int_dec_and_test (&measure->pending_chunks))
+    gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                               measure_done_idle, measure, NULL);
+
+  g_slice_free (MeasureChunk, chunk);
+}
+
+/**
+ * _gtk_pango_measure_start:
+ * @measure: a #GtkPangoMeasure
+ *
+ * Hands the layouts added to @measure over to the worker threads.
+ * Once all of them have been measured, the function passed to
+ * _gtk_pango_measure_new() is called from the main loop, and
+ * @measure is freed when it returns.
+ */
+void
+_gtk_pango_measure_start (GtkPangoMeasure *measure)
+{
+  guint start;
+
+  g_return_if_fail (!measure->started);
+
+  measure->started = TRUE;
+
+  if (measure->items->len == 0)
+    {
+      gdk_threads_add_idle_full (G_PRIORITY_DEFAULT_IDLE,
+                                 measure_done_idle, measure, NULL);
+      return;
+    }
+
+  if (!measure_fontmap_key)
+    measure_fontmap_key = g_private_new (g_object_unref);
+
+  if (!measure_pool)
+    measure_pool = g_thread_pool_new (measure_thread, NULL,
+                                      N_MEASURE_THREADS, FALSE, NULL);
+
+  /* Count all chunks before pushing the first one,
+   * so that no worker finishes the batch early.
+   */
+  measure->pending_chunks = (measure->items->len + MEASURE_CHUNK_SIZE - 1) / MEASURE_CHUNK_SIZE;
+
+  for (start = 0; start < measure->items->len; start += MEASURE_CHUNK_SIZE)
+    {
+      MeasureChunk *chunk;
+
+      chunk = g_slice_new (MeasureChunk);
+      chunk->measure = measure;
+      chunk->start = start;
+      chunk->end = MIN (start + MEASURE_CHUNK_SIZE, measure->items->len);
+
+      g_thread_pool_push (measure_pool, chunk, NULL);
+    }
+}
+
+/**
+ * _gtk_pango_measure_cancel:
+ * @measure: a #GtkPangoMeasure
+ *
+ * Cancels measuring the layouts in @measure. The function passed
+ * to _gtk_pango_measure_new() will not be called, and @measure is
+ * freed as soon as the worker threads are done with it.
+ */
+void
+_gtk_pango_measure_cancel (GtkPangoMeasure *measure)
+{
+  if (!measure->started)
+    {
+      gtk_pango_measure_free (measure);
+      return;
+    }
+
+  measure->func = NULL;
+  g_atomic_int_set (&measure->cancelled, TRUE);
+}
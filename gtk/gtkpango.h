@@ -41,6 +41,25 @@ void
 _gtk_pango_fill_layout (cairo_t     *cr,
                         PangoLayout *layout);
 
+typedef struct _GtkPangoMeasure GtkPangoMeasure;
+
+typedef void (* GtkPangoMeasureFunc) (GtkPangoMeasure *measure,
+                                      gpointer         data);
+
+gboolean         _gtk_pango_measure_supported   (PangoContext        *context);
+GtkPangoMeasure *_gtk_pango_measure_new         (PangoContext        *context,
+                                                 GtkPangoMeasureFunc  func,
+                                                 gpointer             data);
+void             _gtk_pango_measure_add         (GtkPangoMeasure     *measure,
+                                                 PangoLayout         *layout,
+                                                 gpointer             item);
+guint            _gtk_pango_measure_get_n_items (GtkPangoMeasure     *measure);
+gpointer         _gtk_pango_measure_get_item    (GtkPangoMeasure     *measure,
+                                                 guint                i,
+                                                 PangoRectangle      *logical_rect);
+void             _gtk_pango_measure_start       (GtkPangoMeasure     *measure);
+void             _gtk_pango_measure_cancel      (GtkPangoMeasure     *measure);
+
 
 G_END_DECLS
 
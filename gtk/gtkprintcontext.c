@@ -37,6 +37,7 @@ struct _GtkPrintContext
   GtkPrintOperation *op;
   cairo_t *cr;
   GtkPageSetup *page_setup;
+  PangoFontMap *fontmap;
 
   gdouble surface_dpi_x;
   gdouble surface_dpi_y;
@@ -69,6 +70,9 @@ gtk_print_context_finalize (GObject *object)
 
   if (context->cr)
     cairo_destroy (context->cr);
+
+  if (context->fontmap)
+    g_object_unref (context->fontmap);
   
   G_OBJECT_CLASS (gtk_print_context_parent_class)->finalize (object);
 }
@@ -104,9 +108,31 @@ _gtk_print_context_new (GtkPrintOperation *op)
 static PangoFontMap *
 _gtk_print_context_get_fontmap (GtkPrintContext *context)
 {
+  if (context->fontmap)
+    return context->fontmap;
+
   return pango_cairo_font_map_get_default ();
 }
 
+/* Makes @context use @fontmap instead of the default font map,
+ * which must not be used from several threads.
+ */
+void
+_gtk_print_context_set_fontmap (GtkPrintContext *context,
+                                PangoFontMap    *fontmap)
+{
+  g_return_if_fail (GTK_IS_PRINT_CONTEXT (context));
+  g_return_if_fail (fontmap == NULL || PANGO_IS_CAIRO_FONT_MAP (fontmap));
+
+  if (fontmap)
+    g_object_ref (fontmap);
+
+  if (context->fontmap)
+    g_object_unref (context->fontmap);
+
+  context->fontmap = fontmap;
+}
+
 /**
  * gtk_print_context_set_cairo_context:
  * @context: a #GtkPrintContext
@@ -57,6 +57,7 @@ struct _GtkPrintOperationPrivate
   guint support_selection  : 1;
   guint has_selection      : 1;
   guint embed_page_setup   : 1;
+  guint threaded_drawing   : 1;
 
   GtkPageDrawingState      page_drawing_state;
 
@@ -145,6 +146,8 @@ void             _gtk_print_context_set_hard_margins                (GtkPrintCon
 								     gdouble            bottom,
 								     gdouble            left,
 								     gdouble            right);
+void             _gtk_print_context_set_fontmap                     (GtkPrintContext   *context,
+								     PangoFontMap      *fontmap);
 
 G_END_DECLS
 
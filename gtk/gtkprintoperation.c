@@ -107,6 +107,14 @@
 
 #define SHOW_PROGRESS_TIME 1200
 
+/* Threaded drawing: number of worker threads, how many pages
+ * may be drawn ahead of the one being written out, and how long
+ * the main loop blocks waiting for that page (in microseconds).
+ */
+#define N_RENDER_THREADS 4
+#define MAX_QUEUED_PAGES 16
+#define RENDER_WAIT_TIME 20000
+
 
 enum
 {
@@ -144,7 +152,8 @@ enum
   PROP_EMBED_PAGE_SETUP,
   PROP_HAS_SELECTION,
   PROP_SUPPORT_SELECTION,
-  PROP_N_PAGES_TO_PRINT
+  PROP_N_PAGES_TO_PRINT,
+  PROP_THREADED_DRAWING
 };
 
 static guint signals[LAST_SIGNAL] = { 0 };
@@ -158,6 +167,7 @@ static void          common_render_page      (GtkPrintOperation             *op,
 static void          increment_page_sequence (PrintPagesData *data);
 static void          prepare_data            (PrintPagesData *data);
 static void          clamp_page_ranges       (PrintPagesData *data);
+static void          stop_render_threads     (PrintPagesData *data);
 
 
 G_DEFINE_TYPE_WITH_CODE (GtkPrintOperation, gtk_print_operation, G_TYPE_OBJECT,
@@ -429,6 +439,9 @@ gtk_print_operation_set_property (GObject      *object,
     case PROP_SUPPORT_SELECTION:
       gtk_print_operation_set_support_selection (op, g_value_get_boolean (value));
       break;
+    case PROP_THREADED_DRAWING:
+      gtk_print_operation_set_threaded_drawing (op, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -500,6 +513,9 @@ gtk_print_operation_get_property (GObject    *object,
     case PROP_N_PAGES_TO_PRINT:
       g_value_set_int (value, priv->nr_of_pages_to_print);
       break;
+    case PROP_THREADED_DRAWING:
+      g_value_set_boolean (value, priv->threaded_drawing);
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -529,6 +545,16 @@ struct _PrintPagesData
   gboolean initialized;
   gboolean is_preview;
   gboolean done;
+
+  /* Threaded drawing, see gtk_print_operation_set_threaded_drawing() */
+  GThreadPool *render_pool;
+  GQueue *render_jobs;
+  GMutex *render_mutex;
+  GCond *render_cond;
+  /* The page position of the page queued last; the one of the
+   * page written out last is in priv->page_position
+   */
+  gint queue_position;
 };
 
 typedef struct
@@ -1418,6 +1444,23 @@ gtk_print_operation_class_init (GtkPrintOperationClass *class)
 						     G_MAXINT,
 						     -1,
 						     GTK_PARAM_READABLE));
+
+  /**
+   * GtkPrintOperation:threaded-drawing:
+   *
+   * If %TRUE, the #GtkPrintOperation::draw-page signal may be emitted
+   * from worker threads, so that several pages are drawn at the same
+   * time. See gtk_print_operation_set_threaded_drawing().
+   *
+   * Since: 3.2
+   */
+  g_object_class_install_property (gobject_class,
+				   PROP_THREADED_DRAWING,
+				   g_param_spec_boolean ("threaded-drawing",
+							 P_("Threaded Drawing"),
+							 P_("TRUE if pages may be drawn in worker threads"),
+							 FALSE,
+							 GTK_PARAM_READWRITE));
 }
 
 /**
@@ -2296,6 +2339,8 @@ print_pages_idle_done (gpointer user_data)
 
   priv->print_pages_idle_id = 0;
 
+  stop_render_threads (data);
+
   if (priv->show_progress_timeout_id > 0)
     {
       g_source_remove (priv->show_progress_timeout_id);
@@ -2345,7 +2390,17 @@ update_progress (PrintPagesData *data)
 	    text = g_strdup (_("Preparing"));
 	}
       else if (priv->status == GTK_PRINT_STATUS_GENERATING_DATA)
-	text = g_strdup_printf (_("Printing %d"), data->total);
+        {
+          gint total = data->total;
+
+          /* Pages still being drawn in worker threads
+           * have not been printed yet.
+           */
+          if (data->render_jobs)
+            total -= g_queue_get_length (data->render_jobs);
+
+	  text = g_strdup_printf (_("Printing %d"), total);
+        }
       
       if (text)
 	{
@@ -2423,6 +2478,65 @@ gtk_print_operation_get_embed_page_setup (GtkPrintOperation *op)
   return op->priv->embed_page_setup;
 }
 
+/**
+ * gtk_print_operation_set_threaded_drawing:
+ * @op: a #GtkPrintOperation
+ * @threaded: %TRUE to draw pages in worker threads
+ *
+ * Declares that the #GtkPrintOperation::draw-page handlers of @op
+ * are thread-safe. When printing, GTK+ then emits ::draw-page for
+ * several pages at once from a pool of worker threads, each with
+ * its own #GtkPrintContext whose cairo context records into a
+ * recording surface. The recorded pages are replayed in order into
+ * the print output on the main thread.
+ *
+ * All other signals are still emitted on the main thread. The
+ * ::draw-page handlers must not touch widgets, must create their
+ * Pango layouts with gtk_print_context_create_pango_layout() or from
+ * the font map returned by gtk_print_context_get_pango_fontmap(),
+ * instead of the default Pango font map, must not call
+ * gtk_print_operation_set_defer_drawing() and must only use
+ * libraries that are safe to call from several threads. This has
+ * no effect on print previews.
+ *
+ * Since: 3.2
+ **/
+void
+gtk_print_operation_set_threaded_drawing (GtkPrintOperation *op,
+                                          gboolean           threaded)
+{
+  GtkPrintOperationPrivate *priv;
+
+  g_return_if_fail (GTK_IS_PRINT_OPERATION (op));
+
+  priv = op->priv;
+
+  threaded = threaded != FALSE;
+  if (priv->threaded_drawing != threaded)
+    {
+      priv->threaded_drawing = threaded;
+      g_object_notify (G_OBJECT (op), "threaded-drawing");
+    }
+}
+
+/**
+ * gtk_print_operation_get_threaded_drawing:
+ * @op: a #GtkPrintOperation
+ *
+ * Gets the value of #GtkPrintOperation:threaded-drawing property.
+ *
+ * Returns: whether pages may be drawn in worker threads
+ *
+ * Since: 3.2
+ */
+gboolean
+gtk_print_operation_get_threaded_drawing (GtkPrintOperation *op)
+{
+  g_return_val_if_fail (GTK_IS_PRINT_OPERATION (op), FALSE);
+
+  return op->priv->threaded_drawing;
+}
+
 /**
  * gtk_print_operation_draw_page_finish:
  * @op: a #GtkPrintOperation
@@ -2459,22 +2573,36 @@ gtk_print_operation_draw_page_finish (GtkPrintOperation *op)
   priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_READY;
 }
 
-static void
-common_render_page (GtkPrintOperation *op,
-		    gint               page_nr)
+static GtkPageSetup *
+request_page_setup (GtkPrintOperation *op,
+                    gint               page_nr)
 {
   GtkPrintOperationPrivate *priv = op->priv;
   GtkPageSetup *page_setup;
+
+  page_setup = create_page_setup (op);
+
+  g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0,
+		 priv->print_context, page_nr, page_setup);
+
+  return page_setup;
+}
+
+/* Starts a page in the print output and sets up the
+ * cairo context of the print context for drawing it.
+ * The reference to @page_setup is dropped again in
+ * gtk_print_operation_draw_page_finish().
+ */
+static void
+begin_page (GtkPrintOperation *op,
+            GtkPageSetup      *page_setup)
+{
+  GtkPrintOperationPrivate *priv = op->priv;
   GtkPrintContext *print_context;
   cairo_t *cr;
 
   print_context = priv->print_context;
   
-  page_setup = create_page_setup (op);
-  
-  g_signal_emit (op, signals[REQUEST_PAGE_SETUP], 0, 
-		 print_context, page_nr, page_setup);
-  
   _gtk_print_context_set_page_setup (print_context, page_setup);
   
   priv->start_page (op, print_context, page_setup);
@@ -2673,11 +2801,20 @@ common_render_page (GtkPrintOperation *op,
   else
     if (!priv->use_full_page)
       _gtk_print_context_translate_into_margin (print_context);
-  
+}
+
+static void
+common_render_page (GtkPrintOperation *op,
+		    gint               page_nr)
+{
+  GtkPrintOperationPrivate *priv = op->priv;
+
+  begin_page (op, request_page_setup (op, page_nr));
+
   priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_DRAWING;
 
   g_signal_emit (op, signals[DRAW_PAGE], 0, 
-		 print_context, page_nr);
+		 priv->print_context, page_nr);
 
   if (priv->page_drawing_state == GTK_PAGE_DRAWING_STATE_DRAWING)
     gtk_print_operation_draw_page_finish (op);
@@ -2856,6 +2993,236 @@ prepare_data (PrintPagesData *data)
                                    NULL);
 }
 
+typedef struct
+{
+  gint page_nr;
+  gint page_position;
+  GtkPageSetup *page_setup;
+  GtkPrintContext *print_context;
+  cairo_surface_t *recording;
+  cairo_matrix_t unit_matrix;
+  gboolean done;
+} RenderJob;
+
+static RenderJob *
+render_job_new (PrintPagesData *data)
+{
+  GtkPrintOperation *op = data->op;
+  GtkPrintOperationPrivate *priv = op->priv;
+  GtkPrintContext *print_context = priv->print_context;
+  gdouble top, bottom, left, right;
+  RenderJob *job;
+  cairo_t *cr;
+
+  job = g_slice_new0 (RenderJob);
+  job->page_nr = data->page;
+  job->page_position = priv->page_position;
+  job->page_setup = request_page_setup (op, data->page);
+
+  /* Give the draw-page handler a context that matches the
+   * real one, except that it records instead of printing.
+   */
+  job->recording = cairo_recording_surface_create (CAIRO_CONTENT_COLOR_ALPHA, NULL);
+  cr = cairo_create (job->recording);
+
+  job->print_context = _gtk_print_context_new (op);
+  _gtk_print_context_set_page_setup (job->print_context, job->page_setup);
+  gtk_print_context_set_cairo_context (job->print_context, cr,
+                                       gtk_print_context_get_dpi_x (print_context),
+                                       gtk_print_context_get_dpi_y (print_context));
+  if (gtk_print_context_get_hard_margins (print_context, &top, &bottom, &left, &right))
+    _gtk_print_context_set_hard_margins (job->print_context, top, bottom, left, right);
+
+  /* The unit scale is applied again when replaying */
+  cairo_get_matrix (cr, &job->unit_matrix);
+  cairo_destroy (cr);
+
+  return job;
+}
+
+static void
+render_job_free (RenderJob *job)
+{
+  g_object_unref (job->print_context);
+  cairo_surface_destroy (job->recording);
+
+  if (job->page_setup)
+    g_object_unref (job->page_setup);
+
+  g_slice_free (RenderJob, job);
+}
+
+/* The default pango font map must only be used from one thread,
+ * so each worker thread gets its own font map.
+ */
+static GPrivate *render_fontmap_key = NULL;
+
+static void
+render_page_thread (gpointer job_data,
+                    gpointer user_data)
+{
+  PrintPagesData *data = user_data;
+  RenderJob *job = job_data;
+  PangoFontMap *fontmap;
+
+  fontmap = g_private_get (render_fontmap_key);
+  if (!fontmap)
+    {
+      fontmap = pango_cairo_font_map_new ();
+      g_private_set (render_fontmap_key, fontmap);
+    }
+
+  _gtk_print_context_set_fontmap (job->print_context, fontmap);
+
+  if (!data->op->priv->cancelled)
+    g_signal_emit (data->op, signals[DRAW_PAGE], 0,
+                   job->print_context, job->page_nr);
+
+  g_mutex_lock (data->render_mutex);
+  job->done = TRUE;
+  g_cond_signal (data->render_cond);
+  g_mutex_unlock (data->render_mutex);
+}
+
+static void
+replay_page (PrintPagesData *data,
+             RenderJob      *job)
+{
+  GtkPrintOperation *op = data->op;
+  GtkPrintOperationPrivate *priv = op->priv;
+  cairo_t *cr;
+
+  /* The manual number-up layout and the backends
+   * look at the page position of the page being printed.
+   */
+  priv->page_position = job->page_position;
+
+  /* begin_page() takes over the page setup reference */
+  begin_page (op, job->page_setup);
+  job->page_setup = NULL;
+
+  cr = gtk_print_context_get_cairo_context (priv->print_context);
+
+  cairo_save (cr);
+  cairo_matrix_invert (&job->unit_matrix);
+  cairo_transform (cr, &job->unit_matrix);
+  cairo_set_source_surface (cr, job->recording, 0, 0);
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  priv->page_drawing_state = GTK_PAGE_DRAWING_STATE_DRAWING;
+  gtk_print_operation_draw_page_finish (op);
+}
+
+static gboolean
+start_render_threads (PrintPagesData *data)
+{
+  if (!g_thread_supported ())
+    return FALSE;
+
+  if (!render_fontmap_key)
+    render_fontmap_key = g_private_new (g_object_unref);
+
+  data->render_pool = g_thread_pool_new (render_page_thread, data,
+                                         N_RENDER_THREADS, FALSE, NULL);
+  if (!data->render_pool)
+    return FALSE;
+
+  data->render_jobs = g_queue_new ();
+  data->render_mutex = g_mutex_new ();
+  data->render_cond = g_cond_new ();
+  data->queue_position = data->op->priv->page_position;
+
+  return TRUE;
+}
+
+static void
+stop_render_threads (PrintPagesData *data)
+{
+  if (!data->render_pool)
+    return;
+
+  /* Drop the pages that were not started and
+   * wait for the ones being drawn.
+   */
+  g_thread_pool_free (data->render_pool, TRUE, TRUE);
+  data->render_pool = NULL;
+
+  g_queue_foreach (data->render_jobs, (GFunc) render_job_free, NULL);
+  g_queue_free (data->render_jobs);
+  data->render_jobs = NULL;
+
+  g_mutex_free (data->render_mutex);
+  data->render_mutex = NULL;
+  g_cond_free (data->render_cond);
+  data->render_cond = NULL;
+}
+
+/* Threaded counterpart of increment_page_sequence() followed by
+ * common_render_page(): keeps the workers busy with upcoming pages
+ * and writes out the next page in order once it has been drawn.
+ * Returns %TRUE when all pages have been written.
+ */
+static gboolean
+render_pages_threaded (PrintPagesData *data)
+{
+  GtkPrintOperationPrivate *priv = data->op->priv;
+  RenderJob *job;
+  GTimeVal end_time;
+  gboolean job_done;
+  gint written_position;
+
+  /* increment_page_sequence() moves on from the page queued last,
+   * not from the page replay_page() wrote out last.
+   */
+  written_position = priv->page_position;
+  priv->page_position = data->queue_position;
+
+  while (!data->done &&
+         g_queue_get_length (data->render_jobs) < MAX_QUEUED_PAGES)
+    {
+      increment_page_sequence (data);
+
+      if (data->done)
+        break;
+
+      job = render_job_new (data);
+      g_queue_push_tail (data->render_jobs, job);
+      g_thread_pool_push (data->render_pool, job, NULL);
+    }
+
+  data->queue_position = priv->page_position;
+  priv->page_position = written_position;
+
+  job = g_queue_peek_head (data->render_jobs);
+  if (job == NULL)
+    return TRUE;
+
+  /* Don't block the main loop for too long,
+   * so the progress dialog stays responsive.
+   */
+  g_get_current_time (&end_time);
+  g_time_val_add (&end_time, RENDER_WAIT_TIME);
+
+  g_mutex_lock (data->render_mutex);
+  while (!job->done)
+    {
+      if (!g_cond_timed_wait (data->render_cond, data->render_mutex, &end_time))
+        break;
+    }
+  job_done = job->done;
+  g_mutex_unlock (data->render_mutex);
+
+  if (job_done)
+    {
+      g_queue_pop_head (data->render_jobs);
+      replay_page (data, job);
+      render_job_free (job);
+    }
+
+  return FALSE;
+}
+
 static gboolean
 print_pages_idle (gpointer user_data)
 {
@@ -2882,6 +3249,15 @@ print_pages_idle (gpointer user_data)
           goto out;
         }
 
+      if (priv->threaded_drawing && !data->render_pool && !data->done)
+        start_render_threads (data);
+
+      if (data->render_pool)
+        {
+          done = render_pages_threaded (data);
+          goto out;
+        }
+
       increment_page_sequence (data);
 
       if (!data->done)
@@ -2901,6 +3277,8 @@ print_pages_idle (gpointer user_data)
 
       if (done && !data->is_preview)
         {
+          stop_render_threads (data);
+
           g_signal_emit (data->op, signals[END_PRINT], 0, priv->print_context);
           priv->end_run (data->op, priv->is_sync, priv->cancelled);
         }
@@ -250,6 +250,9 @@ gboolean                gtk_print_operation_get_has_selection      (GtkPrintOper
 void                    gtk_print_operation_set_embed_page_setup   (GtkPrintOperation  *op,
                                                                     gboolean            embed);
 gboolean                gtk_print_operation_get_embed_page_setup   (GtkPrintOperation  *op);
+void                    gtk_print_operation_set_threaded_drawing   (GtkPrintOperation  *op,
+                                                                    gboolean            threaded);
+gboolean                gtk_print_operation_get_threaded_drawing   (GtkPrintOperation  *op);
 gint                    gtk_print_operation_get_n_pages_to_print   (GtkPrintOperation  *op);
 
 GtkPageSetup           *gtk_print_run_page_setup_dialog            (GtkWindow          *parent,
@@ -37,6 +37,11 @@ static inline void _fixup_validation              (GtkRBTree  *tree,
 static inline void _fixup_parity                  (GtkRBTree  *tree,
 						   GtkRBNode  *node);
 
+/* The sentinel node shared by all trees. Its parent pointer
+ * is only written to temporarily while removing a node, all
+ * other fields keep their initial values.
+ */
+static GtkRBNode nil = { GTK_RBNODE_BLACK, };
 
 
 static GtkRBNode *
@@ -335,14 +340,7 @@ _gtk_rbtree_new (void)
   retval->parent_tree = NULL;
   retval->parent_node = NULL;
 
-  retval->nil = g_slice_new (GtkRBNode);
-  retval->nil->left = NULL;
-  retval->nil->right = NULL;
-  retval->nil->parent = NULL;
-  retval->nil->flags = GTK_RBNODE_BLACK;
-  retval->nil->count = 0;
-  retval->nil->offset = 0;
-  retval->nil->parity = 0;
+  retval->nil = &nil;
 
   retval->root = retval->nil;
   return retval;
@@ -371,7 +369,6 @@ _gtk_rbtree_free (GtkRBTree *tree)
   if (tree->parent_node &&
       tree->parent_node->children == tree)
     tree->parent_node->children = NULL;
-  _gtk_rbnode_free (tree->nil);
   g_free (tree);
 }
 
@@ -508,6 +505,108 @@ _gtk_rbtree_insert_after (GtkRBTree *tree,
   return node;
 }
 
+static GtkRBNode *
+_gtk_rbtree_build_helper (GtkRBTree *tree,
+			  GtkRBNode *parent,
+			  gint       n_nodes,
+			  gint       depth,
+			  gint       red_depth,
+			  gint       height,
+			  guint      flags)
+{
+  GtkRBNode *node;
+  gint n_left;
+
+  if (n_nodes == 0)
+    return tree->nil;
+
+  n_left = (n_nodes - 1) / 2;
+
+  node = _gtk_rbnode_new (tree, height);
+  node->parent = parent;
+  node->left = _gtk_rbtree_build_helper (tree, node, n_left,
+					 depth + 1, red_depth, height, flags);
+  node->right = _gtk_rbtree_build_helper (tree, node, n_nodes - n_left - 1,
+					  depth + 1, red_depth, height, flags);
+
+  node->flags = flags | (depth == red_depth ? GTK_RBNODE_RED : GTK_RBNODE_BLACK);
+  node->count = n_nodes;
+  node->offset = n_nodes * height;
+  node->parity = n_nodes & 1;
+
+  return node;
+}
+
+/* Fills the empty @tree with @n_nodes nodes of the given height in
+ * linear time, and returns the first one. Splitting every subtree
+ * in two halves of the same size (give or take one) puts all nodes
+ * within the top floor(log2 (n_nodes)) levels, and coloring the
+ * nodes of the deepest level red keeps the black height the same
+ * on every path.
+ */
+GtkRBNode *
+_gtk_rbtree_build (GtkRBTree *tree,
+		   gint       n_nodes,
+		   gint       height,
+		   gboolean   valid)
+{
+  GtkRBNode *node;
+  GtkRBNode *tmp_node;
+  GtkRBTree *tmp_tree;
+  gint red_depth;
+
+  g_return_val_if_fail (tree->root == tree->nil, NULL);
+
+  if (n_nodes <= 0)
+    return NULL;
+
+  red_depth = g_bit_storage (n_nodes) - 1;
+  if (red_depth == 0)
+    red_depth = -1;
+
+  tree->root = _gtk_rbtree_build_helper (tree, tree->nil, n_nodes,
+					 0, red_depth, height,
+					 valid ? 0 : GTK_RBNODE_INVALID | GTK_RBNODE_DESCENDANTS_INVALID);
+
+  /* Update the trees we are a child of */
+  tmp_node = tree->parent_node;
+  tmp_tree = tree->parent_tree;
+
+  while (tmp_tree && tmp_node && tmp_node != tmp_tree->nil)
+    {
+      tmp_node->offset += tree->root->offset;
+
+      if (tree->root->parity)
+	tmp_node->parity = !tmp_node->parity;
+
+      if (!valid)
+	GTK_RBNODE_SET_FLAG (tmp_node, GTK_RBNODE_DESCENDANTS_INVALID);
+
+      tmp_node = tmp_node->parent;
+      if (tmp_node == tmp_tree->nil)
+	{
+	  tmp_node = tmp_tree->parent_node;
+	  tmp_tree = tmp_tree->parent_tree;
+	}
+    }
+
+#ifdef G_ENABLE_DEBUG  
+  if (gtk_get_debug_flags () & GTK_DEBUG_TREE)
+    {
+      g_print ("_gtk_rbtree_build finished...\n");
+      _gtk_rbtree_debug_spew (tree);
+      g_print ("\n\n");
+      _gtk_rbtree_test (G_STRLOC, tree);
+    }
+#endif /* G_ENABLE_DEBUG */  
+
+  node = tree->root;
+  while (node->left != tree->nil)
+    node = node->left;
+
+  return node;
+}
+
 GtkRBNode *
 _gtk_rbtree_insert_before (GtkRBTree *tree,
 			   GtkRBNode *current,
@@ -121,6 +121,10 @@ GtkRBNode *_gtk_rbtree_insert_after     (GtkRBTree              *tree,
 					 gboolean                valid);
 void       _gtk_rbtree_remove_node      (GtkRBTree              *tree,
 					 GtkRBNode              *node);
+GtkRBNode *_gtk_rbtree_build            (GtkRBTree              *tree,
+					 gint                    n_nodes,
+					 gint                    height,
+					 gboolean                valid);
 void       _gtk_rbtree_reorder          (GtkRBTree              *tree,
 					 gint                   *new_order,
 					 gint                    length);
@@ -37,30 +37,6 @@ G_BEGIN_DECLS
 #define GTK_IS_RECENT_CHOOSER(obj)		(G_TYPE_CHECK_INSTANCE_TYPE ((obj), GTK_TYPE_RECENT_CHOOSER))
 #define GTK_RECENT_CHOOSER_GET_IFACE(inst)	(G_TYPE_INSTANCE_GET_INTERFACE ((inst), GTK_TYPE_RECENT_CHOOSER, GtkRecentChooserIface))
 
-/**
- * GtkRecentSortType:
- * @GTK_RECENT_SORT_NONE: Do not sort the returned list of recently used
- *   resources.
- * @GTK_RECENT_SORT_MRU: Sort the returned list with the most recently used
- *   items first.
- * @GTK_RECENT_SORT_LRU: Sort the returned list with the least recently used
- *   items first.
- * @GTK_RECENT_SORT_CUSTOM: Sort the returned list using a custom sorting
- *   function passed using gtk_recent_manager_set_sort_func().
- *
- * Used to specify the sorting method to be applyed to the recently
- * used resource list.
- *
- * Since: 2.10
- */
-typedef enum
-{
-  GTK_RECENT_SORT_NONE = 0,
-  GTK_RECENT_SORT_MRU,
-  GTK_RECENT_SORT_LRU,
-  GTK_RECENT_SORT_CUSTOM
-} GtkRecentSortType;
-
 typedef gint (*GtkRecentSortFunc) (GtkRecentInfo *a,
 				   GtkRecentInfo *b,
 				   gpointer       user_data);
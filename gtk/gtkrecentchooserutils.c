@@ -431,14 +431,22 @@ _gtk_recent_chooser_get_items (GtkRecentChooser  *chooser,
   if (!manager)
     return NULL;
 
-  items = gtk_recent_manager_get_items (manager);
-  if (!items)
-    return NULL;
-
   limit = gtk_recent_chooser_get_limit (chooser);
   if (limit == 0)
     return NULL;
 
+  sort_type = gtk_recent_chooser_get_sort_type (chooser);
+
+  /* with nothing to filter out, let the manager sort and clamp the
+   * list, so that only the items we return are built
+   */
+  if (!filter && sort_type != GTK_RECENT_SORT_CUSTOM)
+    return gtk_recent_manager_query_items (manager, sort_type, limit);
+
+  items = gtk_recent_manager_get_items (manager);
+  if (!items)
+    return NULL;
+
   if (filter)
     {
       GList *filter_items, *l;
@@ -483,7 +491,6 @@ _gtk_recent_chooser_get_items (GtkRecentChooser  *chooser,
   if (!items)
     return NULL;
 
-  sort_type = gtk_recent_chooser_get_sort_type (chooser);
   switch (sort_type)
     {
     case GTK_RECENT_SORT_NONE:
@@ -75,7 +75,8 @@
  *
  * In order to retrieve the list of recently used files, you can use
  * gtk_recent_manager_get_items(), which returns a list of #GtkRecentInfo
- * structures.
+ * structures; gtk_recent_manager_query_items() returns only the most
+ * (or least) recently used ones.
  *
  * A #GtkRecentManager is the model used to populate the contents of
  * one, or more #GtkRecentChooser implementations.
@@ -84,6 +85,10 @@
  * controllable through the #GtkSettings:gtk-recent-files-max-age
  * property.</para></note>
  *
+ * <note><para>Whether changes are written by rewriting the whole list or
+ * by appending them to a journal is controllable through the
+ * #GtkSettings:gtk-recent-files-journal property.</para></note>
+ *
  * Recently used files are supported since GTK+ 2.10.
  */
 
@@ -94,12 +99,20 @@
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
+#ifdef HAVE_FLOCK
+#include <sys/file.h>
+#endif
 #include <errno.h>
+#include <fcntl.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 #include <glib.h>
 #include <glib/gstdio.h>
 #include <gio/gio.h>
+#ifdef G_OS_WIN32
+#include <io.h>
+#endif
 
 #include "gtkrecentmanager.h"
 #include "gtkintl.h"
@@ -113,12 +126,25 @@
 /* the file where we store the recently used items */
 #define GTK_RECENTLY_USED_FILE	"recently-used.xbel"
 
+/* appended to the file name to get the journal of changes */
+#define GTK_RECENTLY_USED_JOURNAL_SUFFIX	".journal"
+
+/* the journal is folded back into the file when it grows past this size */
+#define JOURNAL_COMPACT_SIZE	(64 * 1024)
+
 /* return all items by default */
 #define DEFAULT_LIMIT	-1
 
 /* keep in sync with xdgmime */
 #define GTK_RECENT_DEFAULT_MIME	"application/octet-stream"
 
+typedef struct
+{
+  time_t mtime;
+  goffset size;
+  guint64 inode;
+} FileStamp;
+
 typedef struct
 {
   gchar *name;
@@ -170,6 +196,7 @@ struct _GtkRecentManagerPrivate
   gchar *filename;
 
   guint is_dirty : 1;
+  guint journaled : 1;
   
   gint size;
 
@@ -179,6 +206,14 @@ struct _GtkRecentManagerPrivate
 
   guint changed_timeout;
   guint changed_age;
+
+  /* see the journal section below */
+  gchar *journal_filename;
+  GFileMonitor *journal_monitor;
+  GString *journal_pending;
+  goffset journal_offset;
+  FileStamp journal_stamp;
+  FileStamp file_stamp;
 };
 
 enum
@@ -217,6 +252,19 @@ static void     gtk_recent_manager_clamp_to_age        (GtkRecentManager  *manag
 
 
 static void build_recent_items_list (GtkRecentManager  *manager);
+static void write_recent_items_list (GtkRecentManager  *manager);
+static void journal_record_item     (GtkRecentManager  *manager,
+                                     const gchar       *uri);
+static void journal_record          (GtkRecentManager  *manager,
+                                     gchar              op,
+                                     const gchar       *uri,
+                                     const gchar       *new_uri);
+static void journal_flush           (GtkRecentManager  *manager);
+static gboolean journal_read        (GtkRecentManager  *manager,
+                                     const gchar       *filename,
+                                     goffset           *offset,
+                                     FileStamp         *stamp);
+static void journal_reload          (GtkRecentManager  *manager);
 static void purge_recent_items_list (GtkRecentManager  *manager,
                                      GError           **error);
 
@@ -399,6 +447,10 @@ gtk_recent_manager_finalize (GObject *object)
   GtkRecentManagerPrivate *priv = manager->priv;
 
   g_free (priv->filename);
+  g_free (priv->journal_filename);
+
+  if (priv->journal_pending != NULL)
+    g_string_free (priv->journal_pending, TRUE);
 
   if (priv->recent_items != NULL)
     g_bookmark_file_free (priv->recent_items);
@@ -421,6 +473,15 @@ gtk_recent_manager_dispose (GObject *gobject)
       priv->monitor = NULL;
     }
 
+  if (priv->journal_monitor != NULL)
+    {
+      g_signal_handlers_disconnect_by_func (priv->journal_monitor,
+                                            G_CALLBACK (gtk_recent_manager_monitor_changed),
+                                            manager);
+      g_object_unref (priv->journal_monitor);
+      priv->journal_monitor = NULL;
+    }
+
   if (priv->changed_timeout != 0)
     {
       g_source_remove (priv->changed_timeout);
@@ -438,63 +499,77 @@ gtk_recent_manager_dispose (GObject *gobject)
   G_OBJECT_CLASS (gtk_recent_manager_parent_class)->dispose (gobject);
 }
 
+/* clamps the recently used items list to the maximum age, and
+ * dumps the whole list into the storage file
+ */
 static void
-gtk_recent_manager_real_changed (GtkRecentManager *manager)
+write_recent_items_list (GtkRecentManager *manager)
 {
   GtkRecentManagerPrivate *priv = manager->priv;
+  GError *write_error;
 
-  g_object_freeze_notify (G_OBJECT (manager));
+  g_assert (priv->filename != NULL);
 
-  if (priv->is_dirty)
+  if (!priv->recent_items)
     {
-      GError *write_error;
-      
-      /* we are marked as dirty, so we dump the content of our
-       * recently used items list
+      /* if no container object has been defined, we create a new
+       * empty container, and dump it
        */
-      g_assert (priv->filename != NULL);
+      priv->recent_items = g_bookmark_file_new ();
+      priv->size = 0;
+    }
+  else
+    {
+      GtkSettings *settings = gtk_settings_get_default ();
+      gint age = 30;
 
-      if (!priv->recent_items)
+      g_object_get (G_OBJECT (settings), "gtk-recent-files-max-age", &age, NULL);
+      if (age > 0)
+        gtk_recent_manager_clamp_to_age (manager, age);
+      else if (age == 0)
         {
-          /* if no container object has been defined, we create a new
-           * empty container, and dump it
-           */
+          g_bookmark_file_free (priv->recent_items);
           priv->recent_items = g_bookmark_file_new ();
-	  priv->size = 0;
-	}
-      else
-        {
-          GtkSettings *settings = gtk_settings_get_default ();
-          gint age = 30;
-
-          g_object_get (G_OBJECT (settings), "gtk-recent-files-max-age", &age, NULL);
-          if (age > 0)
-            gtk_recent_manager_clamp_to_age (manager, age);
-          else if (age == 0)
-            {
-              g_bookmark_file_free (priv->recent_items);
-              priv->recent_items = g_bookmark_file_new ();
-            }
         }
+    }
 
-      write_error = NULL;
-      g_bookmark_file_to_file (priv->recent_items, priv->filename, &write_error);
-      if (write_error)
-        {
-          filename_warning ("Attempting to store changes into `%s', "
-			    "but failed: %s",
-			    priv->filename,
-			    write_error->message);
-	  g_error_free (write_error);
-	}
+  write_error = NULL;
+  g_bookmark_file_to_file (priv->recent_items, priv->filename, &write_error);
+  if (write_error)
+    {
+      filename_warning ("Attempting to store changes into `%s', "
+                        "but failed: %s",
+                        priv->filename,
+                        write_error->message);
+      g_error_free (write_error);
+    }
 
-      if (g_chmod (priv->filename, 0600) < 0)
-        {
-          filename_warning ("Attempting to set the permissions of `%s', "
-                            "but failed: %s",
-                            priv->filename,
-                            g_strerror (errno));
-        }
+  if (g_chmod (priv->filename, 0600) < 0)
+    {
+      filename_warning ("Attempting to set the permissions of `%s', "
+                        "but failed: %s",
+                        priv->filename,
+                        g_strerror (errno));
+    }
+}
+
+static void
+gtk_recent_manager_real_changed (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+
+  g_object_freeze_notify (G_OBJECT (manager));
+
+  if (priv->is_dirty)
+    {
+      /* we are marked as dirty, so we dump the content of our
+       * recently used items list, or just the changes to it if
+       * we are keeping a journal
+       */
+      if (priv->journaled)
+        journal_flush (manager);
+      else
+        write_recent_items_list (manager);
 
       /* mark us as clean */
       priv->is_dirty = FALSE;
@@ -505,7 +580,10 @@ gtk_recent_manager_real_changed (GtkRecentManager *manager)
        * because the recently used resources file has been
        * changed (and not from us).
        */
-      build_recent_items_list (manager);
+      if (priv->journaled)
+        journal_reload (manager);
+      else
+        build_recent_items_list (manager);
     }
 
   g_object_thaw_notify (G_OBJECT (manager));
@@ -543,13 +621,44 @@ get_default_filename (void)
                            NULL);
 }
 
+static GFileMonitor *
+monitor_file (GtkRecentManager *manager,
+              const gchar      *filename)
+{
+  GFileMonitor *monitor;
+  GFile *file;
+  GError *error;
+
+  file = g_file_new_for_path (filename);
+
+  error = NULL;
+  monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, &error);
+  if (error)
+    {
+      filename_warning ("Unable to monitor `%s': %s\n"
+                        "The GtkRecentManager will not update its contents "
+                        "if the file is changed from other instances",
+                        filename,
+                        error->message);
+      g_error_free (error);
+    }
+  else
+    g_signal_connect (monitor, "changed",
+                      G_CALLBACK (gtk_recent_manager_monitor_changed),
+                      manager);
+
+  g_object_unref (file);
+
+  return monitor;
+}
+
 static void
 gtk_recent_manager_set_filename (GtkRecentManager *manager,
 				 const gchar      *filename)
 {
   GtkRecentManagerPrivate *priv;
-  GFile *file;
-  GError *error;
+  GtkSettings *settings;
+  gboolean journaled;
   
   g_assert (GTK_IS_RECENT_MANAGER (manager));
 
@@ -575,6 +684,18 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
           priv->monitor = NULL;
         }
 
+      if (priv->journal_monitor)
+        {
+          g_signal_handlers_disconnect_by_func (priv->journal_monitor,
+                                                G_CALLBACK (gtk_recent_manager_monitor_changed),
+                                                manager);
+          g_object_unref (priv->journal_monitor);
+          priv->journal_monitor = NULL;
+        }
+
+      g_free (priv->journal_filename);
+      priv->journal_filename = NULL;
+
       if (!filename || *filename == '\0')
         return;
       else
@@ -589,25 +710,24 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
     }
 
   g_assert (priv->filename != NULL);
-  file = g_file_new_for_path (priv->filename);
+  priv->monitor = monitor_file (manager, priv->filename);
 
-  error = NULL;
-  priv->monitor = g_file_monitor_file (file, G_FILE_MONITOR_NONE, NULL, &error);
-  if (error)
+  journaled = FALSE;
+  settings = gtk_settings_get_default ();
+  if (settings)
+    g_object_get (G_OBJECT (settings), "gtk-recent-files-journal", &journaled, NULL);
+
+  priv->journaled = journaled != FALSE;
+  if (priv->journaled)
     {
-      filename_warning ("Unable to monitor `%s': %s\n"
-                        "The GtkRecentManager will not update its contents "
-                        "if the file is changed from other instances",
-                        priv->filename,
-                        error->message);
-      g_error_free (error);
-    }
-  else
-    g_signal_connect (priv->monitor, "changed",
-                      G_CALLBACK (gtk_recent_manager_monitor_changed),
-                      manager);
+      priv->journal_filename = g_strconcat (priv->filename,
+                                            GTK_RECENTLY_USED_JOURNAL_SUFFIX,
+                                            NULL);
+      priv->journal_monitor = monitor_file (manager, priv->journal_filename);
 
-  g_object_unref (file);
+      if (!priv->journal_pending)
+        priv->journal_pending = g_string_new (NULL);
+    }
 
   priv->is_dirty = FALSE;
   build_recent_items_list (manager);
@@ -618,12 +738,58 @@ gtk_recent_manager_set_filename (GtkRecentManager *manager,
  * RecentInfo object only on user's demand to avoid useless replication.
  * this function resets the dirty bit of the manager.
  */
+static void
+update_size (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gint size;
+
+  if (!priv->recent_items)
+    return;
+
+  size = g_bookmark_file_get_size (priv->recent_items);
+  if (priv->size != size)
+    {
+      priv->size = size;
+
+      g_object_notify (G_OBJECT (manager), "size");
+    }
+}
+
+static void
+get_file_stamp (const gchar *filename,
+                FileStamp   *stamp)
+{
+  struct stat st;
+
+  if (g_stat (filename, &st) < 0)
+    {
+      stamp->mtime = 0;
+      stamp->size = 0;
+      stamp->inode = 0;
+    }
+  else
+    {
+      stamp->mtime = st.st_mtime;
+      stamp->size = st.st_size;
+      stamp->inode = st.st_ino;
+    }
+}
+
+static gboolean
+file_stamp_equal (const FileStamp *a,
+                  const FileStamp *b)
+{
+  return a->mtime == b->mtime &&
+         a->size == b->size &&
+         a->inode == b->inode;
+}
+
 static void
 build_recent_items_list (GtkRecentManager *manager)
 {
   GtkRecentManagerPrivate *priv = manager->priv;
   GError *read_error;
-  gint size;
 
   g_assert (priv->filename != NULL);
   
@@ -633,6 +799,12 @@ build_recent_items_list (GtkRecentManager *manager)
       priv->size = 0;
     }
 
+  /* stamp the file before loading it, so that a write racing with
+   * the load will be picked up by journal_reload()
+   */
+  if (priv->journaled)
+    get_file_stamp (priv->filename, &priv->file_stamp);
+
   /* the file exists, and it's valid (we hope); if not, destroy the container
    * object and hope for a better result when the next "changed" signal is
    * fired. */
@@ -657,20 +829,617 @@ build_recent_items_list (GtkRecentManager *manager)
 
       g_error_free (read_error);
     }
-  else
+
+  if (priv->journaled)
+    {
+      /* the journal holds the changes made since the file was written */
+      if (!priv->recent_items)
+        priv->recent_items = g_bookmark_file_new ();
+
+      priv->journal_offset = 0;
+      memset (&priv->journal_stamp, 0, sizeof (FileStamp));
+      journal_read (manager,
+                    priv->journal_filename,
+                    &priv->journal_offset,
+                    &priv->journal_stamp);
+    }
+
+  update_size (manager);
+
+  priv->is_dirty = FALSE;
+}
+
+/***********
+ * Journal *
+ ***********/
+
+/* When the GtkSettings:gtk-recent-files-journal setting is enabled, the
+ * changes to the list are not written by dumping the whole list into
+ * the storage file; instead, each change is appended as a single line
+ * to a journal file living next to it, and the other instances only
+ * need to parse the lines appended since the last time they looked.
+ *
+ * The line format is a single character operation followed by tab
+ * separated fields, with backslash escapes for tabs and newlines:
+ *
+ *   U uri added modified visited private mime title description
+ *     n_groups group... n_apps (name exec count stamp)...
+ *   R uri
+ *   M uri new_uri
+ *   P
+ *
+ * 'U' records carry the whole state of an item, so that applying them
+ * does not depend on what the reader already knows about it. Once the
+ * journal grows past JOURNAL_COMPACT_SIZE, the instance that wrote to
+ * it moves it out of the way, applies it and writes the storage file,
+ * which makes every other instance reload the file and the (new) journal
+ * from the start.
+ *
+ * Appending and compacting both hold an exclusive flock() on the journal,
+ * and a writer checks that the file it locked is still the journal, so
+ * that no record ends up in a journal that was already compacted.
+ */
+
+/* whether @fd is still open on the journal at @filename, rather than on
+ * one that was moved out of the way by journal_compact()
+ */
+static gboolean
+journal_fd_is_current (gint         fd,
+                       const gchar *filename)
+{
+  struct stat fd_st, st;
+
+  return fstat (fd, &fd_st) == 0 &&
+         g_stat (filename, &st) == 0 &&
+         fd_st.st_dev == st.st_dev &&
+         fd_st.st_ino == st.st_ino;
+}
+
+/* opens the journal at @filename with @flags and locks it; returns -1
+ * and leaves errno set if it cannot be opened
+ */
+static gint
+journal_open_locked (const gchar *filename,
+                     gint         flags)
+{
+  gint fd, i;
+
+  for (i = 0; i < 10; i++)
+    {
+      fd = g_open (filename, flags, 0600);
+      if (fd < 0)
+        return -1;
+
+#ifdef HAVE_FLOCK
+      while (flock (fd, LOCK_EX) < 0 && errno == EINTR)
+        ;
+#endif
+
+      /* compacted while we were waiting for the lock */
+      if (journal_fd_is_current (fd, filename))
+        return fd;
+
+      close (fd);
+    }
+
+  errno = EAGAIN;
+
+  return -1;
+}
+
+/* undoes the expansion g_bookmark_file_get_app_info() applies to the
+ * command line of an application, so that the journal carries the
+ * command line as it was registered and it keeps following @uri
+ * when the item is moved
+ */
+static gchar *
+journal_unexpand_exec (const gchar *exec,
+                       const gchar *uri)
+{
+  GString *raw;
+  gchar *filename;
+  gsize uri_len, filename_len;
+  const gchar *p;
+
+  filename = g_filename_from_uri (uri, NULL, NULL);
+  uri_len = strlen (uri);
+  filename_len = filename ? strlen (filename) : 0;
+
+  raw = g_string_new (NULL);
+
+  for (p = exec; *p != '\0'; )
     {
-      size = g_bookmark_file_get_size (priv->recent_items);
-      if (priv->size != size)
+      if (uri_len > 0 && strncmp (p, uri, uri_len) == 0)
+        {
+          g_string_append (raw, "%u");
+          p += uri_len;
+        }
+      else if (filename_len > 0 && strncmp (p, filename, filename_len) == 0)
         {
-          priv->size = size;
+          g_string_append (raw, "%f");
+          p += filename_len;
+        }
+      else if (*p == '%')
+        {
+          g_string_append (raw, "%%");
+          p++;
+        }
+      else
+        g_string_append_c (raw, *p++);
+    }
+
+  g_free (filename);
+
+  return g_string_free (raw, FALSE);
+}
+
+static void
+journal_append_string (GString     *record,
+                       const gchar *str)
+{
+  const gchar *p;
+
+  g_string_append_c (record, '\t');
 
-          g_object_notify (G_OBJECT (manager), "size");
+  if (!str)
+    return;
+
+  for (p = str; *p != '\0'; p++)
+    {
+      switch (*p)
+        {
+        case '\\':
+          g_string_append (record, "\\\\");
+          break;
+        case '\t':
+          g_string_append (record, "\\t");
+          break;
+        case '\n':
+          g_string_append (record, "\\n");
+          break;
+        case '\r':
+          g_string_append (record, "\\r");
+          break;
+        default:
+          g_string_append_c (record, *p);
+          break;
         }
     }
+}
 
-  priv->is_dirty = FALSE;
+static void
+journal_append_number (GString *record,
+                       gint64   number)
+{
+  g_string_append_printf (record, "\t%" G_GINT64_FORMAT, number);
+}
+
+static void
+journal_record (GtkRecentManager *manager,
+                gchar             op,
+                const gchar      *uri,
+                const gchar      *new_uri)
+{
+  GString *record = manager->priv->journal_pending;
+
+  g_string_append_c (record, op);
+
+  if (uri)
+    journal_append_string (record, uri);
+
+  if (op == 'M')
+    journal_append_string (record, new_uri);
+
+  g_string_append_c (record, '\n');
+}
+
+static void
+journal_record_item (GtkRecentManager *manager,
+                     const gchar      *uri)
+{
+  GBookmarkFile *items = manager->priv->recent_items;
+  GString *record = manager->priv->journal_pending;
+  gchar **groups, **apps;
+  gsize n_groups, n_apps, i;
+  gchar *value;
+
+  g_string_append_c (record, 'U');
+  journal_append_string (record, uri);
+  journal_append_number (record, g_bookmark_file_get_added (items, uri, NULL));
+  journal_append_number (record, g_bookmark_file_get_modified (items, uri, NULL));
+  journal_append_number (record, g_bookmark_file_get_visited (items, uri, NULL));
+  journal_append_number (record, g_bookmark_file_get_is_private (items, uri, NULL));
+
+  value = g_bookmark_file_get_mime_type (items, uri, NULL);
+  journal_append_string (record, value);
+  g_free (value);
+
+  value = g_bookmark_file_get_title (items, uri, NULL);
+  journal_append_string (record, value);
+  g_free (value);
+
+  value = g_bookmark_file_get_description (items, uri, NULL);
+  journal_append_string (record, value);
+  g_free (value);
+
+  groups = g_bookmark_file_get_groups (items, uri, &n_groups, NULL);
+  journal_append_number (record, n_groups);
+  for (i = 0; i < n_groups; i++)
+    journal_append_string (record, groups[i]);
+  g_strfreev (groups);
+
+  apps = g_bookmark_file_get_applications (items, uri, &n_apps, NULL);
+  journal_append_number (record, n_apps);
+  for (i = 0; i < n_apps; i++)
+    {
+      gchar *exec = NULL;
+      guint count = 0;
+      time_t stamp = 0;
+
+      gchar *raw_exec = NULL;
+
+      /* a zero count makes the reader skip the application */
+      g_bookmark_file_get_app_info (items, uri, apps[i],
+                                    &exec, &count, &stamp,
+                                    NULL);
+      if (exec)
+        raw_exec = journal_unexpand_exec (exec, uri);
+
+      journal_append_string (record, apps[i]);
+      journal_append_string (record, raw_exec);
+      journal_append_number (record, count);
+      journal_append_number (record, stamp);
+
+      g_free (raw_exec);
+      g_free (exec);
+    }
+  g_strfreev (apps);
+
+  g_string_append_c (record, '\n');
+}
+
+static void
+journal_apply_item (GBookmarkFile  *items,
+                    gchar         **fields,
+                    guint           n_fields)
+{
+  const gchar *uri;
+  guint n_groups, n_apps, i, pos;
+
+  /* see journal_record_item() for the layout */
+  if (n_fields < 11)
+    return;
+
+  n_groups = strtoul (fields[9], NULL, 10);
+  if (n_groups > n_fields - 11)
+    return;
+
+  pos = 10 + n_groups;
+  n_apps = strtoul (fields[pos++], NULL, 10);
+  if (n_apps != (n_fields - pos) / 4 || (n_fields - pos) % 4 != 0)
+    return;
+
+  uri = fields[1];
+
+  /* start from scratch, the record has the whole item */
+  g_bookmark_file_remove_item (items, uri, NULL);
+
+  g_bookmark_file_set_mime_type (items, uri, fields[6]);
+
+  if (fields[7][0] != '\0')
+    g_bookmark_file_set_title (items, uri, fields[7]);
+
+  if (fields[8][0] != '\0')
+    g_bookmark_file_set_description (items, uri, fields[8]);
+
+  for (i = 0; i < n_groups; i++)
+    g_bookmark_file_add_group (items, uri, fields[10 + i]);
+
+  for (i = 0; i < n_apps; i++, pos += 4)
+    {
+      guint count = strtoul (fields[pos + 2], NULL, 10);
+
+      if (count == 0)
+        continue;
+
+      g_bookmark_file_set_app_info (items, uri,
+                                    fields[pos],
+                                    fields[pos + 1],
+                                    count,
+                                    (time_t) g_ascii_strtoll (fields[pos + 3], NULL, 10),
+                                    NULL);
+    }
+
+  g_bookmark_file_set_is_private (items, uri, fields[5][0] == '1');
+
+  /* the setters above touch the modification time, so set it last */
+  g_bookmark_file_set_added (items, uri, (time_t) g_ascii_strtoll (fields[2], NULL, 10));
+  g_bookmark_file_set_visited (items, uri, (time_t) g_ascii_strtoll (fields[4], NULL, 10));
+  g_bookmark_file_set_modified (items, uri, (time_t) g_ascii_strtoll (fields[3], NULL, 10));
+}
+
+static void
+journal_apply_line (GtkRecentManager *manager,
+                    const gchar      *line,
+                    gsize             length)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gchar *copy, **fields;
+  guint n_fields, i;
+
+  copy = g_strndup (line, length);
+  fields = g_strsplit (copy, "\t", -1);
+  g_free (copy);
+
+  n_fields = g_strv_length (fields);
+  for (i = 0; i < n_fields; i++)
+    {
+      gchar *field = fields[i];
+
+      fields[i] = g_strcompress (field);
+      g_free (field);
+    }
+
+  /* skip what we do not understand, rather than failing the
+   * whole journal
+   */
+  switch (fields[0][0])
+    {
+    case 'U':
+      journal_apply_item (priv->recent_items, fields, n_fields);
+      break;
+
+    case 'R':
+      if (n_fields == 2)
+        g_bookmark_file_remove_item (priv->recent_items, fields[1], NULL);
+      break;
+
+    case 'M':
+      if (n_fields == 3)
+        g_bookmark_file_move_item (priv->recent_items,
+                                   fields[1],
+                                   fields[2][0] != '\0' ? fields[2] : NULL,
+                                   NULL);
+      break;
+
+    case 'P':
+      g_bookmark_file_free (priv->recent_items);
+      priv->recent_items = g_bookmark_file_new ();
+      break;
+
+    default:
+      break;
+    }
+
+  g_strfreev (fields);
+}
+
+/* applies the complete lines appended to the journal at @filename
+ * after @offset, and moves @offset past them. returns %FALSE if the
+ * journal is not the one identified by @stamp anymore, in which case
+ * nothing is applied and the whole list needs to be reloaded.
+ */
+static gboolean
+journal_read (GtkRecentManager *manager,
+              const gchar      *filename,
+              goffset          *offset,
+              FileStamp        *stamp)
+{
+  FileStamp current;
+  FILE *journal;
+  gchar *buffer, *line, *end;
+  gsize length;
+
+  get_file_stamp (filename, &current);
+
+  if (*offset > 0 &&
+      (current.inode != stamp->inode || current.size < *offset))
+    return FALSE;
+
+  *stamp = current;
+
+  if (current.size <= *offset)
+    return TRUE;
+
+  journal = g_fopen (filename, "rb");
+  if (!journal)
+    return TRUE;
+
+  length = current.size - *offset;
+  buffer = g_malloc (length);
+
+  if (fseek (journal, *offset, SEEK_SET) == 0)
+    length = fread (buffer, 1, length, journal);
+  else
+    length = 0;
+
+  fclose (journal);
+
+  line = buffer;
+  while ((end = memchr (line, '\n', length - (line - buffer))) != NULL)
+    {
+      if (end > line)
+        journal_apply_line (manager, line, end - line);
+
+      line = end + 1;
+    }
+
+  /* a partial line is still being written; we'll get to it the
+   * next time around
+   */
+  *offset += line - buffer;
+
+  g_free (buffer);
+
+  return TRUE;
+}
+
+static void
+journal_reload (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  FileStamp file_stamp;
+
+  get_file_stamp (priv->filename, &file_stamp);
+
+  /* if the file was written, the journal was compacted into it */
+  if (!priv->recent_items ||
+      !file_stamp_equal (&file_stamp, &priv->file_stamp) ||
+      !journal_read (manager,
+                     priv->journal_filename,
+                     &priv->journal_offset,
+                     &priv->journal_stamp))
+    {
+      build_recent_items_list (manager);
+      return;
+    }
+
+  update_size (manager);
+}
+
+static void
+journal_compact (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  gchar *old_journal;
+  gint fd;
+
+  /* hold the lock until the old journal is gone, so that nobody
+   * appends to it after we read it
+   */
+  fd = journal_open_locked (priv->journal_filename, O_RDONLY);
+  if (fd < 0)
+    {
+      if (errno != ENOENT)
+        filename_warning ("Attempting to compact the journal `%s', "
+                          "but failed: %s",
+                          priv->journal_filename,
+                          g_strerror (errno));
+      return;
+    }
+
+  old_journal = g_strdup_printf ("%s.%08x",
+                                 priv->journal_filename,
+                                 g_random_int ());
+
+  /* move the journal out of the way first, so that the changes appended
+   * from now on go to a new journal instead of being lost when the file
+   * is written
+   */
+  if (g_rename (priv->journal_filename, old_journal) < 0)
+    {
+      filename_warning ("Attempting to compact the journal `%s', "
+                        "but failed: %s",
+                        priv->journal_filename,
+                        g_strerror (errno));
+
+      close (fd);
+      g_free (old_journal);
+      return;
+    }
+
+  /* pick up whatever was appended since we last read it */
+  if (!journal_read (manager, old_journal,
+                     &priv->journal_offset,
+                     &priv->journal_stamp))
+    {
+      goffset offset = 0;
+      FileStamp stamp = { 0, };
+
+      build_recent_items_list (manager);
+      journal_read (manager, old_journal, &offset, &stamp);
+    }
+
+  write_recent_items_list (manager);
+  g_unlink (old_journal);
+  g_free (old_journal);
+  close (fd);
+
+  get_file_stamp (priv->filename, &priv->file_stamp);
+  priv->journal_offset = 0;
+  memset (&priv->journal_stamp, 0, sizeof (FileStamp));
+
+  update_size (manager);
 }
 
+static void
+journal_flush (GtkRecentManager *manager)
+{
+  GtkRecentManagerPrivate *priv = manager->priv;
+  GtkSettings *settings;
+  gint age = 30;
+
+  if (priv->journal_pending->len > 0)
+    {
+      gboolean done = FALSE;
+      gint i;
+
+      /* retry if the journal we wrote to was moved aside before the
+       * records landed, e.g. without flock() support
+       */
+      for (i = 0; i < 10 && !done; i++)
+        {
+          const gchar *data = priv->journal_pending->str;
+          gsize length = priv->journal_pending->len;
+          gint fd;
+
+          fd = journal_open_locked (priv->journal_filename,
+                                    O_WRONLY | O_CREAT | O_APPEND);
+          if (fd < 0)
+            {
+              filename_warning ("Attempting to store changes into `%s', "
+                                "but failed: %s",
+                                priv->journal_filename,
+                                g_strerror (errno));
+              break;
+            }
+
+          /* keep the records in a single write, so that appends
+           * from different instances do not interleave
+           */
+          while (length > 0)
+            {
+              gssize written = write (fd, data, length);
+
+              if (written < 0)
+                {
+                  if (errno == EINTR)
+                    continue;
+
+                  filename_warning ("Attempting to store changes into `%s', "
+                                    "but failed: %s",
+                                    priv->journal_filename,
+                                    g_strerror (errno));
+                  break;
+                }
+
+              data += written;
+              length -= written;
+            }
+
+          /* give up on errors, they were reported above */
+          done = length > 0 ||
+                 journal_fd_is_current (fd, priv->journal_filename);
+
+          close (fd);
+        }
+
+      g_string_truncate (priv->journal_pending, 0);
+    }
+
+  /* read back our own records together with the ones appended by other
+   * instances in the meantime, so that the list is in the same state as
+   * the one every other instance sees
+   */
+  journal_reload (manager);
+
+  settings = gtk_settings_get_default ();
+  if (settings)
+    g_object_get (G_OBJECT (settings), "gtk-recent-files-max-age", &age, NULL);
+
+  if (priv->journal_offset >= JOURNAL_COMPACT_SIZE || age == 0)
+    journal_compact (manager);
+}
 
 /********************
  * GtkRecentManager *
@@ -952,6 +1721,9 @@ gtk_recent_manager_add_full (GtkRecentManager     *manager,
   
   g_bookmark_file_set_is_private (priv->recent_items, uri,
 		  		  data->is_private);
+
+  if (priv->journaled)
+    journal_record_item (manager, uri);
   
   /* mark us as dirty, so that when emitting the "changed" signal we
    * will dump our changes
@@ -1016,6 +1788,9 @@ gtk_recent_manager_remove_item (GtkRecentManager  *manager,
       return FALSE;
     }
 
+  if (priv->journaled)
+    journal_record (manager, 'R', uri, NULL);
+
   priv->is_dirty = TRUE;
   gtk_recent_manager_changed (manager);
   
@@ -1238,6 +2013,13 @@ gtk_recent_manager_move_item (GtkRecentManager  *recent_manager,
       return FALSE;
     }
 
+  if (priv->journaled)
+    {
+      journal_record (recent_manager, 'M', uri, new_uri);
+      if (new_uri)
+        journal_record_item (recent_manager, new_uri);
+    }
+
   priv->is_dirty = TRUE;
   gtk_recent_manager_changed (recent_manager);
 
@@ -1287,6 +2069,113 @@ gtk_recent_manager_get_items (GtkRecentManager *manager)
   return retval;
 }
 
+typedef struct
+{
+  const gchar *uri;
+  time_t modified;
+} QueryItem;
+
+static gint
+compare_query_items (gconstpointer a,
+                     gconstpointer b,
+                     gpointer      user_data)
+{
+  const QueryItem *item_a = a;
+  const QueryItem *item_b = b;
+  GtkRecentSortType sort_type = GPOINTER_TO_INT (user_data);
+
+  if (item_a->modified == item_b->modified)
+    return 0;
+
+  if (sort_type == GTK_RECENT_SORT_MRU)
+    return item_a->modified > item_b->modified ? -1 : 1;
+  else
+    return item_a->modified < item_b->modified ? -1 : 1;
+}
+
+/**
+ * gtk_recent_manager_query_items:
+ * @manager: a #GtkRecentManager
+ * @sort_type: the sorting order of the returned list; %GTK_RECENT_SORT_CUSTOM
+ *   is not allowed
+ * @limit: the maximum number of items to return, or -1 to return all
+ *   the items
+ *
+ * Gets at most @limit recently used resources, sorted by their
+ * modification time according to @sort_type.
+ *
+ * Unlike gtk_recent_manager_get_items(), only the returned items
+ * are turned into #GtkRecentInfo objects, which makes this function
+ * suitable for filling short lists, like a menu of recently used
+ * files, out of a long recently used resources list.
+ *
+ * Return value: (element-type GtkRecentInfo) (transfer full): a list of
+ *   newly allocated #GtkRecentInfo objects. Use gtk_recent_info_unref()
+ *   on each item inside the list, and then free the list itself using
+ *   g_list_free().
+ *
+ * Since: 3.2
+ */
+GList *
+gtk_recent_manager_query_items (GtkRecentManager  *manager,
+                                GtkRecentSortType  sort_type,
+                                gint               limit)
+{
+  GtkRecentManagerPrivate *priv;
+  GList *retval = NULL;
+  QueryItem *items;
+  gchar **uris;
+  gsize uris_len, n_items, i;
+
+  g_return_val_if_fail (GTK_IS_RECENT_MANAGER (manager), NULL);
+  g_return_val_if_fail (sort_type != GTK_RECENT_SORT_CUSTOM, NULL);
+  g_return_val_if_fail (limit >= -1, NULL);
+
+  priv = manager->priv;
+  if (!priv->recent_items || limit == 0)
+    return NULL;
+
+  uris = g_bookmark_file_get_uris (priv->recent_items, &uris_len);
+
+  items = g_new (QueryItem, uris_len);
+  for (i = 0; i < uris_len; i++)
+    {
+      items[i].uri = uris[i];
+
+      if (sort_type != GTK_RECENT_SORT_NONE)
+        items[i].modified = g_bookmark_file_get_modified (priv->recent_items,
+                                                          uris[i],
+                                                          NULL);
+      else
+        items[i].modified = 0;
+    }
+
+  if (sort_type != GTK_RECENT_SORT_NONE)
+    g_qsort_with_data (items, uris_len, sizeof (QueryItem),
+                       compare_query_items,
+                       GINT_TO_POINTER (sort_type));
+
+  if (limit == -1 || limit > uris_len)
+    n_items = uris_len;
+  else
+    n_items = limit;
+
+  for (i = n_items; i > 0; i--)
+    {
+      GtkRecentInfo *info;
+
+      info = gtk_recent_info_new (items[i - 1].uri);
+      build_recent_info (priv->recent_items, info);
+
+      retval = g_list_prepend (retval, info);
+    }
+
+  g_free (items);
+  g_strfreev (uris);
+
+  return retval;
+}
+
 static void
 purge_recent_items_list (GtkRecentManager  *manager,
 			 GError           **error)
@@ -1300,6 +2189,9 @@ purge_recent_items_list (GtkRecentManager  *manager,
   priv->recent_items = g_bookmark_file_new ();
   priv->size = 0;
 
+  if (priv->journaled)
+    journal_record (manager, 'P', NULL, NULL);
+
   /* emit the changed signal, to ensure that the purge is written */
   priv->is_dirty = TRUE;
   gtk_recent_manager_changed (manager);
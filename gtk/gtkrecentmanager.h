@@ -118,6 +118,30 @@ struct _GtkRecentManagerClass
   void (*_gtk_recent4) (void);
 };
 
+/**
+ * GtkRecentSortType:
+ * @GTK_RECENT_SORT_NONE: Do not sort the returned list of recently used
+ *   resources.
+ * @GTK_RECENT_SORT_MRU: Sort the returned list with the most recently used
+ *   items first.
+ * @GTK_RECENT_SORT_LRU: Sort the returned list with the least recently used
+ *   items first.
+ * @GTK_RECENT_SORT_CUSTOM: Sort the returned list using a custom sorting
+ *   function passed using gtk_recent_manager_set_sort_func().
+ *
+ * Used to specify the sorting method to be applyed to the recently
+ * used resource list.
+ *
+ * Since: 2.10
+ */
+typedef enum
+{
+  GTK_RECENT_SORT_NONE = 0,
+  GTK_RECENT_SORT_MRU,
+  GTK_RECENT_SORT_LRU,
+  GTK_RECENT_SORT_CUSTOM
+} GtkRecentSortType;
+
 /**
  * GtkRecentManagerError:
  * @GTK_RECENT_MANAGER_ERROR_NOT_FOUND: the URI specified does not exists in
@@ -182,6 +206,9 @@ gboolean          gtk_recent_manager_move_item      (GtkRecentManager     *manag
 						     const gchar          *new_uri,
 						     GError              **error);
 GList *           gtk_recent_manager_get_items      (GtkRecentManager     *manager);
+GList *           gtk_recent_manager_query_items    (GtkRecentManager     *manager,
+						     GtkRecentSortType     sort_type,
+						     gint                  limit);
 gint              gtk_recent_manager_purge_items    (GtkRecentManager     *manager,
 						     GError              **error);
 
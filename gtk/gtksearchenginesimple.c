@@ -22,26 +22,40 @@
 
 #include "config.h"
 
-/* these must be defined even when HAVE_GNU_FTW is not defined
- * because (really) old versions of GNU libc have ftw.h but do
- * export ftw() and friends only if _XOPEN_SOURCE and _GNU_SOURCE
- * are defined. see bug #444097.
- */
-#define _XOPEN_SOURCE 500
-#define _GNU_SOURCE 
-
-#ifdef HAVE_FTW_H
-#include <ftw.h>
-#endif
-
 #include <gdk/gdk.h>
 
 #include "gtksearchenginesimple.h"
+#include "gtksettings.h"
 #include "gtkprivate.h"
 
+#include <glib/gstdio.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
 #include <string.h>
+#include <time.h>
+
+#ifdef G_OS_UNIX
+#include <dirent.h>
+#endif
 
 #define BATCH_SIZE 500
+#define N_SEARCH_THREADS 4
+
+/* The most names the index records, about a few megabytes on disk */
+#define MAX_INDEXED_NAMES 100000
+
+#define INDEX_HEADER "GtkSearchIndex 1"
+
+/* A directory as recorded in the name index: its mtime when it was
+ * read, and the names of its children, each prefixed with 'd' for
+ * directories or 'f' for anything else.
+ */
+typedef struct
+{
+  time_t mtime;
+  gchar **names;
+} IndexedDir;
 
 typedef struct 
 {
@@ -49,10 +63,23 @@ typedef struct
   
   gchar *path;
   gchar **words;
-  GList *found_list;
-  
+
+  /* whether GtkSettings:gtk-file-search-index was set */
+  gboolean use_index;
+
+  /* the name index from the previous search below path, read-only */
+  GHashTable *index;
+
+  GThreadPool *pool;
+  GMutex *mutex;
+  GCond *cond;
+
+  /* protected by mutex: */
   gint n_processed_files;
   GList *uri_hits;
+  gint n_pending_dirs;
+  GHashTable *new_index;
+  gint n_indexed_names;
   
   /* accessed on both threads: */
   volatile gboolean cancelled;
@@ -95,11 +122,234 @@ gtk_search_engine_simple_dispose (GObject *object)
   G_OBJECT_CLASS (_gtk_search_engine_simple_parent_class)->dispose (object);
 }
 
+static void
+indexed_dir_free (IndexedDir *dir)
+{
+  g_strfreev (dir->names);
+  g_slice_free (IndexedDir, dir);
+}
+
+static GHashTable *
+index_new (void)
+{
+  return g_hash_table_new_full (g_str_hash, g_str_equal,
+                                g_free, (GDestroyNotify) indexed_dir_free);
+}
+
+static gchar *
+get_index_filename (const gchar *path)
+{
+  gchar *checksum, *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, path, -1);
+  filename = g_build_filename (g_get_user_cache_dir (),
+                               "gtk-3.0", "search-index", checksum,
+                               NULL);
+  g_free (checksum);
+
+  return filename;
+}
+
+/* The index starts with a header line, followed by a list of records,
+ * each one line with the mtime and path of a directory, followed by
+ * one line per child, and ended by an empty line. Directories with
+ * newlines in any name are left out. Both reading and writing go
+ * through streams a line at a time, and stop at MAX_INDEXED_NAMES.
+ */
+static GHashTable *
+index_load (const gchar *path)
+{
+  GHashTable *index = NULL;
+  GFile *file;
+  GFileInputStream *file_stream;
+  GDataInputStream *stream;
+  GPtrArray *names = NULL;
+  gchar *line, *dir_path = NULL;
+  time_t mtime = 0;
+  gint n_names = 0;
+  gchar *filename;
+
+  filename = get_index_filename (path);
+  file = g_file_new_for_path (filename);
+  g_free (filename);
+
+  file_stream = g_file_read (file, NULL, NULL);
+  g_object_unref (file);
+  if (file_stream == NULL)
+    return NULL;
+
+  stream = g_data_input_stream_new (G_INPUT_STREAM (file_stream));
+  g_object_unref (file_stream);
+
+  line = g_data_input_stream_read_line (stream, NULL, NULL, NULL);
+  if (g_strcmp0 (line, INDEX_HEADER) != 0)
+    {
+      g_free (line);
+      g_object_unref (stream);
+      return NULL;
+    }
+  g_free (line);
+
+  index = index_new ();
+
+  while (n_names < MAX_INDEXED_NAMES &&
+         (line = g_data_input_stream_read_line (stream, NULL, NULL, NULL)) != NULL)
+    {
+      if (dir_path == NULL)
+        {
+          gchar *tab = strchr (line, '\t');
+
+          if (tab == NULL)
+            {
+              g_free (line);
+              break;
+            }
+
+          mtime = g_ascii_strtoll (line, NULL, 10);
+          dir_path = g_strdup (tab + 1);
+          names = g_ptr_array_new ();
+        }
+      else if (line[0] != '\0')
+        {
+          g_ptr_array_add (names, line);
+          n_names++;
+          continue;
+        }
+      else
+        {
+          IndexedDir *dir;
+
+          g_ptr_array_add (names, NULL);
+
+          dir = g_slice_new (IndexedDir);
+          dir->mtime = mtime;
+          dir->names = (gchar **) g_ptr_array_free (names, FALSE);
+          names = NULL;
+
+          g_hash_table_replace (index, dir_path, dir);
+          dir_path = NULL;
+        }
+
+      g_free (line);
+    }
+
+  /* Drop a record cut short */
+  if (names)
+    {
+      g_ptr_array_foreach (names, (GFunc) g_free, NULL);
+      g_ptr_array_free (names, TRUE);
+    }
+  g_free (dir_path);
+
+  g_object_unref (stream);
+
+  return index;
+}
+
+static gboolean
+index_write_dir (GDataOutputStream *stream,
+                 const gchar       *path,
+                 IndexedDir        *dir,
+                 GError           **error)
+{
+  gchar *line;
+  gboolean retval;
+  gint i;
+
+  line = g_strdup_printf ("%" G_GINT64_FORMAT "\t%s\n", (gint64) dir->mtime, path);
+  retval = g_data_output_stream_put_string (stream, line, NULL, error);
+  g_free (line);
+
+  for (i = 0; retval && dir->names[i] != NULL; i++)
+    retval = g_data_output_stream_put_string (stream, dir->names[i], NULL, error) &&
+             g_data_output_stream_put_byte (stream, '\n', NULL, error);
+
+  return retval && g_data_output_stream_put_byte (stream, '\n', NULL, error);
+}
+
+static void
+index_save (const gchar *path,
+            GHashTable  *index)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  GFile *file;
+  GFileOutputStream *file_stream;
+  GDataOutputStream *stream;
+  GError *error = NULL;
+  gchar *filename, *dirname;
+  gboolean ok;
+
+  filename = get_index_filename (path);
+  dirname = g_path_get_dirname (filename);
+
+  if (g_mkdir_with_parents (dirname, 0700) != 0)
+    {
+      g_free (dirname);
+      g_free (filename);
+      return;
+    }
+
+  /* The index lists file names, so keep it to the user */
+  file = g_file_new_for_path (filename);
+  file_stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_PRIVATE, NULL, NULL);
+
+  g_free (dirname);
+  g_free (filename);
+
+  if (file_stream == NULL)
+    {
+      g_object_unref (file);
+      return;
+    }
+
+  stream = g_data_output_stream_new (g_buffered_output_stream_new (G_OUTPUT_STREAM (file_stream)));
+  g_object_unref (g_filter_output_stream_get_base_stream (G_FILTER_OUTPUT_STREAM (stream)));
+
+  ok = g_data_output_stream_put_string (stream, INDEX_HEADER "\n", NULL, &error);
+
+  g_hash_table_iter_init (&iter, index);
+  while (ok && g_hash_table_iter_next (&iter, &key, &value))
+    ok = index_write_dir (stream, key, value, &error);
+
+  if (ok)
+    ok = g_output_stream_close (G_OUTPUT_STREAM (stream), NULL, &error);
+
+  /* A partial index is useless, drop it */
+  if (!ok)
+    {
+      GCancellable *cancellable;
+
+      cancellable = g_cancellable_new ();
+      g_cancellable_cancel (cancellable);
+      g_output_stream_close (G_OUTPUT_STREAM (stream), cancellable, NULL);
+      g_object_unref (cancellable);
+
+      g_file_delete (file, NULL, NULL);
+      g_error_free (error);
+    }
+
+  g_object_unref (stream);
+  g_object_unref (file_stream);
+  g_object_unref (file);
+}
+
+static void
+index_remove (const gchar *path)
+{
+  gchar *filename;
+
+  filename = get_index_filename (path);
+  g_unlink (filename);
+  g_free (filename);
+}
+
 static SearchThreadData *
 search_thread_data_new (GtkSearchEngineSimple *engine,
 			GtkQuery              *query)
 {
   SearchThreadData *data;
+  GtkSettings *settings;
   char *text, *lower, *uri;
   
   data = g_new0 (SearchThreadData, 1);
@@ -119,6 +369,14 @@ search_thread_data_new (GtkSearchEngineSimple *engine,
   data->words = g_strsplit (lower, " ", -1);
   g_free (text);
   g_free (lower);
+
+  settings = gtk_settings_get_default ();
+  if (settings)
+    g_object_get (settings, "gtk-file-search-index", &data->use_index, NULL);
+
+  data->mutex = g_mutex_new ();
+  data->cond = g_cond_new ();
+  data->new_index = index_new ();
   
   return data;
 }
@@ -129,6 +387,11 @@ search_thread_data_free (SearchThreadData *data)
   g_object_unref (data->engine);
   g_free (data->path);
   g_strfreev (data->words);
+  if (data->index)
+    g_hash_table_destroy (data->index);
+  g_hash_table_destroy (data->new_index);
+  g_mutex_free (data->mutex);
+  g_cond_free (data->cond);
   g_free (data);
 }
 
@@ -175,6 +438,7 @@ search_thread_add_hits_idle (gpointer user_data)
   return FALSE;
 }
 
+/* Called with data->mutex held */
 static void
 send_batch (SearchThreadData *data)
 {
@@ -194,100 +458,267 @@ send_batch (SearchThreadData *data)
   data->uri_hits = NULL;
 }
 
-static GStaticPrivate search_thread_data = G_STATIC_PRIVATE_INIT;
+#ifdef G_OS_UNIX
 
-#ifdef HAVE_FTW_H
-static int
-search_visit_func (const char        *fpath,
-		   const struct stat *sb,
-		   int                typeflag,
-		   struct FTW        *ftwbuf)
+/* Like strstr (g_ascii_strdown (name), word), for a lowercase
+ * @word, but without allocating
+ */
+static gboolean
+name_contains_word (const gchar *name,
+                    const gchar *word)
 {
-  SearchThreadData *data;
+  const gchar *p;
   gint i;
-  const gchar *name; 
-  gchar *lower_name;
-  gchar *uri;
-  gboolean hit;
-  gboolean is_hidden;
-  
-  data = (SearchThreadData*)g_static_private_get (&search_thread_data);
 
-  if (data->cancelled)
-#ifdef HAVE_GNU_FTW
-    return FTW_STOP;
-#else
-    return 1;
-#endif /* HAVE_GNU_FTW */
+  if (word[0] == '\0')
+    return TRUE;
 
-  name = strrchr (fpath, '/');
-  if (name)
-    name++;
-  else
-    name = fpath;
+  for (p = name; *p != '\0'; p++)
+    {
+      for (i = 0; word[i] != '\0' && g_ascii_tolower (p[i]) == word[i]; i++)
+        ;
 
-  is_hidden = *name == '.';
-	
-  hit = FALSE;
-  
-  if (!is_hidden) 
+      if (word[i] == '\0')
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static gboolean
+name_matches (SearchThreadData *data,
+              const gchar      *name)
+{
+  gint i;
+
+  for (i = 0; data->words[i] != NULL; i++)
     {
-      lower_name = g_ascii_strdown (name, -1);
-      
-      hit = TRUE;
-      for (i = 0; data->words[i] != NULL; i++) 
-	{
-	  if (strstr (lower_name, data->words[i]) == NULL) 
-	    {
-	      hit = FALSE;
-	      break;
-	    }
-	}
-      g_free (lower_name);
+      if (!name_contains_word (name, data->words[i]))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+search_index_dir (SearchThreadData  *data,
+                  const gchar       *path,
+                  time_t             mtime,
+                  gchar            **names)
+{
+  IndexedDir *indexed;
+  guint n_names;
+
+  n_names = g_strv_length (names);
+
+  g_mutex_lock (data->mutex);
+
+  if (data->n_indexed_names + n_names <= MAX_INDEXED_NAMES)
+    {
+      indexed = g_slice_new (IndexedDir);
+      indexed->mtime = mtime;
+      indexed->names = g_strdupv (names);
+
+      g_hash_table_replace (data->new_index, g_strdup (path), indexed);
+      data->n_indexed_names += n_names;
     }
 
-  if (hit) 
+  g_mutex_unlock (data->mutex);
+}
+
+/* Returns the children of @path as stored in the index, reading
+ * the directory only if it changed since the index was written.
+ */
+static gchar **
+search_read_dir (SearchThreadData *data,
+                 const gchar      *path)
+{
+  IndexedDir *indexed = NULL;
+  struct stat st;
+  GPtrArray *names;
+  DIR *dir;
+  struct dirent *entry;
+  gboolean indexable;
+
+  if (g_stat (path, &st) != 0 || !S_ISDIR (st.st_mode))
+    return NULL;
+
+  if (data->index)
+    indexed = g_hash_table_lookup (data->index, path);
+
+  if (indexed && indexed->mtime == st.st_mtime)
     {
-      uri = g_filename_to_uri (fpath, NULL, NULL);
-      data->uri_hits = g_list_prepend (data->uri_hits, uri);
+      search_index_dir (data, path, indexed->mtime, indexed->names);
+
+      return g_strdupv (indexed->names);
     }
 
-  data->n_processed_files++;
-  
+  dir = opendir (path);
+  if (dir == NULL)
+    return NULL;
+
+  names = g_ptr_array_new ();
+
+  /* A directory changed in the same second as we read it could
+   * change again without its mtime changing
+   */
+  indexable = data->use_index &&
+              strchr (path, '\n') == NULL && st.st_mtime < time (NULL) - 1;
+
+  while (!data->cancelled && (entry = readdir (dir)) != NULL)
+    {
+      const gchar *name = entry->d_name;
+      gboolean is_dir;
+
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+        continue;
+
+#ifdef HAVE_STRUCT_DIRENT_D_TYPE
+      if (entry->d_type != DT_UNKNOWN)
+        is_dir = entry->d_type == DT_DIR;
+      else
+#endif
+        {
+          struct stat child_st;
+          gchar *child;
+
+          child = g_build_filename (path, name, NULL);
+          is_dir = g_lstat (child, &child_st) == 0 && S_ISDIR (child_st.st_mode);
+          g_free (child);
+        }
+
+      if (strchr (name, '\n') != NULL)
+        indexable = FALSE;
+
+      g_ptr_array_add (names, g_strconcat (is_dir ? "d" : "f", name, NULL));
+    }
+
+  closedir (dir);
+
+  g_ptr_array_add (names, NULL);
+
+  /* Record the mtime we saw before reading, so that changes made
+   * while we were reading are picked up next time
+   */
+  if (indexable && !data->cancelled)
+    search_index_dir (data, path, st.st_mtime, (gchar **) names->pdata);
+
+  return (gchar **) g_ptr_array_free (names, FALSE);
+}
+
+static void
+search_visit_dir (gpointer task_data,
+                  gpointer user_data)
+{
+  SearchThreadData *data = user_data;
+  gchar *path = task_data;
+  gchar **names = NULL;
+  GList *hits = NULL;
+  gint i;
+
+  if (!data->cancelled)
+    names = search_read_dir (data, path);
+
+  for (i = 0; names && names[i] != NULL && !data->cancelled; i++)
+    {
+      const gchar *name = names[i] + 1;
+      gboolean is_dir = names[i][0] == 'd';
+      gboolean hit;
+      gchar *child;
+
+      /* Hidden files don't match, and hidden directories
+       * are not searched
+       */
+      if (name[0] == '.')
+        continue;
+
+      hit = name_matches (data, name);
+      if (!hit && !is_dir)
+        continue;
+
+      child = g_build_filename (path, name, NULL);
+
+      if (hit)
+        {
+          gchar *uri = g_filename_to_uri (child, NULL, NULL);
+
+          if (uri)
+            hits = g_list_prepend (hits, uri);
+        }
+
+      if (is_dir)
+        {
+          g_mutex_lock (data->mutex);
+          data->n_pending_dirs++;
+          g_mutex_unlock (data->mutex);
+
+          g_thread_pool_push (data->pool, child, NULL);
+        }
+      else
+        g_free (child);
+    }
+
+  g_mutex_lock (data->mutex);
+
+  data->uri_hits = g_list_concat (hits, data->uri_hits);
+  data->n_processed_files += i;
+
   if (data->n_processed_files > BATCH_SIZE)
     send_batch (data);
 
-#ifdef HAVE_GNU_FTW
-  if (is_hidden)
-    return FTW_SKIP_SUBTREE;
-  else
-    return FTW_CONTINUE;
-#else
-  return 0;
-#endif /* HAVE_GNU_FTW */
+  data->n_pending_dirs--;
+  if (data->n_pending_dirs == 0)
+    g_cond_signal (data->cond);
+
+  g_mutex_unlock (data->mutex);
+
+  g_strfreev (names);
+  g_free (path);
 }
-#endif /* HAVE_FTW_H */
 
+#endif /* G_OS_UNIX */
+
+/* Directories are searched in parallel on a small thread pool; every
+ * directory found is pushed back onto the pool as a new task, and this
+ * thread waits until no directory is left.
+ */
 static gpointer 
 search_thread_func (gpointer user_data)
 {
-#ifdef HAVE_FTW_H
+#ifdef G_OS_UNIX
   SearchThreadData *data;
   
   data = user_data;
-  
-  g_static_private_set (&search_thread_data, data, NULL);
 
-  nftw (data->path, search_visit_func, 20,
-#ifdef HAVE_GNU_FTW
-        FTW_ACTIONRETVAL |
-#endif
-        FTW_PHYS);
+  if (data->use_index)
+    data->index = index_load (data->path);
+  else
+    index_remove (data->path);
+
+  data->pool = g_thread_pool_new (search_visit_dir, data,
+                                  N_SEARCH_THREADS, FALSE, NULL);
+
+  data->n_pending_dirs = 1;
+  g_thread_pool_push (data->pool, g_strdup (data->path), NULL);
+
+  g_mutex_lock (data->mutex);
+  while (data->n_pending_dirs > 0)
+    g_cond_wait (data->cond, data->mutex);
+  g_mutex_unlock (data->mutex);
+
+  g_thread_pool_free (data->pool, FALSE, TRUE);
+  data->pool = NULL;
+
+  if (data->use_index && !data->cancelled)
+    index_save (data->path, data->new_index);
 
+  g_mutex_lock (data->mutex);
   send_batch (data);
+  g_mutex_unlock (data->mutex);
   
   gdk_threads_add_idle (search_thread_done_idle, data);
-#endif /* HAVE_FTW_H */
+#endif /* G_OS_UNIX */
   
   return NULL;
 }
@@ -377,7 +808,7 @@ _gtk_search_engine_simple_init (GtkSearchEngineSimple *engine)
 GtkSearchEngine *
 _gtk_search_engine_simple_new (void)
 {
-#ifdef HAVE_FTW_H
+#ifdef G_OS_UNIX
   return g_object_new (GTK_TYPE_SEARCH_ENGINE_SIMPLE, NULL);
 #else
   return NULL;
@@ -30,6 +30,7 @@
 #include "gtkwidget.h"
 #include "gtkprivate.h"
 #include "gtkcssproviderprivate.h"
+#include "gtkstylecontextprivate.h"
 #include "gtksymboliccolor.h"
 #include "gtktypebuiltins.h"
 #include "gtkversion.h"
@@ -196,7 +197,9 @@ enum {
   PROP_LABEL_SELECT_ON_FOCUS,
   PROP_COLOR_PALETTE,
   PROP_IM_PREEDIT_STYLE,
-  PROP_IM_STATUS_STYLE
+  PROP_IM_STATUS_STYLE,
+  PROP_RECENT_FILES_JOURNAL,
+  PROP_FILE_SEARCH_INDEX
 };
 
 /* --- prototypes --- */
@@ -1296,6 +1299,53 @@ gtk_settings_class_init (GtkSettingsClass *class)
                                              gtk_rc_property_parse_enum);
   g_assert (result == PROP_IM_STATUS_STYLE);
 
+  /**
+   * GtkSettings:gtk-recent-files-journal:
+   *
+   * Whether #GtkRecentManager should record changes to the recently
+   * used resources list by appending them to a journal next to the
+   * list, instead of rewriting the whole list each time. The list
+   * itself is rewritten when the journal grows too large.
+   *
+   * All the applications sharing the list should agree on this
+   * setting, since applications that do not use the journal will
+   * only see the changes recorded in it once the list is rewritten.
+   *
+   * Since: 3.2
+   */
+  result = settings_install_property_parser (class,
+                                             g_param_spec_boolean ("gtk-recent-files-journal",
+                                                                   P_("Recent Files Journal"),
+                                                                   P_("Whether to append changes to the recently used files list to a journal"),
+                                                                   FALSE,
+                                                                   GTK_PARAM_READWRITE),
+                                             NULL);
+  g_assert (result == PROP_RECENT_FILES_JOURNAL);
+
+  /**
+   * GtkSettings:gtk-file-search-index:
+   *
+   * Whether searching for files in #GtkFileChooser without an indexed
+   * search engine should keep an index of the names found below the
+   * folder that was searched, so that later searches only have to read
+   * the directories that changed since.
+   *
+   * The index is stored in the user's cache directory and lists the
+   * names of the files that were searched, so it is off by default.
+   * Turning it off removes the index of a folder the next time it is
+   * searched.
+   *
+   * Since: 3.2
+   */
+  result = settings_install_property_parser (class,
+                                             g_param_spec_boolean ("gtk-file-search-index",
+                                                                   P_("File Search Index"),
+                                                                   P_("Whether to keep an index of file names for searching"),
+                                                                   FALSE,
+                                                                   GTK_PARAM_READWRITE),
+                                             NULL);
+  g_assert (result == PROP_FILE_SEARCH_INDEX);
+
   g_type_class_add_private (class, sizeof (GtkSettingsPrivate));
 }
 
@@ -1605,6 +1655,10 @@ gtk_settings_notify (GObject    *object,
   if (priv->screen == NULL) /* initialization */
     return;
 
+  /* Styles from gtk_settings_get_style() may have changed */
+  if (property_id == PROP_FONT_NAME || property_id == PROP_COLOR_SCHEME)
+    _gtk_style_context_invalidate_style_cache ();
+
   switch (property_id)
     {
     case PROP_MODULES:
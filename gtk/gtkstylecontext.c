@@ -24,6 +24,7 @@
 #include <gobject/gvaluecollector.h>
 
 #include "gtkstylecontextprivate.h"
+#include "gtkstylepropertiesprivate.h"
 #include "gtktypebuiltins.h"
 #include "gtkthemingengine.h"
 #include "gtkintl.h"
@@ -35,6 +36,9 @@
 #include "gtktimeline.h"
 #include "gtkiconfactory.h"
 #include "gtkwidgetprivate.h"
+#include "gtkwidgetpathprivate.h"
+#include "gtkcssprovider.h"
+#include "gtksettings.h"
 
 /**
  * SECTION:gtkstylecontext
@@ -413,6 +417,7 @@ typedef struct GtkRegion GtkRegion;
 typedef struct PropertyValue PropertyValue;
 typedef struct AnimationInfo AnimationInfo;
 typedef struct StyleData StyleData;
+typedef struct StyleCache StyleCache;
 
 struct GtkRegion
 {
@@ -447,6 +452,22 @@ struct StyleData
   GtkStyleProperties *store;
   GSList *icon_factories;
   GArray *property_cache;
+  guint ref_count;
+
+  /* The shared cache holding this style, and its key there */
+  StyleCache *cache;
+  GtkWidgetPath *cache_path;
+};
+
+/* Screen-wide cache of resolved styles, shared by all
+ * contexts that only use the screen providers. It does
+ * not hold references of its own, styles are removed
+ * when the last context using them lets go.
+ */
+struct StyleCache
+{
+  GHashTable *styles;
+  guint serial;
 };
 
 struct AnimationInfo
@@ -505,6 +526,8 @@ enum {
 static guint signals[LAST_SIGNAL] = { 0 };
 
 static GQuark provider_list_quark = 0;
+static GQuark style_cache_quark = 0;
+static guint style_cache_serial = 0;
 static GdkRGBA fallback_color = { 1.0, 0.75, 0.75, 1.0 };
 static GtkBorder fallback_border = { 0 };
 
@@ -664,6 +687,15 @@ style_data_new (void)
 
   data = g_slice_new0 (StyleData);
   data->store = gtk_style_properties_new ();
+  data->ref_count = 1;
+
+  return data;
+}
+
+static StyleData *
+style_data_ref (StyleData *data)
+{
+  data->ref_count++;
 
   return data;
 }
@@ -689,8 +721,16 @@ clear_property_cache (StyleData *data)
 }
 
 static void
-style_data_free (StyleData *data)
+style_data_unref (StyleData *data)
 {
+  data->ref_count--;
+
+  if (data->ref_count > 0)
+    return;
+
+  if (data->cache)
+    g_hash_table_remove (data->cache->styles, data->cache_path);
+
   g_object_unref (data->store);
   clear_property_cache (data);
 
@@ -713,7 +753,7 @@ gtk_style_context_init (GtkStyleContext *style_context)
   priv->style_data = g_hash_table_new_full (style_info_hash,
                                             style_info_equal,
                                             (GDestroyNotify) style_info_free,
-                                            (GDestroyNotify) style_data_free);
+                                            (GDestroyNotify) style_data_unref);
   priv->theming_engine = g_object_ref ((gpointer) gtk_theming_engine_load (NULL));
 
   priv->direction = GTK_TEXT_DIR_LTR;
@@ -795,9 +835,10 @@ timeline_frame_cb (GtkTimeline *timeline,
 
   g_assert (info != NULL);
 
-  /* Cancel transition if window is gone */
-  if (gdk_window_is_destroyed (info->window) ||
-      !gdk_window_is_visible (info->window))
+  /* Cancel transition if window is gone, the timeline
+   * itself holds still while the window is unmapped.
+   */
+  if (gdk_window_is_destroyed (info->window))
     {
       priv->animations = g_slist_remove (priv->animations, info);
       animation_info_free (info);
@@ -860,6 +901,7 @@ animation_info_new (GtkStyleContext         *context,
 
   _gtk_timeline_set_progress_type (info->timeline, progress_type);
   _gtk_timeline_set_loop (info->timeline, loop);
+  _gtk_timeline_set_window (info->timeline, window);
 
   if (!loop && !target_value)
     {
@@ -1122,6 +1164,122 @@ create_query_path (GtkStyleContext *context)
   return path;
 }
 
+/* Forgets about all shared styles; contexts still
+ * using them keep them as private styles.
+ */
+static void
+style_cache_clear (StyleCache *cache)
+{
+  GHashTableIter iter;
+  StyleData *data;
+
+  g_hash_table_iter_init (&iter, cache->styles);
+
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &data))
+    {
+      data->cache = NULL;
+      data->cache_path = NULL;
+    }
+
+  g_hash_table_remove_all (cache->styles);
+}
+
+static void
+style_cache_free (StyleCache *cache)
+{
+  style_cache_clear (cache);
+  g_hash_table_destroy (cache->styles);
+  g_slice_free (StyleCache, cache);
+}
+
+/* Whether all providers on @screen tell when their
+ * contents change, see _gtk_style_context_invalidate_style_cache()
+ */
+static gboolean
+screen_providers_notify_changes (GdkScreen *screen)
+{
+  GList *list;
+
+  if (!provider_list_quark)
+    return TRUE;
+
+  list = g_object_get_qdata (G_OBJECT (screen), provider_list_quark);
+
+  while (list)
+    {
+      GtkStyleProviderData *data = list->data;
+
+      if (!GTK_IS_CSS_PROVIDER (data->provider) &&
+          !GTK_IS_SETTINGS (data->provider))
+        return FALSE;
+
+      list = list->next;
+    }
+
+  return TRUE;
+}
+
+/* Returns the cache of shared styles for @context, or
+ * %NULL if the context can't share styles with others.
+ */
+static StyleCache *
+style_cache_get (GtkStyleContext *context)
+{
+  GtkStyleContextPrivate *priv;
+  StyleCache *cache;
+
+  priv = context->priv;
+
+  /* Styles from context-specific providers can't be shared */
+  if (!priv->screen || priv->providers)
+    return NULL;
+
+  /* Nor can styles from providers that may change
+   * without telling anybody
+   */
+  if (!screen_providers_notify_changes (priv->screen))
+    return NULL;
+
+  if (G_UNLIKELY (!style_cache_quark))
+    style_cache_quark = g_quark_from_static_string ("gtk-style-cache-quark");
+
+  cache = g_object_get_qdata (G_OBJECT (priv->screen), style_cache_quark);
+
+  if (!cache)
+    {
+      cache = g_slice_new (StyleCache);
+      cache->styles = g_hash_table_new_full (_gtk_widget_path_hash,
+                                             _gtk_widget_path_equal,
+                                             (GDestroyNotify) gtk_widget_path_free,
+                                             NULL);
+      cache->serial = style_cache_serial;
+
+      g_object_set_qdata_full (G_OBJECT (priv->screen), style_cache_quark,
+                               cache, (GDestroyNotify) style_cache_free);
+    }
+  else if (cache->serial != style_cache_serial)
+    {
+      /* Some provider changed its contents */
+      style_cache_clear (cache);
+      cache->serial = style_cache_serial;
+    }
+
+  return cache;
+}
+
+/*
+ * _gtk_style_context_invalidate_style_cache:
+ *
+ * Drops all shared styles, to be called when a style
+ * provider changes its contents, so contexts don't
+ * pick up stale styles the next time they're invalidated.
+ */
+void
+_gtk_style_context_invalidate_style_cache (void)
+{
+  style_cache_serial++;
+}
+
 static StyleData *
 style_data_lookup (GtkStyleContext *context)
 {
@@ -1140,19 +1298,40 @@ style_data_lookup (GtkStyleContext *context)
 
   if (!data)
     {
+      StyleCache *cache;
       GtkWidgetPath *path;
 
-      data = style_data_new ();
       path = create_query_path (context);
+      cache = style_cache_get (context);
 
-      build_properties (context, data, path);
-      build_icon_factories (context, data, path);
+      if (cache)
+        data = g_hash_table_lookup (cache->styles, path);
+
+      if (data)
+        {
+          style_data_ref (data);
+          gtk_widget_path_free (path);
+        }
+      else
+        {
+          data = style_data_new ();
+
+          build_properties (context, data, path);
+          build_icon_factories (context, data, path);
+
+          if (cache)
+            {
+              data->cache = cache;
+              data->cache_path = path;
+              g_hash_table_insert (cache->styles, path, data);
+            }
+          else
+            gtk_widget_path_free (path);
+        }
 
       g_hash_table_insert (priv->style_data,
                            style_info_copy (priv->info_stack->data),
                            data);
-
-      gtk_widget_path_free (path);
     }
 
   priv->current_data = data;
@@ -1342,6 +1521,9 @@ gtk_style_context_remove_provider (GtkStyleContext  *context,
  * its appearance. As an example, it is used when the color scheme changes
  * in the related #GtkSettings object.
  *
+ * Styles shared between widgets with the same #GtkWidgetPath
+ * on @screen are dropped as well.
+ *
  * Since: 3.0
  **/
 void
@@ -1351,6 +1533,9 @@ gtk_style_context_reset_widgets (GdkScreen *screen)
 
   _gtk_icon_set_invalidate_caches ();
 
+  if (style_cache_quark)
+    g_object_set_qdata (G_OBJECT (screen), style_cache_quark, NULL);
+
   toplevels = gtk_window_list_toplevels ();
   g_list_foreach (toplevels, (GFunc) g_object_ref, NULL);
 
@@ -3362,8 +3547,9 @@ gtk_style_context_get_color (GtkStyleContext *context,
   g_return_if_fail (priv->widget_path != NULL);
 
   data = style_data_lookup (context);
-  value = _gtk_style_properties_peek_property (data->store,
-                                               "color", state);
+  value = _gtk_style_properties_peek_property_by_id (data->store,
+                                                     GTK_STYLE_PROPERTY_ID_COLOR,
+                                                     state);
 
   if (value)
     {
@@ -3401,8 +3587,9 @@ gtk_style_context_get_background_color (GtkStyleContext *context,
   g_return_if_fail (priv->widget_path != NULL);
 
   data = style_data_lookup (context);
-  value = _gtk_style_properties_peek_property (data->store,
-                                               "background-color", state);
+  value = _gtk_style_properties_peek_property_by_id (data->store,
+                                                     GTK_STYLE_PROPERTY_ID_BACKGROUND_COLOR,
+                                                     state);
 
   if (value)
     {
@@ -3440,8 +3627,9 @@ gtk_style_context_get_border_color (GtkStyleContext *context,
   g_return_if_fail (priv->widget_path != NULL);
 
   data = style_data_lookup (context);
-  value = _gtk_style_properties_peek_property (data->store,
-                                               "border-color", state);
+  value = _gtk_style_properties_peek_property_by_id (data->store,
+                                                     GTK_STYLE_PROPERTY_ID_BORDER_COLOR,
+                                                     state);
 
   if (value)
     {
@@ -3480,8 +3668,9 @@ gtk_style_context_get_border (GtkStyleContext *context,
   g_return_if_fail (priv->widget_path != NULL);
 
   data = style_data_lookup (context);
-  value = _gtk_style_properties_peek_property (data->store,
-                                               "border-width", state);
+  value = _gtk_style_properties_peek_property_by_id (data->store,
+                                                     GTK_STYLE_PROPERTY_ID_BORDER_WIDTH,
+                                                     state);
 
   if (value)
     {
@@ -3520,8 +3709,9 @@ gtk_style_context_get_padding (GtkStyleContext *context,
   g_return_if_fail (priv->widget_path != NULL);
 
   data = style_data_lookup (context);
-  value = _gtk_style_properties_peek_property (data->store,
-                                               "padding", state);
+  value = _gtk_style_properties_peek_property_by_id (data->store,
+                                                     GTK_STYLE_PROPERTY_ID_PADDING,
+                                                     state);
 
   if (value)
     {
@@ -3560,8 +3750,9 @@ gtk_style_context_get_margin (GtkStyleContext *context,
   g_return_if_fail (priv->widget_path != NULL);
 
   data = style_data_lookup (context);
-  value = _gtk_style_properties_peek_property (data->store,
-                                               "margin", state);
+  value = _gtk_style_properties_peek_property_by_id (data->store,
+                                                     GTK_STYLE_PROPERTY_ID_MARGIN,
+                                                     state);
 
   if (value)
     {
@@ -3599,7 +3790,9 @@ gtk_style_context_get_font (GtkStyleContext *context,
   g_return_val_if_fail (priv->widget_path != NULL, NULL);
 
   data = style_data_lookup (context);
-  value = _gtk_style_properties_peek_property (data->store, "font", state);
+  value = _gtk_style_properties_peek_property_by_id (data->store,
+                                                     GTK_STYLE_PROPERTY_ID_FONT,
+                                                     state);
 
   if (value)
     return g_value_get_boxed (value);
@@ -33,6 +33,7 @@ void           _gtk_style_context_invalidate_animation_areas (GtkStyleContext *c
 void           _gtk_style_context_coalesce_animation_areas   (GtkStyleContext *context,
                                                               GtkWidget       *widget);
 gboolean       _gtk_style_context_check_region_name          (const gchar     *str);
+void           _gtk_style_context_invalidate_style_cache     (void);
 
 void           _gtk_style_context_get_cursor_color           (GtkStyleContext *context,
                                                               GdkRGBA         *primary_color,
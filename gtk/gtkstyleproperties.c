@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include "gtkstyleproperties.h"
+#include "gtkstylepropertiesprivate.h"
 
 #include <stdlib.h>
 #include <gobject/gvaluecollector.h>
@@ -65,6 +66,7 @@ struct PropertyNode
   GQuark property_quark;
   GParamSpec *pspec;
   GtkStylePropertyParser parse_func;
+  guint id;
 };
 
 struct ValueData
@@ -82,9 +84,17 @@ struct GtkStylePropertiesPrivate
 {
   GHashTable *color_map;
   GHashTable *properties;
+
+  /* Resolved values for every property, indexed by
+   * property id, one array per looked up state.
+   */
+  GHashTable *compiled;
+  GPtrArray *last_compiled;
+  GtkStateFlags last_compiled_state;
 };
 
 static GArray *properties = NULL;
+static guint n_property_ids = 0;
 
 static void gtk_style_properties_provider_init (GtkStyleProviderIface *iface);
 static void gtk_style_properties_finalize      (GObject      *object);
@@ -101,7 +111,12 @@ gtk_style_properties_class_init (GtkStylePropertiesClass *klass)
 
   object_class->finalize = gtk_style_properties_finalize;
 
-  /* Initialize default property set */
+  if (G_UNLIKELY (!properties))
+    properties = g_array_new (FALSE, TRUE, sizeof (PropertyNode));
+
+  /* Initialize default property set, the registration
+   * order must match the GtkStylePropertyId enum.
+   */
   gtk_style_properties_register_property (NULL,
                                           g_param_spec_boxed ("color",
                                                               "Foreground color",
@@ -179,6 +194,8 @@ gtk_style_properties_class_init (GtkStylePropertiesClass *klass)
                                                               G_TYPE_PTR_ARRAY, 0));
 
   g_type_class_add_private (object_class, sizeof (GtkStylePropertiesPrivate));
+
+  g_assert (n_property_ids >= GTK_STYLE_PROPERTY_N_BUILTIN_IDS);
 }
 
 static PropertyData *
@@ -335,6 +352,22 @@ property_data_match_state (PropertyData  *data,
   return NULL;
 }
 
+static void
+style_properties_invalidate_compiled (GtkStyleProperties *props)
+{
+  GtkStylePropertiesPrivate *priv;
+
+  priv = props->priv;
+
+  if (priv->compiled)
+    {
+      g_hash_table_destroy (priv->compiled);
+      priv->compiled = NULL;
+    }
+
+  priv->last_compiled = NULL;
+}
+
 static void
 gtk_style_properties_init (GtkStyleProperties *props)
 {
@@ -358,6 +391,9 @@ gtk_style_properties_finalize (GObject *object)
   priv = props->priv;
   g_hash_table_destroy (priv->properties);
 
+  if (priv->compiled)
+    g_hash_table_destroy (priv->compiled);
+
   if (priv->color_map)
     g_hash_table_destroy (priv->color_map);
 
@@ -435,7 +471,14 @@ gtk_style_properties_register_property (GtkStylePropertyParser  parse_func,
   g_return_if_fail (G_IS_PARAM_SPEC (pspec));
 
   if (G_UNLIKELY (!properties))
-    properties = g_array_new (FALSE, TRUE, sizeof (PropertyNode));
+    {
+      properties = g_array_new (FALSE, TRUE, sizeof (PropertyNode));
+
+      /* Make sure the built-in properties get registered
+       * first, so they get the ids they're known by.
+       */
+      g_type_class_unref (g_type_class_ref (GTK_TYPE_STYLE_PROPERTIES));
+    }
 
   quark = g_quark_from_string (pspec->name);
 
@@ -448,6 +491,7 @@ gtk_style_properties_register_property (GtkStylePropertyParser  parse_func,
 
   new.property_quark = quark;
   new.pspec = pspec;
+  new.id = n_property_ids++;
 
   if (parse_func)
     new.parse_func = parse_func;
@@ -571,6 +615,8 @@ gtk_style_properties_map_color (GtkStyleProperties *props,
   g_hash_table_replace (priv->color_map,
                         g_strdup (name),
                         gtk_symbolic_color_ref (color));
+
+  style_properties_invalidate_compiled (props);
 }
 
 /**
@@ -667,6 +713,7 @@ gtk_style_properties_set_property (GtkStyleProperties *props,
                            prop);
     }
 
+  style_properties_invalidate_compiled (props);
   val = property_data_get_value (prop, state);
 
   if (G_VALUE_TYPE (val) == value_type)
@@ -705,6 +752,8 @@ gtk_style_properties_set_valist (GtkStyleProperties *props,
   priv = props->priv;
   property_name = va_arg (args, const gchar *);
 
+  style_properties_invalidate_compiled (props);
+
   while (property_name)
     {
       PropertyNode *node;
@@ -883,15 +932,103 @@ lookup_default_value (PropertyNode *node,
     g_param_value_set_default (node->pspec, value);
 }
 
+static GPtrArray *
+style_properties_compile (GtkStyleProperties *props,
+                          GtkStateFlags       state)
+{
+  GtkStylePropertiesPrivate *priv;
+  GPtrArray *values;
+  guint i;
+
+  priv = props->priv;
+
+  if (priv->last_compiled &&
+      priv->last_compiled_state == state)
+    return priv->last_compiled;
+
+  if (G_UNLIKELY (!priv->compiled))
+    priv->compiled = g_hash_table_new_full (NULL, NULL, NULL,
+                                            (GDestroyNotify) g_ptr_array_unref);
+
+  values = g_hash_table_lookup (priv->compiled, GUINT_TO_POINTER (state));
+
+  if (!values)
+    {
+      values = g_ptr_array_sized_new (n_property_ids);
+      g_ptr_array_set_size (values, n_property_ids);
+
+      for (i = 0; i < properties->len; i++)
+        {
+          PropertyNode *node;
+          PropertyData *prop;
+          GValue *val;
+
+          node = &g_array_index (properties, PropertyNode, i);
+          prop = g_hash_table_lookup (priv->properties,
+                                      GINT_TO_POINTER (node->property_quark));
+
+          if (!prop)
+            continue;
+
+          val = property_data_match_state (prop, state);
+
+          if (val &&
+              !style_properties_resolve_type (props, node, val))
+            val = NULL;
+
+          g_ptr_array_index (values, node->id) = val;
+        }
+
+      g_hash_table_insert (priv->compiled, GUINT_TO_POINTER (state), values);
+    }
+
+  priv->last_compiled = values;
+  priv->last_compiled_state = state;
+
+  return values;
+}
+
+/*
+ * _gtk_style_properties_peek_property_by_id:
+ * @props: a #GtkStyleProperties
+ * @id: property id, see #GtkStylePropertyId
+ * @state: state to retrieve the property value for
+ *
+ * Returns the value of the property known by @id, with symbolic
+ * colors and gradients already resolved. Values for a given state
+ * are resolved once for all properties and kept until @props is
+ * modified, so repeated lookups are constant time.
+ *
+ * Returns: the property value, or %NULL if it's not set in @props
+ */
+const GValue *
+_gtk_style_properties_peek_property_by_id (GtkStyleProperties *props,
+                                           guint               id,
+                                           GtkStateFlags       state)
+{
+  GPtrArray *values;
+
+  g_return_val_if_fail (GTK_IS_STYLE_PROPERTIES (props), NULL);
+  g_return_val_if_fail (id < n_property_ids, NULL);
+
+  values = style_properties_compile (props, state);
+
+  /* Property registered after values were compiled */
+  if (G_UNLIKELY (id >= values->len))
+    {
+      style_properties_invalidate_compiled (props);
+      values = style_properties_compile (props, state);
+    }
+
+  return g_ptr_array_index (values, id);
+}
+
 const GValue *
 _gtk_style_properties_peek_property (GtkStyleProperties *props,
                                      const gchar        *prop_name,
                                      GtkStateFlags       state)
 {
-  GtkStylePropertiesPrivate *priv;
   PropertyNode *node;
-  PropertyData *prop;
-  GValue *val;
 
   g_return_val_if_fail (GTK_IS_STYLE_PROPERTIES (props), NULL);
   g_return_val_if_fail (prop_name != NULL, NULL);
@@ -904,20 +1041,7 @@ _gtk_style_properties_peek_property (GtkStyleProperties *props,
       return NULL;
     }
 
-  priv = props->priv;
-  prop = g_hash_table_lookup (priv->properties,
-                              GINT_TO_POINTER (node->property_quark));
-
-  if (!prop)
-    return NULL;
-
-  val = property_data_match_state (prop, state);
-
-  if (val &&
-      !style_properties_resolve_type (props, node, val))
-    return NULL;
-
-  return val;
+  return _gtk_style_properties_peek_property_by_id (props, node->id, state);
 }
 
 /**
@@ -1119,6 +1243,8 @@ gtk_style_properties_unset_property (GtkStyleProperties *props,
   if (!prop)
     return;
 
+  style_properties_invalidate_compiled (props);
+
   if (property_data_find_position (prop, state, &pos))
     {
       ValueData *data;
@@ -1147,6 +1273,8 @@ gtk_style_properties_clear (GtkStyleProperties *props)
 
   priv = props->priv;
   g_hash_table_remove_all (priv->properties);
+
+  style_properties_invalidate_compiled (props);
 }
 
 /**
@@ -1177,6 +1305,8 @@ gtk_style_properties_merge (GtkStyleProperties       *props,
   priv = props->priv;
   priv_to_merge = props_to_merge->priv;
 
+  style_properties_invalidate_compiled (props);
+
   /* Merge symbolic color map */
   if (priv_to_merge->color_map)
     {
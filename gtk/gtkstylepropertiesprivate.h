@@ -0,0 +1,54 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2010 Carlos Garnacho <carlosg@gnome.org>
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GTK_STYLE_PROPERTIES_PRIVATE_H__
+#define __GTK_STYLE_PROPERTIES_PRIVATE_H__
+
+#include "gtkstyleproperties.h"
+
+G_BEGIN_DECLS
+
+/* Ids of the built-in properties, these are
+ * registered first, so their ids are fixed.
+ */
+typedef enum {
+  GTK_STYLE_PROPERTY_ID_COLOR,
+  GTK_STYLE_PROPERTY_ID_BACKGROUND_COLOR,
+  GTK_STYLE_PROPERTY_ID_FONT,
+  GTK_STYLE_PROPERTY_ID_MARGIN,
+  GTK_STYLE_PROPERTY_ID_PADDING,
+  GTK_STYLE_PROPERTY_ID_BORDER_WIDTH,
+  GTK_STYLE_PROPERTY_ID_BORDER_RADIUS,
+  GTK_STYLE_PROPERTY_ID_BORDER_STYLE,
+  GTK_STYLE_PROPERTY_ID_BORDER_COLOR,
+  GTK_STYLE_PROPERTY_ID_BACKGROUND_IMAGE,
+  GTK_STYLE_PROPERTY_ID_BORDER_IMAGE,
+  GTK_STYLE_PROPERTY_ID_ENGINE,
+  GTK_STYLE_PROPERTY_ID_TRANSITION,
+  GTK_STYLE_PROPERTY_ID_KEY_BINDINGS,
+  GTK_STYLE_PROPERTY_N_BUILTIN_IDS
+} GtkStylePropertyId;
+
+const GValue * _gtk_style_properties_peek_property_by_id (GtkStyleProperties *props,
+                                                          guint               id,
+                                                          GtkStateFlags       state);
+
+G_END_DECLS
+
+#endif /* __GTK_STYLE_PROPERTIES_PRIVATE_H__ */
@@ -5036,6 +5036,61 @@ _gtk_text_btree_is_valid (GtkTextBTree *tree,
   return (nd && nd->valid);
 }
 
+/**
+ * _gtk_text_btree_find_first_invalid_line:
+ * @tree: a #GtkTextBTree
+ * @view_id: view id
+ *
+ * Finds the first line of @tree that has not been validated
+ * for the given view.
+ *
+ * Return value: the first invalid line, or %NULL if the entire
+ * tree is valid
+ **/
+GtkTextLine *
+_gtk_text_btree_find_first_invalid_line (GtkTextBTree *tree,
+                                         gpointer      view_id)
+{
+  GtkTextBTreeNode *node;
+  GtkTextLine *line;
+  NodeData *nd;
+
+  g_return_val_if_fail (tree != NULL, NULL);
+
+  node = tree->root_node;
+
+  nd = node_data_find (node->node_data, view_id);
+  if (nd && nd->valid)
+    return NULL;
+
+  while (node->level > 0)
+    {
+      node = node->children.node;
+
+      while (node != NULL)
+        {
+          nd = node_data_find (node->node_data, view_id);
+          if (!nd || !nd->valid)
+            break;
+
+          node = node->next;
+        }
+
+      if (node == NULL)
+        return NULL;
+    }
+
+  for (line = node->children.line; line != NULL; line = line->next)
+    {
+      GtkTextLineData *ld = _gtk_text_line_get_data (line, view_id);
+
+      if (!ld || !ld->valid)
+        return line;
+    }
+
+  return NULL;
+}
+
 typedef struct _ValidateState ValidateState;
 
 struct _ValidateState
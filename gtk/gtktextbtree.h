@@ -100,6 +100,8 @@ void         _gtk_text_btree_get_view_size     (GtkTextBTree      *tree,
                                                 gint              *height);
 gboolean     _gtk_text_btree_is_valid          (GtkTextBTree      *tree,
                                                 gpointer           view_id);
+GtkTextLine *_gtk_text_btree_find_first_invalid_line (GtkTextBTree *tree,
+                                                      gpointer      view_id);
 gboolean     _gtk_text_btree_validate          (GtkTextBTree      *tree,
                                                 gpointer           view_id,
                                                 gint               max_pixels,
@@ -83,6 +83,7 @@
 #include "gtktextbtree.h"
 #include "gtktextiterprivate.h"
 #include "gtktextutil.h"
+#include "gtkpango.h"
 #include "gtkintl.h"
 
 #include <stdlib.h>
@@ -91,6 +92,39 @@
 #define GTK_TEXT_LAYOUT_GET_PRIVATE(o)  (G_TYPE_INSTANCE_GET_PRIVATE ((o), GTK_TYPE_TEXT_LAYOUT, GtkTextLayoutPrivate))
 
 typedef struct _GtkTextLayoutPrivate GtkTextLayoutPrivate;
+typedef struct _LineDisplayCacheEntry LineDisplayCacheEntry;
+typedef struct _MeasuredLine MeasuredLine;
+
+/* Rough estimate of the memory used by a line display,
+ * for the purpose of bounding the line display cache.
+ */
+#define LINE_DISPLAY_BASE_SIZE     (sizeof (GtkTextLineDisplay) + 512)
+#define LINE_DISPLAY_BYTE_SIZE     48
+#define DEFAULT_DISPLAY_CACHE_SIZE (1024 * 1024)
+
+/* Size-only displays are created for every line while validating,
+ * they are kept apart so they don't evict the displays of the lines
+ * being drawn.
+ */
+#define SIZE_ONLY_DISPLAY_CACHE_LENGTH 4
+
+struct _LineDisplayCacheEntry
+{
+  GtkTextLineDisplay *display;
+  gsize size;
+};
+
+/* A line handed to the worker threads by _gtk_text_layout_measure_lines() */
+struct _MeasuredLine
+{
+  GtkTextLine *line;
+  gint margins;
+  gint para_height;
+  guint follows_previous : 1;
+
+  gint width;
+  gint height;
+};
 
 struct _GtkTextLayoutPrivate
 {
@@ -98,6 +132,30 @@ struct _GtkTextLayoutPrivate
      direction only influences the direction of the cursor line.
   */
   GtkTextLine *cursor_line;
+
+  /* LRU caches of line displays, the most recently used one
+   * is at the head of its queue. The most recently used display
+   * of either queue is also kept in layout->one_display_cache.
+   */
+  GQueue display_cache;
+  GQueue size_only_display_cache;
+  GHashTable *display_cache_lines;
+  gsize display_cache_size;
+  gsize display_cache_max_size;
+  guint display_cache_hits;
+  guint display_cache_misses;
+
+  /* Lines being measured in worker threads. Lines are dropped from
+   * measure_lines when they are invalidated or deleted, and their
+   * results are thrown away.
+   */
+  GtkPangoMeasure *measure;
+  GArray *measured_lines;
+  GHashTable *measure_lines;
+  GtkTextLayoutMeasureFunc measure_func;
+  gpointer measure_data;
+  guint measure_serial;
+  MeasuredLine *committing;
 };
 
 static GtkTextLineData *gtk_text_layout_real_wrap (GtkTextLayout *layout,
@@ -232,7 +290,12 @@ gtk_text_layout_class_init (GtkTextLayoutClass *klass)
 static void
 gtk_text_layout_init (GtkTextLayout *text_layout)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (text_layout);
+
   text_layout->cursor_visible = TRUE;
+
+  priv->display_cache_lines = g_hash_table_new (NULL, NULL);
+  priv->display_cache_max_size = DEFAULT_DISPLAY_CACHE_SIZE;
 }
 
 GtkTextLayout*
@@ -251,13 +314,168 @@ free_style_cache (GtkTextLayout *text_layout)
     }
 }
 
+static void
+line_display_free (GtkTextLineDisplay *display)
+{
+  if (display->layout)
+    g_object_unref (display->layout);
+
+  if (display->cursors)
+    {
+      g_slist_foreach (display->cursors, (GFunc)g_free, NULL);
+      g_slist_free (display->cursors);
+    }
+
+  if (display->pg_bg_color)
+    gdk_color_free (display->pg_bg_color);
+
+  g_free (display);
+}
+
+static GQueue *
+display_cache_queue (GtkTextLayout      *layout,
+                     GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (display->size_only)
+    return &priv->size_only_display_cache;
+  else
+    return &priv->display_cache;
+}
+
+static LineDisplayCacheEntry *
+display_cache_lookup (GtkTextLayout *layout,
+                      GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, line);
+
+  return (link) ? link->data : NULL;
+}
+
+static void
+display_cache_remove (GtkTextLayout *layout,
+                      GtkTextLine   *line)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  LineDisplayCacheEntry *entry;
+  GList *link;
+
+  link = g_hash_table_lookup (priv->display_cache_lines, line);
+
+  if (!link)
+    return;
+
+  entry = link->data;
+
+  g_hash_table_remove (priv->display_cache_lines, line);
+  g_queue_delete_link (display_cache_queue (layout, entry->display), link);
+
+  if (!entry->display->size_only)
+    priv->display_cache_size -= entry->size;
+
+  if (layout->one_display_cache == entry->display)
+    layout->one_display_cache = NULL;
+
+  line_display_free (entry->display);
+  g_slice_free (LineDisplayCacheEntry, entry);
+}
+
+static void
+display_cache_trim (GtkTextLayout *layout,
+                    gsize          max_size)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  /* The most recently used display is always kept, so
+   * callers can hold onto the display they just got.
+   */
+  while (priv->display_cache_size > max_size &&
+         priv->display_cache.length > 1)
+    {
+      LineDisplayCacheEntry *entry;
+
+      entry = g_queue_peek_tail (&priv->display_cache);
+      display_cache_remove (layout, entry->display->line);
+    }
+
+  while (priv->size_only_display_cache.length > SIZE_ONLY_DISPLAY_CACHE_LENGTH)
+    {
+      LineDisplayCacheEntry *entry;
+
+      entry = g_queue_peek_tail (&priv->size_only_display_cache);
+      display_cache_remove (layout, entry->display->line);
+    }
+}
+
+static void
+display_cache_clear (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  while (priv->display_cache.length > 0)
+    {
+      LineDisplayCacheEntry *entry;
+
+      entry = g_queue_peek_tail (&priv->display_cache);
+      display_cache_remove (layout, entry->display->line);
+    }
+
+  while (priv->size_only_display_cache.length > 0)
+    {
+      LineDisplayCacheEntry *entry;
+
+      entry = g_queue_peek_tail (&priv->size_only_display_cache);
+      display_cache_remove (layout, entry->display->line);
+    }
+}
+
+static void
+display_cache_insert (GtkTextLayout      *layout,
+                      GtkTextLineDisplay *display)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  LineDisplayCacheEntry *entry;
+  GQueue *queue;
+
+  /* Lines without line data are not told when they are destroyed,
+   * so their displays can't be invalidated reliably.
+   */
+  if (!_gtk_text_line_get_data (display->line, layout))
+    return;
+
+  entry = g_slice_new (LineDisplayCacheEntry);
+  entry->display = display;
+  entry->size = LINE_DISPLAY_BASE_SIZE;
+
+  if (display->layout)
+    entry->size += strlen (pango_layout_get_text (display->layout)) * LINE_DISPLAY_BYTE_SIZE;
+
+  queue = display_cache_queue (layout, display);
+  g_queue_push_head (queue, entry);
+  g_hash_table_insert (priv->display_cache_lines, display->line, queue->head);
+
+  if (!display->size_only)
+    priv->display_cache_size += entry->size;
+
+  layout->one_display_cache = display;
+
+  display_cache_trim (layout, priv->display_cache_max_size);
+}
+
 static void
 gtk_text_layout_finalize (GObject *object)
 {
+  GtkTextLayoutPrivate *priv;
   GtkTextLayout *layout;
 
   layout = GTK_TEXT_LAYOUT (object);
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
 
+  _gtk_text_layout_cancel_measure (layout);
   gtk_text_layout_set_buffer (layout, NULL);
 
   if (layout->default_style)
@@ -275,12 +493,8 @@ gtk_text_layout_finalize (GObject *object)
       layout->rtl_context = NULL;
     }
   
-  if (layout->one_display_cache) 
-    {
-      GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-      layout->one_display_cache = NULL;
-      gtk_text_layout_free_line_display (layout, tmp_display);
-    }
+  display_cache_clear (layout);
+  g_hash_table_destroy (priv->display_cache_lines);
 
   if (layout->preedit_string)
     {
@@ -313,11 +527,13 @@ gtk_text_layout_set_buffer (GtkTextLayout *layout,
     return;
 
   free_style_cache (layout);
+  _gtk_text_layout_cancel_measure (layout);
 
   if (layout->buffer)
     {
       _gtk_text_btree_remove_view (_gtk_text_buffer_get_btree (layout->buffer),
                                   layout);
+      display_cache_clear (layout);
 
       g_signal_handlers_disconnect_by_func (layout->buffer, 
                                             G_CALLBACK (gtk_text_layout_mark_set_handler), 
@@ -631,6 +847,47 @@ gtk_text_layout_emit_changed (GtkTextLayout *layout,
   g_signal_emit (layout, signals[CHANGED], 0, y, old_height, new_height);
 }
 
+static gboolean
+display_cache_invalidate_range (GtkTextLayout *layout,
+                                gint           y,
+                                gint           height,
+                                gboolean       cursors_only)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLine *line;
+  guint n_cached;
+  guint n_lines = 0;
+  gint line_top;
+
+  n_cached = priv->display_cache.length + priv->size_only_display_cache.length;
+
+  if (n_cached == 0)
+    return TRUE;
+
+  line = _gtk_text_btree_find_line_by_y (_gtk_text_buffer_get_btree (layout->buffer),
+                                         layout, y, &line_top);
+
+  while (line && line_top < y + height)
+    {
+      GtkTextLineData *line_data = _gtk_text_line_get_data (line, layout);
+      gint line_height = (line_data) ? line_data->height : 0;
+
+      /* Walking a range larger than the cache costs more than
+       * looking at the cached lines themselves.
+       */
+      if (++n_lines > n_cached)
+        return FALSE;
+
+      if (line_top + line_height > y)
+        gtk_text_layout_invalidate_cache (layout, line, cursors_only);
+
+      line_top += line_height;
+      line = _gtk_text_line_next_excluding_last (line);
+    }
+
+  return TRUE;
+}
+
 static void
 text_layout_changed (GtkTextLayout *layout,
                      gint           y,
@@ -638,18 +895,40 @@ text_layout_changed (GtkTextLayout *layout,
                      gint           new_height,
                      gboolean       cursors_only)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  gint height = MAX (old_height, new_height);
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cached lines if so. Usually the range
+   * only covers a few lines, so walk those and look them up.
    */
-  if (layout->one_display_cache)
+  if (!display_cache_invalidate_range (layout, y, height, cursors_only))
     {
-      GtkTextLine *line = layout->one_display_cache->line;
-      gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
-						    line, layout);
-      gint cache_height = layout->one_display_cache->height;
+      GList *l, *next;
+
+      for (l = priv->display_cache.head; l; l = next)
+        {
+          LineDisplayCacheEntry *entry = l->data;
+          GtkTextLine *line = entry->display->line;
+          gint cache_y = _gtk_text_btree_find_line_top (_gtk_text_buffer_get_btree (layout->buffer),
+                                                        line, layout);
+          gint cache_height = entry->display->height;
+
+          next = l->next;
+
+          if (cache_y + cache_height > y && cache_y < y + height)
+            gtk_text_layout_invalidate_cache (layout, line, cursors_only);
+        }
+
+      /* Size-only displays are cheap to recreate */
+      if (!cursors_only)
+        while (priv->size_only_display_cache.length > 0)
+          {
+            LineDisplayCacheEntry *entry;
 
-      if (cache_y + cache_height > y && cache_y < y + old_height)
-	gtk_text_layout_invalidate_cache (layout, line, cursors_only);
+            entry = g_queue_peek_tail (&priv->size_only_display_cache);
+            display_cache_remove (layout, entry->display->line);
+          }
     }
 
   gtk_text_layout_emit_changed (layout, y, old_height, new_height);
@@ -821,9 +1100,17 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
                                   GtkTextLine   *line,
 				  gboolean       cursors_only)
 {
-  if (layout->one_display_cache && line == layout->one_display_cache->line)
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  LineDisplayCacheEntry *entry;
+
+  if (!cursors_only && priv->measure_lines)
+    g_hash_table_remove (priv->measure_lines, line);
+
+  entry = display_cache_lookup (layout, line);
+
+  if (entry)
     {
-      GtkTextLineDisplay *display = layout->one_display_cache;
+      GtkTextLineDisplay *display = entry->display;
 
       if (cursors_only)
 	{
@@ -834,10 +1121,7 @@ gtk_text_layout_invalidate_cache (GtkTextLayout *layout,
 	  display->has_block_cursor = FALSE;
 	}
       else
-	{
-	  layout->one_display_cache = NULL;
-	  gtk_text_layout_free_line_display (layout, display);
-	}
+	display_cache_remove (layout, line);
     }
 }
 
@@ -929,13 +1213,24 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
 					 const GtkTextIter *start,
 					 const GtkTextIter *end)
 {
-  /* Check if the range intersects our cached line display,
-   * and invalidate the cached line if so.
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GList *l;
+
+  if (gtk_text_iter_compare (start, end) > 0)
+    {
+      const GtkTextIter *tmp = start;
+      start = end;
+      end = tmp;
+    }
+
+  /* Check if the range intersects our cached line displays,
+   * and invalidate the cursors in those lines if so.
    */
-  if (layout->one_display_cache)
+  for (l = priv->display_cache.head; l; l = l->next)
     {
+      LineDisplayCacheEntry *entry = l->data;
       GtkTextIter line_start, line_end;
-      GtkTextLine *line = layout->one_display_cache->line;
+      GtkTextLine *line = entry->display->line;
 
       _gtk_text_btree_get_iter_at_line (_gtk_text_buffer_get_btree (layout->buffer),
                                         &line_start, line, 0);
@@ -943,13 +1238,6 @@ gtk_text_layout_real_invalidate_cursors (GtkTextLayout     *layout,
       if (!gtk_text_iter_ends_line (&line_end))
 	gtk_text_iter_forward_to_line_end (&line_end);
 
-      if (gtk_text_iter_compare (start, end) > 0)
-	{
-	  const GtkTextIter *tmp = start;
-	  start = end;
-	  end = tmp;
-	}
-
       if (gtk_text_iter_compare (&line_start, end) <= 0 &&
 	  gtk_text_iter_compare (start, &line_end) <= 0)
 	{
@@ -1124,16 +1412,23 @@ gtk_text_layout_validate_yrange (GtkTextLayout *layout,
  *              than one paragraph beyond this limit will be validated)
  *
  * Validate regions of a #GtkTextLayout. The ::changed signal will
- * be emitted for each region validated.
+ * be emitted once, for the range spanning all validated regions.
  **/
 void
 gtk_text_layout_validate (GtkTextLayout *layout,
                           gint           max_pixels)
 {
   gint y, old_height, new_height;
+  gint first_y = -1;
+  gint last_y = 0;
+  gint delta_height = 0;
 
   g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
 
+  /* Regions are validated from the top down, and everything between
+   * two regions was valid already, so we can report a single change
+   * covering all of them.
+   */
   while (max_pixels > 0 &&
          _gtk_text_btree_validate (_gtk_text_buffer_get_btree (layout->buffer),
                                    layout,  max_pixels,
@@ -1141,8 +1436,19 @@ gtk_text_layout_validate (GtkTextLayout *layout,
     {
       max_pixels -= new_height;
 
+      if (first_y < 0)
+        first_y = y;
+      last_y = y + new_height;
+      delta_height += new_height - old_height;
+    }
+
+  if (first_y >= 0)
+    {
       update_layout_size (layout);
-      gtk_text_layout_emit_changed (layout, y, old_height, new_height);
+      gtk_text_layout_emit_changed (layout,
+                                    first_y,
+                                    last_y - first_y - delta_height,
+                                    last_y - first_y);
     }
 }
 
@@ -1152,6 +1458,7 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
                            /* may be NULL */
                            GtkTextLineData *line_data)
 {
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
   GtkTextLineDisplay *display;
 
   g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), NULL);
@@ -1163,6 +1470,16 @@ gtk_text_layout_real_wrap (GtkTextLayout   *layout,
       _gtk_text_line_add_data (line, line_data);
     }
 
+  /* Committing the size measured in a worker thread */
+  if (priv->committing && priv->committing->line == line)
+    {
+      line_data->width = priv->committing->width;
+      line_data->height = priv->committing->height;
+      line_data->valid = TRUE;
+
+      return line_data;
+    }
+
   display = gtk_text_layout_get_line_display (layout, line, TRUE);
   line_data->width = display->width;
   line_data->height = display->height;
@@ -2119,20 +2436,25 @@ tags_array_toggle_tag (GPtrArray  *array,
   return array;
 }
 
-GtkTextLineDisplay *
-gtk_text_layout_get_line_display (GtkTextLayout *layout,
-                                  GtkTextLine   *line,
-                                  gboolean       size_only)
+/* Fills in the paragraph values, text and attributes of @display,
+ * and its cursors if @add_cursors is set. The text is not laid out
+ * otherwise. Returns %FALSE if the line is completely invisible, so
+ * that there is nothing to lay out.
+ */
+static gboolean
+line_display_fill (GtkTextLayout      *layout,
+                   GtkTextLineDisplay *display,
+                   gboolean            add_cursors,
+                   gboolean           *saw_widget_out)
 {
   GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
-  GtkTextLineDisplay *display;
+  GtkTextLine *line = display->line;
   GtkTextLineSegment *seg;
   GtkTextIter iter;
   GtkTextAttributes *style;
   gchar *text;
   PangoAttrList *attrs;
   gint text_allocated, layout_byte_offset, buffer_byte_offset;
-  PangoRectangle extents;
   gboolean para_values_set = FALSE;
   GSList *cursor_byte_offsets = NULL;
   GSList *cursor_segs = NULL;
@@ -2141,33 +2463,6 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   PangoDirection base_dir;
   GPtrArray *tags;
   gboolean initial_toggle_segments;
-  
-  g_return_val_if_fail (line != NULL, NULL);
-
-  if (layout->one_display_cache)
-    {
-      if (line == layout->one_display_cache->line &&
-          (size_only || !layout->one_display_cache->size_only))
-	{
-	  if (!size_only)
-            update_text_display_cursors (layout, line, layout->one_display_cache);
-	  return layout->one_display_cache;
-	}
-      else
-        {
-          GtkTextLineDisplay *tmp_display = layout->one_display_cache;
-          layout->one_display_cache = NULL;
-          gtk_text_layout_free_line_display (layout, tmp_display);
-        }
-    }
-
-  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
-
-  display = g_new0 (GtkTextLineDisplay, 1);
-
-  display->size_only = size_only;
-  display->line = line;
-  display->insert_index = -1;
 
   _gtk_text_btree_get_iter_at_line (_gtk_text_buffer_get_btree (layout->buffer),
                                     &iter, line, 0);
@@ -2182,8 +2477,9 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
 	display->layout = pango_layout_new (layout->rtl_context);
       else
 	display->layout = pango_layout_new (layout->ltr_context);
-      
-      return display;
+
+      *saw_widget_out = FALSE;
+      return FALSE;
     }
 
   /* Find the bidi base direction */
@@ -2437,7 +2733,8 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   pango_layout_set_text (display->layout, text, layout_byte_offset);
   pango_layout_set_attributes (display->layout, attrs);
 
-  tmp_list1 = cursor_byte_offsets;
+  /* Placing the cursors lays out the text */
+  tmp_list1 = add_cursors ? cursor_byte_offsets : NULL;
   tmp_list2 = cursor_segs;
   while (tmp_list1)
     {
@@ -2449,6 +2746,78 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
   g_slist_free (cursor_byte_offsets);
   g_slist_free (cursor_segs);
 
+  /* Free this if we aren't in a loop */
+  if (layout->wrap_loop_count == 0)
+    invalidate_cached_style (layout);
+
+  g_free (text);
+  pango_attr_list_unref (attrs);
+  if (tags != NULL)
+    g_ptr_array_free (tags, TRUE);
+
+  *saw_widget_out = saw_widget;
+  return TRUE;
+}
+
+GtkTextLineDisplay *
+gtk_text_layout_get_line_display (GtkTextLayout *layout,
+                                  GtkTextLine   *line,
+                                  gboolean       size_only)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextLineDisplay *display;
+  PangoRectangle extents;
+  gboolean saw_widget;
+  
+  g_return_val_if_fail (line != NULL, NULL);
+
+  /* Getting the same line many times in a row is the most common case */
+  if (layout->one_display_cache &&
+      layout->one_display_cache->line == line)
+    display = layout->one_display_cache;
+  else
+    {
+      LineDisplayCacheEntry *entry;
+
+      entry = display_cache_lookup (layout, line);
+      display = (entry) ? entry->display : NULL;
+    }
+
+  if (display)
+    {
+      if (size_only || !display->size_only)
+	{
+          GList *link;
+
+          priv->display_cache_hits++;
+
+          /* Move to the front of the queue */
+          link = g_hash_table_lookup (priv->display_cache_lines, line);
+          g_queue_unlink (display_cache_queue (layout, display), link);
+          g_queue_push_head_link (display_cache_queue (layout, display), link);
+          layout->one_display_cache = display;
+
+	  if (!size_only)
+            update_text_display_cursors (layout, line, display);
+	  return display;
+	}
+      else
+        display_cache_remove (layout, line);
+    }
+
+  priv->display_cache_misses++;
+
+  DV (g_print ("creating one line display cache (%s)\n", G_STRLOC));
+
+  display = g_new0 (GtkTextLineDisplay, 1);
+
+  display->size_only = size_only;
+  display->line = line;
+  display->insert_index = -1;
+
+  if (!line_display_fill (layout, display, TRUE, &saw_widget))
+    return display;
+
   pango_layout_get_extents (display->layout, NULL, &extents);
 
   display->width = PIXEL_BOUND (extents.width) + display->left_margin + display->right_margin;
@@ -2474,16 +2843,7 @@ gtk_text_layout_get_line_display (GtkTextLayout *layout,
 	}
     }
   
-  /* Free this if we aren't in a loop */
-  if (layout->wrap_loop_count == 0)
-    invalidate_cached_style (layout);
-
-  g_free (text);
-  pango_attr_list_unref (attrs);
-  if (tags != NULL)
-    g_ptr_array_free (tags, TRUE);
-
-  layout->one_display_cache = display;
+  display_cache_insert (layout, display);
 
   if (saw_widget)
     allocate_child_widgets (layout, display);
@@ -2495,22 +2855,358 @@ void
 gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                    GtkTextLineDisplay *display)
 {
-  if (display != layout->one_display_cache)
+  LineDisplayCacheEntry *entry;
+
+  /* Cached displays are owned by the cache */
+  entry = display_cache_lookup (layout, display->line);
+
+  if (!entry || entry->display != display)
+    line_display_free (display);
+}
+
+typedef struct
+{
+  gint y;
+  gint old_height;
+  gint new_height;
+} MeasuredRun;
+
+static void
+measure_lines_free (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (priv->measured_lines)
+    {
+      g_array_free (priv->measured_lines, TRUE);
+      priv->measured_lines = NULL;
+    }
+
+  if (priv->measure_lines)
+    {
+      g_hash_table_destroy (priv->measure_lines);
+      priv->measure_lines = NULL;
+    }
+}
+
+static void
+measure_lines_done (GtkPangoMeasure *measure,
+                    gpointer         data)
+{
+  GtkTextLayout *layout = data;
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  GtkTextBTree *btree = _gtk_text_buffer_get_btree (layout->buffer);
+  GtkTextLayoutMeasureFunc func;
+  gpointer func_data;
+  GArray *runs;
+  MeasuredRun *run = NULL;
+  guint serial;
+  guint i, n_items;
+
+  g_object_ref (layout);
+
+  priv->measure = NULL;
+  func = priv->measure_func;
+  func_data = priv->measure_data;
+  priv->measure_func = NULL;
+  priv->measure_data = NULL;
+  serial = priv->measure_serial;
+
+  runs = g_array_new (FALSE, FALSE, sizeof (MeasuredRun));
+
+  n_items = _gtk_pango_measure_get_n_items (measure);
+  for (i = 0; i < n_items; i++)
+    {
+      GtkTextLineData *line_data = NULL;
+      PangoRectangle extents;
+      MeasuredLine *ml;
+      guint index;
+
+      index = GPOINTER_TO_UINT (_gtk_pango_measure_get_item (measure, i, &extents));
+      ml = &g_array_index (priv->measured_lines, MeasuredLine, index);
+
+      /* Lines changed since their text was copied are not in the
+       * table anymore, and lines may have been validated in the
+       * main thread in the meantime.
+       */
+      if (g_hash_table_lookup (priv->measure_lines, ml->line))
+        line_data = _gtk_text_line_get_data (ml->line, layout);
+
+      if (line_data == NULL || line_data->valid)
+        {
+          run = NULL;
+          continue;
+        }
+
+      if (run == NULL || !ml->follows_previous)
+        {
+          g_array_set_size (runs, runs->len + 1);
+          run = &g_array_index (runs, MeasuredRun, runs->len - 1);
+          run->y = _gtk_text_btree_find_line_top (btree, ml->line, layout);
+          run->old_height = 0;
+          run->new_height = 0;
+        }
+
+      run->old_height += line_data->height;
+
+      ml->width = PIXEL_BOUND (extents.width) + ml->margins;
+      ml->height = ml->para_height + PANGO_PIXELS (extents.height);
+
+      priv->committing = ml;
+      _gtk_text_btree_validate_line (btree, ml->line, layout);
+      priv->committing = NULL;
+
+      line_data = _gtk_text_line_get_data (ml->line, layout);
+      run->new_height += line_data->height;
+    }
+
+  measure_lines_free (layout);
+
+  if (runs->len > 0)
+    update_layout_size (layout);
+
+  for (i = 0; i < runs->len; i++)
+    {
+      run = &g_array_index (runs, MeasuredRun, i);
+      gtk_text_layout_emit_changed (layout, run->y,
+                                    run->old_height, run->new_height);
+    }
+
+  g_array_free (runs, TRUE);
+
+  /* Unless a handler of ::changed cancelled us */
+  if (func && serial == priv->measure_serial)
+    func (layout, func_data);
+
+  g_object_unref (layout);
+}
+
+/**
+ * _gtk_text_layout_measure_lines:
+ * @layout: a #GtkTextLayout
+ * @max_lines: the maximum number of lines to look at
+ * @func: function to call when the lines have been measured
+ * @data: data to pass to @func
+ *
+ * Starts measuring the first invalid lines of @layout in worker
+ * threads. The text and attributes of the lines are copied in
+ * the main thread and laid out in the workers. The resulting
+ * sizes are stored in the line data of @layout from the main
+ * loop, emitting ::changed for them, and @func is called after
+ * that. Lines that were changed in the meantime stay invalid.
+ *
+ * Lines with child widgets, completely invisible lines and the
+ * line showing the preedit string are not handed to the workers,
+ * only the lines before the first such line are measured.
+ *
+ * Return value: %TRUE if lines are being measured, %FALSE if
+ *     the first invalid line must be validated in the main thread
+ **/
+gboolean
+_gtk_text_layout_measure_lines (GtkTextLayout            *layout,
+                                gint                      max_lines,
+                                GtkTextLayoutMeasureFunc  func,
+                                gpointer                  data)
+{
+  GtkTextLayoutPrivate *priv;
+  GtkPangoMeasure *measure;
+  GtkTextLine *line;
+  GtkTextLine *preedit_line = NULL;
+  gboolean follows_previous = FALSE;
+  gint i;
+
+  g_return_val_if_fail (GTK_IS_TEXT_LAYOUT (layout), FALSE);
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (priv->measure)
     {
-      if (display->layout)
-        g_object_unref (display->layout);
+      priv->measure_func = func;
+      priv->measure_data = data;
+
+      return TRUE;
+    }
+
+  if (layout->buffer == NULL ||
+      !_gtk_pango_measure_supported (layout->ltr_context) ||
+      !_gtk_pango_measure_supported (layout->rtl_context))
+    return FALSE;
+
+  line = _gtk_text_btree_find_first_invalid_line (_gtk_text_buffer_get_btree (layout->buffer),
+                                                  layout);
+  if (line == NULL)
+    return FALSE;
+
+  if (layout->preedit_len > 0)
+    {
+      GtkTextIter iter;
+
+      gtk_text_buffer_get_iter_at_mark (layout->buffer, &iter,
+                                        gtk_text_buffer_get_insert (layout->buffer));
+      preedit_line = _gtk_text_iter_get_text_line (&iter);
+    }
+
+  measure = _gtk_pango_measure_new (layout->ltr_context, measure_lines_done, layout);
+  priv->measured_lines = g_array_new (FALSE, FALSE, sizeof (MeasuredLine));
+  priv->measure_lines = g_hash_table_new (NULL, NULL);
+
+  gtk_text_layout_wrap_loop_start (layout);
+
+  for (i = 0;
+       i < max_lines && line != NULL;
+       i++, line = _gtk_text_line_next_excluding_last (line))
+    {
+      GtkTextLineData *line_data;
+      GtkTextLineDisplay *display;
+      MeasuredLine ml;
+      gboolean saw_widget;
+
+      line_data = _gtk_text_line_get_data (line, layout);
+      if (line_data && line_data->valid)
+        {
+          follows_previous = FALSE;
+          continue;
+        }
+
+      if (line == preedit_line)
+        break;
+
+      display = g_new0 (GtkTextLineDisplay, 1);
+      display->size_only = TRUE;
+      display->line = line;
+      display->insert_index = -1;
+
+      if (!line_display_fill (layout, display, FALSE, &saw_widget) || saw_widget)
+        {
+          line_display_free (display);
+          break;
+        }
+
+      ml.line = line;
+      ml.margins = display->left_margin + display->right_margin;
+      ml.para_height = display->height;
+      ml.follows_previous = follows_previous;
+      ml.width = 0;
+      ml.height = 0;
+      g_array_append_val (priv->measured_lines, ml);
+
+      _gtk_pango_measure_add (measure, display->layout,
+                              GUINT_TO_POINTER (priv->measured_lines->len - 1));
+      line_display_free (display);
 
-      if (display->cursors)
+      /* Give the line a line data, so that we get to know
+       * when it is deleted through free_line_data()
+       */
+      if (line_data == NULL)
         {
-          g_slist_foreach (display->cursors, (GFunc)g_free, NULL);
-          g_slist_free (display->cursors);
+          line_data = _gtk_text_line_data_new (layout, line);
+          _gtk_text_line_add_data (line, line_data);
         }
 
-      if (display->pg_bg_color)
-        gdk_color_free (display->pg_bg_color);
+      g_hash_table_insert (priv->measure_lines, line, line);
+      follows_previous = TRUE;
+    }
+
+  gtk_text_layout_wrap_loop_end (layout);
+
+  if (priv->measured_lines->len == 0)
+    {
+      _gtk_pango_measure_cancel (measure);
+      measure_lines_free (layout);
+
+      return FALSE;
+    }
+
+  priv->measure = measure;
+  priv->measure_func = func;
+  priv->measure_data = data;
+
+  _gtk_pango_measure_start (measure);
+
+  return TRUE;
+}
+
+/**
+ * _gtk_text_layout_cancel_measure:
+ * @layout: a #GtkTextLayout
+ *
+ * Stops measuring lines started with _gtk_text_layout_measure_lines(),
+ * the function passed to it will not be called.
+ **/
+void
+_gtk_text_layout_cancel_measure (GtkTextLayout *layout)
+{
+  GtkTextLayoutPrivate *priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
 
-      g_free (display);
+  if (priv->measure)
+    {
+      _gtk_pango_measure_cancel (priv->measure);
+      priv->measure = NULL;
     }
+
+  measure_lines_free (layout);
+
+  priv->measure_func = NULL;
+  priv->measure_data = NULL;
+  priv->measure_serial++;
+}
+
+/**
+ * gtk_text_layout_set_line_display_cache_size:
+ * @layout: a #GtkTextLayout
+ * @max_size: approximate amount of memory, in bytes, that
+ *     cached line displays may use
+ *
+ * Sets the memory budget for the cache of line displays kept
+ * by @layout, least recently used lines are dropped first
+ * when the budget is exceeded. The most recently used line
+ * display is always kept.
+ */
+void
+gtk_text_layout_set_line_display_cache_size (GtkTextLayout *layout,
+                                             gsize          max_size)
+{
+  GtkTextLayoutPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+  priv->display_cache_max_size = max_size;
+
+  display_cache_trim (layout, max_size);
+}
+
+/**
+ * gtk_text_layout_get_line_display_cache_stats:
+ * @layout: a #GtkTextLayout
+ * @hits: (out) (allow-none): return location for the number of lookups
+ *     that were satisfied by the line display cache
+ * @misses: (out) (allow-none): return location for the number of line
+ *     displays that had to be created
+ * @size: (out) (allow-none): return location for the approximate
+ *     amount of memory used by cached line displays
+ *
+ * Retrieves statistics about the line display cache of @layout,
+ * this is meant for profiling.
+ */
+void
+gtk_text_layout_get_line_display_cache_stats (GtkTextLayout *layout,
+                                              guint         *hits,
+                                              guint         *misses,
+                                              gsize         *size)
+{
+  GtkTextLayoutPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_LAYOUT (layout));
+
+  priv = GTK_TEXT_LAYOUT_GET_PRIVATE (layout);
+
+  if (hits)
+    *hits = priv->display_cache_hits;
+  if (misses)
+    *misses = priv->display_cache_misses;
+  if (size)
+    *size = priv->display_cache_size;
 }
 
 /* Functions to convert iter <=> index for the line of a GtkTextLineDisplay
@@ -146,8 +146,8 @@ struct _GtkTextLayout
    * over long runs with the same style. */
   GtkTextAttributes *one_style_cache;
 
-  /* A cache of one line display. Getting the same line
-   * many times in a row is the most common case.
+  /* The most recently used line display, more
+   * line displays are cached by the layout.
    */
   GtkTextLineDisplay *one_display_cache;
 
@@ -325,6 +325,13 @@ GtkTextLineDisplay* gtk_text_layout_get_line_display  (GtkTextLayout      *layou
 void                gtk_text_layout_free_line_display (GtkTextLayout      *layout,
                                                        GtkTextLineDisplay *display);
 
+void gtk_text_layout_set_line_display_cache_size  (GtkTextLayout *layout,
+                                                   gsize          max_size);
+void gtk_text_layout_get_line_display_cache_stats (GtkTextLayout *layout,
+                                                   guint         *hits,
+                                                   guint         *misses,
+                                                   gsize         *size);
+
 void gtk_text_layout_get_line_at_y     (GtkTextLayout     *layout,
                                         GtkTextIter       *target_iter,
                                         gint               y,
@@ -356,6 +363,15 @@ void     gtk_text_layout_validate_yrange (GtkTextLayout *layout,
 void     gtk_text_layout_validate        (GtkTextLayout *layout,
                                           gint           max_pixels);
 
+typedef void (* GtkTextLayoutMeasureFunc) (GtkTextLayout *layout,
+                                           gpointer       data);
+
+gboolean _gtk_text_layout_measure_lines  (GtkTextLayout            *layout,
+                                          gint                      max_lines,
+                                          GtkTextLayoutMeasureFunc  func,
+                                          gpointer                  data);
+void     _gtk_text_layout_cancel_measure (GtkTextLayout            *layout);
+
 /* This function should return the passed-in line data,
  * OR remove the existing line data from the line, and
  * return a NEW line data after adding it to the line.
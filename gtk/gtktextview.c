@@ -116,6 +116,12 @@
 
 #define SPACE_FOR_CURSOR 1
 
+/* Time spent validating lines in each run of the incremental validation idle */
+#define GTK_TEXT_VIEW_TIME_MS_PER_IDLE 10
+
+/* Lines handed to the worker threads at once with threaded validation */
+#define GTK_TEXT_VIEW_MEASURE_LINES 500
+
 #define GTK_TEXT_VIEW_GET_PRIVATE(obj) (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GTK_TYPE_TEXT_VIEW, GtkTextViewPrivate))
 
 typedef struct _GtkTextWindow GtkTextWindow;
@@ -229,6 +235,8 @@ struct _GtkTextViewPrivate
    * driving the scrollable adjustment values */
   guint hscroll_policy : 1;
   guint vscroll_policy : 1;
+
+  guint threaded_validation : 1;
 };
 
 struct _GtkTextPendingScroll
@@ -281,7 +289,8 @@ enum
   PROP_HADJUSTMENT,
   PROP_VADJUSTMENT,
   PROP_HSCROLL_POLICY,
-  PROP_VSCROLL_POLICY
+  PROP_VSCROLL_POLICY,
+  PROP_THREADED_VALIDATION
 };
 
 static void gtk_text_view_finalize             (GObject          *object);
@@ -475,6 +484,7 @@ static gboolean gtk_text_view_flush_scroll         (GtkTextView *text_view);
 static void     gtk_text_view_update_adjustments   (GtkTextView *text_view);
 static void     gtk_text_view_invalidate           (GtkTextView *text_view);
 static void     gtk_text_view_flush_first_validate (GtkTextView *text_view);
+static gboolean incremental_validate_callback      (gpointer     data);
 
 static void     gtk_text_view_set_hadjustment        (GtkTextView   *text_view,
                                                       GtkAdjustment *adjustment);
@@ -794,6 +804,22 @@ gtk_text_view_class_init (GtkTextViewClass *klass)
                                                          NULL,
                                                          GTK_PARAM_READWRITE));
 
+  /**
+   * GtkTextView:threaded-validation:
+   *
+   * Whether the sizes of the lines that are not shown are computed
+   * in worker threads. See gtk_text_view_set_threaded_validation().
+   *
+   * Since: 3.2
+   */
+  g_object_class_install_property (gobject_class,
+                                   PROP_THREADED_VALIDATION,
+                                   g_param_spec_boolean ("threaded-validation",
+                                                         P_("Threaded validation"),
+                                                         P_("Whether offscreen lines are measured in worker threads"),
+                                                         FALSE,
+                                                         GTK_PARAM_READWRITE));
+
    /* GtkScrollable interface */
    g_object_class_override_property (gobject_class, PROP_HADJUSTMENT,    "hadjustment");
    g_object_class_override_property (gobject_class, PROP_VADJUSTMENT,    "vadjustment");
@@ -3163,6 +3189,10 @@ gtk_text_view_set_property (GObject         *object,
       gtk_widget_queue_resize (GTK_WIDGET (text_view));
       break;
 
+    case PROP_THREADED_VALIDATION:
+      gtk_text_view_set_threaded_validation (text_view, g_value_get_boolean (value));
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3259,6 +3289,10 @@ gtk_text_view_get_property (GObject         *object,
       g_value_set_enum (value, priv->vscroll_policy);
       break;
 
+    case PROP_THREADED_VALIDATION:
+      g_value_set_boolean (value, priv->threaded_validation);
+      break;
+
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -3781,15 +3815,53 @@ first_validate_callback (gpointer data)
   return FALSE;
 }
 
+static void
+lines_measured (GtkTextLayout *layout,
+                gpointer       data)
+{
+  GtkTextView *text_view = data;
+  GtkTextViewPrivate *priv = text_view->priv;
+
+  gtk_text_view_update_adjustments (text_view);
+
+  if (!priv->incremental_validate_idle &&
+      !gtk_text_layout_is_valid (layout))
+    priv->incremental_validate_idle = gdk_threads_add_idle_full (GTK_TEXT_VIEW_PRIORITY_VALIDATE, incremental_validate_callback, text_view, NULL);
+}
+
 static gboolean
 incremental_validate_callback (gpointer data)
 {
   GtkTextView *text_view = data;
   gboolean result = TRUE;
+  GTimer *timer;
 
   DV(g_print(G_STRLOC"\n"));
-  
-  gtk_text_layout_validate (text_view->priv->layout, 2000);
+
+  /* Hand the next lines to the worker threads, lines_measured()
+   * queues us again once they are done.
+   */
+  if (text_view->priv->threaded_validation &&
+      _gtk_text_layout_measure_lines (text_view->priv->layout,
+                                      GTK_TEXT_VIEW_MEASURE_LINES,
+                                      lines_measured, text_view))
+    {
+      text_view->priv->incremental_validate_idle = 0;
+      return FALSE;
+    }
+
+  /* Validate as much as fits in a time slice rather than a fixed
+   * amount of pixels, so that big buffers get their full height
+   * quickly without blocking the main loop for too long.
+   */
+  timer = g_timer_new ();
+
+  do
+    gtk_text_layout_validate (text_view->priv->layout, 2000);
+  while (!gtk_text_layout_is_valid (text_view->priv->layout) &&
+         g_timer_elapsed (timer, NULL) < GTK_TEXT_VIEW_TIME_MS_PER_IDLE / 1000.);
+
+  g_timer_destroy (timer);
 
   gtk_text_view_update_adjustments (text_view);
   
@@ -6152,6 +6224,62 @@ gtk_text_view_get_accepts_tab (GtkTextView *text_view)
   return text_view->priv->accepts_tab;
 }
 
+/**
+ * gtk_text_view_set_threaded_validation:
+ * @text_view: a #GtkTextView
+ * @threaded: %TRUE to measure offscreen lines in worker threads
+ *
+ * Sets whether the lines of @text_view that are not on screen are
+ * measured in worker threads. Computing the heights of all lines
+ * of a big buffer takes a while, and the scrollbar keeps changing
+ * until it is done. With threaded validation, the text and
+ * attributes of the lines are copied on the main thread and laid
+ * out by a pool of worker threads, each using its own Pango font
+ * map. The main thread only stores the resulting sizes.
+ *
+ * Lines containing child widgets, and the lines showing the input
+ * method preedit string, are still measured on the main thread.
+ * Threaded validation is not used if the #PangoContext of
+ * @text_view does not use the default Pango font map.
+ *
+ * Since: 3.2
+ **/
+void
+gtk_text_view_set_threaded_validation (GtkTextView *text_view,
+                                       gboolean     threaded)
+{
+  GtkTextViewPrivate *priv;
+
+  g_return_if_fail (GTK_IS_TEXT_VIEW (text_view));
+
+  priv = text_view->priv;
+
+  threaded = threaded != FALSE;
+  if (priv->threaded_validation != threaded)
+    {
+      priv->threaded_validation = threaded;
+      g_object_notify (G_OBJECT (text_view), "threaded-validation");
+    }
+}
+
+/**
+ * gtk_text_view_get_threaded_validation:
+ * @text_view: a #GtkTextView
+ *
+ * Gets the value of the #GtkTextView:threaded-validation property.
+ *
+ * Return value: whether offscreen lines are measured in worker threads
+ *
+ * Since: 3.2
+ **/
+gboolean
+gtk_text_view_get_threaded_validation (GtkTextView *text_view)
+{
+  g_return_val_if_fail (GTK_IS_TEXT_VIEW (text_view), FALSE);
+
+  return text_view->priv->threaded_validation;
+}
+
 /*
  * Selections
  */
@@ -6768,6 +6896,7 @@ gtk_text_view_destroy_layout (GtkTextView *text_view)
       GSList *tmp_list;
 
       gtk_text_view_remove_validate_idles (text_view);
+      _gtk_text_layout_cancel_measure (priv->layout);
 
       g_signal_handlers_disconnect_by_func (priv->layout,
 					    invalidated_handler,
@@ -282,6 +282,10 @@ PangoTabArray*   gtk_text_view_get_tabs               (GtkTextView      *text_vi
 /* note that the return value of this changes with the theme */
 GtkTextAttributes* gtk_text_view_get_default_attributes (GtkTextView    *text_view);
 
+void               gtk_text_view_set_threaded_validation (GtkTextView *text_view,
+                                                          gboolean     threaded);
+gboolean           gtk_text_view_get_threaded_validation (GtkTextView *text_view);
+
 G_END_DECLS
 
 #endif /* __GTK_TEXT_VIEW_H__ */
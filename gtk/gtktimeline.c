@@ -20,6 +20,7 @@
 #include <gtk/gtktimeline.h>
 #include <gtk/gtktypebuiltins.h>
 #include <gtk/gtksettings.h>
+#include "gtkintl.h"
 #include <math.h>
 
 #define MSECS_PER_SEC 1000
@@ -27,12 +28,14 @@
 #define DEFAULT_FPS 30
 
 typedef struct GtkTimelinePriv GtkTimelinePriv;
+typedef struct GtkTimelineScheduler GtkTimelineScheduler;
 
 struct GtkTimelinePriv
 {
   guint duration;
   guint fps;
-  guint source_id;
+
+  GtkTimelineScheduler *scheduler;
 
   GTimer *timer;
 
@@ -40,12 +43,27 @@ struct GtkTimelinePriv
   gdouble last_progress;
 
   GdkScreen *screen;
+  GdkWindow *window;
 
   GtkTimelineProgressType progress_type;
 
   guint animations_enabled : 1;
   guint loop               : 1;
   guint direction          : 1;
+  guint frozen             : 1;
+};
+
+/* All running timelines on a screen are driven from a single
+ * source, so they advance in the same main loop iteration and
+ * their redraws are processed in one go.
+ */
+struct GtkTimelineScheduler
+{
+  GList *timelines;
+  guint source_id;
+  guint interval;
+  guint n_ticks;
+  guint in_tick : 1;
 };
 
 enum {
@@ -78,6 +96,11 @@ static void  gtk_timeline_get_property  (GObject         *object,
                                          GParamSpec      *pspec);
 static void  _gtk_timeline_finalize     (GObject *object);
 
+static void  gtk_timeline_run_frame         (GtkTimeline          *timeline);
+static void  gtk_timeline_scheduler_update  (GtkTimelineScheduler *scheduler);
+static void  gtk_timeline_scheduler_remove  (GtkTimelineScheduler *scheduler,
+                                             GtkTimeline          *timeline);
+
 
 G_DEFINE_TYPE (GtkTimeline, _gtk_timeline, G_TYPE_OBJECT)
 
@@ -255,18 +278,205 @@ _gtk_timeline_finalize (GObject *object)
   timeline = (GtkTimeline *) object;
   priv = timeline->priv;
 
-  if (priv->source_id)
-    {
-      g_source_remove (priv->source_id);
-      priv->source_id = 0;
-    }
+  if (priv->scheduler)
+    gtk_timeline_scheduler_remove (priv->scheduler, timeline);
 
   if (priv->timer)
     g_timer_destroy (priv->timer);
 
+  if (priv->window)
+    g_object_unref (priv->window);
+
   G_OBJECT_CLASS (_gtk_timeline_parent_class)->finalize (object);
 }
 
+static guint
+gtk_timeline_scheduler_get_interval (GtkTimelineScheduler *scheduler)
+{
+  guint interval = G_MAXUINT;
+  GList *l;
+
+  for (l = scheduler->timelines; l; l = l->next)
+    {
+      GtkTimelinePriv *priv = GTK_TIMELINE (l->data)->priv;
+      guint timeline_interval;
+
+      /* Frozen timelines are woken up when a window gets mapped */
+      if (priv->frozen)
+        continue;
+
+      if (!priv->animations_enabled)
+        timeline_interval = 0;
+      else
+        timeline_interval = FRAME_INTERVAL (priv->fps);
+
+      interval = MIN (interval, timeline_interval);
+    }
+
+  return interval;
+}
+
+static gboolean
+gtk_timeline_scheduler_tick (gpointer user_data)
+{
+  GtkTimelineScheduler *scheduler = user_data;
+  GList *timelines, *l;
+  guint interval;
+
+  scheduler->in_tick = TRUE;
+  scheduler->n_ticks++;
+
+  /* Timelines may finish, be paused or be finalized from
+   * the ::frame handlers, so iterate over a copy.
+   */
+  timelines = g_list_copy (scheduler->timelines);
+  g_list_foreach (timelines, (GFunc) g_object_ref, NULL);
+
+  for (l = timelines; l; l = l->next)
+    {
+      GtkTimeline *timeline = l->data;
+      GtkTimelinePriv *priv = timeline->priv;
+
+      if (priv->scheduler == scheduler)
+        gtk_timeline_run_frame (timeline);
+    }
+
+  g_list_foreach (timelines, (GFunc) g_object_unref, NULL);
+  g_list_free (timelines);
+
+  scheduler->in_tick = FALSE;
+
+  /* Paint everything the timelines invalidated in a single pass */
+  gdk_window_process_all_updates ();
+
+  interval = gtk_timeline_scheduler_get_interval (scheduler);
+
+  if (interval != G_MAXUINT && interval == scheduler->interval)
+    return TRUE;
+
+  scheduler->source_id = 0;
+  gtk_timeline_scheduler_update (scheduler);
+
+  return FALSE;
+}
+
+static void
+gtk_timeline_scheduler_update (GtkTimelineScheduler *scheduler)
+{
+  guint interval;
+
+  /* The tick function reschedules once all timelines ran */
+  if (scheduler->in_tick)
+    return;
+
+  interval = gtk_timeline_scheduler_get_interval (scheduler);
+
+  if (scheduler->source_id)
+    {
+      if (interval != G_MAXUINT && interval == scheduler->interval)
+        return;
+
+      g_source_remove (scheduler->source_id);
+      scheduler->source_id = 0;
+    }
+
+  /* No timelines, or all of them are frozen */
+  if (interval == G_MAXUINT)
+    return;
+
+  scheduler->interval = interval;
+
+  if (interval == 0)
+    scheduler->source_id = gdk_threads_add_idle (gtk_timeline_scheduler_tick,
+                                                 scheduler);
+  else
+    scheduler->source_id = gdk_threads_add_timeout (interval,
+                                                    gtk_timeline_scheduler_tick,
+                                                    scheduler);
+}
+
+static void
+gtk_timeline_scheduler_free (GtkTimelineScheduler *scheduler)
+{
+  GList *l;
+
+  for (l = scheduler->timelines; l; l = l->next)
+    {
+      GtkTimelinePriv *priv = GTK_TIMELINE (l->data)->priv;
+
+      priv->scheduler = NULL;
+    }
+
+  if (scheduler->source_id)
+    g_source_remove (scheduler->source_id);
+
+  g_list_free (scheduler->timelines);
+  g_slice_free (GtkTimelineScheduler, scheduler);
+}
+
+static GtkTimelineScheduler *
+gtk_timeline_scheduler_get_for_screen (GdkScreen *screen)
+{
+  static GtkTimelineScheduler *default_scheduler = NULL;
+  GtkTimelineScheduler *scheduler;
+
+  if (!screen)
+    {
+      if (!default_scheduler)
+        default_scheduler = g_slice_new0 (GtkTimelineScheduler);
+
+      return default_scheduler;
+    }
+
+  scheduler = g_object_get_data (G_OBJECT (screen), "gtk-timeline-scheduler");
+
+  if (!scheduler)
+    {
+      scheduler = g_slice_new0 (GtkTimelineScheduler);
+      g_object_set_data_full (G_OBJECT (screen), I_("gtk-timeline-scheduler"),
+                              scheduler, (GDestroyNotify) gtk_timeline_scheduler_free);
+    }
+
+  return scheduler;
+}
+
+static void
+gtk_timeline_scheduler_add (GtkTimelineScheduler *scheduler,
+                            GtkTimeline          *timeline)
+{
+  GtkTimelinePriv *priv = timeline->priv;
+
+  g_assert (priv->scheduler == NULL);
+
+  priv->scheduler = scheduler;
+  priv->frozen = FALSE;
+  scheduler->timelines = g_list_prepend (scheduler->timelines, timeline);
+
+  gtk_timeline_scheduler_update (scheduler);
+}
+
+static void
+gtk_timeline_scheduler_remove (GtkTimelineScheduler *scheduler,
+                               GtkTimeline          *timeline)
+{
+  GtkTimelinePriv *priv = timeline->priv;
+
+  g_assert (priv->scheduler == scheduler);
+
+  priv->scheduler = NULL;
+  scheduler->timelines = g_list_remove (scheduler->timelines, timeline);
+
+  gtk_timeline_scheduler_update (scheduler);
+}
+
+static gboolean
+gtk_timeline_window_is_hidden (GtkTimelinePriv *priv)
+{
+  return (priv->window &&
+          !gdk_window_is_destroyed (priv->window) &&
+          !gdk_window_is_viewable (priv->window));
+}
+
 static gdouble
 calculate_progress (gdouble                 linear_progress,
                     GtkTimelineProgressType progress_type)
@@ -304,7 +514,7 @@ calculate_progress (gdouble                 linear_progress,
   return progress;
 }
 
-static gboolean
+static void
 gtk_timeline_run_frame (GtkTimeline *timeline)
 {
   GtkTimelinePriv *priv;
@@ -313,6 +523,21 @@ gtk_timeline_run_frame (GtkTimeline *timeline)
 
   priv = timeline->priv;
 
+  /* Don't advance while the window is unmapped, the
+   * animation picks up where it was once it's back.
+   */
+  if (gtk_timeline_window_is_hidden (priv))
+    {
+      if (!priv->frozen)
+        {
+          g_timer_stop (priv->timer);
+          priv->frozen = TRUE;
+        }
+      return;
+    }
+
+  priv->frozen = FALSE;
+
   elapsed_time = (guint) (g_timer_elapsed (priv->timer, NULL) * 1000);
   g_timer_start (priv->timer);
 
@@ -342,20 +567,15 @@ gtk_timeline_run_frame (GtkTimeline *timeline)
     {
       if (!priv->loop)
         {
-          if (priv->source_id)
-            {
-              g_source_remove (priv->source_id);
-              priv->source_id = 0;
-            }
+          if (priv->scheduler)
+            gtk_timeline_scheduler_remove (priv->scheduler, timeline);
+
           g_timer_stop (priv->timer);
           g_signal_emit (timeline, signals [FINISHED], 0);
-          return FALSE;
         }
       else
         _gtk_timeline_rewind (timeline);
     }
-
-  return TRUE;
 }
 
 /**
@@ -401,7 +621,7 @@ _gtk_timeline_start (GtkTimeline *timeline)
 
   priv = timeline->priv;
 
-  if (!priv->source_id)
+  if (!priv->scheduler)
     {
       if (priv->timer)
         g_timer_continue (priv->timer);
@@ -421,13 +641,8 @@ _gtk_timeline_start (GtkTimeline *timeline)
 
       g_signal_emit (timeline, signals [STARTED], 0);
 
-      if (enable_animations)
-        priv->source_id = gdk_threads_add_timeout (FRAME_INTERVAL (priv->fps),
-                                                   (GSourceFunc) gtk_timeline_run_frame,
-                                                   timeline);
-      else
-        priv->source_id = gdk_threads_add_idle ((GSourceFunc) gtk_timeline_run_frame,
-                                                timeline);
+      gtk_timeline_scheduler_add (gtk_timeline_scheduler_get_for_screen (priv->screen),
+                                  timeline);
     }
 }
 
@@ -446,11 +661,10 @@ _gtk_timeline_pause (GtkTimeline *timeline)
 
   priv = timeline->priv;
 
-  if (priv->source_id)
+  if (priv->scheduler)
     {
       g_timer_stop (priv->timer);
-      g_source_remove (priv->source_id);
-      priv->source_id = 0;
+      gtk_timeline_scheduler_remove (priv->scheduler, timeline);
       g_signal_emit (timeline, signals [PAUSED], 0);
     }
 }
@@ -480,7 +694,7 @@ _gtk_timeline_rewind (GtkTimeline *timeline)
     {
       g_timer_start (priv->timer);
 
-      if (!priv->source_id)
+      if (!priv->scheduler)
         g_timer_stop (priv->timer);
     }
 }
@@ -502,7 +716,7 @@ _gtk_timeline_is_running (GtkTimeline *timeline)
 
   priv = timeline->priv;
 
-  return (priv->source_id != 0);
+  return (priv->scheduler != NULL);
 }
 
 /**
@@ -545,13 +759,8 @@ _gtk_timeline_set_fps (GtkTimeline *timeline,
 
   priv->fps = fps;
 
-  if (_gtk_timeline_is_running (timeline))
-    {
-      g_source_remove (priv->source_id);
-      priv->source_id = gdk_threads_add_timeout (FRAME_INTERVAL (priv->fps),
-                                                 (GSourceFunc) gtk_timeline_run_frame,
-                                                 timeline);
-    }
+  if (priv->scheduler)
+    gtk_timeline_scheduler_update (priv->scheduler);
 
   g_object_notify (G_OBJECT (timeline), "fps");
 }
@@ -684,6 +893,13 @@ _gtk_timeline_set_screen (GtkTimeline *timeline,
 
   priv->screen = g_object_ref (screen);
 
+  if (priv->scheduler)
+    {
+      gtk_timeline_scheduler_remove (priv->scheduler, timeline);
+      gtk_timeline_scheduler_add (gtk_timeline_scheduler_get_for_screen (screen),
+                                  timeline);
+    }
+
   g_object_notify (G_OBJECT (timeline), "screen");
 }
 
@@ -698,6 +914,109 @@ _gtk_timeline_get_screen (GtkTimeline *timeline)
   return priv->screen;
 }
 
+/**
+ * gtk_timeline_set_window:
+ * @timeline: A #GtkTimeline
+ * @window: (allow-none): the #GdkWindow the timeline animates, or %NULL
+ *
+ * Sets the window the timeline paints on. While @window
+ * is not viewable the timeline stays at its current
+ * progress, and continues once the window is mapped again.
+ * See _gtk_timeline_window_mapped().
+ **/
+void
+_gtk_timeline_set_window (GtkTimeline *timeline,
+                          GdkWindow   *window)
+{
+  GtkTimelinePriv *priv;
+
+  g_return_if_fail (GTK_IS_TIMELINE (timeline));
+  g_return_if_fail (!window || GDK_IS_WINDOW (window));
+
+  priv = timeline->priv;
+
+  if (window == priv->window)
+    return;
+
+  if (window)
+    g_object_ref (window);
+
+  if (priv->window)
+    g_object_unref (priv->window);
+
+  priv->window = window;
+
+  if (priv->frozen && !gtk_timeline_window_is_hidden (priv))
+    {
+      g_timer_continue (priv->timer);
+      priv->frozen = FALSE;
+
+      if (priv->scheduler)
+        gtk_timeline_scheduler_update (priv->scheduler);
+    }
+}
+
+GdkWindow *
+_gtk_timeline_get_window (GtkTimeline *timeline)
+{
+  GtkTimelinePriv *priv;
+
+  g_return_val_if_fail (GTK_IS_TIMELINE (timeline), NULL);
+
+  priv = timeline->priv;
+  return priv->window;
+}
+
+/*
+ * _gtk_timeline_window_mapped:
+ * @window: a #GdkWindow that was just mapped
+ *
+ * Lets running timelines frozen on windows that are now viewable
+ * continue. Frozen timelines are not polled, so this must be called
+ * whenever a window may have become viewable.
+ */
+void
+_gtk_timeline_window_mapped (GdkWindow *window)
+{
+  GtkTimelineScheduler *scheduler;
+  gboolean thawed = FALSE;
+  GList *l;
+
+  g_return_if_fail (GDK_IS_WINDOW (window));
+
+  scheduler = g_object_get_data (G_OBJECT (gdk_window_get_screen (window)),
+                                 "gtk-timeline-scheduler");
+  if (!scheduler)
+    return;
+
+  for (l = scheduler->timelines; l; l = l->next)
+    {
+      GtkTimelinePriv *priv = GTK_TIMELINE (l->data)->priv;
+
+      if (priv->frozen && !gtk_timeline_window_is_hidden (priv))
+        {
+          g_timer_continue (priv->timer);
+          priv->frozen = FALSE;
+          thawed = TRUE;
+        }
+    }
+
+  if (thawed)
+    gtk_timeline_scheduler_update (scheduler);
+}
+
+/*
+ * Returns how many times the scheduler of the screen of @timeline
+ * has ticked, for the tests.
+ */
+guint
+_gtk_timeline_get_n_ticks (GtkTimeline *timeline)
+{
+  g_return_val_if_fail (GTK_IS_TIMELINE (timeline), 0);
+
+  return gtk_timeline_scheduler_get_for_screen (timeline->priv->screen)->n_ticks;
+}
+
 gdouble
 _gtk_timeline_get_progress (GtkTimeline *timeline)
 {
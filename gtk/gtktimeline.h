@@ -101,6 +101,12 @@ GdkScreen *             _gtk_timeline_get_screen        (GtkTimeline
 void                    _gtk_timeline_set_screen        (GtkTimeline             *timeline,
                                                          GdkScreen               *screen);
 
+GdkWindow *             _gtk_timeline_get_window        (GtkTimeline             *timeline);
+void                    _gtk_timeline_set_window        (GtkTimeline             *timeline,
+                                                         GdkWindow               *window);
+void                    _gtk_timeline_window_mapped     (GdkWindow               *window);
+guint                   _gtk_timeline_get_n_ticks       (GtkTimeline             *timeline);
+
 GtkTimelineDirection    _gtk_timeline_get_direction     (GtkTimeline             *timeline);
 void                    _gtk_timeline_set_direction     (GtkTimeline             *timeline,
                                                          GtkTimelineDirection     direction);
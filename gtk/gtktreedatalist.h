@@ -50,6 +50,14 @@ typedef struct _GtkTreeDataSortHeader
   GDestroyNotify destroy;
 } GtkTreeDataSortHeader;
 
+typedef union _GtkTreeDataSortKey
+{
+  gint64   v_int64;
+  guint64  v_uint64;
+  gdouble  v_double;
+  gchar   *v_string;
+} GtkTreeDataSortKey;
+
 GtkTreeDataList *_gtk_tree_data_list_alloc          (void);
 void             _gtk_tree_data_list_free           (GtkTreeDataList *list,
 						     GType           *column_headers);
@@ -79,4 +87,19 @@ GList                 *_gtk_tree_data_list_set_header  (GList                  *
 							gpointer                data,
 							GDestroyNotify          destroy);
 
+/* Sort key code */
+GType                  _gtk_tree_data_list_get_sort_key_type (GtkTreeModel             *model,
+                                                              GtkTreeIterCompareFunc    func,
+                                                              gpointer                  data);
+void                   _gtk_tree_data_list_get_sort_key      (GtkTreeModel             *model,
+                                                              GtkTreeIter              *iter,
+                                                              gint                      column,
+                                                              GtkTreeDataSortKey       *key);
+gint                   _gtk_tree_data_list_compare_sort_keys (GType                     key_type,
+                                                              const GtkTreeDataSortKey *a,
+                                                              const GtkTreeDataSortKey *b);
+void                   _gtk_tree_data_list_free_sort_keys    (GType                     key_type,
+                                                              GtkTreeDataSortKey       *keys,
+                                                              gint                      n_keys);
+
 #endif /* __GTK_TREE_DATA_LIST_H__ */
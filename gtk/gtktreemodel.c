@@ -24,6 +24,7 @@
 #include <glib/gprintf.h>
 #include <gobject/gvaluecollector.h>
 #include "gtktreemodel.h"
+#include "gtktreemodelprivate.h"
 #include "gtktreeview.h"
 #include "gtktreeprivate.h"
 #include "gtkmarshalers.h"
@@ -2451,3 +2452,156 @@ gtk_tree_row_reference_reordered (GObject     *proxy,
 
   gtk_tree_row_ref_reordered ((RowRefList *)g_object_get_data (proxy, ROW_REF_DATA_STRING), path, iter, new_order);
 }
+
+/* Whether anything would notice a ::row-inserted emission,
+ * models can use this to skip emitting the signal (and
+ * building paths for it) when adding many rows.
+ */
+gboolean
+_gtk_tree_model_has_row_inserted_listeners (GtkTreeModel *tree_model)
+{
+  RowRefList *refs;
+
+  refs = g_object_get_data (G_OBJECT (tree_model), ROW_REF_DATA_STRING);
+  if (refs && refs->list)
+    return TRUE;
+
+  if (GTK_TREE_MODEL_GET_IFACE (tree_model)->row_inserted)
+    return TRUE;
+
+  return g_signal_has_handler_pending (tree_model,
+                                       tree_model_signals[ROW_INSERTED],
+                                       0, FALSE);
+}
+
+/* Listeners that can take a range of inserted rows in one go,
+ * instead of one ::row-inserted emission per row.
+ */
+#define ROWS_INSERTED_DATA_STRING "gtk-tree-model-rows-inserted"
+
+typedef struct
+{
+  gulong row_inserted_id;
+  GtkTreeModelRowsInsertedFunc func;
+  gpointer data;
+} RowsInsertedHandler;
+
+static void
+rows_inserted_handlers_free (gpointer data)
+{
+  GSList *handlers = data, *l;
+
+  for (l = handlers; l; l = l->next)
+    g_slice_free (RowsInsertedHandler, l->data);
+  g_slist_free (handlers);
+}
+
+/* Registers @func to be called instead of the ::row-inserted
+ * handler @row_inserted_id when a model inserts a range of rows
+ * at the top level, see _gtk_tree_model_begin_rows_inserted().
+ */
+void
+_gtk_tree_model_add_rows_inserted_handler (GtkTreeModel                 *tree_model,
+                                           gulong                        row_inserted_id,
+                                           GtkTreeModelRowsInsertedFunc  func,
+                                           gpointer                      data)
+{
+  RowsInsertedHandler *handler;
+  GSList *handlers;
+
+  handler = g_slice_new (RowsInsertedHandler);
+  handler->row_inserted_id = row_inserted_id;
+  handler->func = func;
+  handler->data = data;
+
+  handlers = g_object_steal_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING);
+  handlers = g_slist_prepend (handlers, handler);
+  g_object_set_data_full (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING,
+                          handlers, rows_inserted_handlers_free);
+}
+
+void
+_gtk_tree_model_remove_rows_inserted_handler (GtkTreeModel *tree_model,
+                                              gpointer      data)
+{
+  GSList *handlers, *l;
+
+  handlers = g_object_steal_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING);
+
+  for (l = handlers; l; l = l->next)
+    {
+      RowsInsertedHandler *handler = l->data;
+
+      if (handler->data == data)
+        {
+          handlers = g_slist_delete_link (handlers, l);
+          g_slice_free (RowsInsertedHandler, handler);
+          break;
+        }
+    }
+
+  if (handlers)
+    g_object_set_data_full (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING,
+                            handlers, rows_inserted_handlers_free);
+}
+
+static void
+rows_inserted_handlers_block (GtkTreeModel *tree_model,
+                              gboolean      block)
+{
+  GSList *l;
+
+  for (l = g_object_get_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING); l; l = l->next)
+    {
+      RowsInsertedHandler *handler = l->data;
+
+      if (block)
+        g_signal_handler_block (tree_model, handler->row_inserted_id);
+      else
+        g_signal_handler_unblock (tree_model, handler->row_inserted_id);
+    }
+}
+
+/* Starts inserting a range of rows at the top level. Returns
+ * %TRUE if all listeners can be told about the whole range at
+ * once, in which case the model must not emit ::row-inserted
+ * for the rows, and must call _gtk_tree_model_end_rows_inserted()
+ * once they are all in place. Returns %FALSE if somebody needs
+ * to see the rows being inserted one by one.
+ */
+gboolean
+_gtk_tree_model_begin_rows_inserted (GtkTreeModel *tree_model)
+{
+  rows_inserted_handlers_block (tree_model, TRUE);
+
+  if (!_gtk_tree_model_has_row_inserted_listeners (tree_model))
+    return TRUE;
+
+  rows_inserted_handlers_block (tree_model, FALSE);
+
+  return FALSE;
+}
+
+void
+_gtk_tree_model_end_rows_inserted (GtkTreeModel *tree_model,
+                                   gint          position,
+                                   gint          n_rows)
+{
+  GSList *handlers, *l;
+
+  rows_inserted_handlers_block (tree_model, FALSE);
+
+  /* Handlers may go away while the others are called */
+  handlers = g_slist_copy (g_object_get_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING));
+
+  for (l = handlers; l; l = l->next)
+    {
+      RowsInsertedHandler *handler = l->data;
+
+      if (g_slist_find (g_object_get_data (G_OBJECT (tree_model), ROWS_INSERTED_DATA_STRING),
+                        handler))
+        handler->func (tree_model, position, n_rows, handler->data);
+    }
+
+  g_slist_free (handlers);
+}
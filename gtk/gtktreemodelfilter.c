@@ -3572,6 +3572,147 @@ gtk_tree_model_filter_refilter (GtkTreeModelFilter *filter)
                           filter);
 }
 
+static void
+gtk_tree_model_filter_refilter_level (GtkTreeModelFilter *filter,
+                                      FilterLevel        *level,
+                                      GtkTreePath        *c_parent_path)
+{
+  GtkTreeModel *c_model = filter->priv->child_model;
+  GtkTreeIter c_parent;
+  GtkTreeIter c_iter;
+  GArray *changed;
+  GArray *descend;
+  gint i, j;
+
+  if (gtk_tree_path_get_depth (c_parent_path) > 0)
+    {
+      if (!gtk_tree_model_get_iter (c_model, &c_parent, c_parent_path)
+          || !gtk_tree_model_iter_children (c_model, &c_iter, &c_parent))
+        return;
+    }
+  else if (!gtk_tree_model_get_iter_first (c_model, &c_iter))
+    return;
+
+  changed = g_array_new (FALSE, FALSE, sizeof (gint));
+  descend = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  /* First evaluate the visible function for the complete level and
+   * compare the result with the cached state.  The elements are sorted
+   * on offset, so a single pass over both suffices.  Nothing is changed
+   * during this pass, we only collect the offsets of the rows whose
+   * visibility differs and of the visible rows whose children need
+   * to be checked.
+   */
+  i = 0;
+  j = 0;
+
+  do
+    {
+      FilterElt *elt = NULL;
+      gboolean visible;
+
+      while (j < level->array->len
+             && g_array_index (level->array, FilterElt, j).offset < i)
+        j++;
+
+      if (j < level->array->len
+          && g_array_index (level->array, FilterElt, j).offset == i)
+        elt = &g_array_index (level->array, FilterElt, j);
+
+      visible = gtk_tree_model_filter_visible (filter, &c_iter);
+
+      if (visible != (elt && elt->visible))
+        g_array_append_val (changed, i);
+      else if (visible && elt->children)
+        g_array_append_val (descend, i);
+
+      i++;
+    }
+  while (gtk_tree_model_iter_next (c_model, &c_iter));
+
+  /* Levels below rows that stay visible are kept, so refilter those. */
+  for (i = 0; i < descend->len; i++)
+    {
+      FilterElt *elt;
+      gint offset;
+
+      offset = g_array_index (descend, gint, i);
+      elt = bsearch_elt_with_offset (level->array, offset, &j);
+
+      if (!elt || !elt->children)
+        continue;
+
+      gtk_tree_path_append_index (c_parent_path, offset);
+      gtk_tree_model_filter_refilter_level (filter, elt->children,
+                                            c_parent_path);
+      gtk_tree_path_up (c_parent_path);
+    }
+
+  /* Finally handle the rows whose visibility changed.  Inserting and
+   * removing nodes may rearrange or free this level, so from here on
+   * only child paths are used to refer to the rows.
+   */
+  for (i = 0; i < changed->len; i++)
+    {
+      gtk_tree_path_append_index (c_parent_path,
+                                  g_array_index (changed, gint, i));
+
+      if (gtk_tree_model_get_iter (c_model, &c_iter, c_parent_path))
+        gtk_tree_model_filter_row_changed (c_model, c_parent_path, &c_iter,
+                                           filter);
+
+      gtk_tree_path_up (c_parent_path);
+    }
+
+  g_array_free (changed, TRUE);
+  g_array_free (descend, TRUE);
+}
+
+/**
+ * gtk_tree_model_filter_refilter_visibility:
+ * @filter: A #GtkTreeModelFilter.
+ *
+ * Re-evaluates whether the rows of the child model are visible, like
+ * gtk_tree_model_filter_refilter(). Unlike that function, only
+ * ::row-inserted and ::row-deleted (and ::row-has-child-toggled where
+ * needed) are emitted, and only for the rows whose visibility
+ * changed. Rows that stay visible do not get ::row-changed.
+ *
+ * Only the levels of @filter that have been accessed are checked,
+ * so this is considerably cheaper than gtk_tree_model_filter_refilter()
+ * for large models. Use it when only the criteria deciding about
+ * visibility have changed, not the contents of the rows.
+ *
+ * Since: 3.2
+ */
+void
+gtk_tree_model_filter_refilter_visibility (GtkTreeModelFilter *filter)
+{
+  GtkTreePath *c_path;
+
+  g_return_if_fail (GTK_IS_TREE_MODEL_FILTER (filter));
+
+  if (!filter->priv->root)
+    {
+      /* No level has been built yet, or all rows in the root level
+       * were filtered out; build it and announce the visible rows.
+       */
+      gtk_tree_model_filter_build_level (filter, NULL, -1, TRUE);
+      return;
+    }
+
+  if (filter->priv->virtual_root)
+    c_path = gtk_tree_path_copy (filter->priv->virtual_root);
+  else
+    c_path = gtk_tree_path_new ();
+
+  gtk_tree_model_filter_refilter_level (filter,
+                                        FILTER_LEVEL (filter->priv->root),
+                                        c_path);
+
+  gtk_tree_path_free (c_path);
+}
+
 /**
  * gtk_tree_model_filter_clear_cache:
  * @filter: A #GtkTreeModelFilter.
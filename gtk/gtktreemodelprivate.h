@@ -0,0 +1,47 @@
+/* GTK - The GIMP Toolkit
+ * gtktreemodelprivate.h
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#ifndef __GTK_TREE_MODEL_PRIVATE_H__
+#define __GTK_TREE_MODEL_PRIVATE_H__
+
+#include "gtktreemodel.h"
+
+G_BEGIN_DECLS
+
+gboolean _gtk_tree_model_has_row_inserted_listeners (GtkTreeModel *tree_model);
+
+typedef void (* GtkTreeModelRowsInsertedFunc) (GtkTreeModel *tree_model,
+                                               gint          position,
+                                               gint          n_rows,
+                                               gpointer      data);
+
+void     _gtk_tree_model_add_rows_inserted_handler    (GtkTreeModel                 *tree_model,
+                                                       gulong                        row_inserted_id,
+                                                       GtkTreeModelRowsInsertedFunc  func,
+                                                       gpointer                      data);
+void     _gtk_tree_model_remove_rows_inserted_handler (GtkTreeModel                 *tree_model,
+                                                       gpointer                      data);
+gboolean _gtk_tree_model_begin_rows_inserted          (GtkTreeModel                 *tree_model);
+void     _gtk_tree_model_end_rows_inserted            (GtkTreeModel                 *tree_model,
+                                                       gint                          position,
+                                                       gint                          n_rows);
+
+G_END_DECLS
+
+#endif /* __GTK_TREE_MODEL_PRIVATE_H__ */
@@ -2839,6 +2839,35 @@ gtk_tree_store_move_after (GtkTreeStore *tree_store,
 }
 
 /* Sorting */
+typedef struct _SortKeyData
+{
+  GtkTreeStore *tree_store;
+  GType key_type;
+  GtkTreeDataSortKey *keys;
+} SortKeyData;
+
+static gint
+gtk_tree_store_key_compare_func (gconstpointer a,
+				 gconstpointer b,
+				 gpointer      user_data)
+{
+  SortKeyData *data = user_data;
+  gint retval;
+
+  retval = _gtk_tree_data_list_compare_sort_keys (data->key_type,
+						  &data->keys[((SortTuple *) a)->offset],
+						  &data->keys[((SortTuple *) b)->offset]);
+
+  if (data->tree_store->priv->order == GTK_SORT_DESCENDING)
+    {
+      if (retval > 0)
+	retval = -1;
+      else if (retval < 0)
+	retval = 1;
+    }
+  return retval;
+}
+
 static gint
 gtk_tree_store_compare_func (gconstpointer a,
 			     gconstpointer b,
@@ -2899,7 +2928,11 @@ gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
 			    GNode        *parent,
 			    gboolean      recurse)
 {
+  GtkTreeStorePrivate *priv = tree_store->priv;
   GtkTreeIter iter;
+  GtkTreeIterCompareFunc func;
+  gpointer func_data;
+  SortKeyData key_data;
   GArray *sort_array;
   GNode *node;
   GNode *tmp_node;
@@ -2934,8 +2967,52 @@ gtk_tree_store_sort_helper (GtkTreeStore *tree_store,
       i++;
     }
 
-  /* Sort the array */
-  g_array_sort_with_data (sort_array, gtk_tree_store_compare_func, tree_store);
+  if (priv->sort_column_id != -1)
+    {
+      GtkTreeDataSortHeader *header;
+
+      header = _gtk_tree_data_list_get_header (priv->sort_list,
+					       priv->sort_column_id);
+      func = header->func;
+      func_data = header->data;
+    }
+  else
+    {
+      func = priv->default_sort_func;
+      func_data = priv->default_sort_data;
+    }
+
+  /* Sort the array; when sorting on a column with the default compare
+   * function, fetch the value of every row once up front, rather than
+   * twice for every comparison.
+   */
+  key_data.key_type = _gtk_tree_data_list_get_sort_key_type (GTK_TREE_MODEL (tree_store),
+							     func, func_data);
+
+  if (key_data.key_type != G_TYPE_INVALID)
+    {
+      key_data.tree_store = tree_store;
+      key_data.keys = g_new (GtkTreeDataSortKey, list_length);
+
+      for (i = 0; i < list_length; i++)
+	{
+	  iter.stamp = priv->stamp;
+	  iter.user_data = g_array_index (sort_array, SortTuple, i).node;
+
+	  _gtk_tree_data_list_get_sort_key (GTK_TREE_MODEL (tree_store), &iter,
+					    GPOINTER_TO_INT (func_data),
+					    &key_data.keys[i]);
+	}
+
+      g_array_sort_with_data (sort_array, gtk_tree_store_key_compare_func,
+			      &key_data);
+
+      _gtk_tree_data_list_free_sort_keys (key_data.key_type, key_data.keys,
+					  list_length);
+    }
+  else
+    g_array_sort_with_data (sort_array, gtk_tree_store_compare_func,
+			    tree_store);
 
   for (i = 0; i < list_length - 1; i++)
     {
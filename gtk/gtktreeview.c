@@ -27,7 +27,10 @@
 #include "gtkrbtree.h"
 #include "gtktreednd.h"
 #include "gtktreeprivate.h"
+#include "gtktreemodelprivate.h"
 #include "gtkcellrenderer.h"
+#include "gtkcellrenderertext.h"
+#include "gtkcellareabox.h"
 #include "gtkmainprivate.h"
 #include "gtkmarshalers.h"
 #include "gtkbuildable.h"
@@ -46,6 +49,8 @@
 #include "gtktooltip.h"
 #include "gtkscrollable.h"
 #include "gtkcelllayout.h"
+#include "gtkorientable.h"
+#include "gtkpango.h"
 #include "gtkprivate.h"
 #include "gtkwidgetprivate.h"
 #include "gtkentryprivate.h"
@@ -229,6 +234,9 @@ enum
 #define GTK_TREE_VIEW_PRIORITY_VALIDATE (GDK_PRIORITY_REDRAW + 5)
 #define GTK_TREE_VIEW_PRIORITY_SCROLL_SYNC (GTK_TREE_VIEW_PRIORITY_VALIDATE + 2)
 #define GTK_TREE_VIEW_TIME_MS_PER_IDLE 30
+#define GTK_TREE_VIEW_N_ESTIMATE_SAMPLES 50
+/* Rows handed to the worker threads at once with threaded validation */
+#define GTK_TREE_VIEW_MEASURE_ROWS 1000
 #define SCROLL_EDGE_SIZE 15
 #define EXPANDER_EXTRA_PADDING 4
 #define GTK_TREE_VIEW_SEARCH_DIALOG_TIMEOUT 5000
@@ -259,6 +267,24 @@ struct _GtkTreeViewChild
   gint height;
 };
 
+/* A row handed to the worker threads by measure_rows() */
+typedef struct _GtkTreeViewMeasuredRow GtkTreeViewMeasuredRow;
+struct _GtkTreeViewMeasuredRow
+{
+  GtkRBTree *tree;
+  GtkRBNode *node;
+};
+
+/* A text cell of such a row, @column indexes the visible columns */
+typedef struct _GtkTreeViewMeasuredCell GtkTreeViewMeasuredCell;
+struct _GtkTreeViewMeasuredCell
+{
+  guint row;
+  guint column;
+  gint xpad;
+  gint ypad;
+};
+
 
 typedef struct _TreeViewDragInfo TreeViewDragInfo;
 struct _TreeViewDragInfo
@@ -311,6 +337,17 @@ struct _GtkTreeViewPrivate
   gint expander_size;
   GtkTreeViewColumn *expander_column;
 
+  /* Style properties needed to measure rows, cached
+   * in style_updated() since validate_row() is called
+   * for every row in the model.
+   */
+  gint focus_pad;
+  gint horizontal_separator;
+  gint vertical_separator;
+  gint style_grid_line_width;
+  gint separator_height;
+  guint wide_separators : 1;
+
   gint level_indentation;
 
   /* Key navigation (focus), selection */
@@ -412,6 +449,19 @@ struct _GtkTreeViewPrivate
   /* fixed height */
   gint fixed_height;
 
+  /* estimated height, given to rows that haven't been measured yet */
+  gint estimated_height;
+
+  /* Rows being measured in worker threads, see measure_rows().
+   * Rows are dropped from measured_nodes when they change while
+   * they are being measured, and their sizes are thrown away.
+   */
+  GtkPangoMeasure *measure;
+  GArray *measured_rows;
+  GArray *measured_cells;
+  GHashTable *measured_nodes;
+  guint n_measured_columns;
+
   /* Scroll-to functionality when unrealized */
   GtkTreeRowReference *scroll_to_path;
   GtkTreeViewColumn *scroll_to_column;
@@ -455,6 +505,10 @@ struct _GtkTreeViewPrivate
   guint fixed_height_mode : 1;
   guint fixed_height_check : 1;
 
+  guint estimated_height_mode : 1;
+
+  guint threaded_validation : 1;
+
   guint reorderable : 1;
   guint header_has_focus : 1;
   guint drag_column_window_state : 3;
@@ -544,6 +598,8 @@ enum {
   PROP_ENABLE_SEARCH,
   PROP_SEARCH_COLUMN,
   PROP_FIXED_HEIGHT_MODE,
+  PROP_ESTIMATED_HEIGHT_MODE,
+  PROP_THREADED_VALIDATION,
   PROP_HOVER_SELECTION,
   PROP_HOVER_EXPAND,
   PROP_SHOW_EXPANDERS,
@@ -689,6 +745,10 @@ static void gtk_tree_view_row_inserted                    (GtkTreeModel    *mode
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
 							   gpointer         data);
+static void gtk_tree_view_rows_inserted                   (GtkTreeModel    *model,
+							   gint             position,
+							   gint             n_rows,
+							   gpointer         data);
 static void gtk_tree_view_row_has_child_toggled           (GtkTreeModel    *model,
 							   GtkTreePath     *path,
 							   GtkTreeIter     *iter,
@@ -713,6 +773,8 @@ static gboolean validate_rows_handler    (GtkTreeView *tree_view);
 static gboolean do_validate_rows         (GtkTreeView *tree_view,
 					  gboolean     size_request);
 static gboolean validate_rows            (GtkTreeView *tree_view);
+static gboolean measure_rows             (GtkTreeView *tree_view);
+static void     cancel_measure_rows      (GtkTreeView *tree_view);
 static gboolean presize_handler_callback (gpointer     data);
 static void     install_presize_handler  (GtkTreeView *tree_view);
 static void     install_scroll_sync_handler (GtkTreeView *tree_view);
@@ -1068,6 +1130,43 @@ gtk_tree_view_class_init (GtkTreeViewClass *class)
                                                            P_("Speeds up GtkTreeView by assuming that all rows have the same height"),
                                                            FALSE,
                                                            GTK_PARAM_READWRITE));
+
+    /**
+     * GtkTreeView:estimated-height-mode:
+     *
+     * Setting the ::estimated-height-mode property to %TRUE speeds up
+     * #GtkTreeView by only measuring the rows that are shown, and
+     * giving all other rows a height estimated from a sample of rows.
+     * Please see gtk_tree_view_set_estimated_height_mode() for more
+     * information on this option.
+     *
+     * Since: 3.2
+     **/
+    g_object_class_install_property (o_class,
+                                     PROP_ESTIMATED_HEIGHT_MODE,
+                                     g_param_spec_boolean ("estimated-height-mode",
+                                                           P_("Estimated Height Mode"),
+                                                           P_("Speeds up GtkTreeView by only measuring rows when they are shown"),
+                                                           FALSE,
+                                                           GTK_PARAM_READWRITE));
+
+    /**
+     * GtkTreeView:threaded-validation:
+     *
+     * Whether the heights of rows showing only text are computed
+     * in worker threads. Please see
+     * gtk_tree_view_set_threaded_validation() for more information
+     * on this option.
+     *
+     * Since: 3.2
+     **/
+    g_object_class_install_property (o_class,
+                                     PROP_THREADED_VALIDATION,
+                                     g_param_spec_boolean ("threaded-validation",
+                                                           P_("Threaded Validation"),
+                                                           P_("Whether rows showing only text are measured in worker threads"),
+                                                           FALSE,
+                                                           GTK_PARAM_READWRITE));
     
     /**
      * GtkTreeView:hover-selection:
@@ -1727,6 +1826,8 @@ gtk_tree_view_init (GtkTreeView *tree_view)
   tree_view->priv->fixed_height = -1;
   tree_view->priv->fixed_height_mode = FALSE;
   tree_view->priv->fixed_height_check = 0;
+  tree_view->priv->estimated_height = -1;
+  tree_view->priv->estimated_height_mode = FALSE;
   tree_view->priv->selection = _gtk_tree_selection_new_with_tree_view (tree_view);
   tree_view->priv->enable_search = TRUE;
   tree_view->priv->search_column = -1;
@@ -1819,6 +1920,12 @@ gtk_tree_view_set_property (GObject         *object,
     case PROP_FIXED_HEIGHT_MODE:
       gtk_tree_view_set_fixed_height_mode (tree_view, g_value_get_boolean (value));
       break;
+    case PROP_ESTIMATED_HEIGHT_MODE:
+      gtk_tree_view_set_estimated_height_mode (tree_view, g_value_get_boolean (value));
+      break;
+    case PROP_THREADED_VALIDATION:
+      gtk_tree_view_set_threaded_validation (tree_view, g_value_get_boolean (value));
+      break;
     case PROP_HOVER_SELECTION:
       tree_view->priv->hover_selection = g_value_get_boolean (value);
       break;
@@ -1900,6 +2007,12 @@ gtk_tree_view_get_property (GObject    *object,
     case PROP_FIXED_HEIGHT_MODE:
       g_value_set_boolean (value, tree_view->priv->fixed_height_mode);
       break;
+    case PROP_ESTIMATED_HEIGHT_MODE:
+      g_value_set_boolean (value, tree_view->priv->estimated_height_mode);
+      break;
+    case PROP_THREADED_VALIDATION:
+      g_value_set_boolean (value, tree_view->priv->threaded_validation);
+      break;
     case PROP_HOVER_SELECTION:
       g_value_set_boolean (value, tree_view->priv->hover_selection);
       break;
@@ -1975,6 +2088,8 @@ gtk_tree_view_buildable_get_internal_child (GtkBuildable      *buildable,
 static void
 gtk_tree_view_free_rbtree (GtkTreeView *tree_view)
 {
+  cancel_measure_rows (tree_view);
+
   _gtk_rbtree_free (tree_view->priv->tree);
   
   tree_view->priv->tree = NULL;
@@ -2308,6 +2423,8 @@ gtk_tree_view_unrealize (GtkWidget *widget)
   context = gtk_widget_get_style_context (widget);
   gtk_style_context_cancel_animations (context, NULL);
 
+  cancel_measure_rows (tree_view);
+
   if (priv->presize_handler_timer != 0)
     {
       g_source_remove (priv->presize_handler_timer);
@@ -2430,7 +2547,8 @@ gtk_tree_view_size_request (GtkWidget      *widget,
 {
   GtkTreeView *tree_view = GTK_TREE_VIEW (widget);
 
-  if (may_validate)
+  /* Rows being measured in worker threads queue a resize when they are done */
+  if (may_validate && tree_view->priv->measure == NULL)
     {
       /* we validate some rows initially just to make sure we have some size.
        * In practice, with a lot of static lists, this should get a good width.
@@ -6093,14 +6211,12 @@ validate_row (GtkTreeView *tree_view,
 
   is_separator = row_is_separator (tree_view, iter, NULL);
 
-  gtk_widget_style_get (GTK_WIDGET (tree_view),
-			"focus-padding", &focus_pad,
-			"horizontal-separator", &horizontal_separator,
-			"vertical-separator", &vertical_separator,
-			"grid-line-width", &grid_line_width,
-                        "wide-separators",  &wide_separators,
-                        "separator-height", &separator_height,
-			NULL);
+  focus_pad = tree_view->priv->focus_pad;
+  horizontal_separator = tree_view->priv->horizontal_separator;
+  vertical_separator = tree_view->priv->vertical_separator;
+  grid_line_width = tree_view->priv->style_grid_line_width;
+  wide_separators = tree_view->priv->wide_separators;
+  separator_height = tree_view->priv->separator_height;
   
   draw_vgrid_lines =
     tree_view->priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_VERTICAL
@@ -6605,6 +6721,84 @@ initialize_fixed_height_mode (GtkTreeView *tree_view)
                                  tree_view->priv->fixed_height, TRUE);
 }
 
+/* Finds the left-most invalid node, the tree must have one */
+static void
+find_first_invalid_node (GtkTreeView  *tree_view,
+                         GtkRBTree   **tree_out,
+                         GtkRBNode   **node_out)
+{
+  GtkRBTree *tree;
+  GtkRBNode *node;
+
+  tree = tree_view->priv->tree;
+  node = tree_view->priv->tree->root;
+
+  g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_INVALID));
+
+  do
+    {
+      if (node->left != tree->nil &&
+	  GTK_RBNODE_FLAG_SET (node->left, GTK_RBNODE_DESCENDANTS_INVALID))
+	{
+	  node = node->left;
+	}
+      else if (node->right != tree->nil &&
+	       GTK_RBNODE_FLAG_SET (node->right, GTK_RBNODE_DESCENDANTS_INVALID))
+	{
+	  node = node->right;
+	}
+      else if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) ||
+	       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
+	{
+	  break;
+	}
+      else if (node->children != NULL)
+	{
+	  tree = node->children;
+	  node = tree->root;
+	}
+      else
+	/* RBTree corruption!  All bad */
+	g_assert_not_reached ();
+    }
+  while (TRUE);
+
+  *tree_out = tree;
+  *node_out = node;
+}
+
+/* Updates the scroll adjustments after rows changed size */
+static void
+update_validated_size (GtkTreeView *tree_view,
+                       gboolean     queue_resize)
+{
+  GtkRequisition requisition;
+
+  /* We temporarily guess a size, under the assumption that it will be the
+   * same when we get our next size_allocate.  If we don't do this, we'll be
+   * in an inconsistent state when we call top_row_to_dy. */
+
+  /* FIXME: This is called from size_request, for some reason it is not infinitely
+   * recursing, we cannot call gtk_widget_get_preferred_size() here because that's
+   * not allowed (from inside ->get_preferred_width/height() implementations, one
+   * should call the vfuncs directly). However what is desired here is the full
+   * size including any margins and limited by any alignment (i.e. after 
+   * GtkWidget:adjust_size_request() is called).
+   *
+   * Currently bypassing this but the real solution is to not update the scroll adjustments
+   * untill we've recieved an allocation (never update scroll adjustments from size-requests).
+   */
+  gtk_tree_view_size_request (GTK_WIDGET (tree_view), &requisition, FALSE);
+
+  gtk_adjustment_set_upper (tree_view->priv->hadjustment,
+                            MAX (gtk_adjustment_get_upper (tree_view->priv->hadjustment), requisition.width));
+  gtk_adjustment_set_upper (tree_view->priv->vadjustment,
+                            MAX (gtk_adjustment_get_upper (tree_view->priv->vadjustment), requisition.height));
+
+  if (queue_resize)
+    gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+}
+
 /* Our strategy for finding nodes to validate is a little convoluted.  We find
  * the left-most uninvalidated node.  We then try walking right, validating
  * nodes.  Once we find a valid node, we repeat the previous process of finding
@@ -6625,6 +6819,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
   gint prev_height = -1;
   gboolean fixed_height = TRUE;
+  gint sampled_height = 0;
 
   g_assert (tree_view);
 
@@ -6639,6 +6834,13 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
       return FALSE;
     }
 
+  /* Once we have an estimate, rows only get measured when
+   * they are shown, see validate_visible_area().
+   */
+  if (tree_view->priv->estimated_height_mode &&
+      tree_view->priv->estimated_height >= 0)
+    return FALSE;
+
   timer = g_timer_new ();
   g_timer_start (timer);
 
@@ -6667,38 +6869,7 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
       if (path == NULL)
 	{
-	  tree = tree_view->priv->tree;
-	  node = tree_view->priv->tree->root;
-
-	  g_assert (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_DESCENDANTS_INVALID));
-
-	  do
-	    {
-	      if (node->left != tree->nil &&
-		  GTK_RBNODE_FLAG_SET (node->left, GTK_RBNODE_DESCENDANTS_INVALID))
-		{
-		  node = node->left;
-		}
-	      else if (node->right != tree->nil &&
-		       GTK_RBNODE_FLAG_SET (node->right, GTK_RBNODE_DESCENDANTS_INVALID))
-		{
-		  node = node->right;
-		}
-	      else if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID) ||
-		       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
-		{
-		  break;
-		}
-	      else if (node->children != NULL)
-		{
-		  tree = node->children;
-		  node = tree->root;
-		}
-	      else
-		/* RBTree corruption!  All bad */
-		g_assert_not_reached ();
-	    }
-	  while (TRUE);
+	  find_first_invalid_node (tree_view, &tree, &node);
 	  path = _gtk_tree_view_find_path (tree_view, tree, node);
 	  gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
 	}
@@ -6706,6 +6877,9 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
       validated_area = validate_row (tree_view, tree, node, &iter, path) ||
                        validated_area;
 
+      if (tree_view->priv->estimated_height_mode)
+        sampled_height += gtk_tree_view_get_row_height (tree_view, node);
+
       if (!tree_view->priv->fixed_height_check)
         {
 	  gint height;
@@ -6719,7 +6893,8 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
       i++;
     }
-  while (g_timer_elapsed (timer, NULL) < GTK_TREE_VIEW_TIME_MS_PER_IDLE / 1000.);
+  while (g_timer_elapsed (timer, NULL) < GTK_TREE_VIEW_TIME_MS_PER_IDLE / 1000. &&
+         !(tree_view->priv->estimated_height_mode && i >= GTK_TREE_VIEW_N_ESTIMATE_SAMPLES));
 
   if (!tree_view->priv->fixed_height_check)
    {
@@ -6728,36 +6903,24 @@ do_validate_rows (GtkTreeView *tree_view, gboolean queue_resize)
 
      tree_view->priv->fixed_height_check = 1;
    }
-  
- done:
-  if (validated_area)
-    {
-      GtkRequisition requisition;
 
-      /* We temporarily guess a size, under the assumption that it will be the
-       * same when we get our next size_allocate.  If we don't do this, we'll be
-       * in an inconsistent state when we call top_row_to_dy. */
-
-      /* FIXME: This is called from size_request, for some reason it is not infinitely
-       * recursing, we cannot call gtk_widget_get_preferred_size() here because that's
-       * not allowed (from inside ->get_preferred_width/height() implementations, one
-       * should call the vfuncs directly). However what is desired here is the full
-       * size including any margins and limited by any alignment (i.e. after 
-       * GtkWidget:adjust_size_request() is called).
-       *
-       * Currently bypassing this but the real solution is to not update the scroll adjustments
-       * untill we've recieved an allocation (never update scroll adjustments from size-requests).
+  if (tree_view->priv->estimated_height_mode)
+    {
+      /* Give all rows we haven't measured the average height of
+       * the rows we have, they stay invalid so they will be
+       * measured once they become visible.
        */
-      gtk_tree_view_size_request (GTK_WIDGET (tree_view), &requisition, FALSE);
-
-      gtk_adjustment_set_upper (tree_view->priv->hadjustment,
-                                MAX (gtk_adjustment_get_upper (tree_view->priv->hadjustment), requisition.width));
-      gtk_adjustment_set_upper (tree_view->priv->vadjustment,
-                                MAX (gtk_adjustment_get_upper (tree_view->priv->vadjustment), requisition.height));
+      tree_view->priv->estimated_height = sampled_height / i;
+      _gtk_rbtree_set_fixed_height (tree_view->priv->tree,
+                                    tree_view->priv->estimated_height, FALSE);
 
-      if (queue_resize)
-        gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+      validated_area = TRUE;
+      retval = FALSE;
     }
+  
+ done:
+  if (validated_area)
+    update_validated_size (tree_view, queue_resize);
 
   if (path) gtk_tree_path_free (path);
   g_timer_destroy (timer);
@@ -6786,6 +6949,16 @@ validate_rows_handler (GtkTreeView *tree_view)
 {
   gboolean retval;
 
+  /* Hand the next rows to the worker threads, rows_measured()
+   * carries on once they are done.
+   */
+  if (tree_view->priv->measure != NULL ||
+      (tree_view->priv->threaded_validation && measure_rows (tree_view)))
+    {
+      tree_view->priv->validate_rows_timer = 0;
+      return FALSE;
+    }
+
   retval = do_validate_rows (tree_view, TRUE);
   if (! retval && tree_view->priv->validate_rows_timer)
     {
@@ -6796,6 +6969,387 @@ validate_rows_handler (GtkTreeView *tree_view)
   return retval;
 }
 
+static void
+measured_rows_free (GtkTreeView *tree_view)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+
+  if (priv->measured_rows)
+    {
+      g_array_free (priv->measured_rows, TRUE);
+      priv->measured_rows = NULL;
+    }
+
+  if (priv->measured_cells)
+    {
+      g_array_free (priv->measured_cells, TRUE);
+      priv->measured_cells = NULL;
+    }
+
+  if (priv->measured_nodes)
+    {
+      g_hash_table_destroy (priv->measured_nodes);
+      priv->measured_nodes = NULL;
+    }
+
+  priv->n_measured_columns = 0;
+}
+
+static gboolean
+measured_row_is_current (GtkTreeView *tree_view,
+                         guint        row)
+{
+  GtkTreeViewMeasuredRow *mr;
+
+  mr = &g_array_index (tree_view->priv->measured_rows, GtkTreeViewMeasuredRow, row);
+
+  return g_hash_table_lookup (tree_view->priv->measured_nodes, mr->node) != NULL;
+}
+
+/* Validates a row of the batch on the main thread */
+static gboolean
+validate_measured_row (GtkTreeView *tree_view,
+                       guint        row)
+{
+  GtkTreeViewMeasuredRow *mr;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  gboolean retval;
+
+  mr = &g_array_index (tree_view->priv->measured_rows, GtkTreeViewMeasuredRow, row);
+
+  path = _gtk_tree_view_find_path (tree_view, mr->tree, mr->node);
+  gtk_tree_model_get_iter (tree_view->priv->model, &iter, path);
+
+  retval = validate_row (tree_view, mr->tree, mr->node, &iter, path);
+
+  gtk_tree_path_free (path);
+
+  return retval;
+}
+
+static void
+rows_measured (GtkPangoMeasure *measure,
+               gpointer         data)
+{
+  GtkTreeView *tree_view = data;
+  GtkTreeViewPrivate *priv = tree_view->priv;
+  gboolean validated_area = FALSE;
+  gint focus_line_width;
+  gint *heights, *min_widths, *nat_widths;
+  guint *min_rows, *nat_rows;
+  guint n_items, n_columns, i;
+
+  priv->measure = NULL;
+
+  gtk_widget_style_get (GTK_WIDGET (tree_view),
+                        "focus-line-width", &focus_line_width,
+                        NULL);
+
+  n_columns = priv->n_measured_columns;
+  heights = g_new0 (gint, priv->measured_rows->len);
+  min_widths = g_new0 (gint, n_columns);
+  nat_widths = g_new0 (gint, n_columns);
+  min_rows = g_new0 (guint, n_columns);
+  nat_rows = g_new0 (guint, n_columns);
+
+  n_items = _gtk_pango_measure_get_n_items (measure);
+  for (i = 0; i < n_items; i++)
+    {
+      GtkTreeViewMeasuredCell *mc;
+      PangoRectangle rect;
+      gint min_width, nat_width, height;
+      guint index;
+
+      index = GPOINTER_TO_UINT (_gtk_pango_measure_get_item (measure, i, &rect));
+      mc = &g_array_index (priv->measured_cells, GtkTreeViewMeasuredCell, index);
+
+      if (!measured_row_is_current (tree_view, mc->row))
+        continue;
+
+      /* The widths gtk_cell_renderer_text_get_preferred_width() returns */
+      min_width = mc->xpad * 2 + rect.x + PANGO_PIXELS_CEIL (rect.width);
+      nat_width = MAX (mc->xpad * 2 + PANGO_PIXELS_CEIL (rect.width), min_width);
+
+      if (min_width > min_widths[mc->column])
+        {
+          min_widths[mc->column] = min_width;
+          min_rows[mc->column] = mc->row;
+        }
+      if (nat_width > nat_widths[mc->column])
+        {
+          nat_widths[mc->column] = nat_width;
+          nat_rows[mc->column] = mc->row;
+        }
+
+      /* The cells are at least as wide as their text, so their height
+       * is the unwrapped text height, plus the padding and the focus
+       * line gtk_cell_area_request_renderer() adds.
+       */
+      pango_extents_to_pixels (&rect, NULL);
+      height = rect.height + mc->ypad * 2 + focus_line_width * 2;
+
+      heights[mc->row] = MAX (heights[mc->row], height + priv->vertical_separator);
+    }
+
+  /* The requested widths of the columns are accumulated by their cell
+   * area contexts, measure the widest rows on the main thread to get
+   * them there.
+   */
+  for (i = 0; i < n_columns; i++)
+    {
+      if (measured_row_is_current (tree_view, min_rows[i]))
+        validated_area = validate_measured_row (tree_view, min_rows[i]) || validated_area;
+      if (measured_row_is_current (tree_view, nat_rows[i]))
+        validated_area = validate_measured_row (tree_view, nat_rows[i]) || validated_area;
+    }
+
+  for (i = 0; i < priv->measured_rows->len; i++)
+    {
+      GtkTreeViewMeasuredRow *mr;
+      gint height;
+
+      mr = &g_array_index (priv->measured_rows, GtkTreeViewMeasuredRow, i);
+
+      /* Changed, or validated on the main thread in the meantime */
+      if (!measured_row_is_current (tree_view, i) ||
+          ! GTK_RBNODE_FLAG_SET (mr->node, GTK_RBNODE_INVALID) ||
+          GTK_RBNODE_FLAG_SET (mr->node, GTK_RBNODE_COLUMN_INVALID))
+        continue;
+
+      height = MAX (heights[i], priv->expander_size);
+
+      if (priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_HORIZONTAL ||
+          priv->grid_lines == GTK_TREE_VIEW_GRID_LINES_BOTH)
+        height += priv->style_grid_line_width;
+
+      if (height != GTK_RBNODE_GET_HEIGHT (mr->node))
+        {
+          validated_area = TRUE;
+          _gtk_rbtree_node_set_height (mr->tree, mr->node, height);
+        }
+      _gtk_rbtree_node_mark_valid (mr->tree, mr->node);
+      priv->post_validation_flag = TRUE;
+    }
+
+  g_free (heights);
+  g_free (min_widths);
+  g_free (nat_widths);
+  g_free (min_rows);
+  g_free (nat_rows);
+
+  measured_rows_free (tree_view);
+
+  /* Start on the next rows right away, so that the resize queued
+   * below doesn't measure them on the main thread.
+   */
+  if (!priv->threaded_validation || !measure_rows (tree_view))
+    install_presize_handler (tree_view);
+
+  if (validated_area)
+    update_validated_size (tree_view, TRUE);
+}
+
+/* Returns the text cell renderer of @column if its rows can
+ * be measured in worker threads.
+ */
+static GtkCellRenderer *
+get_measured_cell (GtkTreeViewColumn *column)
+{
+  GtkCellArea *area;
+  GtkCellRenderer *cell = NULL;
+  GList *cells;
+
+  area = gtk_cell_layout_get_area (GTK_CELL_LAYOUT (column));
+  if (G_OBJECT_TYPE (area) != GTK_TYPE_CELL_AREA_BOX ||
+      gtk_orientable_get_orientation (GTK_ORIENTABLE (area)) != GTK_ORIENTATION_HORIZONTAL)
+    return NULL;
+
+  cells = gtk_cell_layout_get_cells (GTK_CELL_LAYOUT (column));
+  if (cells != NULL && cells->next == NULL &&
+      G_OBJECT_TYPE (cells->data) == GTK_TYPE_CELL_RENDERER_TEXT)
+    cell = cells->data;
+  g_list_free (cells);
+
+  return cell;
+}
+
+/* Hands the next invalid rows to the worker threads, as long as
+ * their height only depends on the text of plain text cells.
+ * Only the rows following the first invalid row on its level are
+ * considered, and we stop at the first row that can't be measured
+ * this way. The model is only accessed here, on the main thread.
+ *
+ * Returns FALSE if the next rows need to be validated on the main
+ * thread.
+ */
+static gboolean
+measure_rows (GtkTreeView *tree_view)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+  GtkWidget *widget = GTK_WIDGET (tree_view);
+  GtkPangoMeasure *measure;
+  GPtrArray *columns, *cells;
+  GtkTreeViewMeasuredCell *row_cells;
+  PangoLayout **layouts;
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GList *list;
+  guint i;
+
+  g_return_val_if_fail (priv->measure == NULL, FALSE);
+
+  if (priv->tree == NULL ||
+      ! GTK_RBNODE_FLAG_SET (priv->tree->root, GTK_RBNODE_DESCENDANTS_INVALID) ||
+      priv->mark_rows_col_dirty ||
+      priv->fixed_height_mode ||
+      priv->estimated_height_mode ||
+      priv->row_separator_func != NULL ||
+      !_gtk_pango_measure_supported (gtk_widget_get_pango_context (widget)))
+    return FALSE;
+
+  columns = g_ptr_array_new ();
+  cells = g_ptr_array_new ();
+
+  for (list = priv->columns; list; list = list->next)
+    {
+      GtkTreeViewColumn *column = list->data;
+      GtkCellRenderer *cell;
+
+      if (!gtk_tree_view_column_get_visible (column))
+        continue;
+
+      cell = get_measured_cell (column);
+      if (cell == NULL)
+        {
+          g_ptr_array_free (columns, TRUE);
+          g_ptr_array_free (cells, TRUE);
+          return FALSE;
+        }
+
+      g_ptr_array_add (columns, column);
+      g_ptr_array_add (cells, cell);
+    }
+
+  if (columns->len == 0)
+    {
+      g_ptr_array_free (columns, TRUE);
+      g_ptr_array_free (cells, TRUE);
+      return FALSE;
+    }
+
+  find_first_invalid_node (tree_view, &tree, &node);
+  path = _gtk_tree_view_find_path (tree_view, tree, node);
+  gtk_tree_model_get_iter (priv->model, &iter, path);
+  gtk_tree_path_free (path);
+
+  measure = _gtk_pango_measure_new (gtk_widget_get_pango_context (widget),
+                                    rows_measured, tree_view);
+  priv->measured_rows = g_array_new (FALSE, FALSE, sizeof (GtkTreeViewMeasuredRow));
+  priv->measured_cells = g_array_new (FALSE, FALSE, sizeof (GtkTreeViewMeasuredCell));
+  priv->measured_nodes = g_hash_table_new (NULL, NULL);
+  priv->n_measured_columns = columns->len;
+
+  row_cells = g_new (GtkTreeViewMeasuredCell, columns->len);
+  layouts = g_new (PangoLayout *, columns->len);
+
+  while (node != NULL &&
+         priv->measured_rows->len < GTK_TREE_VIEW_MEASURE_ROWS)
+    {
+      /* Only some columns of these need measuring, see validate_row() */
+      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_COLUMN_INVALID))
+        break;
+
+      if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_INVALID))
+        {
+          GtkTreeViewMeasuredRow mr;
+
+          for (i = 0; i < columns->len; i++)
+            {
+              GtkCellRenderer *cell = g_ptr_array_index (cells, i);
+
+              gtk_tree_view_column_cell_set_cell_data (g_ptr_array_index (columns, i),
+                                                       priv->model, &iter,
+                                                       GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT),
+                                                       node->children?TRUE:FALSE);
+
+              layouts[i] = _gtk_cell_renderer_text_get_size_layout (GTK_CELL_RENDERER_TEXT (cell),
+                                                                   widget);
+              if (layouts[i] == NULL)
+                break;
+
+              row_cells[i].row = priv->measured_rows->len;
+              row_cells[i].column = i;
+              gtk_cell_renderer_get_padding (cell, &row_cells[i].xpad, &row_cells[i].ypad);
+            }
+
+          if (i < columns->len)
+            {
+              while (i-- > 0)
+                g_object_unref (layouts[i]);
+              break;
+            }
+
+          mr.tree = tree;
+          mr.node = node;
+          g_array_append_val (priv->measured_rows, mr);
+          g_hash_table_insert (priv->measured_nodes, node, node);
+
+          for (i = 0; i < columns->len; i++)
+            {
+              g_array_append_val (priv->measured_cells, row_cells[i]);
+              _gtk_pango_measure_add (measure, layouts[i],
+                                      GUINT_TO_POINTER (priv->measured_cells->len - 1));
+              g_object_unref (layouts[i]);
+            }
+        }
+
+      /* Leave it to do_validate_rows() to complain if the
+       * model doesn't agree with the tree.
+       */
+      node = _gtk_rbtree_next (tree, node);
+      if (node != NULL && !gtk_tree_model_iter_next (priv->model, &iter))
+        break;
+    }
+
+  g_free (row_cells);
+  g_free (layouts);
+  g_ptr_array_free (columns, TRUE);
+  g_ptr_array_free (cells, TRUE);
+
+  if (priv->measured_rows->len == 0)
+    {
+      _gtk_pango_measure_cancel (measure);
+      measured_rows_free (tree_view);
+      return FALSE;
+    }
+
+  priv->measure = measure;
+  _gtk_pango_measure_start (measure);
+
+  return TRUE;
+}
+
+/* Drops the rows being measured in worker threads, they
+ * are validated again later.
+ */
+static void
+cancel_measure_rows (GtkTreeView *tree_view)
+{
+  GtkTreeViewPrivate *priv = tree_view->priv;
+
+  if (priv->measure == NULL)
+    return;
+
+  _gtk_pango_measure_cancel (priv->measure);
+  priv->measure = NULL;
+  measured_rows_free (tree_view);
+
+  install_presize_handler (tree_view);
+}
+
 static gboolean
 do_presize_handler (GtkTreeView *tree_view)
 {
@@ -7011,6 +7565,8 @@ _gtk_tree_view_install_mark_rows_col_dirty (GtkTreeView *tree_view,
 {
   tree_view->priv->mark_rows_col_dirty = TRUE;
 
+  cancel_measure_rows (tree_view);
+
   if (install_handler)
     install_presize_handler (tree_view);
 }
@@ -8183,6 +8739,8 @@ gtk_tree_view_set_fixed_height_mode (GtkTreeView *tree_view,
       
       tree_view->priv->fixed_height_mode = 1;
       tree_view->priv->fixed_height = -1;
+
+      cancel_measure_rows (tree_view);
       
       if (tree_view->priv->tree)
 	initialize_fixed_height_mode (tree_view);
@@ -8207,6 +8765,136 @@ gtk_tree_view_get_fixed_height_mode (GtkTreeView *tree_view)
   return tree_view->priv->fixed_height_mode;
 }
 
+/**
+ * gtk_tree_view_set_estimated_height_mode:
+ * @tree_view: a #GtkTreeView
+ * @enable: %TRUE to enable estimated height mode
+ *
+ * Enables or disables the estimated height mode of @tree_view.
+ *
+ * Normally, #GtkTreeView measures every row of the model in the
+ * background to find out the total height of the view. In estimated
+ * height mode, only a sample of rows is measured, and rows that
+ * haven't been measured are assumed to have the average height of
+ * the sample. Rows are measured exactly when they are scrolled into
+ * view, keeping the top visible row in place when the estimate
+ * turns out to be wrong.
+ *
+ * Unlike fixed height mode, this works with rows of differing
+ * heights, but the scrollbar is only accurate once all rows have
+ * been shown. Columns that are not of type
+ * %GTK_TREE_VIEW_COLUMN_FIXED only take the rows that have been
+ * measured into account for their width. If fixed height mode is
+ * enabled as well, it takes precedence.
+ *
+ * Since: 3.2
+ **/
+void
+gtk_tree_view_set_estimated_height_mode (GtkTreeView *tree_view,
+                                         gboolean     enable)
+{
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  enable = enable != FALSE;
+
+  if (enable == tree_view->priv->estimated_height_mode)
+    return;
+
+  tree_view->priv->estimated_height_mode = enable;
+  tree_view->priv->estimated_height = -1;
+
+  cancel_measure_rows (tree_view);
+
+  /* either measure a new sample, or go back to validating all rows */
+  install_presize_handler (tree_view);
+
+  g_object_notify (G_OBJECT (tree_view), "estimated-height-mode");
+}
+
+/**
+ * gtk_tree_view_get_estimated_height_mode:
+ * @tree_view: a #GtkTreeView
+ *
+ * Returns whether estimated height mode is turned on for @tree_view.
+ *
+ * Return value: %TRUE if @tree_view is in estimated height mode
+ *
+ * Since: 3.2
+ **/
+gboolean
+gtk_tree_view_get_estimated_height_mode (GtkTreeView *tree_view)
+{
+  g_return_val_if_fail (GTK_IS_TREE_VIEW (tree_view), FALSE);
+
+  return tree_view->priv->estimated_height_mode;
+}
+
+/**
+ * gtk_tree_view_set_threaded_validation:
+ * @tree_view: a #GtkTreeView
+ * @threaded: %TRUE to measure rows in worker threads
+ *
+ * Sets whether @tree_view measures its rows in worker threads.
+ *
+ * Normally, #GtkTreeView measures every row of the model in the
+ * background on the main thread to find out the total height of
+ * the view, which takes a while for big models. With threaded
+ * validation, the text of the rows is fetched from the model on
+ * the main thread and laid out by a pool of worker threads, each
+ * using its own Pango font map. The main thread only stores the
+ * resulting row heights, and fully measures the widest rows of
+ * each batch so that the columns get the right width.
+ *
+ * This is only done for rows whose visible columns each show a
+ * single #GtkCellRendererText that does not wrap or ellipsize
+ * its text and has no fixed size. Other rows, and all rows in
+ * fixed height mode, estimated height mode or with a row
+ * separator function, are still measured on the main thread.
+ * Threaded validation is not used if the #PangoContext of
+ * @tree_view does not use the default Pango font map.
+ *
+ * Since: 3.2
+ **/
+void
+gtk_tree_view_set_threaded_validation (GtkTreeView *tree_view,
+                                       gboolean     threaded)
+{
+  g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
+
+  threaded = threaded != FALSE;
+
+  if (threaded == tree_view->priv->threaded_validation)
+    return;
+
+  tree_view->priv->threaded_validation = threaded;
+
+  if (!threaded)
+    cancel_measure_rows (tree_view);
+  else
+    install_presize_handler (tree_view);
+
+  g_object_notify (G_OBJECT (tree_view), "threaded-validation");
+}
+
+/**
+ * gtk_tree_view_get_threaded_validation:
+ * @tree_view: a #GtkTreeView
+ *
+ * Gets the value of the #GtkTreeView:threaded-validation property.
+ *
+ * Return value: %TRUE if rows of @tree_view are measured in
+ *     worker threads
+ *
+ * Since: 3.2
+ **/
+gboolean
+gtk_tree_view_get_threaded_validation (GtkTreeView *tree_view)
+{
+  g_return_val_if_fail (GTK_IS_TREE_VIEW (tree_view), FALSE);
+
+  return tree_view->priv->threaded_validation;
+}
+
 /* Returns TRUE if the focus is within the headers, after the focus operation is
  * done
  */
@@ -8488,6 +9176,7 @@ gtk_tree_view_style_updated (GtkWidget *widget)
   GtkTreeView *tree_view = GTK_TREE_VIEW (widget);
   GList *list;
   GtkTreeViewColumn *column;
+  gboolean wide_separators;
 
   GTK_WIDGET_CLASS (gtk_tree_view_parent_class)->style_updated (widget);
 
@@ -8510,8 +9199,17 @@ gtk_tree_view_style_updated (GtkWidget *widget)
 
   gtk_widget_style_get (widget,
 			"expander-size", &tree_view->priv->expander_size,
+			"focus-padding", &tree_view->priv->focus_pad,
+			"horizontal-separator", &tree_view->priv->horizontal_separator,
+			"vertical-separator", &tree_view->priv->vertical_separator,
+			"grid-line-width", &tree_view->priv->style_grid_line_width,
+                        "wide-separators",  &wide_separators,
+                        "separator-height", &tree_view->priv->separator_height,
 			NULL);
   tree_view->priv->expander_size += EXPANDER_EXTRA_PADDING;
+  tree_view->priv->wide_separators = wide_separators != FALSE;
+
+  cancel_measure_rows (tree_view);
 
   for (list = tree_view->priv->columns; list; list = list->next)
     {
@@ -8520,6 +9218,7 @@ gtk_tree_view_style_updated (GtkWidget *widget)
     }
 
   tree_view->priv->fixed_height = -1;
+  tree_view->priv->estimated_height = -1;
   _gtk_rbtree_mark_invalid (tree_view->priv->tree);
 
   gtk_widget_queue_resize (widget);
@@ -8775,6 +9474,9 @@ gtk_tree_view_row_changed (GtkTreeModel *model,
     }
   else
     {
+      if (tree_view->priv->measured_nodes)
+        g_hash_table_remove (tree_view->priv->measured_nodes, node);
+
       _gtk_rbtree_node_mark_invalid (tree, node);
       for (list = tree_view->priv->columns; list; list = list->next)
         {
@@ -8812,6 +9514,7 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
   gint depth;
   gint i = 0;
   gint height;
+  gint initial_height;
   gboolean free_path = FALSE;
   gboolean node_visible = TRUE;
 
@@ -8823,6 +9526,11 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
   else
     height = 0;
 
+  /* Unmeasured rows start out with the estimated height, if any */
+  initial_height = height;
+  if (initial_height == 0 && tree_view->priv->estimated_height_mode)
+    initial_height = MAX (tree_view->priv->estimated_height, 0);
+
   if (path == NULL)
     {
       path = gtk_tree_model_get_path (model, iter);
@@ -8889,12 +9597,12 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
   if (indices[depth - 1] == 0)
     {
       tmpnode = _gtk_rbtree_find_count (tree, 1);
-      tmpnode = _gtk_rbtree_insert_before (tree, tmpnode, height, FALSE);
+      tmpnode = _gtk_rbtree_insert_before (tree, tmpnode, initial_height, FALSE);
     }
   else
     {
       tmpnode = _gtk_rbtree_find_count (tree, indices[depth - 1]);
-      tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, height, FALSE);
+      tmpnode = _gtk_rbtree_insert_after (tree, tmpnode, initial_height, FALSE);
     }
 
  done:
@@ -8914,6 +9622,83 @@ gtk_tree_view_row_inserted (GtkTreeModel *model,
     gtk_tree_path_free (path);
 }
 
+/* Called instead of gtk_tree_view_row_inserted() when the model
+ * inserted @n_rows rows at @position at the top level, and nobody
+ * else needed to see them one by one.
+ */
+static void
+gtk_tree_view_rows_inserted (GtkTreeModel *model,
+                             gint          position,
+                             gint          n_rows,
+                             gpointer      data)
+{
+  GtkTreeView *tree_view = (GtkTreeView *) data;
+  GtkTreePath *path;
+  GtkTreeIter iter;
+  GtkRBTree *tree;
+  GtkRBNode *node;
+  gint height;
+  gint initial_height;
+  gint i;
+
+  if (tree_view->priv->fixed_height_mode
+      && tree_view->priv->fixed_height >= 0)
+    height = tree_view->priv->fixed_height;
+  else
+    height = 0;
+
+  initial_height = height;
+  if (initial_height == 0 && tree_view->priv->estimated_height_mode)
+    initial_height = MAX (tree_view->priv->estimated_height, 0);
+
+  path = gtk_tree_path_new_from_indices (position, -1);
+  if (!gtk_tree_model_get_iter (model, &iter, path))
+    {
+      gtk_tree_path_free (path);
+      return;
+    }
+
+  if (tree_view->priv->tree == NULL)
+    tree_view->priv->tree = _gtk_rbtree_new ();
+
+  tree = tree_view->priv->tree;
+
+  /* Each row goes after the previous one, so only the
+   * first one needs to be looked up.
+   */
+  if (position == 0)
+    node = NULL;
+  else
+    node = _gtk_rbtree_find_count (tree, position);
+
+  for (i = 0; i < n_rows; i++)
+    {
+      /* Update all row-references */
+      gtk_tree_row_reference_inserted (G_OBJECT (data), path);
+
+      gtk_tree_model_ref_node (tree_view->priv->model, &iter);
+
+      if (node == NULL)
+        node = _gtk_rbtree_insert_before (tree, _gtk_rbtree_find_count (tree, 1),
+                                          initial_height, FALSE);
+      else
+        node = _gtk_rbtree_insert_after (tree, node, initial_height, FALSE);
+
+      if (height > 0)
+        _gtk_rbtree_node_mark_valid (tree, node);
+
+      gtk_tree_path_next (path);
+      gtk_tree_model_iter_next (model, &iter);
+    }
+
+  gtk_tree_path_free (path);
+
+  if (height > 0)
+    gtk_widget_queue_resize (GTK_WIDGET (tree_view));
+  else
+    install_presize_handler (tree_view);
+}
+
 static void
 gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
 				     GtkTreePath  *path,
@@ -8956,6 +9741,9 @@ gtk_tree_view_row_has_child_toggled (GtkTreeModel *model,
   if (GTK_RBNODE_FLAG_SET (node, GTK_RBNODE_IS_PARENT) == has_child)
     goto done;
 
+  if (tree_view->priv->measured_nodes)
+    g_hash_table_remove (tree_view->priv->measured_nodes, node);
+
   if (has_child)
     GTK_RBNODE_SET_FLAG (node, GTK_RBNODE_IS_PARENT);
   else
@@ -9032,6 +9820,9 @@ gtk_tree_view_row_deleted (GtkTreeModel *model,
   if (tree == NULL)
     return;
 
+  /* Removing the node can move other rows to different nodes */
+  cancel_measure_rows (tree_view);
+
   /* check if the selection has been changed */
   _gtk_rbtree_traverse (tree, node, G_POST_ORDER,
                         check_selection_helper, &selection_changed);
@@ -9113,6 +9904,8 @@ gtk_tree_view_rows_reordered (GtkTreeModel *model,
 				&node))
     return;
 
+  cancel_measure_rows (tree_view);
+
   /* We need to special case the parent path */
   if (tree == NULL)
     tree = tree_view->priv->tree;
@@ -9258,20 +10051,34 @@ gtk_tree_view_build_tree (GtkTreeView *tree_view,
 {
   GtkRBNode *temp = NULL;
   GtkTreePath *path = NULL;
+  GtkTreeIter parent;
+  gint n_nodes;
+  gint height = 0;
+  gboolean valid = FALSE;
+
+  if (tree_view->priv->fixed_height > 0)
+    {
+      height = tree_view->priv->fixed_height;
+      valid = TRUE;
+    }
+  else if (tree_view->priv->estimated_height_mode)
+    height = MAX (tree_view->priv->estimated_height, 0);
+
+  /* @tree is empty, so we can create the nodes for all rows
+   * of this level at once, instead of inserting them one by one
+   */
+  if (gtk_tree_model_iter_parent (tree_view->priv->model, &parent, iter))
+    n_nodes = gtk_tree_model_iter_n_children (tree_view->priv->model, &parent);
+  else
+    n_nodes = gtk_tree_model_iter_n_children (tree_view->priv->model, NULL);
+
+  temp = _gtk_rbtree_build (tree, n_nodes, height, valid);
+  if (temp == NULL)
+    return;
 
   do
     {
       gtk_tree_model_ref_node (tree_view->priv->model, iter);
-      temp = _gtk_rbtree_insert_after (tree, temp, 0, FALSE);
-
-      if (tree_view->priv->fixed_height > 0)
-        {
-          if (GTK_RBNODE_FLAG_SET (temp, GTK_RBNODE_INVALID))
-	    {
-              _gtk_rbtree_node_set_height (tree, temp, tree_view->priv->fixed_height);
-	      _gtk_rbtree_node_mark_valid (tree, temp);
-	    }
-        }
 
       if (tree_view->priv->is_list)
         continue;
@@ -9308,7 +10115,8 @@ gtk_tree_view_build_tree (GtkTreeView *tree_view,
 	    temp->flags ^= GTK_RBNODE_IS_PARENT;
 	}
     }
-  while (gtk_tree_model_iter_next (tree_view->priv->model, iter));
+  while ((temp = _gtk_rbtree_next (tree, temp)) != NULL &&
+         gtk_tree_model_iter_next (tree_view->priv->model, iter));
 
   if (path)
     gtk_tree_path_free (path);
@@ -11270,7 +12078,17 @@ gtk_tree_view_adjustment_changed (GtkAdjustment *adjustment,
           tree_view->priv->dy = (int) gtk_adjustment_get_value (tree_view->priv->vadjustment);
 
           if (!tree_view->priv->in_top_row_to_dy)
-            gtk_tree_view_dy_to_top_row (tree_view);
+            {
+              gtk_tree_view_dy_to_top_row (tree_view);
+
+              /* Rows scrolled into view may only have an estimated
+               * height, measure them before they are drawn.
+               */
+              if (tree_view->priv->estimated_height_mode &&
+                  tree_view->priv->tree &&
+                  GTK_RBNODE_FLAG_SET (tree_view->priv->tree->root, GTK_RBNODE_DESCENDANTS_INVALID))
+                install_presize_handler (tree_view);
+            }
 	}
 
       gdk_window_process_updates (tree_view->priv->header_window, TRUE);
@@ -11369,6 +12187,8 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_changed,
 					    tree_view);
+      _gtk_tree_model_remove_rows_inserted_handler (tree_view->priv->model,
+                                                    tree_view);
       g_signal_handlers_disconnect_by_func (tree_view->priv->model,
 					    gtk_tree_view_row_inserted,
 					    tree_view);
@@ -11407,6 +12227,7 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       tree_view->priv->search_column = -1;
       tree_view->priv->fixed_height_check = 0;
       tree_view->priv->fixed_height = -1;
+      tree_view->priv->estimated_height = -1;
       tree_view->priv->dy = tree_view->priv->top_row_dy = 0;
       tree_view->priv->last_button_x = -1;
       tree_view->priv->last_button_y = -1;
@@ -11420,6 +12241,7 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
       GtkTreePath *path;
       GtkTreeIter iter;
       GtkTreeModelFlags flags;
+      gulong handler_id;
 
       if (tree_view->priv->search_column == -1)
 	{
@@ -11440,10 +12262,14 @@ gtk_tree_view_set_model (GtkTreeView  *tree_view,
 			"row-changed",
 			G_CALLBACK (gtk_tree_view_row_changed),
 			tree_view);
-      g_signal_connect (tree_view->priv->model,
-			"row-inserted",
-			G_CALLBACK (gtk_tree_view_row_inserted),
-			tree_view);
+      handler_id = g_signal_connect (tree_view->priv->model,
+                                     "row-inserted",
+                                     G_CALLBACK (gtk_tree_view_row_inserted),
+                                     tree_view);
+      _gtk_tree_model_add_rows_inserted_handler (tree_view->priv->model,
+                                                 handler_id,
+                                                 gtk_tree_view_rows_inserted,
+                                                 tree_view);
       g_signal_connect (tree_view->priv->model,
 			"row-has-child-toggled",
 			G_CALLBACK (gtk_tree_view_row_has_child_toggled),
@@ -11918,6 +12744,8 @@ gtk_tree_view_remove_column (GtkTreeView       *tree_view,
   if (tree_view->priv->expander_column == column)
     tree_view->priv->expander_column = NULL;
 
+  cancel_measure_rows (tree_view);
+
   g_signal_handlers_disconnect_by_func (column,
                                         G_CALLBACK (column_sizing_notify),
                                         tree_view);
@@ -11984,6 +12812,8 @@ gtk_tree_view_insert_column (GtkTreeView       *tree_view,
 
   g_object_ref_sink (column);
 
+  cancel_measure_rows (tree_view);
+
   if (tree_view->priv->n_columns == 0 &&
       gtk_widget_get_realized (GTK_WIDGET (tree_view)) &&
       gtk_tree_view_get_headers_visible (tree_view))
@@ -12698,6 +13528,10 @@ gtk_tree_view_real_expand_row (GtkTreeView *tree_view,
   if (expand)
     return FALSE;
 
+  /* The row is measured as an expanded row from now on */
+  if (tree_view->priv->measured_nodes)
+    g_hash_table_remove (tree_view->priv->measured_nodes, node);
+
   node->children = _gtk_rbtree_new ();
   node->children->parent_tree = tree;
   node->children->parent_node = node;
@@ -12880,6 +13714,8 @@ gtk_tree_view_real_collapse_row (GtkTreeView *tree_view,
   tree_view->priv->last_button_x = -1;
   tree_view->priv->last_button_y = -1;
 
+  cancel_measure_rows (tree_view);
+
   if (gtk_tree_view_unref_and_check_selection_tree (tree_view, node->children))
     {
       _gtk_rbtree_remove (node->children);
@@ -15817,6 +16653,8 @@ gtk_tree_view_set_row_separator_func (GtkTreeView                 *tree_view,
 {
   g_return_if_fail (GTK_IS_TREE_VIEW (tree_view));
 
+  cancel_measure_rows (tree_view);
+
   if (tree_view->priv->row_separator_destroy)
     tree_view->priv->row_separator_destroy (tree_view->priv->row_separator_data);
 
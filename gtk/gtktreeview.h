@@ -441,6 +441,12 @@ void gtk_tree_view_set_destroy_count_func (GtkTreeView             *tree_view,
 void     gtk_tree_view_set_fixed_height_mode (GtkTreeView          *tree_view,
 					      gboolean              enable);
 gboolean gtk_tree_view_get_fixed_height_mode (GtkTreeView          *tree_view);
+void     gtk_tree_view_set_estimated_height_mode (GtkTreeView      *tree_view,
+                                                  gboolean          enable);
+gboolean gtk_tree_view_get_estimated_height_mode (GtkTreeView      *tree_view);
+void     gtk_tree_view_set_threaded_validation (GtkTreeView        *tree_view,
+                                                gboolean            threaded);
+gboolean gtk_tree_view_get_threaded_validation (GtkTreeView        *tree_view);
 void     gtk_tree_view_set_hover_selection   (GtkTreeView          *tree_view,
 					      gboolean              hover);
 gboolean gtk_tree_view_get_hover_selection   (GtkTreeView          *tree_view);
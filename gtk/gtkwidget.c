@@ -61,6 +61,7 @@
 #include "gtkcssprovider.h"
 #include "gtkanimationdescription.h"
 #include "gtkmodifierstyle.h"
+#include "gtktimeline.h"
 #include "gtkversion.h"
 #include "gtkdebug.h"
 #include "gtkplug.h"
@@ -4154,6 +4155,9 @@ gtk_widget_map (GtkWidget *widget)
       if (!gtk_widget_get_has_window (widget))
         gdk_window_invalidate_rect (priv->window, &priv->allocation, FALSE);
 
+      /* Animations frozen while the window was hidden can go on */
+      _gtk_timeline_window_mapped (priv->window);
+
       gtk_widget_pop_verify_invariants (widget);
 
       _gtk_widget_start_state_transitions (widget);
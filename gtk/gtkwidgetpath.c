@@ -23,6 +23,7 @@
 
 #include "gtkwidget.h"
 #include "gtkwidgetpath.h"
+#include "gtkwidgetpathprivate.h"
 #include "gtkstylecontextprivate.h"
 
 /**
@@ -1046,3 +1047,145 @@ gtk_widget_path_has_parent (const GtkWidgetPath *path,
 
   return FALSE;
 }
+
+static guint
+path_element_hash (const GtkPathElement *elem)
+{
+  guint i, hash;
+
+  hash = (guint) elem->type;
+  hash = (hash << 5) - hash + elem->name;
+
+  if (elem->classes)
+    {
+      for (i = 0; i < elem->classes->len; i++)
+        hash = (hash << 5) - hash + g_array_index (elem->classes, GQuark, i);
+    }
+
+  if (elem->regions)
+    {
+      GHashTableIter iter;
+      gpointer key, value;
+      guint regions_hash = 0;
+
+      /* Regions are unordered, so combine them
+       * in a way that doesn't depend on order
+       */
+      g_hash_table_iter_init (&iter, elem->regions);
+
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        regions_hash += GPOINTER_TO_UINT (key) ^ (GPOINTER_TO_UINT (value) << 16);
+
+      hash = (hash << 5) - hash + regions_hash;
+    }
+
+  return hash;
+}
+
+static gboolean
+path_element_equal (const GtkPathElement *elem1,
+                    const GtkPathElement *elem2)
+{
+  guint n_classes1, n_classes2;
+  guint n_regions1, n_regions2;
+
+  if (elem1->type != elem2->type ||
+      elem1->name != elem2->name)
+    return FALSE;
+
+  n_classes1 = (elem1->classes) ? elem1->classes->len : 0;
+  n_classes2 = (elem2->classes) ? elem2->classes->len : 0;
+
+  if (n_classes1 != n_classes2)
+    return FALSE;
+
+  /* Classes are kept sorted */
+  if (n_classes1 > 0 &&
+      memcmp (elem1->classes->data, elem2->classes->data,
+              n_classes1 * sizeof (GQuark)) != 0)
+    return FALSE;
+
+  n_regions1 = (elem1->regions) ? g_hash_table_size (elem1->regions) : 0;
+  n_regions2 = (elem2->regions) ? g_hash_table_size (elem2->regions) : 0;
+
+  if (n_regions1 != n_regions2)
+    return FALSE;
+
+  if (n_regions1 > 0)
+    {
+      GHashTableIter iter;
+      gpointer key, value, value2;
+
+      g_hash_table_iter_init (&iter, elem1->regions);
+
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          if (!g_hash_table_lookup_extended (elem2->regions, key, NULL, &value2) ||
+              value != value2)
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/*
+ * _gtk_widget_path_hash:
+ * @path: a #GtkWidgetPath
+ *
+ * Converts @path to a hash value, taking into account every
+ * element's type, name, classes and regions. Suitable for
+ * use as a #GHashFunc together with _gtk_widget_path_equal().
+ *
+ * Returns: a hash value for @path
+ */
+guint
+_gtk_widget_path_hash (gconstpointer path)
+{
+  const GtkWidgetPath *widget_path = path;
+  guint i, hash = 0;
+
+  for (i = 0; i < widget_path->elems->len; i++)
+    {
+      GtkPathElement *elem;
+
+      elem = &g_array_index (widget_path->elems, GtkPathElement, i);
+      hash = (hash << 5) - hash + path_element_hash (elem);
+    }
+
+  return hash;
+}
+
+/*
+ * _gtk_widget_path_equal:
+ * @path1: a #GtkWidgetPath
+ * @path2: another #GtkWidgetPath
+ *
+ * Returns %TRUE if both paths describe the same widget
+ * hierarchy, so they are bound to get the same style.
+ *
+ * Returns: whether @path1 and @path2 are equal
+ */
+gboolean
+_gtk_widget_path_equal (gconstpointer path1,
+                        gconstpointer path2)
+{
+  const GtkWidgetPath *widget_path1 = path1;
+  const GtkWidgetPath *widget_path2 = path2;
+  guint i;
+
+  if (widget_path1 == widget_path2)
+    return TRUE;
+
+  if (widget_path1->elems->len != widget_path2->elems->len)
+    return FALSE;
+
+  for (i = 0; i < widget_path1->elems->len; i++)
+    {
+      if (!path_element_equal (&g_array_index (widget_path1->elems, GtkPathElement, i),
+                               &g_array_index (widget_path2->elems, GtkPathElement, i)))
+        return FALSE;
+    }
+
+  return TRUE;
+}
@@ -0,0 +1,187 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2011 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <gtk/gtk.h>
+
+static const gchar *names[] = {
+  "Alice", "alfred", "Albert", "\xc3\x85sa", "Bob", "bobby", "Carol", "Dave"
+};
+
+static GtkTreeModel *
+find_filter_model (GtkWidget    *widget,
+                   GtkTreeModel *model)
+{
+  GtkTreeModel *filter_model = NULL;
+  GList *children, *l;
+
+  if (GTK_IS_TREE_VIEW (widget))
+    {
+      filter_model = gtk_tree_view_get_model (GTK_TREE_VIEW (widget));
+      if (GTK_IS_TREE_MODEL_FILTER (filter_model) &&
+          gtk_tree_model_filter_get_model (GTK_TREE_MODEL_FILTER (filter_model)) == model)
+        return filter_model;
+
+      return NULL;
+    }
+
+  if (!GTK_IS_CONTAINER (widget))
+    return NULL;
+
+  children = gtk_container_get_children (GTK_CONTAINER (widget));
+  for (l = children; l && filter_model == NULL; l = l->next)
+    filter_model = find_filter_model (l->data, model);
+  g_list_free (children);
+
+  return filter_model;
+}
+
+/* Returns the model showing the matches, from the popup of the completion */
+static GtkTreeModel *
+get_filter_model (GtkEntryCompletion *completion)
+{
+  GtkTreeModel *model, *filter_model = NULL;
+  GList *toplevels, *l;
+
+  model = gtk_entry_completion_get_model (completion);
+  toplevels = gtk_window_list_toplevels ();
+  for (l = toplevels; l && filter_model == NULL; l = l->next)
+    filter_model = find_filter_model (l->data, model);
+  g_list_free (toplevels);
+
+  g_assert (filter_model != NULL);
+
+  return filter_model;
+}
+
+static gint
+count_matches (GtkEntryCompletion *completion,
+               const gchar        *text)
+{
+  gtk_entry_set_text (GTK_ENTRY (gtk_entry_completion_get_entry (completion)), text);
+  gtk_entry_completion_complete (completion);
+
+  return gtk_tree_model_iter_n_children (get_filter_model (completion), NULL);
+}
+
+static GtkEntryCompletion *
+create_completion (GtkTreeModel *model)
+{
+  GtkEntryCompletion *completion;
+  GtkWidget *entry;
+
+  entry = gtk_entry_new ();
+  g_object_ref_sink (entry);
+
+  completion = gtk_entry_completion_new ();
+  gtk_entry_completion_set_model (completion, model);
+  gtk_entry_completion_set_text_column (completion, 0);
+  gtk_entry_set_completion (GTK_ENTRY (entry), completion);
+  g_object_unref (completion);
+
+  return completion;
+}
+
+static void
+destroy_completion (GtkEntryCompletion *completion)
+{
+  GtkWidget *entry = gtk_entry_completion_get_entry (completion);
+
+  gtk_widget_destroy (entry);
+  g_object_unref (entry);
+}
+
+static void
+test_match (void)
+{
+  GtkEntryCompletion *completion;
+  GtkListStore *store;
+  GtkTreeIter iter;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, names[i], -1);
+  /* Rows without text never match */
+  gtk_list_store_append (store, &iter);
+
+  completion = create_completion (GTK_TREE_MODEL (store));
+
+  g_assert_cmpint (count_matches (completion, "a"), ==, 3);
+  g_assert_cmpint (count_matches (completion, "al"), ==, 3);
+  g_assert_cmpint (count_matches (completion, "ALB"), ==, 1);
+  g_assert_cmpint (count_matches (completion, "alx"), ==, 0);
+  g_assert_cmpint (count_matches (completion, "b"), ==, 2);
+  g_assert_cmpint (count_matches (completion, "bobb"), ==, 1);
+  g_assert_cmpint (count_matches (completion, "\xc3\xa5"), ==, 1);
+  g_assert_cmpint (count_matches (completion, "a\xcc\x8a"), ==, 1);
+  g_assert_cmpint (count_matches (completion, "z"), ==, 0);
+
+  destroy_completion (completion);
+  g_object_unref (store);
+}
+
+static void
+test_model_changes (void)
+{
+  GtkEntryCompletion *completion;
+  GtkListStore *store;
+  GtkTreeIter iter, bob;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < G_N_ELEMENTS (names); i++)
+    gtk_list_store_insert_with_values (store, NULL, -1, 0, names[i], -1);
+
+  completion = create_completion (GTK_TREE_MODEL (store));
+
+  g_assert_cmpint (count_matches (completion, "b"), ==, 2);
+
+  /* Rows added while a key is active show up right away */
+  gtk_list_store_append (store, &iter);
+  gtk_list_store_set (store, &iter, 0, "Bert", -1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (get_filter_model (completion), NULL), ==, 3);
+  g_assert_cmpint (count_matches (completion, "be"), ==, 1);
+
+  /* ... as do changed rows */
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &bob, NULL, 4));
+  gtk_list_store_set (store, &bob, 0, "Beatrice", -1);
+  g_assert_cmpint (gtk_tree_model_iter_n_children (get_filter_model (completion), NULL), ==, 2);
+  g_assert_cmpint (count_matches (completion, "bob"), ==, 1);
+  g_assert_cmpint (count_matches (completion, "bea"), ==, 1);
+
+  gtk_list_store_remove (store, &bob);
+  g_assert_cmpint (count_matches (completion, "b"), ==, 2);
+  g_assert_cmpint (count_matches (completion, "bea"), ==, 0);
+
+  destroy_completion (completion);
+  g_object_unref (store);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/entry-completion/match", test_match);
+  g_test_add_func ("/entry-completion/model-changes", test_model_changes);
+
+  return g_test_run ();
+}
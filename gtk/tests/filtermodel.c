@@ -904,6 +904,47 @@ filled_hide_root_level (FilterTest    *fixture,
   check_filter_model (fixture);
 }
 
+static void
+filled_refilter_visibility (FilterTest    *fixture,
+                            gconstpointer  user_data)
+{
+  /* Change the visibility without notifying the filter model, so that
+   * all changes are picked up by a single refilter.
+   */
+  filter_test_block_signals (fixture);
+  set_path_visibility (fixture, "1", FALSE);
+  set_path_visibility (fixture, "3", FALSE);
+  set_path_visibility (fixture, "0:2", FALSE);
+  filter_test_unblock_signals (fixture);
+
+  /* Only the rows that got hidden are announced, no ::row-changed
+   * is emitted for the rows that stay visible.
+   */
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "0:2");
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "1");
+  signal_monitor_append_signal (fixture->monitor, ROW_DELETED, "2");
+  gtk_tree_model_filter_refilter_visibility (fixture->filter);
+
+  check_filter_model (fixture);
+  check_level_length (fixture->filter, NULL, LEVEL_LENGTH - 2);
+  check_level_length (fixture->filter, "0", LEVEL_LENGTH - 1);
+
+  /* Nothing changed, so nothing should be emitted */
+  gtk_tree_model_filter_refilter_visibility (fixture->filter);
+  signal_monitor_assert_is_empty (fixture->monitor);
+
+  filter_test_block_signals (fixture);
+  set_path_visibility (fixture, "1", TRUE);
+  filter_test_unblock_signals (fixture);
+
+  signal_monitor_append_signal (fixture->monitor, ROW_INSERTED, "1");
+  signal_monitor_append_signal (fixture->monitor, ROW_HAS_CHILD_TOGGLED, "1");
+  gtk_tree_model_filter_refilter_visibility (fixture->filter);
+
+  check_filter_model (fixture);
+  check_level_length (fixture->filter, NULL, LEVEL_LENGTH - 1);
+}
+
 static void
 filled_hide_child_levels (FilterTest    *fixture,
                           gconstpointer  user_data)
@@ -2857,6 +2898,11 @@ main (int    argc,
               filter_test_setup,
               filled_hide_child_levels,
               filter_test_teardown);
+  g_test_add ("/FilterModel/filled/refilter-visibility",
+              FilterTest, NULL,
+              filter_test_setup,
+              filled_refilter_visibility,
+              filter_test_teardown);
 
   g_test_add ("/FilterModel/filled/hide-root-level/vroot",
               FilterTest, gtk_tree_path_new_from_indices (2, -1),
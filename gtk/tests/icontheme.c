@@ -0,0 +1,397 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2011 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <utime.h>
+
+static const gchar *index_theme =
+  "[Icon Theme]\n"
+  "Name=Test\n"
+  "Directories=16x16/apps,48x48/apps,scalable/apps\n"
+  "\n"
+  "[16x16/apps]\n"
+  "Size=16\n"
+  "Type=Fixed\n"
+  "\n"
+  "[48x48/apps]\n"
+  "Size=48\n"
+  "Type=Fixed\n"
+  "\n"
+  "[scalable/apps]\n"
+  "Size=48\n"
+  "Type=Scalable\n";
+
+static gchar *tmp_dir;
+
+static void
+create_file (const gchar *path,
+             const gchar *contents)
+{
+  gchar *filename, *dirname;
+
+  filename = g_build_filename (tmp_dir, path, NULL);
+  dirname = g_path_get_dirname (filename);
+
+  g_assert_cmpint (g_mkdir_with_parents (dirname, 0700), ==, 0);
+  g_assert (g_file_set_contents (filename, contents, -1, NULL));
+
+  g_free (dirname);
+  g_free (filename);
+}
+
+static void
+set_mtime (const gchar *path,
+           time_t       mtime)
+{
+  struct utimbuf times;
+  gchar *filename;
+
+  filename = g_build_filename (tmp_dir, path, NULL);
+  times.actime = mtime;
+  times.modtime = mtime;
+  g_assert_cmpint (g_utime (filename, &times), ==, 0);
+  g_free (filename);
+}
+
+static void
+remove_tree (const gchar *path)
+{
+  GDir *dir;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir)
+    {
+      while ((name = g_dir_read_name (dir)))
+        {
+          gchar *child = g_build_filename (path, name, NULL);
+          remove_tree (child);
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_remove (path);
+}
+
+static GtkIconTheme *
+create_theme (const gchar *name)
+{
+  GtkIconTheme *theme;
+  gchar *path[1];
+
+  path[0] = g_build_filename (tmp_dir, "icons", NULL);
+
+  theme = gtk_icon_theme_new ();
+  gtk_icon_theme_set_search_path (theme, (const gchar **)path, 1);
+  gtk_icon_theme_set_custom_theme (theme, name);
+
+  g_free (path[0]);
+
+  return theme;
+}
+
+static gchar *
+get_index_filename (void)
+{
+  gchar *theme_dir, *checksum, *basename, *filename;
+
+  theme_dir = g_build_filename (tmp_dir, "icons", "test", NULL);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, theme_dir, -1);
+  basename = g_strconcat (checksum, ".cache", NULL);
+  filename = g_build_filename (g_get_user_cache_dir (),
+                               "gtk-3.0", "icon-index", basename,
+                               NULL);
+
+  g_free (basename);
+  g_free (checksum);
+  g_free (theme_dir);
+
+  return filename;
+}
+
+static void
+check_filename (GtkIconTheme *theme,
+                const gchar  *icon_name,
+                gint          size,
+                const gchar  *suffix)
+{
+  GtkIconInfo *info;
+
+  info = gtk_icon_theme_lookup_icon (theme, icon_name, size, 0);
+  g_assert (info != NULL);
+  g_assert (g_str_has_suffix (gtk_icon_info_get_filename (info), suffix));
+  gtk_icon_info_free (info);
+}
+
+static void
+test_index (void)
+{
+  GtkIconTheme *theme;
+  gchar *index_filename;
+  time_t past, future;
+
+  past = time (NULL) - 100;
+  future = time (NULL) + 100;
+
+  create_file ("icons/test/index.theme", index_theme);
+  create_file ("icons/test/16x16/apps/foo.png", "");
+  create_file ("icons/test/48x48/apps/foo.png", "");
+  create_file ("icons/test/48x48/apps/foo.icon",
+               "[Icon Data]\nDisplayName=Foo\n");
+  create_file ("icons/test/scalable/apps/bar.svg", "");
+
+  set_mtime ("icons/test/16x16/apps", past);
+  set_mtime ("icons/test/48x48/apps", past);
+  set_mtime ("icons/test/scalable/apps", past);
+  set_mtime ("icons/test", past);
+
+  index_filename = get_index_filename ();
+  g_assert (!g_file_test (index_filename, G_FILE_TEST_EXISTS));
+
+  /* The first scan writes the index */
+  theme = create_theme ("test");
+  g_assert (gtk_icon_theme_has_icon (theme, "foo"));
+  g_assert (g_file_test (index_filename, G_FILE_TEST_IS_REGULAR));
+  g_object_unref (theme);
+
+  /* Sneak an icon in behind its back; a fresh index hides it */
+  create_file ("icons/test/16x16/apps/baz.png", "");
+  set_mtime ("icons/test/16x16/apps", past);
+
+  theme = create_theme ("test");
+  g_assert (gtk_icon_theme_has_icon (theme, "foo"));
+  g_assert (gtk_icon_theme_has_icon (theme, "bar"));
+  g_assert (!gtk_icon_theme_has_icon (theme, "baz"));
+  check_filename (theme, "foo", 16, "16x16/apps/foo.png");
+  check_filename (theme, "foo", 48, "48x48/apps/foo.png");
+  check_filename (theme, "bar", 48, "scalable/apps/bar.svg");
+  g_object_unref (theme);
+
+  /* Touching the subdirectory invalidates the index */
+  set_mtime ("icons/test/16x16/apps", future);
+
+  theme = create_theme ("test");
+  g_assert (gtk_icon_theme_has_icon (theme, "baz"));
+  check_filename (theme, "baz", 16, "16x16/apps/baz.png");
+  g_object_unref (theme);
+
+  /* Directories that changed in the last second are not indexed */
+  g_assert (!g_file_test (index_filename, G_FILE_TEST_EXISTS) ||
+            g_unlink (index_filename) == 0);
+  set_mtime ("icons/test/16x16/apps", time (NULL));
+
+  theme = create_theme ("test");
+  g_assert (gtk_icon_theme_has_icon (theme, "baz"));
+  g_assert (!g_file_test (index_filename, G_FILE_TEST_EXISTS));
+  g_object_unref (theme);
+
+  set_mtime ("icons/test/16x16/apps", past);
+
+  theme = create_theme ("test");
+  g_assert (g_file_test (index_filename, G_FILE_TEST_IS_REGULAR));
+  g_object_unref (theme);
+
+  /* Any change of the mtime invalidates the index, even if
+   * the directory still looks older than the index file.
+   */
+  create_file ("icons/test/48x48/apps/qux.png", "");
+  set_mtime ("icons/test/48x48/apps", past + 1);
+
+  theme = create_theme ("test");
+  g_assert (gtk_icon_theme_has_icon (theme, "qux"));
+  check_filename (theme, "qux", 48, "48x48/apps/qux.png");
+  g_object_unref (theme);
+
+  g_free (index_filename);
+}
+
+typedef struct
+{
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+} AsyncLoad;
+
+static void
+load_done (GObject      *source,
+           GAsyncResult *result,
+           gpointer      data)
+{
+  AsyncLoad *load = data;
+  GError *error = NULL;
+
+  load->pixbuf = gtk_icon_info_load_icon_finish (load->info, result, &error);
+  g_assert_no_error (error);
+  g_assert (load->pixbuf != NULL);
+}
+
+static void
+test_async (void)
+{
+  GtkIconTheme *theme;
+  AsyncLoad loads[3];
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf;
+  gchar *contents, *filename;
+  gsize length;
+  gint i;
+
+  create_file ("icons/async/index.theme",
+               "[Icon Theme]\n"
+               "Name=Async\n"
+               "Directories=48x48/apps\n"
+               "\n"
+               "[48x48/apps]\n"
+               "Size=48\n"
+               "Type=Fixed\n");
+
+  g_assert (g_file_get_contents (SRCDIR "/test.png", &contents, &length, NULL));
+  filename = g_build_filename (tmp_dir, "icons", "async", "48x48", "apps", "pic.png", NULL);
+  create_file ("icons/async/48x48/apps/pic.png", "");
+  g_assert (g_file_set_contents (filename, contents, length, NULL));
+  g_free (filename);
+  g_free (contents);
+
+  theme = create_theme ("async");
+
+  /* Concurrent requests for the same icon share one decode */
+  for (i = 0; i < G_N_ELEMENTS (loads); i++)
+    {
+      loads[i].info = gtk_icon_theme_lookup_icon (theme, "pic", 48, 0);
+      g_assert (loads[i].info != NULL);
+      loads[i].pixbuf = NULL;
+      gtk_icon_info_load_icon_async (loads[i].info, NULL, load_done, &loads[i]);
+    }
+
+  for (i = 0; i < G_N_ELEMENTS (loads); i++)
+    while (loads[i].pixbuf == NULL)
+      g_main_context_iteration (NULL, TRUE);
+
+  g_assert_cmpint (gdk_pixbuf_get_width (loads[0].pixbuf), ==, 48);
+  g_assert (loads[1].pixbuf == loads[0].pixbuf);
+  g_assert (loads[2].pixbuf == loads[0].pixbuf);
+
+  /* ... and the synchronous path finds it in the cache */
+  info = gtk_icon_theme_lookup_icon (theme, "pic", 48, 0);
+  pixbuf = gtk_icon_info_load_icon (info, NULL);
+  g_assert (pixbuf == loads[0].pixbuf);
+  g_object_unref (pixbuf);
+  gtk_icon_info_free (info);
+
+  for (i = 0; i < G_N_ELEMENTS (loads); i++)
+    {
+      g_object_unref (loads[i].pixbuf);
+      gtk_icon_info_free (loads[i].info);
+    }
+
+  g_object_unref (theme);
+}
+
+static void
+test_symbolic (void)
+{
+  GtkIconTheme *theme;
+  GtkIconInfo *info;
+  GdkPixbuf *pixbuf1, *pixbuf2, *pixbuf3;
+  GdkRGBA fg = { 0.5, 0.5, 0.5, 1.0 };
+  gboolean was_symbolic;
+
+  create_file ("icons/symbolic/index.theme",
+               "[Icon Theme]\n"
+               "Name=Symbolic\n"
+               "Directories=scalable/actions\n"
+               "\n"
+               "[scalable/actions]\n"
+               "Size=16\n"
+               "Type=Scalable\n");
+  create_file ("icons/symbolic/scalable/actions/go-symbolic.svg",
+               "<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"16\" height=\"16\">\n"
+               "  <rect x=\"0\" y=\"0\" width=\"16\" height=\"16\"/>\n"
+               "</svg>\n");
+
+  theme = create_theme ("symbolic");
+  info = gtk_icon_theme_lookup_icon (theme, "go-symbolic", 16, 0);
+  g_assert (info != NULL);
+
+  pixbuf1 = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL,
+                                         &was_symbolic, NULL);
+  if (pixbuf1 == NULL)
+    {
+      g_test_message ("SVG loading is not available, skipping");
+      gtk_icon_info_free (info);
+      g_object_unref (theme);
+      return;
+    }
+
+  g_assert (was_symbolic);
+
+  /* The second load comes from the cache, but callers still
+   * get a pixbuf of their own that they may modify.
+   */
+  pixbuf2 = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL, NULL, NULL);
+  g_assert (pixbuf2 != NULL);
+  g_assert (pixbuf2 != pixbuf1);
+  g_assert_cmpint (G_OBJECT (pixbuf2)->ref_count, ==, 1);
+
+  gdk_pixbuf_fill (pixbuf1, 0xff0000ff);
+
+  pixbuf3 = gtk_icon_info_load_symbolic (info, &fg, NULL, NULL, NULL, NULL, NULL);
+  g_assert (memcmp (gdk_pixbuf_get_pixels (pixbuf3),
+                    gdk_pixbuf_get_pixels (pixbuf2),
+                    gdk_pixbuf_get_rowstride (pixbuf2) *
+                    gdk_pixbuf_get_height (pixbuf2)) == 0);
+
+  g_object_unref (pixbuf1);
+  g_object_unref (pixbuf2);
+  g_object_unref (pixbuf3);
+  gtk_icon_info_free (info);
+  g_object_unref (theme);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gchar *cache_dir;
+  gint result;
+
+  tmp_dir = g_build_filename (g_get_tmp_dir (), "icontheme-XXXXXX", NULL);
+  g_assert (mkdtemp (tmp_dir) != NULL);
+
+  /* Keep the index out of the real cache directory */
+  cache_dir = g_build_filename (tmp_dir, "cache", NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/icon-theme/index", test_index);
+  g_test_add_func ("/icon-theme/async", test_async);
+  g_test_add_func ("/icon-theme/symbolic", test_symbolic);
+
+  result = g_test_run ();
+
+  remove_tree (tmp_dir);
+  g_free (cache_dir);
+  g_free (tmp_dir);
+
+  return result;
+}
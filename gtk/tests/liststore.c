@@ -455,6 +455,172 @@ list_store_test_insert_before_NULL (void)
   g_object_unref (store);
 }
 
+static void
+row_inserted_counter (GtkTreeModel *model,
+                      GtkTreePath  *path,
+                      GtkTreeIter  *iter,
+                      gpointer      data)
+{
+  gint *n_inserted = data;
+  gint value;
+
+  /* The row must be filled in by the time it is announced */
+  gtk_tree_model_get (model, iter, 0, &value, -1);
+  g_assert_cmpint (value, ==, 100 + *n_inserted);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, 1 + *n_inserted);
+
+  (*n_inserted)++;
+}
+
+static void
+check_rows (GtkListStore *store,
+            gint         *expected,
+            gint          n_expected)
+{
+  GtkTreeIter iter;
+  gboolean valid;
+  gint i, value;
+
+  g_assert_cmpint (gtk_tree_model_iter_n_children (GTK_TREE_MODEL (store), NULL), ==, n_expected);
+
+  valid = gtk_tree_model_get_iter_first (GTK_TREE_MODEL (store), &iter);
+  for (i = 0; i < n_expected; i++)
+    {
+      g_assert (valid);
+      gtk_tree_model_get (GTK_TREE_MODEL (store), &iter, 0, &value, -1);
+      g_assert_cmpint (value, ==, expected[i]);
+      g_assert (iter_position (store, &iter, i));
+
+      valid = gtk_tree_model_iter_next (GTK_TREE_MODEL (store), &iter);
+    }
+  g_assert (!valid);
+}
+
+static void
+list_store_test_insert_rows (void)
+{
+  GtkListStore *store;
+  GValue values[3] = { { 0, }, };
+  gint columns[1] = { 0 };
+  gint expected[5] = { 0, 100, 101, 102, 1 };
+  gint n_inserted = 0;
+  gint i;
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 100 + i);
+    }
+
+  /* Nobody listening */
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 0, -1);
+  gtk_list_store_insert_with_values (store, NULL, 1, 0, 1, -1);
+
+  gtk_list_store_insert_rows_with_valuesv (store, 1, 3, columns, values, 1);
+  check_rows (store, expected, 5);
+
+  g_object_unref (store);
+
+  /* With a row-inserted handler */
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_with_values (store, NULL, 0, 0, 0, -1);
+  gtk_list_store_insert_with_values (store, NULL, 1, 0, 1, -1);
+  g_signal_connect (store, "row-inserted",
+                    G_CALLBACK (row_inserted_counter), &n_inserted);
+
+  gtk_list_store_insert_rows_with_valuesv (store, 1, 3, columns, values, 1);
+  g_assert_cmpint (n_inserted, ==, 3);
+  check_rows (store, expected, 5);
+
+  g_object_unref (store);
+
+  /* Appending */
+  store = gtk_list_store_new (1, G_TYPE_INT);
+  gtk_list_store_insert_rows_with_valuesv (store, -1, 3, columns, values, 1);
+  check_rows (store, expected + 1, 3);
+
+  g_object_unref (store);
+
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+}
+
+static void
+check_view_cursor (GtkWidget *view,
+                   gint       expected)
+{
+  GtkTreePath *path;
+
+  gtk_tree_view_get_cursor (GTK_TREE_VIEW (view), &path, NULL);
+  g_assert (path != NULL);
+  g_assert_cmpint (gtk_tree_path_get_indices (path)[0], ==, expected);
+  gtk_tree_path_free (path);
+}
+
+static void
+set_view_cursor (GtkWidget *view,
+                 gint       row)
+{
+  GtkTreePath *path;
+
+  path = gtk_tree_path_new_from_indices (row, -1);
+  gtk_tree_view_set_cursor (GTK_TREE_VIEW (view), path, NULL, FALSE);
+  gtk_tree_path_free (path);
+}
+
+static void
+list_store_test_insert_rows_view (void)
+{
+  GtkListStore *store;
+  GtkWidget *view;
+  GValue values[3] = { { 0, }, };
+  gint columns[1] = { 0 };
+  gint n_inserted = 0;
+  gint i, pass;
+
+  for (i = 0; i < 3; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], 100 + i);
+    }
+
+  /* A view alone is told about the rows all at once, a view
+   * next to another listener sees them one by one.
+   */
+  for (pass = 0; pass < 2; pass++)
+    {
+      store = gtk_list_store_new (1, G_TYPE_INT);
+      for (i = 0; i < 10; i++)
+        gtk_list_store_insert_with_values (store, NULL, i, 0, i, -1);
+
+      view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+      g_object_ref_sink (view);
+
+      n_inserted = 0;
+      if (pass == 1)
+        g_signal_connect (store, "row-inserted",
+                          G_CALLBACK (row_inserted_counter), &n_inserted);
+
+      /* The cursor follows its row */
+      set_view_cursor (view, 5);
+      gtk_list_store_insert_rows_with_valuesv (store, 1, 3, columns, values, 1);
+      check_view_cursor (view, 8);
+      g_assert_cmpint (n_inserted, ==, pass == 1 ? 3 : 0);
+
+      /* And the view has a row for every row of the model */
+      set_view_cursor (view, 12);
+      check_view_cursor (view, 12);
+
+      gtk_widget_destroy (view);
+      g_object_unref (view);
+      g_object_unref (store);
+    }
+
+  for (i = 0; i < 3; i++)
+    g_value_unset (&values[i]);
+}
+
 /* removal */
 static void
 list_store_test_remove_begin (ListStore     *fixture,
@@ -1019,6 +1185,10 @@ main (int    argc,
 		   list_store_test_insert_before);
   g_test_add_func ("/list-store/insert-before-NULL",
 		   list_store_test_insert_before_NULL);
+  g_test_add_func ("/list-store/insert-rows",
+                   list_store_test_insert_rows);
+  g_test_add_func ("/list-store/insert-rows-view",
+                   list_store_test_insert_rows_view);
 
   /* setting values (FIXME) */
 
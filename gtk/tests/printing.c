@@ -0,0 +1,480 @@
+/* GTK - The GIMP Toolkit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include <gtk/gtkunixprint.h>
+
+static gboolean
+find_file_printer (GtkPrinter *printer,
+                   gpointer    data)
+{
+  GtkPrinter **result = data;
+
+  if (g_strcmp0 (G_OBJECT_TYPE_NAME (gtk_printer_get_backend (printer)),
+                 "GtkPrintBackendFile") == 0)
+    {
+      *result = g_object_ref (printer);
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+job_complete (GtkPrintJob  *job,
+              gpointer      user_data,
+              const GError *error)
+{
+  GMainLoop *loop = user_data;
+
+  g_assert_no_error ((GError *) error);
+  g_main_loop_quit (loop);
+}
+
+static glong
+get_max_rss (void)
+{
+  struct rusage usage;
+
+  getrusage (RUSAGE_SELF, &usage);
+
+  return usage.ru_maxrss;
+}
+
+/* Prints @n_pages to a PDF through the file backend, and reports
+ * how long it took and how much the peak memory usage grew.
+ */
+static void
+print_to_file (gint n_pages)
+{
+  GtkPrinter *printer = NULL;
+  GtkPrintSettings *settings;
+  GtkPageSetup *page_setup;
+  GtkPrintJob *job;
+  GMainLoop *loop;
+  GError *error = NULL;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gchar *filename, *uri, *contents;
+  gsize length;
+  GTimer *timer;
+  glong max_rss;
+  gint fd, i;
+
+  gtk_enumerate_printers (find_file_printer, &printer, NULL, TRUE);
+
+  if (printer == NULL)
+    {
+      g_test_message ("The file print backend is not available, skipping");
+      return;
+    }
+
+  fd = g_file_open_tmp ("printing-XXXXXX.pdf", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  uri = g_filename_to_uri (filename, NULL, &error);
+  g_assert_no_error (error);
+
+  settings = gtk_print_settings_new ();
+  gtk_print_settings_set (settings, GTK_PRINT_SETTINGS_OUTPUT_URI, uri);
+  gtk_print_settings_set (settings, GTK_PRINT_SETTINGS_OUTPUT_FILE_FORMAT, "pdf");
+  page_setup = gtk_page_setup_new ();
+
+  job = gtk_print_job_new ("printing test", printer, settings, page_setup);
+
+  max_rss = get_max_rss ();
+  timer = g_timer_new ();
+
+  surface = gtk_print_job_get_surface (job, &error);
+  g_assert_no_error (error);
+  g_assert (surface != NULL);
+
+  cr = cairo_create (surface);
+
+  for (i = 0; i < n_pages; i++)
+    {
+      gint j;
+
+      for (j = 0; j < 50; j++)
+        {
+          cairo_rectangle (cr, (i + j * 7) % 500, (i * 3 + j * 11) % 700, 40, 20);
+          cairo_set_source_rgb (cr, (j % 3) / 2.0, (j % 5) / 4.0, (j % 7) / 6.0);
+          cairo_fill (cr);
+        }
+
+      cairo_show_page (cr);
+    }
+
+  cairo_destroy (cr);
+  cairo_surface_finish (surface);
+  g_assert_cmpint (cairo_surface_status (surface), ==, CAIRO_STATUS_SUCCESS);
+
+  loop = g_main_loop_new (NULL, FALSE);
+  gtk_print_job_send (job, job_complete, loop, NULL);
+  g_main_loop_run (loop);
+  g_main_loop_unref (loop);
+
+  g_test_message ("%d pages: %g sec, peak memory grew by %ld kB",
+                  n_pages, g_timer_elapsed (timer, NULL), get_max_rss () - max_rss);
+
+  g_file_get_contents (filename, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_assert (length > 5);
+  g_assert (strncmp (contents, "%PDF-", 5) == 0);
+  g_assert (g_strrstr_len (contents, length, "%%EOF") != NULL);
+  g_free (contents);
+
+  g_timer_destroy (timer);
+  g_object_unref (job);
+  g_object_unref (page_setup);
+  g_object_unref (settings);
+  g_object_unref (printer);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (uri);
+}
+
+static void
+test_file_backend (void)
+{
+  print_to_file (20);
+}
+
+static void
+test_file_backend_large (void)
+{
+  print_to_file (5000);
+}
+
+/* Starts a job printing to @filename, draws a few pages
+ * and drops the job without sending it.
+ */
+static gboolean
+cancel_print_to_file (const gchar *filename)
+{
+  GtkPrinter *printer = NULL;
+  GtkPrintSettings *settings;
+  GtkPageSetup *page_setup;
+  GtkPrintJob *job;
+  GError *error = NULL;
+  cairo_surface_t *surface;
+  cairo_t *cr;
+  gchar *uri;
+  gint i;
+
+  gtk_enumerate_printers (find_file_printer, &printer, NULL, TRUE);
+
+  if (printer == NULL)
+    {
+      g_test_message ("The file print backend is not available, skipping");
+      return FALSE;
+    }
+
+  uri = g_filename_to_uri (filename, NULL, &error);
+  g_assert_no_error (error);
+
+  settings = gtk_print_settings_new ();
+  gtk_print_settings_set (settings, GTK_PRINT_SETTINGS_OUTPUT_URI, uri);
+  gtk_print_settings_set (settings, GTK_PRINT_SETTINGS_OUTPUT_FILE_FORMAT, "pdf");
+  page_setup = gtk_page_setup_new ();
+
+  job = gtk_print_job_new ("printing test", printer, settings, page_setup);
+
+  surface = gtk_print_job_get_surface (job, &error);
+  g_assert_no_error (error);
+
+  cr = cairo_create (surface);
+  for (i = 0; i < 50; i++)
+    {
+      cairo_rectangle (cr, i, i, 40, 20);
+      cairo_fill (cr);
+      cairo_show_page (cr);
+    }
+  cairo_destroy (cr);
+
+  g_object_unref (job);
+  g_object_unref (page_setup);
+  g_object_unref (settings);
+  g_object_unref (printer);
+  g_free (uri);
+
+  return TRUE;
+}
+
+static void
+test_file_backend_cancel (void)
+{
+  GError *error = NULL;
+  gchar *filename, *contents;
+  gint fd;
+
+  fd = g_file_open_tmp ("printing-XXXXXX.pdf", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  /* A cancelled job keeps the file it would have replaced */
+  g_file_set_contents (filename, "old contents", -1, &error);
+  g_assert_no_error (error);
+
+  if (cancel_print_to_file (filename))
+    {
+      g_file_get_contents (filename, &contents, NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpstr (contents, ==, "old contents");
+      g_free (contents);
+
+      /* And doesn't leave a file of its own behind */
+      g_unlink (filename);
+      cancel_print_to_file (filename);
+      g_assert (!g_file_test (filename, G_FILE_TEST_EXISTS));
+    }
+
+  g_unlink (filename);
+  g_free (filename);
+}
+
+#define N_THREADED_PAGES 12
+
+/* More pages than are queued for the worker threads at once */
+#define N_QUEUED_PAGES 40
+
+typedef struct
+{
+  GMutex *mutex;
+  GThread *main_thread;
+  PangoFontMap *default_fontmap;
+  gint drawn[N_QUEUED_PAGES];
+  gint n_threaded;
+  gboolean shared_fontmap;
+  gboolean empty_layout;
+} ThreadedData;
+
+static void
+draw_page_text (GtkPrintOperation *op,
+                GtkPrintContext   *context,
+                gint               page_nr,
+                ThreadedData      *data)
+{
+  PangoLayout *layout;
+  cairo_t *cr;
+  gchar *text;
+  gint width, height;
+
+  cr = gtk_print_context_get_cairo_context (context);
+  layout = gtk_print_context_create_pango_layout (context);
+
+  text = g_strdup_printf ("Page %d", page_nr + 1);
+  pango_layout_set_text (layout, text, -1);
+  pango_layout_get_pixel_size (layout, &width, &height);
+
+  cairo_move_to (cr, 20, 20);
+  pango_cairo_show_layout (cr, layout);
+
+  g_object_unref (layout);
+  g_free (text);
+
+  g_mutex_lock (data->mutex);
+
+  data->drawn[page_nr]++;
+
+  if (g_thread_self () != data->main_thread)
+    {
+      data->n_threaded++;
+
+      if (gtk_print_context_get_pango_fontmap (context) == data->default_fontmap)
+        data->shared_fontmap = TRUE;
+    }
+
+  if (width <= 0 || height <= 0)
+    data->empty_layout = TRUE;
+
+  g_mutex_unlock (data->mutex);
+}
+
+/* Counts the page objects in a PDF written by cairo */
+static gint
+count_pdf_pages (const gchar *contents,
+                 gsize        length)
+{
+  const gchar *p, *end = contents + length;
+  gint n_pages = 0;
+
+  for (p = contents; p < end; p++)
+    {
+      p = g_strstr_len (p, end - p, "/Type /Page");
+      if (p == NULL)
+        break;
+
+      if (p + 11 < end && p[11] != 's')
+        n_pages++;
+    }
+
+  return n_pages;
+}
+
+static void
+test_threaded_drawing (void)
+{
+  GtkPrintOperation *op;
+  GtkPrintOperationResult result;
+  ThreadedData data = { 0, };
+  GError *error = NULL;
+  gchar *filename, *contents;
+  gsize length;
+  gint fd, i;
+
+  fd = g_file_open_tmp ("printing-XXXXXX.pdf", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  data.mutex = g_mutex_new ();
+  data.main_thread = g_thread_self ();
+  data.default_fontmap = pango_cairo_font_map_get_default ();
+
+  op = gtk_print_operation_new ();
+  gtk_print_operation_set_n_pages (op, N_THREADED_PAGES);
+  gtk_print_operation_set_threaded_drawing (op, TRUE);
+  gtk_print_operation_set_export_filename (op, filename);
+  g_signal_connect (op, "draw-page", G_CALLBACK (draw_page_text), &data);
+
+  result = gtk_print_operation_run (op, GTK_PRINT_OPERATION_ACTION_EXPORT,
+                                    NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (result, ==, GTK_PRINT_OPERATION_RESULT_APPLY);
+
+  /* Every page was drawn once, in a worker thread,
+   * with a font map of its own.
+   */
+  for (i = 0; i < N_THREADED_PAGES; i++)
+    g_assert_cmpint (data.drawn[i], ==, 1);
+
+  g_assert_cmpint (data.n_threaded, ==, N_THREADED_PAGES);
+  g_assert (!data.shared_fontmap);
+  g_assert (!data.empty_layout);
+
+  /* And all pages, with their text, made it to the output */
+  g_file_get_contents (filename, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_assert (strncmp (contents, "%PDF-", 5) == 0);
+  g_assert_cmpint (count_pdf_pages (contents, length), ==, N_THREADED_PAGES);
+  g_assert (g_strstr_len (contents, length, "/Font") != NULL);
+  g_free (contents);
+
+  g_object_unref (op);
+  g_mutex_free (data.mutex);
+  g_unlink (filename);
+  g_free (filename);
+}
+
+static void
+test_threaded_number_up (void)
+{
+  GtkPrinter *printer = NULL;
+  GtkPrintOperation *op;
+  GtkPrintOperationResult result;
+  GtkPrintSettings *settings;
+  ThreadedData data = { 0, };
+  GError *error = NULL;
+  gchar *filename, *uri, *contents;
+  gsize length;
+  gint fd, i;
+
+  gtk_enumerate_printers (find_file_printer, &printer, NULL, TRUE);
+
+  if (printer == NULL)
+    {
+      g_test_message ("The file print backend is not available, skipping");
+      return;
+    }
+
+  fd = g_file_open_tmp ("printing-XXXXXX.pdf", &filename, &error);
+  g_assert_no_error (error);
+  close (fd);
+
+  uri = g_filename_to_uri (filename, NULL, &error);
+  g_assert_no_error (error);
+
+  /* The file backend leaves copies and number-up to the print operation */
+  settings = gtk_print_settings_new ();
+  gtk_print_settings_set_printer (settings, gtk_printer_get_name (printer));
+  gtk_print_settings_set (settings, GTK_PRINT_SETTINGS_OUTPUT_URI, uri);
+  gtk_print_settings_set (settings, GTK_PRINT_SETTINGS_OUTPUT_FILE_FORMAT, "pdf");
+  gtk_print_settings_set_n_copies (settings, 3);
+  gtk_print_settings_set_collate (settings, FALSE);
+  gtk_print_settings_set_number_up (settings, 2);
+
+  data.mutex = g_mutex_new ();
+  data.main_thread = g_thread_self ();
+  data.default_fontmap = pango_cairo_font_map_get_default ();
+
+  op = gtk_print_operation_new ();
+  gtk_print_operation_set_print_settings (op, settings);
+  gtk_print_operation_set_n_pages (op, N_QUEUED_PAGES);
+  gtk_print_operation_set_threaded_drawing (op, TRUE);
+  g_signal_connect (op, "draw-page", G_CALLBACK (draw_page_text), &data);
+
+  result = gtk_print_operation_run (op, GTK_PRINT_OPERATION_ACTION_PRINT,
+                                    NULL, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (result, ==, GTK_PRINT_OPERATION_RESULT_APPLY);
+
+  /* Every page was drawn once for each copy */
+  for (i = 0; i < N_QUEUED_PAGES; i++)
+    g_assert_cmpint (data.drawn[i], ==, 3);
+
+  g_assert (!data.shared_fontmap);
+
+  /* Two pages to a sheet, no sheet twice, and no copy left out */
+  g_file_get_contents (filename, &contents, &length, &error);
+  g_assert_no_error (error);
+  g_assert (strncmp (contents, "%PDF-", 5) == 0);
+  g_assert_cmpint (count_pdf_pages (contents, length), ==, 3 * N_QUEUED_PAGES / 2);
+  g_free (contents);
+
+  g_object_unref (op);
+  g_object_unref (settings);
+  g_object_unref (printer);
+  g_mutex_free (data.mutex);
+  g_unlink (filename);
+  g_free (filename);
+  g_free (uri);
+}
+
+int
+main (int argc, char *argv[])
+{
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/printing/file-backend", test_file_backend);
+  g_test_add_func ("/printing/file-backend-cancel", test_file_backend_cancel);
+  g_test_add_func ("/printing/threaded-drawing", test_threaded_drawing);
+  g_test_add_func ("/printing/threaded-number-up", test_threaded_number_up);
+
+  if (g_test_perf ())
+    g_test_add_func ("/printing/file-backend-large", test_file_backend_large);
+
+  return g_test_run ();
+}
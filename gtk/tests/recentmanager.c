@@ -292,6 +292,180 @@ recent_manager_purge (void)
   g_assert (n == 1);
 }
 
+static void
+add_item (GtkRecentManager *manager,
+          const gchar      *item_uri,
+          const gchar      *description)
+{
+  GtkRecentData data = { NULL, };
+
+  data.description = (gchar *) description;
+  data.mime_type = "text/plain";
+  data.app_name = "testrecentchooser";
+  data.app_exec = "testrecentchooser %u";
+
+  g_assert (gtk_recent_manager_add_full (manager, item_uri, &data));
+}
+
+static GtkRecentManager *
+create_journaled_manager (const gchar *filename)
+{
+  GtkSettings *settings = gtk_settings_get_default ();
+  GtkRecentManager *manager;
+
+  g_object_set (settings, "gtk-recent-files-journal", TRUE, NULL);
+  manager = g_object_new (GTK_TYPE_RECENT_MANAGER,
+                          "filename", filename,
+                          NULL);
+  g_object_set (settings, "gtk-recent-files-journal", FALSE, NULL);
+
+  return manager;
+}
+
+static gint
+get_size (GtkRecentManager *manager)
+{
+  gint size;
+
+  g_object_get (manager, "size", &size, NULL);
+
+  return size;
+}
+
+static void
+recent_manager_journal (void)
+{
+  const gchar *filename = "recently-used-journal.xbel";
+  const gchar *journal = "recently-used-journal.xbel.journal";
+  const gchar *uri3 = "file:///tmp/testrecentchooser3.txt";
+  GtkRecentManager *writer, *reader;
+  GtkRecentInfo *info;
+  const gchar *app_exec;
+  gchar *description;
+  gint i;
+
+  writer = create_journaled_manager (filename);
+  add_item (writer, uri, "First");
+  add_item (writer, uri2, NULL);
+
+  /* flush the pending changes; they only go to the journal */
+  g_signal_emit_by_name (writer, "changed");
+  g_assert (!g_file_test (filename, G_FILE_TEST_EXISTS));
+  g_assert (g_file_test (journal, G_FILE_TEST_IS_REGULAR));
+
+  reader = create_journaled_manager (filename);
+  g_assert_cmpint (get_size (reader), ==, 2);
+
+  info = gtk_recent_manager_lookup_item (reader, uri, NULL);
+  g_assert (info != NULL);
+  g_assert_cmpstr (gtk_recent_info_get_description (info), ==, "First");
+  g_assert (gtk_recent_info_has_application (info, "testrecentchooser"));
+  gtk_recent_info_unref (info);
+
+  /* the reader picks up the changes appended afterwards */
+  g_assert (gtk_recent_manager_move_item (writer, uri, uri3, NULL));
+  g_assert (gtk_recent_manager_remove_item (writer, uri2, NULL));
+  g_signal_emit_by_name (writer, "changed");
+  g_signal_emit_by_name (reader, "changed");
+
+  g_assert (!gtk_recent_manager_has_item (reader, uri));
+  g_assert (!gtk_recent_manager_has_item (reader, uri2));
+  g_assert (gtk_recent_manager_has_item (reader, uri3));
+
+  info = gtk_recent_manager_lookup_item (reader, uri3, NULL);
+  g_assert (info != NULL);
+  g_assert_cmpstr (gtk_recent_info_get_description (info), ==, "First");
+
+  /* the journal keeps the command line as registered,
+   * so it follows the item when it is moved
+   */
+  g_assert (gtk_recent_info_get_application_info (info, "testrecentchooser",
+                                                  &app_exec, NULL, NULL));
+  g_assert_cmpstr (app_exec, ==, "testrecentchooser file:///tmp/testrecentchooser3.txt");
+  gtk_recent_info_unref (info);
+
+  /* growing the journal enough folds it back into the file */
+  description = g_strnfill (512, 'x');
+  for (i = 0; i < 200; i++)
+    {
+      gchar *item_uri;
+
+      item_uri = g_strdup_printf ("file:///doesnotexist-%d.txt", i);
+      add_item (writer, item_uri, description);
+      g_free (item_uri);
+    }
+  g_free (description);
+
+  g_signal_emit_by_name (writer, "changed");
+  g_assert (g_file_test (filename, G_FILE_TEST_IS_REGULAR));
+  g_assert (!g_file_test (journal, G_FILE_TEST_EXISTS));
+  g_assert_cmpint (get_size (writer), ==, 201);
+
+  g_signal_emit_by_name (reader, "changed");
+  g_assert_cmpint (get_size (reader), ==, 201);
+  g_assert (gtk_recent_manager_has_item (reader, uri3));
+
+  g_object_unref (reader);
+  g_object_unref (writer);
+
+  g_assert_cmpint (g_unlink (filename), ==, 0);
+  g_unlink (journal);
+}
+
+static void
+recent_manager_query (void)
+{
+  GtkRecentManager *manager;
+  GList *items, *l;
+  time_t last;
+  gint i;
+
+  manager = g_object_new (GTK_TYPE_RECENT_MANAGER,
+                          "filename", "recently-used-query.xbel",
+                          NULL);
+
+  for (i = 0; i < 5; i++)
+    {
+      gchar *item_uri;
+
+      item_uri = g_strdup_printf ("file:///doesnotexist-%d.txt", i);
+      add_item (manager, item_uri, NULL);
+      g_free (item_uri);
+    }
+
+  g_assert (gtk_recent_manager_query_items (manager, GTK_RECENT_SORT_MRU, 0) == NULL);
+
+  items = gtk_recent_manager_query_items (manager, GTK_RECENT_SORT_MRU, 3);
+  g_assert_cmpint (g_list_length (items), ==, 3);
+
+  last = G_MAXLONG;
+  for (l = items; l != NULL; l = l->next)
+    {
+      g_assert_cmpint (gtk_recent_info_get_modified (l->data), <=, last);
+      last = gtk_recent_info_get_modified (l->data);
+    }
+
+  g_list_foreach (items, (GFunc) gtk_recent_info_unref, NULL);
+  g_list_free (items);
+
+  items = gtk_recent_manager_query_items (manager, GTK_RECENT_SORT_LRU, -1);
+  g_assert_cmpint (g_list_length (items), ==, 5);
+
+  last = 0;
+  for (l = items; l != NULL; l = l->next)
+    {
+      g_assert_cmpint (gtk_recent_info_get_modified (l->data), >=, last);
+      last = gtk_recent_info_get_modified (l->data);
+    }
+
+  g_list_foreach (items, (GFunc) gtk_recent_info_unref, NULL);
+  g_list_free (items);
+
+  g_object_unref (manager);
+
+  g_assert_cmpint (g_unlink ("recently-used-query.xbel"), ==, 0);
+}
+
 int
 main (int    argc,
       char **argv)
@@ -306,6 +480,8 @@ main (int    argc,
   g_test_add_func ("/recent-manager/lookup-item", recent_manager_lookup_item);
   g_test_add_func ("/recent-manager/remove-item", recent_manager_remove_item);
   g_test_add_func ("/recent-manager/purge", recent_manager_purge);
+  g_test_add_func ("/recent-manager/journal", recent_manager_journal);
+  g_test_add_func ("/recent-manager/query", recent_manager_query);
 
   return g_test_run ();
 }
@@ -0,0 +1,385 @@
+/* GTK - The GIMP Toolkit
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <utime.h>
+#include "gtk/gtksearchenginesimple.h"
+
+static gchar *tmp_dir;
+static gchar *tree_dir;
+
+static void
+create_file (const gchar *path)
+{
+  gchar *filename, *dirname;
+
+  filename = g_build_filename (tree_dir, path, NULL);
+  dirname = g_path_get_dirname (filename);
+
+  g_assert_cmpint (g_mkdir_with_parents (dirname, 0700), ==, 0);
+  g_assert (g_file_set_contents (filename, "", -1, NULL));
+
+  g_free (dirname);
+  g_free (filename);
+}
+
+static void
+create_dir (const gchar *path)
+{
+  gchar *filename;
+
+  filename = g_build_filename (tree_dir, path, NULL);
+  g_assert_cmpint (g_mkdir_with_parents (filename, 0700), ==, 0);
+  g_free (filename);
+}
+
+static void
+set_mtime (const gchar *path,
+           time_t       mtime)
+{
+  struct utimbuf times;
+  gchar *filename;
+
+  filename = g_build_filename (tree_dir, path, NULL);
+  times.actime = mtime;
+  times.modtime = mtime;
+  g_assert_cmpint (g_utime (filename, &times), ==, 0);
+  g_free (filename);
+}
+
+/* Sets the mtime of every directory in the tree */
+static void
+set_tree_mtime (const gchar *path,
+                time_t       mtime)
+{
+  gchar *filename;
+  const gchar *name;
+  GDir *dir;
+
+  filename = g_build_filename (tree_dir, path, NULL);
+  dir = g_dir_open (filename, 0, NULL);
+  g_free (filename);
+
+  if (dir == NULL)
+    return;
+
+  while ((name = g_dir_read_name (dir)))
+    {
+      gchar *child = g_build_filename (path, name, NULL);
+      set_tree_mtime (child, mtime);
+      g_free (child);
+    }
+  g_dir_close (dir);
+
+  set_mtime (path, mtime);
+}
+
+static void
+remove_tree (const gchar *path)
+{
+  GDir *dir;
+  const gchar *name;
+
+  dir = g_dir_open (path, 0, NULL);
+  if (dir)
+    {
+      while ((name = g_dir_read_name (dir)))
+        {
+          gchar *child = g_build_filename (path, name, NULL);
+          remove_tree (child);
+          g_free (child);
+        }
+      g_dir_close (dir);
+    }
+
+  g_remove (path);
+}
+
+static void
+hits_added (GtkSearchEngine *engine,
+            GList           *hits,
+            GHashTable      *result)
+{
+  GList *l;
+
+  for (l = hits; l; l = l->next)
+    {
+      gchar *filename;
+
+      filename = g_filename_from_uri (l->data, NULL, NULL);
+      g_assert (filename != NULL);
+      g_assert (g_str_has_prefix (filename, tree_dir));
+
+      /* Every file is reported once */
+      g_assert (!g_hash_table_lookup (result, filename + strlen (tree_dir) + 1));
+      g_hash_table_insert (result, g_strdup (filename + strlen (tree_dir) + 1),
+                           GINT_TO_POINTER (TRUE));
+      g_free (filename);
+    }
+}
+
+static void
+finished (GtkSearchEngine *engine,
+          gboolean        *done)
+{
+  *done = TRUE;
+}
+
+/* Searches the tree for @text and returns the hits,
+ * relative to the tree
+ */
+static GHashTable *
+search (const gchar *text)
+{
+  GtkSearchEngine *engine;
+  GtkQuery *query;
+  GHashTable *result;
+  gboolean done = FALSE;
+  gchar *uri;
+
+  result = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  uri = g_filename_to_uri (tree_dir, NULL, NULL);
+  query = _gtk_query_new ();
+  _gtk_query_set_text (query, text);
+  _gtk_query_set_location (query, uri);
+  g_free (uri);
+
+  engine = _gtk_search_engine_simple_new ();
+  _gtk_search_engine_set_query (engine, query);
+  g_signal_connect (engine, "hits-added", G_CALLBACK (hits_added), result);
+  g_signal_connect (engine, "finished", G_CALLBACK (finished), &done);
+
+  _gtk_search_engine_start (engine);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_object_unref (engine);
+  g_object_unref (query);
+
+  return result;
+}
+
+static void
+assert_hits (GHashTable   *result,
+             const gchar **expected)
+{
+  gint i;
+
+  for (i = 0; expected[i] != NULL; i++)
+    if (!g_hash_table_lookup (result, expected[i]))
+      g_error ("%s was not found", expected[i]);
+
+  g_assert_cmpint (g_hash_table_size (result), ==, i);
+}
+
+static void
+test_matching (void)
+{
+  GHashTable *result;
+  const gchar *alpha[] = {
+    "Alpha.TXT", "alphabet.png", "sub/ALPHA-two.txt", "alpha-dir", NULL
+  };
+  const gchar *alpha_txt[] = {
+    "Alpha.TXT", "sub/ALPHA-two.txt", NULL
+  };
+
+  create_file ("Alpha.TXT");
+  create_file ("alphabet.png");
+  create_file ("beta.txt");
+  create_file (".alpha-hidden");
+  create_file (".hidden/alpha.txt");
+  create_file ("sub/ALPHA-two.txt");
+  create_file ("alpha-dir/other");
+
+  /* Matching ignores case, hidden files are skipped and
+   * hidden directories are not searched
+   */
+  result = search ("alpha");
+  assert_hits (result, alpha);
+  g_hash_table_destroy (result);
+
+  /* All words must match */
+  result = search ("alpha txt");
+  assert_hits (result, alpha_txt);
+  g_hash_table_destroy (result);
+
+  result = search ("gamma");
+  g_assert_cmpint (g_hash_table_size (result), ==, 0);
+  g_hash_table_destroy (result);
+
+  remove_tree (tree_dir);
+}
+
+#define N_DIRS 8
+#define N_FILES 6
+
+static void
+test_parallel_walk (void)
+{
+  GHashTable *result;
+  gint i, j, k;
+
+  for (i = 0; i < N_DIRS; i++)
+    for (j = 0; j < N_DIRS; j++)
+      {
+        gchar *path;
+
+        for (k = 0; k < N_FILES; k++)
+          {
+            path = g_strdup_printf ("d%d/d%d/file-%d-%d-%d", i, j, i, j, k);
+            create_file (path);
+            g_free (path);
+          }
+
+        path = g_strdup_printf ("d%d/d%d/other", i, j);
+        create_file (path);
+        g_free (path);
+      }
+
+  /* Every file below every directory is found, once */
+  result = search ("file");
+  g_assert_cmpint (g_hash_table_size (result), ==, N_DIRS * N_DIRS * N_FILES);
+
+  for (i = 0; i < N_DIRS; i++)
+    for (j = 0; j < N_DIRS; j++)
+      for (k = 0; k < N_FILES; k++)
+        {
+          gchar *path;
+
+          path = g_strdup_printf ("d%d/d%d/file-%d-%d-%d", i, j, i, j, k);
+          g_assert (g_hash_table_lookup (result, path));
+          g_free (path);
+        }
+
+  g_hash_table_destroy (result);
+
+  remove_tree (tree_dir);
+}
+
+static gchar *
+get_index_filename (void)
+{
+  gchar *checksum, *filename;
+
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_MD5, tree_dir, -1);
+  filename = g_build_filename (g_get_user_cache_dir (),
+                               "gtk-3.0", "search-index", checksum,
+                               NULL);
+  g_free (checksum);
+
+  return filename;
+}
+
+static void
+test_index (void)
+{
+  GHashTable *result;
+  gchar *index_filename;
+  struct stat st;
+  time_t past;
+  const gchar *before[] = { "a/match-1", "b/match-2", NULL };
+  const gchar *after[] = { "a/match-1", "a/match-3", "b/match-2", NULL };
+
+  past = time (NULL) - 100;
+  index_filename = get_index_filename ();
+
+  create_file ("a/match-1");
+  create_file ("b/match-2");
+  create_dir ("c");
+  set_tree_mtime ("", past);
+
+  /* Without the setting, no index is kept */
+  result = search ("match");
+  assert_hits (result, before);
+  g_hash_table_destroy (result);
+  g_assert (!g_file_test (index_filename, G_FILE_TEST_EXISTS));
+
+  g_object_set (gtk_settings_get_default (), "gtk-file-search-index", TRUE, NULL);
+
+  result = search ("match");
+  assert_hits (result, before);
+  g_hash_table_destroy (result);
+
+  g_assert (g_file_test (index_filename, G_FILE_TEST_IS_REGULAR));
+  g_assert_cmpint (g_stat (index_filename, &st), ==, 0);
+  g_assert_cmpint (st.st_mode & 077, ==, 0);
+
+  /* Directories with an unchanged mtime are taken from the index */
+  create_file ("a/match-3");
+  set_mtime ("a", past);
+
+  result = search ("match");
+  assert_hits (result, before);
+  g_hash_table_destroy (result);
+
+  /* And changing the mtime makes the search read them again */
+  set_mtime ("a", past + 1);
+
+  result = search ("match");
+  assert_hits (result, after);
+  g_hash_table_destroy (result);
+
+  /* Turning the setting off removes the index */
+  g_object_set (gtk_settings_get_default (), "gtk-file-search-index", FALSE, NULL);
+
+  result = search ("match");
+  assert_hits (result, after);
+  g_hash_table_destroy (result);
+  g_assert (!g_file_test (index_filename, G_FILE_TEST_EXISTS));
+
+  g_free (index_filename);
+  remove_tree (tree_dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gchar *cache_dir;
+  gint result;
+
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
+  tmp_dir = g_build_filename (g_get_tmp_dir (), "searchengine-XXXXXX", NULL);
+  g_assert (mkdtemp (tmp_dir) != NULL);
+  tree_dir = g_build_filename (tmp_dir, "tree", NULL);
+
+  /* Keep the index out of the real cache directory */
+  cache_dir = g_build_filename (tmp_dir, "cache", NULL);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  gtk_test_init (&argc, &argv);
+
+  g_test_add_func ("/search-engine/simple/matching", test_matching);
+  g_test_add_func ("/search-engine/simple/parallel-walk", test_parallel_walk);
+  g_test_add_func ("/search-engine/simple/index", test_index);
+
+  result = g_test_run ();
+
+  remove_tree (tmp_dir);
+  g_free (cache_dir);
+  g_free (tree_dir);
+  g_free (tmp_dir);
+
+  return result;
+}
@@ -1,5 +1,11 @@
 #include <gtk/gtk.h>
 
+/* From gtkstylecontextprivate.h */
+const GValue * _gtk_style_context_peek_style_property (GtkStyleContext *context,
+                                                       GType            widget_type,
+                                                       GtkStateFlags    state,
+                                                       GParamSpec      *pspec);
+
 static void
 test_parse_empty (void)
 {
@@ -479,6 +485,75 @@ test_match (void)
   g_object_unref (context);
 }
 
+static void
+test_match_many_rules (void)
+{
+  GtkStyleContext *context;
+  GtkWidgetPath *path;
+  GtkCssProvider *provider;
+  GError *error;
+  GString *data;
+  GdkRGBA *color;
+  GdkRGBA expected;
+  gint i;
+
+  error = NULL;
+  provider = gtk_css_provider_new ();
+
+  gdk_rgba_parse (&expected, "#fff");
+
+  context = gtk_style_context_new ();
+
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_WINDOW);
+  gtk_widget_path_append_type (path, GTK_TYPE_BOX);
+  gtk_widget_path_append_type (path, GTK_TYPE_BUTTON);
+  gtk_widget_path_iter_set_name (path, 0, "mywindow");
+  gtk_widget_path_iter_add_class (path, 2, "button");
+  gtk_style_context_set_path (context, path);
+  gtk_widget_path_free (path);
+
+  gtk_style_context_add_provider (context,
+                                  GTK_STYLE_PROVIDER (provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  /* Lots of rules that don't apply, mixed with
+   * some that do, all with the same specificity.
+   */
+  data = g_string_new ("GtkButton { color: #f00 }\n");
+
+  for (i = 0; i < 500; i++)
+    {
+      g_string_append_printf (data, ".other%d { color: #f00 }\n", i);
+      g_string_append_printf (data, "#other%d { color: #f00 }\n", i);
+      g_string_append_printf (data, "GtkLabel { color: #f00 }\n");
+
+      if (i == 250)
+        g_string_append (data, "GtkButton { color: #000 }\n");
+    }
+
+  g_string_append (data, "GtkButton { color: #fff }\n");
+
+  gtk_css_provider_load_from_data (provider, data->str, -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_invalidate (context);
+  gtk_style_context_get (context, 0, "color", &color, NULL);
+  g_assert (gdk_rgba_equal (color, &expected));
+  gdk_rgba_free (color);
+
+  /* Reloading must drop the previous rules */
+  gtk_css_provider_load_from_data (provider, ".other1 { color: #f00 }", -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_invalidate (context);
+  gtk_style_context_get (context, 0, "color", &color, NULL);
+  g_assert (!gdk_rgba_equal (color, &expected));
+  gdk_rgba_free (color);
+
+  g_string_free (data, TRUE);
+  g_object_unref (provider);
+  g_object_unref (context);
+}
+
 static void
 test_style_property (void)
 {
@@ -567,6 +642,178 @@ test_basic_properties (void)
   g_object_unref (context);
 }
 
+static void
+test_resolved_colors (void)
+{
+  GtkStyleContext *context;
+  GtkWidgetPath *path;
+  GtkCssProvider *provider;
+  GError *error;
+  GdkRGBA color, expected;
+
+  error = NULL;
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "@define-color fg #fff;\n"
+                                   "GtkButton { color: @fg }\n"
+                                   "GtkButton:hover { color: #000 }",
+                                   -1, &error);
+  g_assert_no_error (error);
+
+  context = gtk_style_context_new ();
+
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_BUTTON);
+  gtk_style_context_set_path (context, path);
+  gtk_widget_path_free (path);
+
+  gtk_style_context_add_provider (context,
+                                  GTK_STYLE_PROVIDER (provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  /* Resolved values are kept per state, make sure
+   * each state gets the value that applies to it.
+   */
+  gdk_rgba_parse (&expected, "#fff");
+  gtk_style_context_get_color (context, 0, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+
+  gdk_rgba_parse (&expected, "#000");
+  gtk_style_context_get_color (context, GTK_STATE_FLAG_PRELIGHT, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+
+  gdk_rgba_parse (&expected, "#fff");
+  gtk_style_context_get_color (context, 0, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+
+  /* And that they're dropped when the style changes */
+  gtk_css_provider_load_from_data (provider,
+                                   "GtkButton { color: #000 }",
+                                   -1, &error);
+  g_assert_no_error (error);
+  gtk_style_context_invalidate (context);
+
+  gdk_rgba_parse (&expected, "#000");
+  gtk_style_context_get_color (context, 0, &color);
+  g_assert (gdk_rgba_equal (&color, &expected));
+
+  g_object_unref (provider);
+  g_object_unref (context);
+}
+
+static GtkStyleContext *
+create_button_context (void)
+{
+  GtkStyleContext *context;
+  GtkWidgetPath *path;
+
+  context = gtk_style_context_new ();
+
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_WINDOW);
+  gtk_widget_path_append_type (path, GTK_TYPE_BUTTON);
+  gtk_style_context_set_path (context, path);
+  gtk_widget_path_free (path);
+
+  return context;
+}
+
+/* Style properties are cached in the resolved style, so contexts
+ * sharing it get the very same value back
+ */
+static const GValue *
+peek_focus_line_width (GtkStyleContext *context)
+{
+  GtkWidgetClass *klass;
+  GParamSpec *pspec;
+  const GValue *value;
+
+  klass = g_type_class_ref (GTK_TYPE_BUTTON);
+  pspec = gtk_widget_class_find_style_property (klass, "focus-line-width");
+  value = _gtk_style_context_peek_style_property (context, GTK_TYPE_BUTTON, 0, pspec);
+  g_type_class_unref (klass);
+
+  return value;
+}
+
+static void
+test_shared_style (void)
+{
+  GtkStyleContext *context1, *context2, *context3;
+  GtkCssProvider *provider;
+  GError *error;
+  GdkRGBA *color;
+  GdkRGBA expected;
+
+  error = NULL;
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_data (provider,
+                                   "GtkWindow GtkButton { color: #fff }",
+                                   -1, &error);
+  g_assert_no_error (error);
+
+  gtk_style_context_add_provider_for_screen (gdk_screen_get_default (),
+                                             GTK_STYLE_PROVIDER (provider),
+                                             GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  context1 = create_button_context ();
+  context2 = create_button_context ();
+
+  gdk_rgba_parse (&expected, "#fff");
+
+  gtk_style_context_get (context1, 0, "color", &color, NULL);
+  g_assert (gdk_rgba_equal (color, &expected));
+  gdk_rgba_free (color);
+
+  gtk_style_context_get (context2, 0, "color", &color, NULL);
+  g_assert (gdk_rgba_equal (color, &expected));
+  gdk_rgba_free (color);
+
+  /* The two contexts share the resolved style */
+  g_assert (peek_focus_line_width (context1) != NULL);
+  g_assert (peek_focus_line_width (context1) == peek_focus_line_width (context2));
+
+  /* ... which outlives either of them */
+  context3 = create_button_context ();
+  g_object_unref (context2);
+  context2 = create_button_context ();
+  g_assert (peek_focus_line_width (context1) == peek_focus_line_width (context2));
+  g_assert (peek_focus_line_width (context1) == peek_focus_line_width (context3));
+  g_object_unref (context3);
+
+  /* Reloading the provider must not leave stale shared styles behind */
+  gtk_css_provider_load_from_data (provider,
+                                   "GtkWindow GtkButton { color: #000 }",
+                                   -1, &error);
+  g_assert_no_error (error);
+  gdk_rgba_parse (&expected, "#000");
+
+  gtk_style_context_invalidate (context1);
+  gtk_style_context_get (context1, 0, "color", &color, NULL);
+  g_assert (gdk_rgba_equal (color, &expected));
+  gdk_rgba_free (color);
+  g_assert (peek_focus_line_width (context1) != peek_focus_line_width (context2));
+
+  gtk_style_context_invalidate (context2);
+  g_assert (peek_focus_line_width (context1) == peek_focus_line_width (context2));
+
+  /* Contexts with their own providers get their own styles */
+  gtk_style_context_add_provider (context2,
+                                  GTK_STYLE_PROVIDER (provider),
+                                  GTK_STYLE_PROVIDER_PRIORITY_FALLBACK);
+  gtk_style_context_get (context2, 0, "color", &color, NULL);
+  g_assert (gdk_rgba_equal (color, &expected));
+  gdk_rgba_free (color);
+  g_assert (peek_focus_line_width (context1) != peek_focus_line_width (context2));
+
+  gtk_style_context_remove_provider_for_screen (gdk_screen_get_default (),
+                                                GTK_STYLE_PROVIDER (provider));
+
+  g_object_unref (context1);
+  g_object_unref (context2);
+  g_object_unref (provider);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -579,8 +826,11 @@ main (int argc, char *argv[])
   g_test_add_func ("/style/parse/declarations", test_parse_declarations);
   g_test_add_func ("/style/path", test_path);
   g_test_add_func ("/style/match", test_match);
+  g_test_add_func ("/style/match/many-rules", test_match_many_rules);
   g_test_add_func ("/style/style-property", test_style_property);
   g_test_add_func ("/style/basic", test_basic_properties);
+  g_test_add_func ("/style/resolved-colors", test_resolved_colors);
+  g_test_add_func ("/style/shared", test_shared_style);
 
   return g_test_run ();
 }
@@ -0,0 +1,438 @@
+/* GtkTextLayout line display cache and line measuring tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#define GTK_TEXT_USE_INTERNAL_UNSUPPORTED_API
+#include <gtk/gtk.h>
+#include "gtk/gtktextlayout.h"
+
+#define N_LINES 100
+
+typedef struct
+{
+  GtkWidget *widget;
+  GtkTextBuffer *buffer;
+  GtkTextLayout *layout;
+  GSList *lines;
+} Fixture;
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  data)
+{
+  GtkTextAttributes *style;
+  PangoContext *ltr_context, *rtl_context;
+  GString *text;
+  gint i;
+
+  fixture->widget = gtk_text_view_new ();
+  g_object_ref_sink (fixture->widget);
+
+  text = g_string_new (NULL);
+  for (i = 0; i < N_LINES; i++)
+    g_string_append_printf (text, "line %d\n", i);
+
+  fixture->buffer = gtk_text_buffer_new (NULL);
+  gtk_text_buffer_set_text (fixture->buffer, text->str, -1);
+  g_string_free (text, TRUE);
+
+  fixture->layout = gtk_text_layout_new ();
+  gtk_text_layout_set_buffer (fixture->layout, fixture->buffer);
+
+  ltr_context = gtk_widget_create_pango_context (fixture->widget);
+  pango_context_set_base_dir (ltr_context, PANGO_DIRECTION_LTR);
+  rtl_context = gtk_widget_create_pango_context (fixture->widget);
+  pango_context_set_base_dir (rtl_context, PANGO_DIRECTION_RTL);
+  gtk_text_layout_set_contexts (fixture->layout, ltr_context, rtl_context);
+  g_object_unref (ltr_context);
+  g_object_unref (rtl_context);
+
+  style = gtk_text_attributes_new ();
+  gtk_text_layout_set_default_style (fixture->layout, style);
+  gtk_text_attributes_unref (style);
+
+  gtk_text_layout_set_screen_width (fixture->layout, 400);
+  gtk_text_layout_validate (fixture->layout, G_MAXINT);
+
+  fixture->lines = gtk_text_layout_get_lines (fixture->layout, 0, G_MAXINT, NULL);
+  g_assert_cmpint (g_slist_length (fixture->lines), >=, N_LINES);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  data)
+{
+  g_slist_free (fixture->lines);
+  g_object_unref (fixture->layout);
+  g_object_unref (fixture->buffer);
+  g_object_unref (fixture->widget);
+}
+
+static GtkTextLine *
+get_line (Fixture *fixture,
+          gint     n)
+{
+  return g_slist_nth_data (fixture->lines, n);
+}
+
+/* Fetches a display for line @n and returns whether it
+ * was found in the line display cache.
+ */
+static gboolean
+fetch_line (Fixture  *fixture,
+            gint      n,
+            gboolean  size_only)
+{
+  GtkTextLineDisplay *display;
+  guint hits, new_hits;
+
+  gtk_text_layout_get_line_display_cache_stats (fixture->layout, &hits, NULL, NULL);
+
+  display = gtk_text_layout_get_line_display (fixture->layout,
+                                              get_line (fixture, n),
+                                              size_only);
+  g_assert (display != NULL);
+  g_assert (display->line == get_line (fixture, n));
+  g_assert (display->size_only == size_only || !display->size_only);
+  gtk_text_layout_free_line_display (fixture->layout, display);
+
+  gtk_text_layout_get_line_display_cache_stats (fixture->layout, &new_hits, NULL, NULL);
+
+  return new_hits > hits;
+}
+
+static void
+test_hit (Fixture       *fixture,
+          gconstpointer  data)
+{
+  gint i;
+
+  for (i = 0; i < 10; i++)
+    g_assert (!fetch_line (fixture, i, FALSE));
+
+  /* More than the most recently used line is kept */
+  for (i = 0; i < 10; i++)
+    g_assert (fetch_line (fixture, i, FALSE));
+
+  /* A full display satisfies a size-only request */
+  g_assert (fetch_line (fixture, 5, TRUE));
+}
+
+static void
+test_invalidate_on_edit (Fixture       *fixture,
+                         gconstpointer  data)
+{
+  GtkTextIter iter;
+  gint i;
+
+  for (i = 0; i < 10; i++)
+    fetch_line (fixture, i, FALSE);
+
+  gtk_text_buffer_get_iter_at_line (fixture->buffer, &iter, 5);
+  gtk_text_buffer_insert (fixture->buffer, &iter, "edited ", -1);
+
+  /* Only the edited line is dropped */
+  g_assert (!fetch_line (fixture, 5, FALSE));
+  g_assert (fetch_line (fixture, 4, FALSE));
+  g_assert (fetch_line (fixture, 6, FALSE));
+
+  /* Revalidating the edited line keeps the other displays */
+  gtk_text_layout_validate (fixture->layout, G_MAXINT);
+  g_assert (fetch_line (fixture, 2, FALSE));
+  g_assert (fetch_line (fixture, 8, FALSE));
+}
+
+static void
+test_eviction (Fixture       *fixture,
+               gconstpointer  data)
+{
+  gsize size;
+  gint i;
+
+  for (i = 0; i < 5; i++)
+    fetch_line (fixture, i, FALSE);
+
+  gtk_text_layout_get_line_display_cache_stats (fixture->layout, NULL, NULL, &size);
+  gtk_text_layout_set_line_display_cache_size (fixture->layout, size);
+
+  /* Size-only displays have their own budget, and don't evict
+   * the displays of the lines being drawn.
+   */
+  for (i = 10; i < N_LINES; i++)
+    fetch_line (fixture, i, TRUE);
+
+  for (i = 0; i < 5; i++)
+    g_assert (fetch_line (fixture, i, FALSE));
+
+  /* Going over the budget drops the least recently used line */
+  g_assert (!fetch_line (fixture, 5, FALSE));
+  g_assert (!fetch_line (fixture, 0, FALSE));
+  g_assert (fetch_line (fixture, 5, FALSE));
+
+  /* The most recently used display is always kept */
+  gtk_text_layout_set_line_display_cache_size (fixture->layout, 0);
+  g_assert (fetch_line (fixture, 5, FALSE));
+  g_assert (!fetch_line (fixture, 4, FALSE));
+  g_assert (!fetch_line (fixture, 5, FALSE));
+}
+
+/* Lines measured in worker threads */
+
+static GtkTextLayout *
+create_unvalidated_layout (Fixture *fixture)
+{
+  GtkTextLayout *layout;
+  GtkTextAttributes *style;
+  PangoContext *ltr_context, *rtl_context;
+
+  layout = gtk_text_layout_new ();
+  gtk_text_layout_set_buffer (layout, fixture->buffer);
+
+  ltr_context = gtk_widget_create_pango_context (fixture->widget);
+  pango_context_set_base_dir (ltr_context, PANGO_DIRECTION_LTR);
+  rtl_context = gtk_widget_create_pango_context (fixture->widget);
+  pango_context_set_base_dir (rtl_context, PANGO_DIRECTION_RTL);
+  gtk_text_layout_set_contexts (layout, ltr_context, rtl_context);
+  g_object_unref (ltr_context);
+  g_object_unref (rtl_context);
+
+  style = gtk_text_attributes_new ();
+  gtk_text_layout_set_default_style (layout, style);
+  gtk_text_attributes_unref (style);
+
+  gtk_text_layout_set_screen_width (layout, 400);
+
+  return layout;
+}
+
+static void
+lines_measured (GtkTextLayout *layout,
+                gpointer       data)
+{
+  gboolean *done = data;
+
+  *done = TRUE;
+}
+
+static gboolean
+measure_timeout (gpointer data)
+{
+  g_assert_not_reached ();
+
+  return FALSE;
+}
+
+static void
+wait_for_measured_lines (gboolean *done)
+{
+  guint timeout;
+
+  timeout = g_timeout_add_seconds (10, measure_timeout, NULL);
+
+  while (!*done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_source_remove (timeout);
+}
+
+/* Validates @layout with the worker threads where possible */
+static void
+measure_layout (GtkTextLayout *layout)
+{
+  while (!gtk_text_layout_is_valid (layout))
+    {
+      gboolean done = FALSE;
+
+      if (_gtk_text_layout_measure_lines (layout, G_MAXINT,
+                                          lines_measured, &done))
+        wait_for_measured_lines (&done);
+      else
+        gtk_text_layout_validate (layout, 1);
+    }
+}
+
+static void
+assert_same_sizes (GtkTextBuffer *buffer,
+                   GtkTextLayout *layout,
+                   GtkTextLayout *measured)
+{
+  GtkTextIter iter;
+  gint width, height, measured_width, measured_height;
+
+  gtk_text_layout_get_size (layout, &width, &height);
+  gtk_text_layout_get_size (measured, &measured_width, &measured_height);
+  g_assert_cmpint (width, ==, measured_width);
+  g_assert_cmpint (height, ==, measured_height);
+
+  gtk_text_buffer_get_start_iter (buffer, &iter);
+  do
+    {
+      gint y, measured_y;
+
+      gtk_text_layout_get_line_yrange (layout, &iter, &y, &height);
+      gtk_text_layout_get_line_yrange (measured, &iter, &measured_y, &measured_height);
+      g_assert_cmpint (y, ==, measured_y);
+      g_assert_cmpint (height, ==, measured_height);
+    }
+  while (gtk_text_iter_forward_line (&iter));
+}
+
+static void
+add_varied_lines (Fixture *fixture)
+{
+  GtkTextTag *tag;
+  GtkTextIter start, end;
+  gint i;
+
+  /* Lines that wrap, and lines with a bigger font */
+  for (i = 0; i < N_LINES; i += 7)
+    {
+      gtk_text_buffer_get_iter_at_line (fixture->buffer, &start, i);
+      gtk_text_buffer_insert (fixture->buffer, &start,
+                              "a line long enough to be wrapped more than once "
+                              "at the width of four hundred pixels that the "
+                              "layouts of this test use ", -1);
+    }
+
+  tag = gtk_text_buffer_create_tag (fixture->buffer, NULL,
+                                    "scale", PANGO_SCALE_XX_LARGE,
+                                    "pixels-above-lines", 3,
+                                    NULL);
+  gtk_text_buffer_get_iter_at_line (fixture->buffer, &start, 10);
+  gtk_text_buffer_get_iter_at_line (fixture->buffer, &end, 20);
+  gtk_text_buffer_apply_tag (fixture->buffer, tag, &start, &end);
+
+  gtk_text_layout_validate (fixture->layout, G_MAXINT);
+}
+
+static void
+test_measure_sizes (Fixture       *fixture,
+                    gconstpointer  data)
+{
+  GtkTextLayout *measured;
+
+  add_varied_lines (fixture);
+
+  measured = create_unvalidated_layout (fixture);
+  measure_layout (measured);
+
+  assert_same_sizes (fixture->buffer, fixture->layout, measured);
+
+  g_object_unref (measured);
+}
+
+static void
+test_measure_edited (Fixture       *fixture,
+                     gconstpointer  data)
+{
+  GtkTextLayout *measured;
+  GtkTextIter start, end;
+  gboolean done = FALSE;
+
+  add_varied_lines (fixture);
+
+  measured = create_unvalidated_layout (fixture);
+
+  g_assert (_gtk_text_layout_measure_lines (measured, G_MAXINT,
+                                            lines_measured, &done));
+
+  /* Change and delete lines while they are being measured, the
+   * results for them must not be stored.
+   */
+  gtk_text_buffer_get_iter_at_line (fixture->buffer, &start, 5);
+  gtk_text_buffer_insert (fixture->buffer, &start,
+                          "text making the fifth line wrap at the width of "
+                          "the layouts used in this test, which is four "
+                          "hundred pixels ", -1);
+  gtk_text_buffer_get_iter_at_line (fixture->buffer, &start, 30);
+  gtk_text_buffer_get_iter_at_line (fixture->buffer, &end, 40);
+  gtk_text_buffer_delete (fixture->buffer, &start, &end);
+
+  wait_for_measured_lines (&done);
+  g_assert (!gtk_text_layout_is_valid (measured));
+
+  measure_layout (measured);
+  gtk_text_layout_validate (fixture->layout, G_MAXINT);
+
+  assert_same_sizes (fixture->buffer, fixture->layout, measured);
+
+  g_object_unref (measured);
+}
+
+static void
+test_measure_cancel (Fixture       *fixture,
+                     gconstpointer  data)
+{
+  GtkTextLayout *measured;
+  gboolean done = FALSE;
+
+  measured = create_unvalidated_layout (fixture);
+
+  g_assert (_gtk_text_layout_measure_lines (measured, G_MAXINT,
+                                            lines_measured, &done));
+  _gtk_text_layout_cancel_measure (measured);
+
+  /* The lines are still measured, but nothing is stored */
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+  g_usleep (G_USEC_PER_SEC / 10);
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  g_assert (!done);
+  g_assert (!gtk_text_layout_is_valid (measured));
+
+  /* Finalizing a layout whose lines are being measured */
+  g_assert (_gtk_text_layout_measure_lines (measured, G_MAXINT,
+                                            lines_measured, &done));
+  g_object_unref (measured);
+
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+  g_usleep (G_USEC_PER_SEC / 10);
+  while (g_main_context_pending (NULL))
+    g_main_context_iteration (NULL, FALSE);
+
+  g_assert (!done);
+}
+
+int
+main (int argc, char **argv)
+{
+  /* The measure-lines tests need the worker threads */
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
+  gtk_test_init (&argc, &argv);
+
+  g_test_add ("/TextLayout/display-cache/hit", Fixture, NULL,
+              fixture_setup, test_hit, fixture_teardown);
+  g_test_add ("/TextLayout/display-cache/invalidate-on-edit", Fixture, NULL,
+              fixture_setup, test_invalidate_on_edit, fixture_teardown);
+  g_test_add ("/TextLayout/display-cache/eviction", Fixture, NULL,
+              fixture_setup, test_eviction, fixture_teardown);
+  g_test_add ("/TextLayout/measure-lines/sizes", Fixture, NULL,
+              fixture_setup, test_measure_sizes, fixture_teardown);
+  g_test_add ("/TextLayout/measure-lines/edited", Fixture, NULL,
+              fixture_setup, test_measure_edited, fixture_teardown);
+  g_test_add ("/TextLayout/measure-lines/cancel", Fixture, NULL,
+              fixture_setup, test_measure_cancel, fixture_teardown);
+
+  return g_test_run ();
+}
@@ -0,0 +1,188 @@
+/* Timeline scheduler tests.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+#include "gtk/gtktimeline.h"
+
+static gboolean
+quit_loop (gpointer data)
+{
+  g_main_loop_quit (data);
+
+  return FALSE;
+}
+
+static void
+run_main_loop (guint msecs)
+{
+  GMainLoop *loop;
+
+  loop = g_main_loop_new (NULL, FALSE);
+  g_timeout_add (msecs, quit_loop, loop);
+  g_main_loop_run (loop);
+  g_main_loop_unref (loop);
+}
+
+static void
+count_frame (GtkTimeline *timeline,
+             gdouble      progress,
+             gint        *n_frames)
+{
+  (*n_frames)++;
+}
+
+static gboolean
+set_timed_out (gpointer data)
+{
+  *(gboolean *) data = TRUE;
+
+  return FALSE;
+}
+
+/* Runs the main loop until the scheduler driving @timeline has
+ * ticked @n_ticks more times. The timeout is only there to not
+ * hang when it doesn't, so it is generous.
+ */
+static gboolean
+wait_for_ticks (GtkTimeline *timeline,
+                guint        n_ticks)
+{
+  gboolean timed_out = FALSE;
+  guint target, id;
+
+  target = _gtk_timeline_get_n_ticks (timeline) + n_ticks;
+  id = g_timeout_add (10000, set_timed_out, &timed_out);
+
+  while (_gtk_timeline_get_n_ticks (timeline) < target && !timed_out)
+    g_main_context_iteration (NULL, TRUE);
+
+  if (!timed_out)
+    g_source_remove (id);
+
+  return !timed_out;
+}
+
+static void
+test_shared_tick (void)
+{
+  GtkTimeline *timeline1, *timeline2;
+  gint n_frames1 = 0, n_frames2 = 0;
+
+  timeline1 = _gtk_timeline_new (10000);
+  timeline2 = _gtk_timeline_new (10000);
+  _gtk_timeline_set_fps (timeline2, 10);
+
+  g_signal_connect (timeline1, "frame", G_CALLBACK (count_frame), &n_frames1);
+  g_signal_connect (timeline2, "frame", G_CALLBACK (count_frame), &n_frames2);
+
+  _gtk_timeline_start (timeline1);
+  _gtk_timeline_start (timeline2);
+  g_assert (_gtk_timeline_is_running (timeline1));
+  g_assert (_gtk_timeline_is_running (timeline2));
+
+  /* Both run at the highest frame rate, in the same tick */
+  g_assert (wait_for_ticks (timeline1, 5));
+  g_assert_cmpint (n_frames1, ==, 5);
+  g_assert_cmpint (n_frames1, ==, n_frames2);
+
+  _gtk_timeline_pause (timeline1);
+  g_assert (!_gtk_timeline_is_running (timeline1));
+  n_frames1 = 0;
+
+  g_assert (wait_for_ticks (timeline2, 2));
+  g_assert_cmpint (n_frames1, ==, 0);
+  g_assert (_gtk_timeline_get_progress (timeline2) > 0.0);
+
+  g_object_unref (timeline1);
+  g_object_unref (timeline2);
+}
+
+static void
+test_frozen_window (void)
+{
+  GtkWidget *window;
+  GtkTimeline *timeline;
+  gint n_frames = 0;
+  guint n_ticks;
+  gdouble progress;
+
+  window = gtk_offscreen_window_new ();
+  gtk_widget_realize (window);
+
+  timeline = _gtk_timeline_new (2000);
+  _gtk_timeline_set_window (timeline, gtk_widget_get_window (window));
+  g_signal_connect (timeline, "frame", G_CALLBACK (count_frame), &n_frames);
+  _gtk_timeline_start (timeline);
+
+  /* The window is not viewable, so the timeline doesn't advance,
+   * and no more ticks are scheduled after it notices.
+   */
+  g_assert (wait_for_ticks (timeline, 1));
+  g_assert (_gtk_timeline_is_running (timeline));
+  g_assert_cmpint (n_frames, ==, 0);
+  g_assert_cmpfloat (_gtk_timeline_get_progress (timeline), ==, 0.0);
+
+  n_ticks = _gtk_timeline_get_n_ticks (timeline);
+  run_main_loop (300);
+  g_assert_cmpuint (_gtk_timeline_get_n_ticks (timeline), ==, n_ticks);
+
+  /* Mapping the window lets it go on, without counting the
+   * time it was frozen.
+   */
+  gtk_widget_show (window);
+  g_assert (wait_for_ticks (timeline, 2));
+  g_assert_cmpint (n_frames, >, 0);
+  progress = _gtk_timeline_get_progress (timeline);
+  g_assert_cmpfloat (progress, >, 0.0);
+  g_assert_cmpfloat (progress, <, 0.15);
+
+  /* And hiding it freezes it again, keeping the progress */
+  gtk_widget_hide (window);
+  g_assert (wait_for_ticks (timeline, 1));
+  progress = _gtk_timeline_get_progress (timeline);
+  n_ticks = _gtk_timeline_get_n_ticks (timeline);
+  n_frames = 0;
+
+  run_main_loop (500);
+  g_assert_cmpuint (_gtk_timeline_get_n_ticks (timeline), ==, n_ticks);
+  g_assert_cmpint (n_frames, ==, 0);
+  g_assert_cmpfloat (_gtk_timeline_get_progress (timeline), ==, progress);
+
+  /* Time spent hidden doesn't count */
+  gtk_widget_show (window);
+  g_assert (wait_for_ticks (timeline, 2));
+  g_assert_cmpint (n_frames, >, 0);
+  g_assert_cmpfloat (_gtk_timeline_get_progress (timeline), >, progress);
+  g_assert_cmpfloat (_gtk_timeline_get_progress (timeline), <, progress + 0.25);
+
+  g_object_unref (timeline);
+  gtk_widget_destroy (window);
+}
+
+int
+main (int argc, char **argv)
+{
+  gtk_test_init (&argc, &argv);
+
+  g_object_set (gtk_settings_get_default (), "gtk-enable-animations", TRUE, NULL);
+
+  g_test_add_func ("/timeline/shared-tick", test_shared_tick);
+  g_test_add_func ("/timeline/frozen-window", test_frozen_window);
+
+  return g_test_run ();
+}
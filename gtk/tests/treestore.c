@@ -998,6 +998,150 @@ tree_store_test_iter_parent_invalid (TreeStore     *fixture,
   g_assert (iter.stamp == 0);
 }
 
+/* sorting */
+static const gchar *sort_strings[] = {
+  "walnut", "Apple", "cherry", NULL, "banana", "apple", "Date", "fig", "", "cherry"
+};
+
+static GtkTreeStore *
+create_sort_store (void)
+{
+  GtkTreeStore *store;
+  GtkTreeIter iter, child;
+  int i, j;
+
+  store = gtk_tree_store_new (3, G_TYPE_STRING, G_TYPE_INT, G_TYPE_DOUBLE);
+
+  for (i = 0; i < G_N_ELEMENTS (sort_strings); i++)
+    {
+      gtk_tree_store_insert_with_values (store, &iter, NULL, -1,
+                                         0, sort_strings[i],
+                                         1, (i * 7) % 5 - 2,
+                                         2, 1.0 / (i + 1),
+                                         -1);
+
+      for (j = 0; j < 4; j++)
+        gtk_tree_store_insert_with_values (store, &child, &iter, -1,
+                                           0, sort_strings[(i + j) % G_N_ELEMENTS (sort_strings)],
+                                           1, j * i - 3 * j,
+                                           2, (gdouble) -j,
+                                           -1);
+    }
+
+  return store;
+}
+
+static gint
+compare_rows (GtkTreeModel *model,
+              GtkTreeIter  *a,
+              GtkTreeIter  *b,
+              gint          column)
+{
+  gint retval;
+
+  if (column == 0)
+    {
+      gchar *str_a, *str_b;
+
+      gtk_tree_model_get (model, a, 0, &str_a, -1);
+      gtk_tree_model_get (model, b, 0, &str_b, -1);
+      retval = g_utf8_collate (str_a ? str_a : "", str_b ? str_b : "");
+      g_free (str_a);
+      g_free (str_b);
+    }
+  else if (column == 1)
+    {
+      gint int_a, int_b;
+
+      gtk_tree_model_get (model, a, 1, &int_a, -1);
+      gtk_tree_model_get (model, b, 1, &int_b, -1);
+      retval = (int_a > int_b) - (int_a < int_b);
+    }
+  else
+    {
+      gdouble double_a, double_b;
+
+      gtk_tree_model_get (model, a, 2, &double_a, -1);
+      gtk_tree_model_get (model, b, 2, &double_b, -1);
+      retval = (double_a > double_b) - (double_a < double_b);
+    }
+
+  return retval;
+}
+
+static void
+check_sorted (GtkTreeModel *model,
+              GtkTreeIter  *parent,
+              gint          column,
+              GtkSortType   order)
+{
+  GtkTreeIter iter, prev, child;
+  gint n = 0;
+
+  if (!gtk_tree_model_iter_children (model, &iter, parent))
+    return;
+
+  do
+    {
+      if (n > 0)
+        {
+          gint retval = compare_rows (model, &prev, &iter, column);
+
+          if (order == GTK_SORT_ASCENDING)
+            g_assert_cmpint (retval, <=, 0);
+          else
+            g_assert_cmpint (retval, >=, 0);
+        }
+
+      if (gtk_tree_model_iter_children (model, &child, &iter))
+        check_sorted (model, &iter, column, order);
+
+      prev = iter;
+      n++;
+    }
+  while (gtk_tree_model_iter_next (model, &iter));
+
+  g_assert_cmpint (n, ==, gtk_tree_model_iter_n_children (model, parent));
+}
+
+static void
+tree_store_test_sort_column (void)
+{
+  GtkTreeStore *store;
+  GtkTreeModel *sort_model;
+  gint column;
+
+  for (column = 0; column < 3; column++)
+    {
+      store = create_sort_store ();
+
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store),
+                                            column, GTK_SORT_ASCENDING);
+      check_sorted (GTK_TREE_MODEL (store), NULL, column, GTK_SORT_ASCENDING);
+
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (store),
+                                            column, GTK_SORT_DESCENDING);
+      check_sorted (GTK_TREE_MODEL (store), NULL, column, GTK_SORT_DESCENDING);
+
+      g_object_unref (store);
+
+      /* And the same through a GtkTreeModelSort */
+      store = create_sort_store ();
+      sort_model = gtk_tree_model_sort_new_with_model (GTK_TREE_MODEL (store));
+
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                            column, GTK_SORT_ASCENDING);
+      check_sorted (sort_model, NULL, column, GTK_SORT_ASCENDING);
+
+      gtk_tree_sortable_set_sort_column_id (GTK_TREE_SORTABLE (sort_model),
+                                            column, GTK_SORT_DESCENDING);
+      check_sorted (sort_model, NULL, column, GTK_SORT_DESCENDING);
+
+      g_object_unref (sort_model);
+      g_object_unref (store);
+    }
+}
+
 
 /* main */
 
@@ -1124,5 +1268,9 @@ main (int    argc,
               tree_store_setup, tree_store_test_iter_parent_invalid,
               tree_store_teardown);
 
+  /* sorting */
+  g_test_add_func ("/tree-store/sort-column",
+                   tree_store_test_sort_column);
+
   return g_test_run ();
 }
@@ -0,0 +1,458 @@
+/* GtkTreeView and GtkContainer accessibility tests
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include <gtk/gtk.h>
+#include <stdlib.h>
+
+#define N_ROWS 20
+
+/* The number of cells GailTreeView keeps around */
+#define CELL_CACHE_SIZE 256
+
+typedef struct
+{
+  GtkWidget *window;
+  GtkWidget *view;
+  GtkListStore *store;
+  AtkObject *accessible;
+} Fixture;
+
+static void
+fixture_setup (Fixture       *fixture,
+               gconstpointer  data)
+{
+  gint n_rows = data ? GPOINTER_TO_INT (data) : N_ROWS;
+  gint i;
+
+  fixture->store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < n_rows; i++)
+    {
+      gchar *text = g_strdup_printf ("row %d", i);
+
+      gtk_list_store_insert_with_values (fixture->store, NULL, i, 0, text, -1);
+      g_free (text);
+    }
+
+  fixture->view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (fixture->store));
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (fixture->view), 0,
+                                               "Text", gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+
+  fixture->window = gtk_offscreen_window_new ();
+  gtk_container_add (GTK_CONTAINER (fixture->window), fixture->view);
+  gtk_widget_show_all (fixture->window);
+
+  fixture->accessible = gtk_widget_get_accessible (fixture->view);
+}
+
+static void
+fixture_teardown (Fixture       *fixture,
+                  gconstpointer  data)
+{
+  gtk_widget_destroy (fixture->window);
+  g_object_unref (fixture->store);
+}
+
+static gboolean
+have_gail (Fixture *fixture)
+{
+  if (g_strcmp0 (G_OBJECT_TYPE_NAME (fixture->accessible), "GailTreeView") == 0)
+    return TRUE;
+
+  g_test_message ("The gail module is not loaded, skipping");
+
+  return FALSE;
+}
+
+static gchar *
+get_row_text (Fixture *fixture,
+              gint     row)
+{
+  GtkTreeIter iter;
+  gchar *text;
+
+  g_assert (gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store),
+                                           &iter, NULL, row));
+  gtk_tree_model_get (GTK_TREE_MODEL (fixture->store), &iter, 0, &text, -1);
+
+  return text;
+}
+
+static gint
+get_row_of_text (Fixture     *fixture,
+                 const gchar *text)
+{
+  gint row, n_rows;
+
+  n_rows = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (fixture->store), NULL);
+  for (row = 0; row < n_rows; row++)
+    {
+      gchar *row_text = get_row_text (fixture, row);
+      gboolean found = g_strcmp0 (row_text, text) == 0;
+
+      g_free (row_text);
+      if (found)
+        return row;
+    }
+
+  return -1;
+}
+
+static AtkObject *
+ref_cell (Fixture *fixture,
+          gint     row)
+{
+  AtkObject *cell;
+
+  cell = atk_object_ref_accessible_child (fixture->accessible,
+                                          atk_table_get_index_at (ATK_TABLE (fixture->accessible), row, 0));
+  g_assert (cell != NULL);
+
+  return cell;
+}
+
+static gchar *
+get_cell_text (AtkObject *cell)
+{
+  return atk_text_get_text (ATK_TEXT (cell), 0, -1);
+}
+
+/* Checks that every row has the right cell at the right index */
+static void
+check_cells (Fixture *fixture)
+{
+  AtkTable *table = ATK_TABLE (fixture->accessible);
+  gint row, n_rows;
+
+  n_rows = gtk_tree_model_iter_n_children (GTK_TREE_MODEL (fixture->store), NULL);
+  for (row = 0; row < n_rows; row++)
+    {
+      AtkObject *cell;
+      gchar *text, *cell_text;
+      gint index;
+
+      index = atk_table_get_index_at (table, row, 0);
+      g_assert_cmpint (atk_table_get_row_at_index (table, index), ==, row);
+
+      cell = atk_object_ref_accessible_child (fixture->accessible, index);
+      g_assert (cell != NULL);
+      g_assert_cmpint (atk_object_get_index_in_parent (cell), ==, index);
+
+      text = get_row_text (fixture, row);
+      cell_text = get_cell_text (cell);
+      g_assert_cmpstr (cell_text, ==, text);
+      g_free (cell_text);
+      g_free (text);
+
+      g_object_unref (cell);
+    }
+}
+
+/* Checks that the cells an AT is holding on to follow their rows */
+static void
+check_held_cells (Fixture    *fixture,
+                  GPtrArray  *cells,
+                  GPtrArray  *texts)
+{
+  AtkTable *table = ATK_TABLE (fixture->accessible);
+  guint i;
+
+  for (i = 0; i < cells->len; i++)
+    {
+      AtkObject *cell = g_ptr_array_index (cells, i);
+      AtkStateSet *states;
+      gboolean defunct;
+      gint row;
+
+      states = atk_object_ref_state_set (cell);
+      defunct = atk_state_set_contains_state (states, ATK_STATE_DEFUNCT);
+      g_object_unref (states);
+
+      row = get_row_of_text (fixture, g_ptr_array_index (texts, i));
+      if (row < 0)
+        {
+          /* Its row was deleted */
+          g_assert (defunct);
+          continue;
+        }
+
+      g_assert (!defunct);
+      g_assert_cmpint (atk_object_get_index_in_parent (cell), ==,
+                       atk_table_get_index_at (table, row, 0));
+    }
+}
+
+static void
+test_row_changes (Fixture       *fixture,
+                  gconstpointer  data)
+{
+  AtkTable *table;
+  GPtrArray *cells, *texts;
+  GtkTreeIter iter;
+  gint new_order[N_ROWS];
+  gint i;
+
+  if (!have_gail (fixture))
+    return;
+
+  table = ATK_TABLE (fixture->accessible);
+  cells = g_ptr_array_new_with_free_func (g_object_unref);
+  texts = g_ptr_array_new_with_free_func (g_free);
+
+  /* Hold on to some cells, like an AT following the cursor */
+  for (i = 0; i < 10; i++)
+    {
+      AtkObject *cell;
+
+      cell = atk_object_ref_accessible_child (fixture->accessible,
+                                              atk_table_get_index_at (table, i, 0));
+      g_ptr_array_add (cells, cell);
+      g_ptr_array_add (texts, get_cell_text (cell));
+    }
+
+  check_cells (fixture);
+
+  /* Inserting moves the cells below */
+  gtk_list_store_insert_with_values (fixture->store, NULL, 3, 0, "inserted", -1);
+  check_held_cells (fixture, cells, texts);
+  check_cells (fixture);
+  check_held_cells (fixture, cells, texts);
+
+  /* Deleting makes the cells of the row defunct and moves the rest */
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &iter, NULL, 0);
+  gtk_list_store_remove (fixture->store, &iter);
+  gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (fixture->store), &iter, NULL, 5);
+  gtk_list_store_remove (fixture->store, &iter);
+  check_held_cells (fixture, cells, texts);
+  check_cells (fixture);
+
+  /* Reordering moves them around */
+  for (i = 0; i < N_ROWS - 1; i++)
+    new_order[i] = N_ROWS - 2 - i;
+  gtk_list_store_reorder (fixture->store, new_order);
+  check_held_cells (fixture, cells, texts);
+  check_cells (fixture);
+  check_held_cells (fixture, cells, texts);
+
+  g_ptr_array_free (cells, TRUE);
+  g_ptr_array_free (texts, TRUE);
+}
+
+static void
+test_cell_cache (Fixture       *fixture,
+                 gconstpointer  data)
+{
+  AtkObject *first, *cell;
+  gint i;
+
+  if (!have_gail (fixture))
+    return;
+
+  first = ref_cell (fixture, 0);
+  g_object_add_weak_pointer (G_OBJECT (first), (gpointer *) &first);
+  g_object_unref (first);
+
+  /* Nobody holds on to the cell, but it is kept */
+  g_assert (first != NULL);
+  cell = ref_cell (fixture, 0);
+  g_assert (cell == first);
+  g_object_unref (cell);
+
+  /* Until enough other cells have been asked for */
+  for (i = 1; i < CELL_CACHE_SIZE; i++)
+    g_object_unref (ref_cell (fixture, i));
+  g_assert (first != NULL);
+
+  g_object_unref (ref_cell (fixture, CELL_CACHE_SIZE));
+  g_assert (first == NULL);
+}
+
+static void
+test_cell_cache_destroy (Fixture       *fixture,
+                         gconstpointer  data)
+{
+  AtkObject *cells[10];
+  guint i;
+
+  if (!have_gail (fixture))
+    return;
+
+  for (i = 0; i < G_N_ELEMENTS (cells); i++)
+    {
+      cells[i] = ref_cell (fixture, i);
+      g_object_add_weak_pointer (G_OBJECT (cells[i]), (gpointer *) &cells[i]);
+      g_object_unref (cells[i]);
+      g_assert (cells[i] != NULL);
+    }
+
+  /* The cached cells go away with the tree view */
+  gtk_widget_destroy (fixture->view);
+
+  for (i = 0; i < G_N_ELEMENTS (cells); i++)
+    g_assert (cells[i] == NULL);
+}
+
+static gboolean
+gail_loaded (void)
+{
+  if (g_type_from_name ("GailWidget") != 0)
+    return TRUE;
+
+  g_test_message ("The gail module is not loaded, skipping");
+
+  return FALSE;
+}
+
+static void
+count_children_changed (AtkObject *accessible,
+                        guint      index,
+                        gpointer   child,
+                        gint      *count)
+{
+  (*count)++;
+}
+
+static GtkWidget *
+create_box (gint *n_added)
+{
+  GtkWidget *box;
+
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  g_object_ref_sink (box);
+  g_signal_connect (gtk_widget_get_accessible (box), "children-changed::add",
+                    G_CALLBACK (count_children_changed), n_added);
+
+  return box;
+}
+
+static void
+test_container_children_changed (void)
+{
+  GtkWidget *box, *child;
+  gint n_added = 0;
+
+  if (!gail_loaded ())
+    return;
+
+  /* Nobody asked for the children, so nobody is told about new ones */
+  box = create_box (&n_added);
+  child = gtk_label_new ("one");
+  gtk_container_add (GTK_CONTAINER (box), child);
+  g_assert_cmpint (n_added, ==, 0);
+
+  /* Once the accessible of a child exists, they are */
+  gtk_widget_get_accessible (child);
+  gtk_container_add (GTK_CONTAINER (box), gtk_label_new ("two"));
+  g_assert_cmpint (n_added, ==, 1);
+  g_object_unref (box);
+
+  /* Likewise once the children have been asked for */
+  n_added = 0;
+  box = create_box (&n_added);
+  gtk_container_add (GTK_CONTAINER (box), gtk_label_new ("one"));
+  g_assert_cmpint (atk_object_get_n_accessible_children (gtk_widget_get_accessible (box)), ==, 1);
+  gtk_container_add (GTK_CONTAINER (box), gtk_label_new ("two"));
+  g_assert_cmpint (n_added, ==, 1);
+  g_object_unref (box);
+
+  /* Or if the accessible of a child was created before the container's */
+  n_added = 0;
+  box = gtk_box_new (GTK_ORIENTATION_VERTICAL, 0);
+  g_object_ref_sink (box);
+  child = gtk_label_new ("one");
+  gtk_container_add (GTK_CONTAINER (box), child);
+  gtk_widget_get_accessible (child);
+  g_signal_connect (gtk_widget_get_accessible (box), "children-changed::add",
+                    G_CALLBACK (count_children_changed), &n_added);
+  gtk_container_add (GTK_CONTAINER (box), gtk_label_new ("two"));
+  g_assert_cmpint (n_added, ==, 1);
+  g_object_unref (box);
+}
+
+static void
+add_spinners (GtkWidget *box,
+              gint       n)
+{
+  gint i;
+
+  for (i = 0; i < n; i++)
+    gtk_container_add (GTK_CONTAINER (box), gtk_spinner_new ());
+}
+
+/* GAIL_STATS prints the accessibles created when the program exits */
+static void
+test_container_stats (void)
+{
+  gchar *pattern;
+  gint n_added = 0;
+
+  if (!gail_loaded ())
+    return;
+
+  /* Spinners are not used by the other tests, so they are all ours */
+  if (g_test_trap_fork (0, G_TEST_TRAP_SILENCE_STDERR))
+    {
+      add_spinners (create_box (&n_added), 10);
+      exit (0);
+    }
+  g_test_trap_assert_passed ();
+  g_test_trap_assert_stderr ("*Accessibles for*");
+  g_test_trap_assert_stderr_unmatched ("*GtkSpinner*");
+
+  if (g_test_trap_fork (0, G_TEST_TRAP_SILENCE_STDERR))
+    {
+      GtkWidget *box = create_box (&n_added);
+
+      add_spinners (box, 10);
+      atk_object_get_n_accessible_children (gtk_widget_get_accessible (box));
+      add_spinners (box, 5);
+      exit (0);
+    }
+  g_test_trap_assert_passed ();
+  pattern = g_strdup_printf ("*\n%-32s %8u %8u %8u\n*", "GtkSpinner", 5, 5, 5);
+  g_test_trap_assert_stderr (pattern);
+  g_free (pattern);
+}
+
+int
+main (int argc, char **argv)
+{
+  /* Prefer the gail module from the build tree */
+  if (g_file_test (GAIL_MODULE, G_FILE_TEST_EXISTS))
+    g_setenv ("GTK_MODULES", GAIL_MODULE, TRUE);
+  else
+    g_setenv ("GTK_MODULES", "gail", TRUE);
+  g_setenv ("GAIL_STATS", "1", TRUE);
+
+  gtk_test_init (&argc, &argv);
+
+  g_test_add ("/treeview/accessible/row-changes", Fixture, NULL,
+              fixture_setup, test_row_changes, fixture_teardown);
+  g_test_add ("/treeview/accessible/cell-cache", Fixture,
+              GINT_TO_POINTER (CELL_CACHE_SIZE + 10),
+              fixture_setup, test_cell_cache, fixture_teardown);
+  g_test_add ("/treeview/accessible/cell-cache-destroy", Fixture, NULL,
+              fixture_setup, test_cell_cache_destroy, fixture_teardown);
+  g_test_add_func ("/container/accessible/children-changed",
+                   test_container_children_changed);
+  g_test_add_func ("/container/accessible/stats",
+                   test_container_stats);
+
+  return g_test_run ();
+}
@@ -228,10 +228,381 @@ test_row_separator_height (void)
   gtk_widget_destroy (tree_view);
 }
 
+static void
+test_estimated_height_mode (void)
+{
+  GtkTreeIter iter;
+  GtkTreePath *path;
+  GtkListStore *store;
+  GtkWidget *window;
+  GtkWidget *tree_view;
+  GdkRectangle first_rect, last_rect;
+  gboolean enabled;
+  int i;
+
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 5000; i++)
+    gtk_list_store_insert_with_values (store, &iter, i, 0, "Row content", -1);
+
+  window = gtk_offscreen_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_view_set_estimated_height_mode (GTK_TREE_VIEW (tree_view), TRUE);
+  g_object_get (tree_view, "estimated-height-mode", &enabled, NULL);
+  g_assert (enabled);
+
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view),
+                                               0,
+                                               "Test",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+
+  gtk_container_add (GTK_CONTAINER (window), tree_view);
+  gtk_widget_show_all (window);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  /* All rows have the same content, so the estimate is exact */
+  path = gtk_tree_path_new_from_indices (0, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &first_rect);
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_path_new_from_indices (4999, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &last_rect);
+  g_assert_cmpint (first_rect.height, >, 0);
+  g_assert_cmpint (last_rect.height, ==, first_rect.height);
+
+  /* Scrolling to a row measures it */
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (tree_view), path, NULL,
+                                FALSE, 0.0, 0.0);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &last_rect);
+  gtk_tree_path_free (path);
+
+  g_assert_cmpint (last_rect.height, ==, first_rect.height);
+  g_assert_cmpint (last_rect.y, >=, 0);
+  g_assert_cmpint (last_rect.y + last_rect.height, <=, 200);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+}
+
+static void
+test_estimated_height_mode_varying (void)
+{
+  GtkTreeIter iter;
+  GtkTreePath *path, *at_path;
+  GtkListStore *store;
+  GtkWidget *window;
+  GtkWidget *tree_view;
+  GtkAdjustment *vadjustment;
+  GdkRectangle tall_rect, short_rect, rect;
+  gdouble upper, expected;
+  int i;
+
+  /* Every tenth row is three lines high */
+  store = gtk_list_store_new (1, G_TYPE_STRING);
+  for (i = 0; i < 5000; i++)
+    gtk_list_store_insert_with_values (store, &iter, i,
+                                       0, (i % 10 == 0) ? "Tall\nrow\ncontent" : "Row content",
+                                       -1);
+
+  window = gtk_offscreen_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_view_set_estimated_height_mode (GTK_TREE_VIEW (tree_view), TRUE);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view),
+                                               0,
+                                               "Test",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+
+  gtk_container_add (GTK_CONTAINER (window), tree_view);
+  gtk_widget_show_all (window);
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  /* The first rows are part of the sample, so they are measured */
+  path = gtk_tree_path_new_from_indices (0, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &tall_rect);
+  gtk_tree_path_free (path);
+
+  path = gtk_tree_path_new_from_indices (1, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &short_rect);
+  gtk_tree_path_free (path);
+
+  g_assert_cmpint (short_rect.height, >, 0);
+  g_assert_cmpint (tall_rect.height, >, short_rect.height);
+
+  /* The estimate is the average of the sample, which follows
+   * the pattern of the whole model.
+   */
+  vadjustment = gtk_scrollable_get_vadjustment (GTK_SCROLLABLE (tree_view));
+  upper = gtk_adjustment_get_upper (vadjustment);
+  expected = 5000 * (tall_rect.height + 9 * short_rect.height) / 10.0;
+
+  g_assert_cmpfloat (upper, >, 5000 * short_rect.height);
+  g_assert_cmpfloat (upper, <, 5000 * tall_rect.height);
+  g_assert_cmpfloat (upper, >, expected * 0.8);
+  g_assert_cmpfloat (upper, <, expected * 1.2);
+
+  /* Scrolling to a tall row measures it, and shows it at the top */
+  path = gtk_tree_path_new_from_indices (4000, -1);
+  gtk_tree_view_scroll_to_cell (GTK_TREE_VIEW (tree_view), path, NULL,
+                                TRUE, 0.0, 0.0);
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view),
+                                     path, NULL, &rect);
+  g_assert_cmpint (rect.height, ==, tall_rect.height);
+  g_assert_cmpint (rect.y, >=, 0);
+  g_assert_cmpint (rect.y, <, 200);
+
+  g_assert (gtk_tree_view_get_path_at_pos (GTK_TREE_VIEW (tree_view),
+                                           1, rect.y + rect.height / 2,
+                                           &at_path, NULL, NULL, NULL));
+  g_assert_cmpint (gtk_tree_path_compare (at_path, path), ==, 0);
+  gtk_tree_path_free (at_path);
+  gtk_tree_path_free (path);
+
+  /* The rows measured while scrolling are accounted for */
+  upper = gtk_adjustment_get_upper (vadjustment);
+  g_assert_cmpfloat (upper, >=,
+                     gtk_adjustment_get_value (vadjustment) +
+                     gtk_adjustment_get_page_size (vadjustment));
+  g_assert_cmpfloat (upper, >, expected * 0.8);
+  g_assert_cmpfloat (upper, <, expected * 1.2);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+}
+
+static gboolean
+threaded_validation_timeout (gpointer data)
+{
+  g_assert_not_reached ();
+
+  return FALSE;
+}
+
+static GtkListStore *
+create_varied_store (void)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  int i;
+
+  /* Rows of differing widths and heights */
+  store = gtk_list_store_new (3, G_TYPE_STRING, G_TYPE_STRING, G_TYPE_DOUBLE);
+  for (i = 0; i < 3000; i++)
+    {
+      gchar *text, *other;
+
+      if (i % 7 == 0)
+        text = g_strdup_printf ("Row %d\nspanning two lines", i);
+      else if (i % 11 == 0)
+        text = g_strdup_printf ("Row %d, which is quite a bit wider than the others", i);
+      else
+        text = g_strdup_printf ("Row %d", i);
+
+      other = g_strdup_printf ("%d", i * i);
+
+      gtk_list_store_insert_with_values (store, &iter, i,
+                                         0, text,
+                                         1, other,
+                                         2, (i % 5 == 0) ? 1.5 : 1.0,
+                                         -1);
+      g_free (text);
+      g_free (other);
+    }
+
+  return store;
+}
+
+static GtkWidget *
+create_varied_view (GtkListStore *store,
+                    gboolean      threaded)
+{
+  GtkWidget *window;
+  GtkWidget *scrolled_window;
+  GtkWidget *tree_view;
+
+  window = gtk_offscreen_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+
+  scrolled_window = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (window), scrolled_window);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_view_set_threaded_validation (GTK_TREE_VIEW (tree_view), threaded);
+
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view),
+                                               0,
+                                               "Text",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view),
+                                               1,
+                                               "Scaled",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 1,
+                                               "scale", 2,
+                                               NULL);
+
+  gtk_container_add (GTK_CONTAINER (scrolled_window), tree_view);
+  gtk_widget_show_all (window);
+
+  return tree_view;
+}
+
+static gboolean
+same_sizes (GtkTreeView *tree_view,
+            GtkTreeView *reference)
+{
+  GtkTreeModel *model;
+  GtkTreeIter iter;
+  gboolean valid;
+  int i;
+
+  for (i = 0; i < 2; i++)
+    if (gtk_tree_view_column_get_width (gtk_tree_view_get_column (tree_view, i)) !=
+        gtk_tree_view_column_get_width (gtk_tree_view_get_column (reference, i)))
+      return FALSE;
+
+  model = gtk_tree_view_get_model (reference);
+  for (valid = gtk_tree_model_get_iter_first (model, &iter);
+       valid;
+       valid = gtk_tree_model_iter_next (model, &iter))
+    {
+      GtkTreePath *path;
+      GdkRectangle rect, reference_rect;
+
+      path = gtk_tree_model_get_path (model, &iter);
+      gtk_tree_view_get_background_area (tree_view, path, NULL, &rect);
+      gtk_tree_view_get_background_area (reference, path, NULL, &reference_rect);
+      gtk_tree_path_free (path);
+
+      if (rect.y != reference_rect.y || rect.height != reference_rect.height)
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+/* Waits until the rows of @tree_view have been measured in worker
+ * threads, and checks that they got the sizes of @reference, which
+ * measures them on the main thread.
+ */
+static void
+wait_for_same_sizes (GtkWidget *tree_view,
+                     GtkWidget *reference)
+{
+  guint timeout;
+
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+
+  timeout = g_timeout_add_seconds (10, threaded_validation_timeout, NULL);
+
+  while (!same_sizes (GTK_TREE_VIEW (tree_view), GTK_TREE_VIEW (reference)))
+    g_main_context_iteration (NULL, TRUE);
+
+  g_source_remove (timeout);
+}
+
+static void
+test_threaded_validation (void)
+{
+  GtkListStore *store;
+  GtkWidget *reference;
+  GtkWidget *tree_view;
+  gboolean enabled;
+
+  store = create_varied_store ();
+
+  reference = create_varied_view (store, FALSE);
+  tree_view = create_varied_view (store, TRUE);
+
+  g_object_get (tree_view, "threaded-validation", &enabled, NULL);
+  g_assert (enabled);
+
+  wait_for_same_sizes (tree_view, reference);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (tree_view));
+  gtk_widget_destroy (gtk_widget_get_toplevel (reference));
+  g_object_unref (store);
+}
+
+static void
+test_threaded_validation_edited (void)
+{
+  GtkListStore *store;
+  GtkWidget *reference;
+  GtkWidget *tree_view;
+  GtkTreeIter iter;
+  int i;
+
+  store = create_varied_store ();
+
+  reference = create_varied_view (store, FALSE);
+  tree_view = create_varied_view (store, TRUE);
+
+  /* Let the first rows get handed to the worker threads */
+  for (i = 0; i < 5; i++)
+    g_main_context_iteration (NULL, FALSE);
+
+  /* Change and remove rows while they are being measured */
+  for (i = 2000; i > 0; i -= 100)
+    {
+      gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, i);
+      gtk_list_store_set (store, &iter,
+                          0, "Changed row\nnow spanning\nthree lines",
+                          -1);
+
+      gtk_tree_model_iter_nth_child (GTK_TREE_MODEL (store), &iter, NULL, i + 1);
+      gtk_list_store_remove (store, &iter);
+    }
+
+  wait_for_same_sizes (tree_view, reference);
+
+  /* Switching it off goes back to measuring on the main thread */
+  gtk_tree_view_set_threaded_validation (GTK_TREE_VIEW (tree_view), FALSE);
+  gtk_list_store_insert_with_values (store, &iter, 0,
+                                     0, "Inserted row\nspanning two lines",
+                                     1, "0",
+                                     2, 1.0,
+                                     -1);
+
+  wait_for_same_sizes (tree_view, reference);
+
+  gtk_widget_destroy (gtk_widget_get_toplevel (tree_view));
+  gtk_widget_destroy (gtk_widget_get_toplevel (reference));
+  g_object_unref (store);
+}
+
 int
 main (int    argc,
       char **argv)
 {
+  /* The threaded-validation tests need the worker threads */
+  if (!g_thread_supported ())
+    g_thread_init (NULL);
+
   gtk_test_init (&argc, &argv, NULL);
 
   g_test_add_func ("/TreeView/cursor/bug-546005", test_bug_546005);
@@ -240,6 +611,14 @@ main (int    argc,
                    test_select_collapsed_row);
   g_test_add_func ("/TreeView/sizing/row-separator-height",
                    test_row_separator_height);
+  g_test_add_func ("/TreeView/sizing/estimated-height-mode",
+                   test_estimated_height_mode);
+  g_test_add_func ("/TreeView/sizing/estimated-height-mode-varying",
+                   test_estimated_height_mode_varying);
+  g_test_add_func ("/TreeView/sizing/threaded-validation",
+                   test_threaded_validation);
+  g_test_add_func ("/TreeView/sizing/threaded-validation-edited",
+                   test_threaded_validation_edited);
 
   return g_test_run ();
 }
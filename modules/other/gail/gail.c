@@ -25,6 +25,7 @@
 #include <gtk/gtkx.h>
 #include "gail.h"
 #include "gailfactory.h"
+#include "gailstats.h"
 
 #define GNOME_ACCESSIBILITY_ENV "GNOME_ACCESSIBILITY"
 #define NO_GAIL_ENV "NO_GAIL"
@@ -873,6 +874,8 @@ gail_accessibility_module_init (void)
   if (a_t_support)
     fprintf (stderr, "GTK Accessibility Module initialized\n");
 
+  gail_stats_init ();
+
   GAIL_WIDGET_SET_FACTORY (GTK_TYPE_WIDGET, gail_widget);
   GAIL_WIDGET_SET_FACTORY (GTK_TYPE_CONTAINER, gail_container);
   GAIL_WIDGET_SET_FACTORY (GTK_TYPE_BUTTON, gail_button);
@@ -25,6 +25,7 @@
 #include "gailcontainercell.h"
 #include "gailcell.h"
 #include "gailcellparent.h"
+#include "gailstats.h"
 
 static void	    gail_cell_class_init          (GailCellClass       *klass);
 static void         gail_cell_destroyed           (GtkWidget           *widget,
@@ -104,6 +105,8 @@ gail_cell_initialise (GailCell  *cell,
   atk_object_set_parent (ATK_OBJECT (cell), parent);
   cell->index = index;
 
+  gail_stats_track (ATK_OBJECT (cell), G_OBJECT_TYPE (cell));
+
   g_signal_connect_object (G_OBJECT (widget),
                            "destroy",
                            G_CALLBACK (gail_cell_destroyed ),
@@ -46,6 +46,9 @@ static void          gail_container_real_initialize    (AtkObject          *obj,
 
 static void          gail_container_finalize           (GObject            *object);
 
+static AtkObject*    peek_accessible                   (GtkWidget          *widget);
+static gboolean      children_queried                  (GailContainer      *container);
+
 G_DEFINE_TYPE (GailContainer, gail_container, GAIL_TYPE_WIDGET)
 
 static void
@@ -68,6 +71,7 @@ static void
 gail_container_init (GailContainer      *container)
 {
   container->children = NULL;
+  container->children_queried = FALSE;
 }
 
 static gint
@@ -83,6 +87,8 @@ gail_container_get_n_children (AtkObject* obj)
   if (widget == NULL)
     return 0;
 
+  GAIL_CONTAINER (obj)->children_queried = TRUE;
+
   children = gtk_container_get_children (GTK_CONTAINER(widget));
   count = g_list_length (children);
   g_list_free (children);
@@ -105,6 +111,8 @@ gail_container_ref_child (AtkObject *obj,
   if (widget == NULL)
     return NULL;
 
+  GAIL_CONTAINER (obj)->children_queried = TRUE;
+
   children = gtk_container_get_children (GTK_CONTAINER (widget));
   tmp_list = g_list_nth (children, i);
   if (!tmp_list)
@@ -157,10 +165,23 @@ gail_container_real_add_gtk (GtkContainer *container,
                              gpointer     data)
 {
   AtkObject* atk_parent = ATK_OBJECT (data);
-  AtkObject* atk_child = gtk_widget_get_accessible (widget);
+  AtkObject* atk_child;
   GailContainer *gail_container = GAIL_CONTAINER (atk_parent);
   gint       index;
 
+  /*
+   * If nobody has asked for the children yet, there is nobody to tell
+   * about the new one either; its accessible gets created when it is
+   * asked for.
+   */
+  if (!children_queried (gail_container) && peek_accessible (widget) == NULL)
+    {
+      g_list_free (gail_container->children);
+      gail_container->children = gtk_container_get_children (container);
+      return 1;
+    }
+
+  atk_child = gtk_widget_get_accessible (widget);
   g_object_notify (G_OBJECT (atk_child), "accessible_parent");
 
   g_list_free (gail_container->children);
@@ -184,7 +205,12 @@ gail_container_real_remove_gtk (GtkContainer       *container,
   gint       index;
 
   atk_parent = ATK_OBJECT (data);
-  atk_child = gtk_widget_get_accessible (widget);
+  gail_container = GAIL_CONTAINER (atk_parent);
+
+  /* Don't create an accessible only to announce that it is going away */
+  atk_child = peek_accessible (widget);
+  if (atk_child == NULL && children_queried (gail_container))
+    atk_child = gtk_widget_get_accessible (widget);
 
   if (atk_child)
     {
@@ -198,11 +224,11 @@ gail_container_real_remove_gtk (GtkContainer       *container,
                              "property_change::accessible-parent", &values, NULL);
       g_object_unref (atk_child);
     }
-  gail_container = GAIL_CONTAINER (atk_parent);
   index = g_list_index (gail_container->children, widget);
   g_list_free (gail_container->children);
   gail_container->children = gtk_container_get_children (container);
-  if (index >= 0 && index <= g_list_length (gail_container->children))
+  if (atk_child &&
+      index >= 0 && index <= g_list_length (gail_container->children))
     g_signal_emit_by_name (atk_parent, "children_changed::remove", 
 			   index, atk_child, NULL);
 
@@ -214,11 +240,23 @@ gail_container_real_initialize (AtkObject *obj,
                                 gpointer  data)
 {
   GailContainer *container = GAIL_CONTAINER (obj);
+  GList *l;
 
   ATK_OBJECT_CLASS (gail_container_parent_class)->initialize (obj, data);
 
   container->children = gtk_container_get_children (GTK_CONTAINER (data));
 
+  /*
+   * If the accessible of a child was created first, whoever holds it
+   * finds its siblings through us; see gail_widget_real_initialize()
+   */
+  for (l = container->children; l; l = l->next)
+    if (gail_widget_has_accessible (l->data))
+      {
+        container->children_queried = TRUE;
+        break;
+      }
+
   g_signal_connect (data, "add",
                     G_CALLBACK (gail_container_add_gtk),
                     obj);
@@ -242,3 +280,25 @@ gail_container_finalize (GObject *object)
   g_list_free (container->children);
   G_OBJECT_CLASS (gail_container_parent_class)->finalize (object);
 }
+
+static AtkObject*
+peek_accessible (GtkWidget *widget)
+{
+  if (!gail_widget_has_accessible (widget))
+    return NULL;
+
+  return gtk_widget_get_accessible (widget);
+}
+
+static gboolean
+children_queried (GailContainer *container)
+{
+  /*
+   * Subclasses enumerating their children in their own way don't
+   * tell us when they are asked for them, so assume they have been.
+   */
+  if (ATK_OBJECT_GET_CLASS (container)->ref_child != gail_container_ref_child)
+    return TRUE;
+
+  return container->children_queried;
+}
@@ -42,6 +42,13 @@ struct _GailContainer
    * Cached list of children
    */
   GList      *children;
+
+  /*
+   * Whether the children have been asked for, or the accessible of
+   * one of them exists; until then, accessibles are not created for
+   * children being added
+   */
+  gboolean   children_queried;
 };
 
 GType gail_container_get_type (void);
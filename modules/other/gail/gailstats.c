@@ -0,0 +1,136 @@
+/* GAIL - The GNOME Accessibility Implementation Library
+ * Copyright 2011 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Library General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Library General Public License for more details.
+ *
+ * You should have received a copy of the GNU Library General Public
+ * License along with this library; if not, write to the
+ * Free Software Foundation, Inc., 59 Temple Place - Suite 330,
+ * Boston, MA 02111-1307, USA.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "gailstats.h"
+
+#define GAIL_STATS_ENV "GAIL_STATS"
+
+/*
+ * Counts of the accessibles created for each widget type, enabled by
+ * setting GAIL_STATS=1 in the environment. The counts are printed when
+ * the program exits.
+ */
+typedef struct
+{
+  GType type;
+  guint live;
+  guint peak;
+  guint created;
+} GailStatsEntry;
+
+static GHashTable *stats = NULL;
+
+static void
+accessible_finalized (gpointer  data,
+                      GObject  *where_the_object_was)
+{
+  GailStatsEntry *entry = data;
+
+  entry->live--;
+}
+
+static gint
+compare_entries (gconstpointer a,
+                 gconstpointer b)
+{
+  const GailStatsEntry *ea = *(const GailStatsEntry **) a;
+  const GailStatsEntry *eb = *(const GailStatsEntry **) b;
+
+  if (ea->peak != eb->peak)
+    return ea->peak < eb->peak ? 1 : -1;
+
+  return ea->created < eb->created ? 1 : (ea->created > eb->created ? -1 : 0);
+}
+
+static void
+print_stats (void)
+{
+  GHashTableIter iter;
+  GPtrArray *entries;
+  GailStatsEntry *entry;
+  guint i, live = 0, created = 0;
+
+  entries = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, stats);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &entry))
+    g_ptr_array_add (entries, entry);
+  g_ptr_array_sort (entries, compare_entries);
+
+  fprintf (stderr, "%-32s %8s %8s %8s\n", "Accessibles for", "live", "peak", "created");
+  for (i = 0; i < entries->len; i++)
+    {
+      entry = g_ptr_array_index (entries, i);
+      fprintf (stderr, "%-32s %8u %8u %8u\n",
+               g_type_name (entry->type), entry->live, entry->peak, entry->created);
+      live += entry->live;
+      created += entry->created;
+    }
+  fprintf (stderr, "%-32s %8u %8s %8u\n", "Total", live, "", created);
+
+  g_ptr_array_free (entries, TRUE);
+}
+
+void
+gail_stats_init (void)
+{
+  const gchar *env_stats;
+
+  if (stats != NULL)
+    return;
+
+  env_stats = g_getenv (GAIL_STATS_ENV);
+  if (env_stats == NULL || !atoi (env_stats))
+    return;
+
+  stats = g_hash_table_new (NULL, NULL);
+  atexit (print_stats);
+}
+
+/*
+ * Counts accessible as live for type until it is finalized. Accessibles
+ * for widgets are counted for the type of the widget, cells for the
+ * type of the cell.
+ */
+void
+gail_stats_track (AtkObject *accessible,
+                  GType      type)
+{
+  GailStatsEntry *entry;
+
+  if (G_LIKELY (stats == NULL))
+    return;
+
+  entry = g_hash_table_lookup (stats, GSIZE_TO_POINTER (type));
+  if (entry == NULL)
+    {
+      entry = g_new0 (GailStatsEntry, 1);
+      entry->type = type;
+      g_hash_table_insert (stats, GSIZE_TO_POINTER (type), entry);
+    }
+
+  entry->live++;
+  entry->peak = MAX (entry->peak, entry->live);
+  entry->created++;
+
+  g_object_weak_ref (G_OBJECT (accessible), accessible_finalized, entry);
+}
@@ -34,6 +34,7 @@
 
 typedef struct _GailTreeViewRowInfo    GailTreeViewRowInfo;
 typedef struct _GailTreeViewCellInfo   GailTreeViewCellInfo;
+typedef struct _GailTreeViewCellPosition GailTreeViewCellPosition;
 
 static void             gail_tree_view_class_init       (GailTreeViewClass      *klass);
 static void             gail_tree_view_init             (GailTreeView           *view);
@@ -246,7 +247,7 @@ static void             free_row_info                   (GArray
                                                          gint                   array_idx,
                                                          gboolean               shift);
 static void             clean_cell_info                 (GailTreeView           *tree_view,
-                                                         GList                  *list); 
+                                                         GailTreeViewCellInfo   *cell_info);
 static void             clean_rows                      (GailTreeView           *tree_view);
 static void             clean_cols                      (GailTreeView           *tree_view,
                                                          GtkTreeViewColumn      *tv_col);
@@ -277,10 +278,6 @@ static void             toggle_cell_toggled             (GailCell
 static void             edit_cell                       (GailCell               *cell);
 static void             activate_cell                   (GailCell               *cell);
 static void             cell_destroyed                  (gpointer               data);
-#if 0
-static void             cell_info_remove                (GailTreeView           *tree_view, 
-                                                         GailCell               *cell);
-#endif
 static void             cell_info_get_index             (GtkTreeView            *tree_view, 
                                                          GailTreeViewCellInfo   *info,
                                                          gint                   *index);
@@ -334,13 +331,33 @@ static gboolean         get_path_column_from_index      (GtkTreeView
 static void             set_cell_expandable             (GailCell               *cell);
 
 static GailTreeViewCellInfo* find_cell_info             (GailTreeView           *view,
-                                                         GailCell               *cell,
-                                                          GList**                list,
-							 gboolean                live_only);
+                                                         GailCell               *cell);
+static GailTreeViewCellInfo* find_cell_info_at          (GailTreeView           *view,
+                                                         GtkTreePath            *path,
+                                                         GtkTreeViewColumn      *tv_col);
+static GList*            get_cell_infos                 (GailTreeView           *view);
+static void              release_cell_info              (GailTreeView           *view,
+                                                         GailTreeViewCellInfo   *cell_info);
+static guint             cell_position_hash             (gconstpointer          key);
+static gboolean          cell_position_equal            (gconstpointer          a,
+                                                         gconstpointer          b);
+static void              cell_position_free             (gpointer               key);
+static void              cell_position_add              (GailTreeView           *view,
+                                                         GailTreeViewCellInfo   *cell_info,
+                                                         GtkTreePath            *path);
+static void              cell_cache_touch               (GailTreeView           *view,
+                                                         GailTreeViewCellInfo   *cell_info);
+static void              cell_cache_clear               (GailTreeView           *view);
 static AtkObject *       get_header_from_column         (GtkTreeViewColumn      *tv_col);
 static gboolean          idle_garbage_collect_cell_data (gpointer data);
 static gboolean          garbage_collect_cell_data      (gpointer data);
 
+/*
+ * The number of cells, most recently asked for, which are kept alive
+ * even if nobody else holds on to them; a few screenfuls worth.
+ */
+#define CELL_CACHE_SIZE 256
+
 static GQuark quark_column_desc_object = 0;
 static GQuark quark_column_header_object = 0;
 static gboolean editing = FALSE;
@@ -359,6 +376,21 @@ struct _GailTreeViewCellInfo
   GtkTreeViewColumn *cell_col_ref;
   GailTreeView *view;
   gboolean in_use;
+  GailTreeViewCellPosition *position;
+  GList *cache_link;
+};
+
+/*
+ * Key of the cell_positions table, which maps the position of a cell to
+ * the GailTreeViewCellInfo standing for it. The path is a snapshot of the
+ * row reference; since inserting, deleting or reordering rows moves the
+ * row references around, the table is marked as stale when that happens,
+ * and rebuilt from the row references on the next lookup.
+ */
+struct _GailTreeViewCellPosition
+{
+  GtkTreePath *path;
+  GtkTreeViewColumn *column;
 };
 
 G_DEFINE_TYPE_WITH_CODE (GailTreeView, gail_tree_view, GAIL_TYPE_CONTAINER,
@@ -459,7 +491,14 @@ gail_tree_view_real_initialize (AtkObject *obj,
   view->summary = NULL;
   view->row_data = NULL;
   view->col_data = NULL;
-  view->cell_data = NULL;
+  view->cell_data = g_hash_table_new (NULL, NULL);
+  view->cell_positions = g_hash_table_new_full (cell_position_hash,
+                                                cell_position_equal,
+                                                cell_position_free,
+                                                NULL);
+  view->dead_cell_data = NULL;
+  view->cell_cache = g_queue_new ();
+  view->cell_positions_stale = FALSE;
   view->focus_cell = NULL;
   view->old_hadj = NULL;
   view->old_vadj = NULL;
@@ -633,6 +672,9 @@ gail_tree_view_finalize (GObject	    *object)
   GailTreeView *view = GAIL_TREE_VIEW (object);
 
   clear_cached_data (view);
+  g_hash_table_destroy (view->cell_data);
+  g_hash_table_destroy (view->cell_positions);
+  g_queue_free (view->cell_cache);
 
   /* remove any idle handlers still pending */
   if (view->idle_garbage_collect_id)
@@ -711,6 +753,8 @@ gail_tree_view_destroyed (GtkWidget *widget,
       g_object_unref (gailview->focus_cell);
       gailview->focus_cell = NULL;
     }
+  /* The cached cells hold a reference on their parent */
+  cell_cache_clear (gailview);
   if (gailview->idle_expand_id) 
     {
       g_source_remove (gailview->idle_expand_id);
@@ -900,8 +944,8 @@ gail_tree_view_ref_child (AtkObject *obj,
                             widget, ATK_OBJECT (gailview), 
                             i);
       /*
-       * The GailTreeViewCellInfo structure for the container will be before
-       * the ones for the cells so that the first one we find for a position
+       * The GailTreeViewCellInfo structure for the container takes the
+       * position of the cell, so that the one we find for a position
        * will be for the container
        */
       cell_info_new (gailview, tree_model, path, tv_col, container_cell);
@@ -1052,10 +1096,12 @@ gail_tree_view_ref_child (AtkObject *obj,
   gtk_tree_path_free (path);
 
   /*
-   * We do not increase the reference count here; when g_object_unref() is 
-   * called for the cell then cell_destroyed() is called and
-   * this removes the cell from the cache.
+   * The reference we return is the caller's; the cell cache holds
+   * one of its own. When the last reference is dropped,
+   * cell_destroyed() forgets about the cell.
    */
+  cell_cache_touch (gailview, find_cell_info (gailview, GAIL_CELL (child)));
+
   return child;
 }
 
@@ -2092,7 +2138,7 @@ gail_tree_view_get_cell_area (GailCellParent *parent,
     {
       top_cell = cell;
     }
-  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), top_cell, NULL, TRUE);
+  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), top_cell);
   gail_return_if_fail (cell_info);
   gail_return_if_fail (cell_info->cell_col_ref);
   gail_return_if_fail (cell_info->cell_row_ref);
@@ -2176,7 +2222,7 @@ gail_tree_view_grab_cell_focus  (GailCellParent *parent,
 
   tree_view = GTK_TREE_VIEW (widget);
 
-  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell, NULL, TRUE);
+  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell);
   gail_return_val_if_fail (cell_info, FALSE);
   gail_return_val_if_fail (cell_info->cell_col_ref, FALSE);
   gail_return_val_if_fail (cell_info->cell_row_ref, FALSE);
@@ -2389,7 +2435,6 @@ gail_tree_view_changed_gtk (GtkTreeSelection *selection,
   GtkTreePath *path;
 
   gailview = GAIL_TREE_VIEW (data);
-  cell_list = gailview->cell_data;
   widget = gtk_accessible_get_widget (GTK_ACCESSIBLE (gailview));
   if (widget == NULL)
     /*
@@ -2402,6 +2447,7 @@ gail_tree_view_changed_gtk (GtkTreeSelection *selection,
 
   clean_rows (gailview);
 
+  cell_list = get_cell_infos (gailview);
   for (l = cell_list; l; l = l->next)
     {
       info = (GailTreeViewCellInfo *) (l->data);
@@ -2416,6 +2462,7 @@ gail_tree_view_changed_gtk (GtkTreeSelection *selection,
 	  gtk_tree_path_free (path);
       }
     }
+  g_list_free (cell_list);
   if (gtk_widget_get_realized (widget))
     g_signal_emit_by_name (gailview, "selection_changed");
 }
@@ -2693,35 +2740,37 @@ model_row_changed (GtkTreeModel *tree_model,
 {
   GtkTreeView *tree_view = GTK_TREE_VIEW(user_data);
   GailTreeView *gailview;
-  GtkTreePath *cell_path;
-  GList *l;
+  GList *tv_cols, *l;
   GailTreeViewCellInfo *cell_info;
  
   gailview = GAIL_TREE_VIEW (gtk_widget_get_accessible (GTK_WIDGET (tree_view)));
 
-  /* Loop through our cached cells */
-  /* Must loop through them all */
-  for (l = gailview->cell_data; l; l = l->next)
+  /* Only the cells on the changed row need updating */
+  tv_cols = gtk_tree_view_get_columns (tree_view);
+  for (l = tv_cols; l; l = l->next)
     {
-      cell_info = (GailTreeViewCellInfo *) l->data;
-      if (cell_info->in_use) 
-      {
-	  cell_path = gtk_tree_row_reference_get_path (cell_info->cell_row_ref);
+      cell_info = find_cell_info_at (gailview, path, l->data);
+      if (cell_info == NULL)
+        continue;
+
+      if (GAIL_IS_RENDERER_CELL (cell_info->cell))
+        update_cell_value (GAIL_RENDERER_CELL (cell_info->cell),
+                           gailview, TRUE);
+      else if (GAIL_IS_CONTAINER_CELL (cell_info->cell))
+        {
+          GList *children;
 
-	  if (cell_path != NULL)
-	  {
-	      if (path && gtk_tree_path_compare (cell_path, path) == 0)
-	      {
-		  if (GAIL_IS_RENDERER_CELL (cell_info->cell))
-		  {
-		      update_cell_value (GAIL_RENDERER_CELL (cell_info->cell),
-					 gailview, TRUE);
-		  }
-	      }
-	      gtk_tree_path_free (cell_path);
-	  }
-      }
+          children = GAIL_CONTAINER_CELL (cell_info->cell)->children;
+          for (; children; children = children->next)
+            {
+              if (GAIL_IS_RENDERER_CELL (children->data))
+                update_cell_value (GAIL_RENDERER_CELL (children->data),
+                                   gailview, TRUE);
+            }
+        }
     }
+  g_list_free (tv_cols);
+
   g_signal_emit_by_name (gailview, "visible-data-changed");
 }
 
@@ -2739,7 +2788,7 @@ column_visibility_changed (GObject    *object,
        */ 
       GtkTreeView *tree_view = (GtkTreeView *)user_data;
       GailTreeView *gailview;
-      GList *l;
+      GList *cell_list, *l;
       GailTreeViewCellInfo *cell_info;
       GtkTreeViewColumn *this_col = GTK_TREE_VIEW_COLUMN (object);
       GtkTreeViewColumn *tv_col;
@@ -2748,7 +2797,8 @@ column_visibility_changed (GObject    *object,
 );
       g_signal_emit_by_name (gailview, "model_changed");
 
-      for (l = gailview->cell_data; l; l = l->next)
+      cell_list = get_cell_infos (gailview);
+      for (l = cell_list; l; l = l->next)
         {
           cell_info = (GailTreeViewCellInfo *) l->data;
 	  if (cell_info->in_use) 
@@ -2776,6 +2826,7 @@ column_visibility_changed (GObject    *object,
 	      }
 	  }
         }
+      g_list_free (cell_list);
     }
 }
 
@@ -2791,6 +2842,9 @@ model_row_inserted (GtkTreeModel *tree_model,
   GailTreeView *gailview = GAIL_TREE_VIEW (atk_obj);
   gint row, n_inserted, child_row;
 
+  /* The rows after the new one moved */
+  gailview->cell_positions_stale = TRUE;
+
   if (gailview->idle_expand_id)
     {
       g_source_remove (gailview->idle_expand_id);
@@ -2886,6 +2940,9 @@ model_row_deleted (GtkTreeModel *tree_model,
   atk_obj = gtk_widget_get_accessible (GTK_WIDGET (tree_view));
   gailview = GAIL_TREE_VIEW (atk_obj);
 
+  /* The rows after the deleted one moved */
+  gailview->cell_positions_stale = TRUE;
+
   if (gailview->idle_expand_id)
     {
       g_source_remove (gailview->idle_expand_id);
@@ -2966,6 +3023,8 @@ model_rows_reordered (GtkTreeModel *tree_model,
   AtkObject *atk_obj = gtk_widget_get_accessible (GTK_WIDGET (tree_view));
   GailTreeView *gailview = GAIL_TREE_VIEW (atk_obj);
 
+  gailview->cell_positions_stale = TRUE;
+
   if (gailview->idle_expand_id)
     {
       g_source_remove (gailview->idle_expand_id);
@@ -3102,7 +3161,7 @@ update_cell_value (GailRendererCell *renderer_cell,
   prop_list = gail_renderer_cell_class->property_list;
 
   cell = GAIL_CELL (renderer_cell);
-  cell_info = find_cell_info (gailview, cell, NULL, TRUE);
+  cell_info = find_cell_info (gailview, cell);
   gail_return_val_if_fail (cell_info, FALSE);
   gail_return_val_if_fail (cell_info->cell_col_ref, FALSE);
   gail_return_val_if_fail (cell_info->cell_row_ref, FALSE);
@@ -3477,31 +3536,111 @@ iterate_thru_children(GtkTreeView  *tree_view,
 }
 
 static void
-clean_cell_info (GailTreeView *gailview,
-                 GList        *list) 
+clean_cell_info (GailTreeView         *gailview,
+                 GailTreeViewCellInfo *cell_info) 
 {
-  GailTreeViewCellInfo *cell_info;
   GObject *obj;
 
   g_assert (GAIL_IS_TREE_VIEW (gailview));
 
-  cell_info = list->data;
-
   if (cell_info->in_use) {
       obj = G_OBJECT (cell_info->cell);
       
       gail_cell_add_state (cell_info->cell, ATK_STATE_DEFUNCT, FALSE);
       g_object_weak_unref (obj, (GWeakNotify) cell_destroyed, cell_info);
-      cell_info->in_use = FALSE; 
-      if (!gailview->garbage_collection_pending) {
-	  gailview->garbage_collection_pending = TRUE;
-          g_assert (gailview->idle_garbage_collect_id == 0);
-	  gailview->idle_garbage_collect_id = 
-	    gdk_threads_add_idle (idle_garbage_collect_cell_data, gailview);
-      }
+      release_cell_info (gailview, cell_info);
   }
 }
 
+/*
+ * Drops a cell info from the lookup tables; the cell info itself
+ * is only freed by garbage_collect_cell_data(), as callers may still
+ * be holding it.
+ */
+static void
+release_cell_info (GailTreeView         *gailview,
+                   GailTreeViewCellInfo *cell_info)
+{
+  gboolean cached;
+
+  cell_info->in_use = FALSE;
+
+  if (g_hash_table_lookup (gailview->cell_data, cell_info->cell) == cell_info)
+    g_hash_table_remove (gailview->cell_data, cell_info->cell);
+
+  if (cell_info->position)
+    {
+      g_hash_table_remove (gailview->cell_positions, cell_info->position);
+      cell_info->position = NULL;
+    }
+
+  gailview->dead_cell_data = g_slist_prepend (gailview->dead_cell_data,
+                                              cell_info);
+
+  cached = cell_info->cache_link != NULL;
+  if (cached)
+    {
+      g_queue_delete_link (gailview->cell_cache, cell_info->cache_link);
+      cell_info->cache_link = NULL;
+    }
+
+  if (!gailview->garbage_collection_pending) {
+      gailview->garbage_collection_pending = TRUE;
+      g_assert (gailview->idle_garbage_collect_id == 0);
+      gailview->idle_garbage_collect_id = 
+        gdk_threads_add_idle (idle_garbage_collect_cell_data, gailview);
+  }
+
+  /* This may finalize the cell, so do it last */
+  if (cached)
+    g_object_unref (cell_info->cell);
+}
+
+/*
+ * Moves the cell to the front of the cell cache, dropping the least
+ * recently used cell if the cache is full.
+ */
+static void
+cell_cache_touch (GailTreeView         *gailview,
+                  GailTreeViewCellInfo *cell_info)
+{
+  GailTreeViewCellInfo *oldest;
+
+  if (cell_info == NULL || !cell_info->in_use)
+    return;
+
+  if (cell_info->cache_link)
+    {
+      g_queue_unlink (gailview->cell_cache, cell_info->cache_link);
+      g_queue_push_head_link (gailview->cell_cache, cell_info->cache_link);
+      return;
+    }
+
+  g_queue_push_head (gailview->cell_cache, cell_info);
+  cell_info->cache_link = gailview->cell_cache->head;
+  g_object_ref (cell_info->cell);
+
+  if (g_queue_get_length (gailview->cell_cache) > CELL_CACHE_SIZE)
+    {
+      oldest = g_queue_pop_tail (gailview->cell_cache);
+      oldest->cache_link = NULL;
+      /* If nobody else holds on to it, cell_destroyed() releases it */
+      g_object_unref (oldest->cell);
+    }
+}
+
+static void
+cell_cache_clear (GailTreeView *gailview)
+{
+  GailTreeViewCellInfo *cell_info;
+
+  while ((cell_info = g_queue_pop_head (gailview->cell_cache)))
+    {
+      cell_info->cache_link = NULL;
+      g_object_unref (cell_info->cell);
+    }
+}
+
 static void 
 clean_rows (GailTreeView *gailview)
 {
@@ -3535,21 +3674,19 @@ clean_rows (GailTreeView *gailview)
 
   /* Clean GailTreeViewCellInfo data */
 
-  if (gailview->cell_data != NULL)
+  if (g_hash_table_size (gailview->cell_data) > 0)
     {
       GailTreeViewCellInfo *cell_info;
       GtkTreePath *row_path;
-      GList *cur_list;
+      GList *cell_list;
       GList *temp_list;
 
-      temp_list = gailview->cell_data;
+      cell_list = get_cell_infos (gailview);
 
       /* Must loop through them all */
-      while (temp_list != NULL)
+      for (temp_list = cell_list; temp_list; temp_list = temp_list->next)
         {
-          cur_list = temp_list;
           cell_info = temp_list->data;
-          temp_list = temp_list->next;
           row_path = gtk_tree_row_reference_get_path (cell_info->cell_row_ref);
 
          /*
@@ -3560,13 +3697,14 @@ clean_rows (GailTreeView *gailview)
           */
           if (row_path == NULL)
             {
-              clean_cell_info (gailview, cur_list);
+              clean_cell_info (gailview, cell_info);
             }
           else
             {
               gtk_tree_path_free (row_path);
             }
         }
+      g_list_free (cell_list);
     }
 }
 
@@ -3576,18 +3714,16 @@ clean_cols (GailTreeView      *gailview,
 {
   /* Clean GailTreeViewCellInfo data */
 
-  if (gailview->cell_data != NULL)
+  if (g_hash_table_size (gailview->cell_data) > 0)
     {
       GailTreeViewCellInfo *cell_info;
-      GList *cur_list, *temp_list;
+      GList *cell_list, *temp_list;
 
-      temp_list = gailview->cell_data;
+      cell_list = get_cell_infos (gailview);
 
-      while (temp_list != NULL)
+      for (temp_list = cell_list; temp_list; temp_list = temp_list->next)
         {
-          cur_list = temp_list;
           cell_info = temp_list->data;
-          temp_list = temp_list->next;
 
          /*
           * If the cell has become invalid because the column tv_col
@@ -3596,9 +3732,10 @@ clean_cols (GailTreeView      *gailview,
           */
           if (cell_info->cell_col_ref == tv_col)
             {
-              clean_cell_info (gailview, cur_list);
+              clean_cell_info (gailview, cell_info);
             }
         }
+      g_list_free (cell_list);
     }
 }
 
@@ -3629,12 +3766,15 @@ static gboolean
 garbage_collect_cell_data (gpointer data)
 {
       GailTreeView *tree_view;
-      GList *temp_list, *list;
+      GSList *temp_list, *list;
       GailTreeViewCellInfo *cell_info;
 
       g_assert (GAIL_IS_TREE_VIEW (data));
       tree_view = (GailTreeView *)data;
-      list = g_list_copy (tree_view->cell_data);
+
+      /* Only the cell infos released since the last time need freeing */
+      list = tree_view->dead_cell_data;
+      tree_view->dead_cell_data = NULL;
 
       tree_view->garbage_collection_pending = FALSE;
       if (tree_view->idle_garbage_collect_id != 0) 
@@ -3643,23 +3783,15 @@ garbage_collect_cell_data (gpointer data)
 	  tree_view->idle_garbage_collect_id = 0;
       }
 
-      /* Must loop through them all */
-      temp_list = list;
-      while (temp_list != NULL)
+      for (temp_list = list; temp_list; temp_list = temp_list->next)
       {
           cell_info = temp_list->data;
-	  if (!cell_info->in_use)
-	  {
-	      /* g_object_unref (cell_info->cell); */
-	      tree_view->cell_data = g_list_remove (tree_view->cell_data, 
-						    cell_info);
-	      if (cell_info->cell_row_ref)
-		  gtk_tree_row_reference_free (cell_info->cell_row_ref);
-	      g_free (cell_info);
-	  }
-          temp_list = temp_list->next;
+	  /* g_object_unref (cell_info->cell); */
+	  if (cell_info->cell_row_ref)
+	      gtk_tree_row_reference_free (cell_info->cell_row_ref);
+	  g_free (cell_info);
       }
-      g_list_free (list);
+      g_slist_free (list);
 
       return tree_view->garbage_collection_pending;
 }
@@ -3682,11 +3814,11 @@ traverse_cells (GailTreeView *tree_view,
                 gboolean     set_stale,
                 gboolean     inc_row)
 {
-  if (tree_view->cell_data != NULL)
+  if (g_hash_table_size (tree_view->cell_data) > 0)
     {
       GailTreeViewCellInfo *cell_info;
       GtkTreeView *gtk_tree_view;
-      GList *temp_list;
+      GList *cell_list, *temp_list;
       GtkWidget *widget;
 
       g_assert (GTK_IS_ACCESSIBLE (tree_view));
@@ -3697,7 +3829,8 @@ traverse_cells (GailTreeView *tree_view,
         return;
 
       gtk_tree_view = GTK_TREE_VIEW (widget);
-      temp_list = tree_view->cell_data;
+      cell_list = get_cell_infos (tree_view);
+      temp_list = cell_list;
 
       /* Must loop through them all */
       while (temp_list != NULL)
@@ -3711,7 +3844,11 @@ traverse_cells (GailTreeView *tree_view,
 	  if (cell_info->in_use)
 	  {
 	      row_path = gtk_tree_row_reference_get_path (cell_info->cell_row_ref);
-	      g_return_if_fail (row_path != NULL);
+	      if (row_path == NULL)
+	      {
+		  g_warning ("cell info without a row during traversal");
+		  continue;
+	      }
 	      if (tree_path == NULL)
 		  act_on_cell = TRUE;
 	      else 
@@ -3738,6 +3875,7 @@ traverse_cells (GailTreeView *tree_view,
 	      gtk_tree_path_free (row_path);
 	  }
 	}
+      g_list_free (cell_list);
     }
   g_signal_emit_by_name (tree_view, "visible-data-changed");
 }
@@ -3762,6 +3900,40 @@ free_row_info (GArray   *array,
     g_array_remove_index (array, array_idx);
 }
 
+/*
+ * Sets ATK_STATE_EXPANDABLE and ATK_STATE_EXPANDED on cell,
+ * according to the row at cell_path.
+ */
+static void
+set_cell_expand_state (GtkTreeView  *tree_view,
+                       GtkTreeModel *tree_model,
+                       GailCell     *cell,
+                       GtkTreePath  *cell_path)
+{
+  GtkTreeIter iter;
+
+  gtk_tree_model_get_iter (tree_model, &iter, cell_path);
+
+  /* Set or unset ATK_STATE_EXPANDABLE as appropriate */
+  if (gtk_tree_model_iter_has_child (tree_model, &iter)) 
+    {
+      set_cell_expandable (cell);
+
+      if (gtk_tree_view_row_expanded (tree_view, cell_path))
+        gail_cell_add_state (cell, ATK_STATE_EXPANDED, TRUE);
+      else
+        gail_cell_remove_state (cell, ATK_STATE_EXPANDED, TRUE);
+    }
+  else
+    {
+      gail_cell_remove_state (cell, ATK_STATE_EXPANDED, TRUE);
+      if (gail_cell_remove_state (cell, ATK_STATE_EXPANDABLE, TRUE))
+        /* The state may have been propagated to the container cell */
+        if (!GAIL_IS_CONTAINER_CELL (cell))
+          gail_cell_remove_action_by_name (cell, "expand or contract");
+    }
+}
+
 /*
  * If the tree_path passed in has children, then
  * ATK_STATE_EXPANDABLE is set.  If the row is expanded
@@ -3781,99 +3953,58 @@ set_expand_state (GtkTreeView  *tree_view,
                   GtkTreePath  *tree_path,
                   gboolean     set_on_ancestor)
 {
-  if (gailview->cell_data != NULL)
+  GtkTreeViewColumn *expander_tv;
+  GailTreeViewCellInfo *cell_info;
+  GList *cell_list, *temp_list;
+  GtkTreePath *cell_path;
+
+  if (tree_path == NULL || g_hash_table_size (gailview->cell_data) == 0)
+    return;
+
+  /*
+   * Only set state for the cell that is in the column with the
+   * expander toggle
+   */
+  expander_tv = gtk_tree_view_get_expander_column (tree_view);
+
+  if (!set_on_ancestor)
     {
-      GtkTreeViewColumn *expander_tv;
-      GailTreeViewCellInfo *cell_info;
-      GList *temp_list;
-      GtkTreePath *cell_path;
-      GtkTreeIter iter;
-      gboolean found;
+      /*
+       * The cell found for a position is the container cell, if
+       * there is one, so that is the only one to update.
+       */
+      cell_info = find_cell_info_at (gailview, tree_path, expander_tv);
+      if (cell_info && cell_info->in_use)
+        set_cell_expand_state (tree_view, tree_model, cell_info->cell, tree_path);
+      return;
+    }
 
-      temp_list = gailview->cell_data;
+  cell_list = get_cell_infos (gailview);
+  for (temp_list = cell_list; temp_list; temp_list = temp_list->next)
+    {
+      cell_info = temp_list->data;
+      if (!cell_info->in_use || expander_tv != cell_info->cell_col_ref)
+        continue;
 
-      while (temp_list != NULL)
-        {
-          cell_info = temp_list->data;
-          temp_list = temp_list->next;
-	  if (cell_info->in_use)
-	  {
-	      cell_path = gtk_tree_row_reference_get_path (cell_info->cell_row_ref);
-	      found = FALSE;
-	      
-	      if (cell_path != NULL)
-	      {
-		  GailCell *cell  = GAIL_CELL (cell_info->cell);
-		  
-		  expander_tv = gtk_tree_view_get_expander_column (tree_view);
-		  
-		  /*
-		   * Only set state for the cell that is in the column with the
-		   * expander toggle
-		   */
-		  if (expander_tv == cell_info->cell_col_ref)
-		  {
-		      if (tree_path && gtk_tree_path_compare (cell_path, tree_path) == 0)
-			  found = TRUE;
-		      else if (set_on_ancestor &&
-			       gtk_tree_path_get_depth (cell_path) <
-			       gtk_tree_path_get_depth (tree_path) && 
-			       gtk_tree_path_is_ancestor (cell_path, tree_path) == 1)
-			  /* Only set if set_on_ancestor was passed in as TRUE */
-			  found = TRUE;
-		  }
-		  
-		  /*
-		   * Set ATK_STATE_EXPANDABLE and ATK_STATE_EXPANDED
-		   * for ancestors and found cells.
-		   */
-		  if (found)
-		  {
-		      /*
-		       * Must check against cell_path since cell_path
-		       * can be equal to or an ancestor of tree_path.
-		       */
-		      gtk_tree_model_get_iter (tree_model, &iter, cell_path);
-		      
-		      /* Set or unset ATK_STATE_EXPANDABLE as appropriate */
-		      if (gtk_tree_model_iter_has_child (tree_model, &iter)) 
-		      {
-			  set_cell_expandable (cell);
-			  
-			  if (gtk_tree_view_row_expanded (tree_view, cell_path))
-			      gail_cell_add_state (cell, ATK_STATE_EXPANDED, TRUE);
-			  else
-			      gail_cell_remove_state (cell, 
-						      ATK_STATE_EXPANDED, TRUE);
-		      }
-		      else
-		      {
-			  gail_cell_remove_state (cell, 
-						  ATK_STATE_EXPANDED, TRUE);
-			  if (gail_cell_remove_state (cell,
-						      ATK_STATE_EXPANDABLE, TRUE))
-			      /* The state may have been propagated to the container cell */
-			      if (!GAIL_IS_CONTAINER_CELL (cell))
-				  gail_cell_remove_action_by_name (cell,
-								   "expand or contract");
-		      }
-		      
-		      /*
-		       * We assume that each cell in the cache once and
-		       * a container cell is before its child cells so we are 
-		       * finished if set_on_ancestor is not set to TRUE.
-		       */
-		      if (!set_on_ancestor)
-			  break;
-		  }
-	      }
-	      gtk_tree_path_free (cell_path);
-	  }
-	}
+      cell_path = gtk_tree_row_reference_get_path (cell_info->cell_row_ref);
+      if (cell_path == NULL)
+        continue;
+
+      /*
+       * Must check against cell_path since cell_path
+       * can be equal to or an ancestor of tree_path.
+       */
+      if (gtk_tree_path_compare (cell_path, tree_path) == 0 ||
+          (gtk_tree_path_get_depth (cell_path) <
+           gtk_tree_path_get_depth (tree_path) && 
+           gtk_tree_path_is_ancestor (cell_path, tree_path) == 1))
+        set_cell_expand_state (tree_view, tree_model, cell_info->cell, cell_path);
+
+      gtk_tree_path_free (cell_path);
     }
+  g_list_free (cell_list);
 }
 
-
 static void
 add_cell_actions (GailCell *cell,
                   gboolean editable)
@@ -3910,7 +4041,7 @@ toggle_cell_expanded (GailCell *cell)
   if (GAIL_IS_CONTAINER_CELL (parent))
     parent = atk_object_get_parent (parent);
 
-  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell, NULL, TRUE);
+  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell);
   gail_return_if_fail (cell_info);
   gail_return_if_fail (cell_info->cell_col_ref);
   gail_return_if_fail (cell_info->cell_row_ref);
@@ -3946,7 +4077,7 @@ toggle_cell_toggled (GailCell *cell)
       parent = atk_object_get_parent (parent);
     }
 
-  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell, NULL, TRUE);
+  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell);
   gail_return_if_fail (cell_info);
   gail_return_if_fail (cell_info->cell_col_ref);
   gail_return_if_fail (cell_info->cell_row_ref);
@@ -3994,7 +4125,7 @@ edit_cell (GailCell *cell)
   if (GAIL_IS_CONTAINER_CELL (parent))
     parent = atk_object_get_parent (parent);
 
-  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell, NULL, TRUE);
+  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell);
   gail_return_if_fail (cell_info);
   gail_return_if_fail (cell_info->cell_col_ref);
   gail_return_if_fail (cell_info->cell_row_ref);
@@ -4020,7 +4151,7 @@ activate_cell (GailCell *cell)
   if (GAIL_IS_CONTAINER_CELL (parent))
     parent = atk_object_get_parent (parent);
 
-  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell, NULL, TRUE);
+  cell_info = find_cell_info (GAIL_TREE_VIEW (parent), cell);
   gail_return_if_fail (cell_info);
   gail_return_if_fail (cell_info->cell_col_ref);
   gail_return_if_fail (cell_info->cell_row_ref);
@@ -4040,35 +4171,11 @@ cell_destroyed (gpointer data)
 
   gail_return_if_fail (cell_info);
   if (cell_info->in_use) {
-      cell_info->in_use = FALSE;
-
       g_assert (GAIL_IS_TREE_VIEW (cell_info->view));
-      if (!cell_info->view->garbage_collection_pending) {
-	  cell_info->view->garbage_collection_pending = TRUE;
-	  cell_info->view->idle_garbage_collect_id =
-	    gdk_threads_add_idle (idle_garbage_collect_cell_data, cell_info->view);
-      }
+      release_cell_info (cell_info->view, cell_info);
   }
 }
 
-#if 0
-static void
-cell_info_remove (GailTreeView *tree_view, 
-                  GailCell     *cell)
-{
-  GailTreeViewCellInfo *info;
-  GList *temp_list;
-
-  info = find_cell_info (tree_view, cell, &temp_list, FALSE);
-  if (info)
-    {
-      info->in_use = FALSE;
-      return;
-    }
-  g_warning ("No cell removed in cell_info_remove\n");
-}
-#endif
-
 static void
 cell_info_get_index (GtkTreeView            *tree_view, 
                      GailTreeViewCellInfo   *info,
@@ -4103,7 +4210,13 @@ cell_info_new (GailTreeView      *gailview,
   cell_info->cell = cell;
   cell_info->in_use = TRUE; /* if we've created it, assume it's in use */
   cell_info->view = gailview;
-  gailview->cell_data = g_list_append (gailview->cell_data, cell_info);
+  cell_info->position = NULL;
+  cell_info->cache_link = NULL;
+  g_hash_table_insert (gailview->cell_data, cell, cell_info);
+
+  /* A stale position table picks the cell up when it is rebuilt */
+  if (!gailview->cell_positions_stale)
+    cell_position_add (gailview, cell_info, path);
       
   /* Setup weak reference notification */
 
@@ -4118,36 +4231,25 @@ find_cell (GailTreeView *gailview,
 {
   GailTreeViewCellInfo *info;
   GtkTreeView *tree_view;
-  GList *cell_list;
-  GList *l;
-  gint real_index;
-  gboolean needs_cleaning = FALSE;
-  GailCell *retval = NULL;
+  GtkTreeViewColumn *tv_col;
+  GtkTreePath *path;
+
+  if (g_hash_table_size (gailview->cell_data) == 0)
+    return NULL;
 
   tree_view = GTK_TREE_VIEW (gtk_accessible_get_widget (GTK_ACCESSIBLE (gailview)));
-  cell_list = gailview->cell_data;
+  if (!get_path_column_from_index (tree_view, index, &path, &tv_col))
+    return NULL;
 
-  for (l = cell_list; l; l = l->next)
-    {
-      info = (GailTreeViewCellInfo *) (l->data);
-      if (info->in_use)
-      {
-	  cell_info_get_index (tree_view, info, &real_index);
-	  if (index == real_index)
-	  {
-	      retval =  info->cell;
-	      break;
-	  }
-      }
-      else
-      {
-	  needs_cleaning = TRUE;
-      }
-    }
-  if (needs_cleaning)
-     garbage_collect_cell_data (gailview);
+  info = find_cell_info_at (gailview, path, tv_col);
+  gtk_tree_path_free (path);
+
+  if (info == NULL)
+    return NULL;
+
+  cell_cache_touch (gailview, info);
 
-  return retval;
+  return info->cell;
 }
 
 static void
@@ -4165,7 +4267,7 @@ refresh_cell_index (GailCell *cell)
 
   /* Find this cell in the GailTreeView's cache */
 
-  info = find_cell_info (GAIL_TREE_VIEW (parent), cell, NULL, TRUE);
+  info = find_cell_info (GAIL_TREE_VIEW (parent), cell);
   gail_return_if_fail (info);
   
   cell_info_get_index (tree_view, info, &index); 
@@ -4220,7 +4322,7 @@ disconnect_model_signals (GailTreeView *view)
 static void
 clear_cached_data (GailTreeView  *view)
 {
-  GList *temp_list;
+  GList *cell_list, *temp_list;
 
   if (view->row_data)
     {
@@ -4239,19 +4341,14 @@ clear_cached_data (GailTreeView  *view)
       view->row_data = NULL;
     }
 
-  if (view->cell_data)
-    {
-      /* Must loop through them all */
-      for (temp_list = view->cell_data; temp_list; temp_list = temp_list->next)
-        {
-	    clean_cell_info (view, temp_list);
-        }
-    }
+  /* Must loop through them all */
+  cell_list = get_cell_infos (view);
+  for (temp_list = cell_list; temp_list; temp_list = temp_list->next)
+    clean_cell_info (view, temp_list->data);
+  g_list_free (cell_list);
+
   garbage_collect_cell_data (view);
-  if (view->cell_data)
-      g_list_free (view->cell_data);
-  
-  view->cell_data = NULL;
+  view->cell_positions_stale = FALSE;
 }
 
 /*
@@ -4598,26 +4695,134 @@ set_cell_expandable (GailCell *cell)
                           toggle_cell_expanded);
 }
 
-static GailTreeViewCellInfo*
-find_cell_info (GailTreeView *view,
-                GailCell     *cell,
-                GList**      list,
-		gboolean     live_only)
+static guint
+cell_position_hash (gconstpointer key)
+{
+  const GailTreeViewCellPosition *position = key;
+  gint *indices;
+  gint depth, i;
+  guint hash;
+
+  hash = GPOINTER_TO_UINT (position->column);
+  indices = gtk_tree_path_get_indices (position->path);
+  depth = gtk_tree_path_get_depth (position->path);
+  for (i = 0; i < depth; i++)
+    hash = hash * 31 + indices[i];
+
+  return hash;
+}
+
+static gboolean
+cell_position_equal (gconstpointer a,
+                     gconstpointer b)
 {
-  GList *temp_list;
+  const GailTreeViewCellPosition *pa = a;
+  const GailTreeViewCellPosition *pb = b;
+
+  return pa->column == pb->column &&
+         gtk_tree_path_compare (pa->path, pb->path) == 0;
+}
+
+static void
+cell_position_free (gpointer key)
+{
+  GailTreeViewCellPosition *position = key;
+
+  gtk_tree_path_free (position->path);
+  g_slice_free (GailTreeViewCellPosition, position);
+}
+
+/*
+ * Makes cell_info the one found for its position, unless that position
+ * is already taken by a live cell. A container cell always wins over the
+ * renderer cells inside of it.
+ */
+static void
+cell_position_add (GailTreeView         *view,
+                   GailTreeViewCellInfo *cell_info,
+                   GtkTreePath          *path)
+{
+  GailTreeViewCellPosition key, *position;
+  GailTreeViewCellInfo *other;
+
+  key.path = path;
+  key.column = cell_info->cell_col_ref;
+
+  other = g_hash_table_lookup (view->cell_positions, &key);
+  if (other)
+    {
+      if (other->in_use && !GAIL_IS_CONTAINER_CELL (cell_info->cell))
+        return;
+
+      /* g_hash_table_replace() frees the key other is pointing at */
+      other->position = NULL;
+    }
+
+  position = g_slice_new (GailTreeViewCellPosition);
+  position->path = gtk_tree_path_copy (path);
+  position->column = cell_info->cell_col_ref;
+  g_hash_table_replace (view->cell_positions, position, cell_info);
+  cell_info->position = position;
+}
+
+static void
+rebuild_cell_positions (GailTreeView *view)
+{
+  GHashTableIter iter;
   GailTreeViewCellInfo *cell_info;
+  GtkTreePath *path;
+
+  g_hash_table_remove_all (view->cell_positions);
 
-  for (temp_list = view->cell_data; temp_list; temp_list = temp_list->next)
+  g_hash_table_iter_init (&iter, view->cell_data);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cell_info))
     {
-      cell_info = (GailTreeViewCellInfo *) temp_list->data;
-      if (cell_info->cell == cell && (!live_only || cell_info->in_use))
-        {
-          if (list)
-            *list = temp_list;
-          return cell_info;
-        }
+      cell_info->position = NULL;
+      if (!cell_info->in_use)
+        continue;
+
+      path = gtk_tree_row_reference_get_path (cell_info->cell_row_ref);
+      if (path == NULL)
+        continue;
+
+      cell_position_add (view, cell_info, path);
+      gtk_tree_path_free (path);
     }
-  return NULL;
+
+  view->cell_positions_stale = FALSE;
+}
+
+static GailTreeViewCellInfo*
+find_cell_info_at (GailTreeView      *view,
+                   GtkTreePath       *path,
+                   GtkTreeViewColumn *tv_col)
+{
+  GailTreeViewCellPosition key;
+
+  if (view->cell_positions_stale)
+    rebuild_cell_positions (view);
+
+  key.path = path;
+  key.column = tv_col;
+
+  return g_hash_table_lookup (view->cell_positions, &key);
+}
+
+/*
+ * Returns a list of the live cell infos, which stays valid while
+ * cells are being cleaned.
+ */
+static GList*
+get_cell_infos (GailTreeView *view)
+{
+  return g_hash_table_get_values (view->cell_data);
+}
+
+static GailTreeViewCellInfo*
+find_cell_info (GailTreeView *view,
+                GailCell     *cell)
+{
+  return g_hash_table_lookup (view->cell_data, cell);
 }
 
 static AtkObject *
@@ -45,7 +45,10 @@ struct _GailTreeView
   gint          n_children_deleted;
   GArray*       col_data;
   GArray*	row_data;
-  GList*        cell_data;
+  GHashTable*   cell_data;
+  GHashTable*   cell_positions;
+  GSList*       dead_cell_data;
+  GQueue*       cell_cache;
   GtkTreeModel  *tree_model;
   AtkObject     *focus_cell;
   GtkAdjustment *old_hadj;
@@ -55,6 +58,7 @@ struct _GailTreeView
   guint         idle_cursor_changed_id;
   GtkTreePath   *idle_expand_path;
   gboolean      garbage_collection_pending;
+  gboolean      cell_positions_stale;
 };
 
 GType gail_tree_view_get_type (void);
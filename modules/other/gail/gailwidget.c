@@ -26,7 +26,9 @@
 #include <gdk/x11/gdkx.h>
 #endif
 #include "gailwidget.h"
+#include "gailcontainer.h"
 #include "gailnotebookpage.h"
+#include "gailstats.h"
 #include "gail-private-macros.h"
 
 extern GtkWidget *focus_widget;
@@ -107,6 +109,8 @@ static GtkWidget* gail_widget_find_viewport      (GtkWidget     *widget);
 static gboolean   gail_widget_on_screen          (GtkWidget     *widget);
 static gboolean   gail_widget_all_parents_visible(GtkWidget     *widget);
 
+static GQuark quark_gail_accessible = 0;
+
 G_DEFINE_TYPE_WITH_CODE (GailWidget, gail_widget, GTK_TYPE_ACCESSIBLE,
                          G_IMPLEMENT_INTERFACE (ATK_TYPE_COMPONENT, atk_component_interface_init))
 
@@ -128,6 +132,8 @@ gail_widget_class_init (GailWidgetClass *klass)
   class->get_index_in_parent = gail_widget_get_index_in_parent;
   class->initialize = gail_widget_real_initialize;
   class->get_attributes = gail_widget_get_attributes;
+
+  quark_gail_accessible = g_quark_from_static_string ("gail-accessible");
 }
 
 static void
@@ -145,6 +151,7 @@ gail_widget_real_initialize (AtkObject *obj,
 {
   GtkAccessible *accessible;
   GtkWidget *widget;
+  GtkWidget *parent;
 
   g_return_if_fail (GTK_IS_WIDGET (data));
 
@@ -186,6 +193,38 @@ gail_widget_real_initialize (AtkObject *obj,
 		     GINT_TO_POINTER (ATK_LAYER_WIDGET));
 
   obj->role = ATK_ROLE_UNKNOWN;
+
+  /*
+   * The accessible lives as long as the widget, so this stays true
+   * once set.
+   */
+  g_object_set_qdata (G_OBJECT (widget), quark_gail_accessible,
+                      GINT_TO_POINTER (TRUE));
+
+  /*
+   * Whoever got hold of this accessible may find its siblings through
+   * its parent, so the parent has to announce new children from now on.
+   */
+  parent = gtk_widget_get_parent (widget);
+  if (parent && gail_widget_has_accessible (parent))
+    {
+      AtkObject *parent_obj = gtk_widget_get_accessible (parent);
+
+      if (GAIL_IS_CONTAINER (parent_obj))
+        GAIL_CONTAINER (parent_obj)->children_queried = TRUE;
+    }
+
+  gail_stats_track (obj, G_OBJECT_TYPE (widget));
+}
+
+/*
+ * Returns whether gail has created the accessible of widget yet,
+ * without creating it as gtk_widget_get_accessible() would.
+ */
+gboolean
+gail_widget_has_accessible (GtkWidget *widget)
+{
+  return g_object_get_qdata (G_OBJECT (widget), quark_gail_accessible) != NULL;
 }
 
 AtkObject* 
@@ -41,6 +41,8 @@ struct _GailWidget
 
 GType gail_widget_get_type (void);
 
+gboolean gail_widget_has_accessible (GtkWidget *widget);
+
 struct _GailWidgetClass
 {
   GtkAccessibleClass parent_class;
@@ -312,6 +312,142 @@ _cairo_write (void                *closure,
 }
 
 
+/* The document is normally written straight into the output file
+ * while it is being rendered, instead of being spooled into the
+ * cache file of the job first and copied over when the job is sent.
+ * Direct writes are looked up by the cache channel of their job,
+ * which is what print_stream() gets handed.
+ */
+typedef struct {
+  GIOChannel *cache_io;
+  GFile *file;
+  GFileOutputStream *target_io_stream;
+  GError *error;
+  guint created : 1;
+} _DirectWriteData;
+
+static GHashTable *direct_writes = NULL;
+static cairo_user_data_key_t direct_write_key;
+
+static cairo_status_t
+_cairo_write_direct (void                *closure,
+                     const unsigned char *data,
+                     unsigned int         length)
+{
+  _DirectWriteData *dw = (_DirectWriteData *) closure;
+  gsize written;
+
+  if (dw->error != NULL)
+    return CAIRO_STATUS_WRITE_ERROR;
+
+  GTK_NOTE (PRINTING,
+            g_print ("FILE Backend: Writting %i byte chunk to target file\n", length));
+
+  if (!g_output_stream_write_all (G_OUTPUT_STREAM (dw->target_io_stream),
+                                  data, length, &written, NULL, &dw->error))
+    {
+      GTK_NOTE (PRINTING,
+                g_print ("FILE Backend: Error writting to target file, %s\n", dw->error->message));
+
+      return CAIRO_STATUS_WRITE_ERROR;
+    }
+
+  return CAIRO_STATUS_SUCCESS;
+}
+
+static _DirectWriteData *
+direct_write_new (GtkPrintSettings *settings,
+                  GIOChannel       *cache_io)
+{
+  _DirectWriteData *dw;
+  GFileOutputStream *stream;
+  GFile *file;
+  gchar *uri;
+  gboolean created;
+
+  uri = output_file_from_settings (settings, NULL);
+  if (uri == NULL)
+    return NULL;
+
+  file = g_file_new_for_uri (uri);
+  g_free (uri);
+
+  /* Remember whether the job creates the file itself, so that
+   * it can be removed again if the job doesn't complete.
+   * Replacing an existing file only takes effect on close.
+   */
+  stream = g_file_create (file, G_FILE_CREATE_NONE, NULL, NULL);
+  created = stream != NULL;
+  if (stream == NULL)
+    stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_NONE, NULL, NULL);
+
+  /* Spool to the cache file as before, print_stream()
+   * will report the error.
+   */
+  if (stream == NULL)
+    {
+      g_object_unref (file);
+      return NULL;
+    }
+
+  dw = g_slice_new0 (_DirectWriteData);
+  dw->cache_io = cache_io;
+  dw->file = file;
+  dw->target_io_stream = stream;
+  dw->created = created;
+
+  if (direct_writes == NULL)
+    direct_writes = g_hash_table_new (NULL, NULL);
+
+  g_hash_table_insert (direct_writes, cache_io, dw);
+
+  return dw;
+}
+
+/* Drops a partial document. Closing with a cancelled cancellable
+ * keeps whatever was in a replaced file before, and a file the
+ * job created itself is removed again.
+ */
+static void
+direct_write_discard (_DirectWriteData *dw)
+{
+  if (dw->target_io_stream != NULL)
+    {
+      GCancellable *cancellable;
+
+      cancellable = g_cancellable_new ();
+      g_cancellable_cancel (cancellable);
+      g_output_stream_close (G_OUTPUT_STREAM (dw->target_io_stream), cancellable, NULL);
+      g_object_unref (cancellable);
+
+      g_object_unref (dw->target_io_stream);
+      dw->target_io_stream = NULL;
+    }
+
+  if (dw->created)
+    {
+      g_file_delete (dw->file, NULL, NULL);
+      dw->created = FALSE;
+    }
+}
+
+static void
+direct_write_free (_DirectWriteData *dw)
+{
+  /* The job was never sent, e.g. because it was cancelled */
+  if (dw->target_io_stream != NULL)
+    direct_write_discard (dw);
+
+  if (g_hash_table_lookup (direct_writes, dw->cache_io) == dw)
+    g_hash_table_remove (direct_writes, dw->cache_io);
+
+  if (dw->error != NULL)
+    g_error_free (dw->error);
+
+  g_object_unref (dw->file);
+  g_slice_free (_DirectWriteData, dw);
+}
+
 static cairo_surface_t *
 file_printer_create_cairo_surface (GtkPrinter       *printer,
 				   GtkPrintSettings *settings,
@@ -323,20 +459,35 @@ file_printer_create_cairo_surface (GtkPrinter       *printer,
   OutputFormat format;
   const cairo_svg_version_t *versions;
   int num_versions = 0;
+  cairo_write_func_t write_func;
+  _DirectWriteData *dw;
+  gpointer closure;
 
   format = format_from_settings (settings);
 
+  dw = direct_write_new (settings, cache_io);
+  if (dw != NULL)
+    {
+      write_func = _cairo_write_direct;
+      closure = dw;
+    }
+  else
+    {
+      write_func = _cairo_write;
+      closure = cache_io;
+    }
+
   switch (format)
     {
       default:
       case FORMAT_PDF:
-        surface = cairo_pdf_surface_create_for_stream (_cairo_write, cache_io, width, height);
+        surface = cairo_pdf_surface_create_for_stream (write_func, closure, width, height);
         break;
       case FORMAT_PS:
-        surface = cairo_ps_surface_create_for_stream (_cairo_write, cache_io, width, height);
+        surface = cairo_ps_surface_create_for_stream (write_func, closure, width, height);
         break;
       case FORMAT_SVG:
-        surface = cairo_svg_surface_create_for_stream (_cairo_write, cache_io, width, height);
+        surface = cairo_svg_surface_create_for_stream (write_func, closure, width, height);
         cairo_svg_get_versions (&versions, &num_versions);
         if (num_versions > 0)
           cairo_svg_surface_restrict_to_version (surface, versions[num_versions - 1]);
@@ -347,6 +498,10 @@ file_printer_create_cairo_surface (GtkPrinter       *printer,
                                          2.0 * gtk_print_settings_get_printer_lpi (settings),
                                          2.0 * gtk_print_settings_get_printer_lpi (settings));
 
+  if (dw != NULL)
+    cairo_surface_set_user_data (surface, &direct_write_key,
+                                 dw, (cairo_destroy_func_t) direct_write_free);
+
   return surface;
 }
 
@@ -465,6 +620,39 @@ gtk_print_backend_file_print_stream (GtkPrintBackend        *print_backend,
   ps->backend = print_backend;
 
   internal_error = NULL;
+
+  if (direct_writes != NULL)
+    {
+      _DirectWriteData *dw;
+
+      dw = g_hash_table_lookup (direct_writes, data_io);
+
+      /* The document already went to the output file,
+       * all that is left is to commit it.
+       */
+      if (dw != NULL)
+        {
+          g_hash_table_remove (direct_writes, data_io);
+
+          if (dw->error == NULL)
+            {
+              g_output_stream_close (G_OUTPUT_STREAM (dw->target_io_stream),
+                                     NULL, &dw->error);
+              g_object_unref (dw->target_io_stream);
+              dw->target_io_stream = NULL;
+            }
+
+          /* Don't leave a truncated document behind */
+          if (dw->error != NULL)
+            direct_write_discard (dw);
+          else
+            dw->created = FALSE;
+
+          file_print_cb (GTK_PRINT_BACKEND_FILE (print_backend), dw->error, ps);
+
+          return;
+        }
+    }
   uri = output_file_from_settings (settings, NULL);
 
   if (uri == NULL)
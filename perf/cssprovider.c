@@ -0,0 +1,142 @@
+/* Measures style lookups per second against a large stylesheet */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#define N_RULES 5000
+#define N_LOOKUPS 20000
+
+static const gchar *widget_types[] = {
+  "GtkButton", "GtkLabel", "GtkEntry", "GtkTreeView", "GtkScrolledWindow",
+  "GtkWindow", "GtkNotebook", "GtkToolbar", "GtkMenuItem", "GtkCheckButton"
+};
+
+static GString *
+create_stylesheet (gint n_rules)
+{
+  GString *str;
+  gint i;
+
+  str = g_string_new (NULL);
+
+  for (i = 0; i < n_rules; i++)
+    {
+      const gchar *type = widget_types[i % G_N_ELEMENTS (widget_types)];
+
+      switch (i % 5)
+        {
+        case 0:
+          g_string_append_printf (str, "%s.class-%d { padding: %d; }\n", type, i, i % 7);
+          break;
+        case 1:
+          g_string_append_printf (str, "#name-%d { color: #%06x; }\n", i, i);
+          break;
+        case 2:
+          g_string_append_printf (str, "GtkWindow %s.class-%d:hover { margin: 1; }\n", type, i);
+          break;
+        case 3:
+          g_string_append_printf (str, ".class-%d { border-width: 2; }\n", i);
+          break;
+        default:
+          g_string_append_printf (str, "%s { background-color: #%06x; }\n", type, i);
+          break;
+        }
+    }
+
+  return str;
+}
+
+static GtkWidgetPath *
+create_path (gint n)
+{
+  GtkWidgetPath *path;
+  gint pos;
+
+  path = gtk_widget_path_new ();
+  gtk_widget_path_append_type (path, GTK_TYPE_WINDOW);
+  gtk_widget_path_append_type (path, GTK_TYPE_BOX);
+  gtk_widget_path_append_type (path, GTK_TYPE_SCROLLED_WINDOW);
+  pos = gtk_widget_path_append_type (path, GTK_TYPE_BUTTON);
+  gtk_widget_path_iter_add_class (path, pos, GTK_STYLE_CLASS_BUTTON);
+
+  if (n % 3 == 0)
+    {
+      gchar *name;
+
+      name = g_strdup_printf ("class-%d", n % N_RULES);
+      gtk_widget_path_iter_add_class (path, pos, name);
+      g_free (name);
+    }
+
+  pos = gtk_widget_path_append_type (path, GTK_TYPE_LABEL);
+
+  if (n % 3 == 1)
+    {
+      gchar *name;
+
+      name = g_strdup_printf ("name-%d", n % N_RULES);
+      gtk_widget_path_iter_set_name (path, pos, name);
+      g_free (name);
+    }
+
+  return path;
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkCssProvider *provider;
+  GtkWidgetPath *paths[16];
+  GError *error = NULL;
+  GString *data;
+  GTimer *timer;
+  gdouble elapsed;
+  gint n_rules, i;
+
+  gtk_init (&argc, &argv);
+
+  n_rules = (argc > 1) ? atoi (argv[1]) : N_RULES;
+
+  data = create_stylesheet (n_rules);
+  provider = gtk_css_provider_new ();
+
+  timer = g_timer_new ();
+
+  if (!gtk_css_provider_load_from_data (provider, data->str, data->len, &error))
+    {
+      g_printerr ("Could not load stylesheet: %s\n", error->message);
+      return 1;
+    }
+
+  fprintf (stdout, "stylesheet parse (%d rules): %g sec\n",
+           n_rules, g_timer_elapsed (timer, NULL));
+
+  for (i = 0; i < G_N_ELEMENTS (paths); i++)
+    paths[i] = create_path (i);
+
+  g_timer_start (timer);
+
+  for (i = 0; i < N_LOOKUPS; i++)
+    {
+      GtkStyleProperties *props;
+
+      props = gtk_style_provider_get_style (GTK_STYLE_PROVIDER (provider),
+                                            paths[i % G_N_ELEMENTS (paths)]);
+      g_object_unref (props);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  fprintf (stdout, "style lookups: %d in %g sec (%g lookups/sec)\n",
+           N_LOOKUPS, elapsed, N_LOOKUPS / elapsed);
+
+  for (i = 0; i < G_N_ELEMENTS (paths); i++)
+    gtk_widget_path_free (paths[i]);
+
+  g_timer_destroy (timer);
+  g_string_free (data, TRUE);
+  g_object_unref (provider);
+
+  return 0;
+}
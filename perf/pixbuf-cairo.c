@@ -0,0 +1,129 @@
+/* Measures pixel conversion between pixbufs and cairo surfaces */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#define SIZE 48
+#define N_ITERATIONS 20000
+
+static GdkPixbuf *
+create_pixbuf (gboolean has_alpha)
+{
+  GdkPixbuf *pixbuf;
+  guchar *pixels;
+  gint rowstride, n_channels;
+  gint x, y;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, has_alpha, 8, SIZE, SIZE);
+  pixels = gdk_pixbuf_get_pixels (pixbuf);
+  rowstride = gdk_pixbuf_get_rowstride (pixbuf);
+  n_channels = gdk_pixbuf_get_n_channels (pixbuf);
+
+  /* Like an icon: an opaque shape with an antialiased edge on a
+   * transparent background.
+   */
+  for (y = 0; y < SIZE; y++)
+    for (x = 0; x < SIZE; x++)
+      {
+        guchar *p = pixels + y * rowstride + x * n_channels;
+        gint d = ABS (x - SIZE / 2) + ABS (y - SIZE / 2);
+
+        p[0] = x * 5;
+        p[1] = y * 5;
+        p[2] = (x + y) * 3;
+        if (has_alpha)
+          p[3] = d < SIZE / 3 ? 0xff : d < SIZE / 3 + 4 ? 0xff - (d - SIZE / 3) * 60 : 0;
+      }
+
+  return pixbuf;
+}
+
+static void
+report (const gchar *name,
+        gdouble      elapsed,
+        gint         n_iterations)
+{
+  fprintf (stdout, "%s: %d conversions of %dx%d in %g sec (%g Mpixels/sec)\n",
+           name, n_iterations, SIZE, SIZE, elapsed,
+           (gdouble) n_iterations * SIZE * SIZE / elapsed / 1000000);
+}
+
+static void
+time_set_source_pixbuf (gboolean has_alpha,
+                        gint     n_iterations)
+{
+  cairo_surface_t *target;
+  GdkPixbuf *pixbuf;
+  GTimer *timer;
+  cairo_t *cr;
+  gint i;
+
+  pixbuf = create_pixbuf (has_alpha);
+  target = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, 1, 1);
+  cr = cairo_create (target);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_iterations; i++)
+    gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+
+  report (has_alpha ? "gdk_cairo_set_source_pixbuf (RGBA)" : "gdk_cairo_set_source_pixbuf (RGB)",
+          g_timer_elapsed (timer, NULL), n_iterations);
+
+  g_timer_destroy (timer);
+  cairo_destroy (cr);
+  cairo_surface_destroy (target);
+  g_object_unref (pixbuf);
+}
+
+static void
+time_get_from_surface (gboolean has_alpha,
+                       gint     n_iterations)
+{
+  cairo_surface_t *surface;
+  GdkPixbuf *pixbuf;
+  GTimer *timer;
+  cairo_t *cr;
+  gint i;
+
+  pixbuf = create_pixbuf (has_alpha);
+  surface = cairo_image_surface_create (has_alpha ? CAIRO_FORMAT_ARGB32 : CAIRO_FORMAT_RGB24,
+                                        SIZE, SIZE);
+  cr = cairo_create (surface);
+  gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+  g_object_unref (pixbuf);
+
+  timer = g_timer_new ();
+
+  for (i = 0; i < n_iterations; i++)
+    {
+      pixbuf = gdk_pixbuf_get_from_surface (surface, 0, 0, SIZE, SIZE);
+      g_object_unref (pixbuf);
+    }
+
+  report (has_alpha ? "gdk_pixbuf_get_from_surface (RGBA)" : "gdk_pixbuf_get_from_surface (RGB)",
+          g_timer_elapsed (timer, NULL), n_iterations);
+
+  g_timer_destroy (timer);
+  cairo_surface_destroy (surface);
+}
+
+int
+main (int argc, char **argv)
+{
+  gint n_iterations;
+
+  gtk_init (&argc, &argv);
+
+  n_iterations = (argc > 1) ? atoi (argv[1]) : N_ITERATIONS;
+
+  time_set_source_pixbuf (TRUE, n_iterations);
+  time_set_source_pixbuf (FALSE, n_iterations);
+  time_get_from_surface (TRUE, n_iterations);
+  time_get_from_surface (FALSE, n_iterations);
+
+  return 0;
+}
@@ -0,0 +1,112 @@
+/* Measures pages per second when exporting a print operation to PDF,
+ * with the draw-page handler run on the main thread and in worker threads
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+
+#define N_PAGES 500
+#define N_SHAPES 400
+
+static void
+draw_page (GtkPrintOperation *operation,
+           GtkPrintContext   *context,
+           gint               page_nr,
+           gpointer           user_data)
+{
+  cairo_t *cr;
+  gdouble width, height;
+  gint i;
+
+  cr = gtk_print_context_get_cairo_context (context);
+  width = gtk_print_context_get_width (context);
+  height = gtk_print_context_get_height (context);
+
+  /* Enough path geometry that drawing dominates writing */
+  for (i = 0; i < N_SHAPES; i++)
+    {
+      gdouble x, y, r;
+
+      x = fmod ((page_nr + 1) * (i + 1) * 37.0, width);
+      y = fmod ((page_nr + 3) * (i + 7) * 53.0, height);
+      r = 2 + i % 11;
+
+      cairo_new_sub_path (cr);
+      cairo_arc (cr, x, y, r, 0, 2 * G_PI);
+      cairo_set_source_rgb (cr, (i % 3) / 2.0, (i % 5) / 4.0, (i % 7) / 6.0);
+      cairo_fill_preserve (cr);
+      cairo_set_source_rgb (cr, 0, 0, 0);
+      cairo_stroke (cr);
+    }
+}
+
+static gdouble
+run (const gchar *filename,
+     gint         n_pages,
+     gboolean     threaded)
+{
+  GtkPrintOperation *operation;
+  GError *error = NULL;
+  GTimer *timer;
+  gdouble elapsed;
+
+  operation = gtk_print_operation_new ();
+  gtk_print_operation_set_n_pages (operation, n_pages);
+  gtk_print_operation_set_export_filename (operation, filename);
+  gtk_print_operation_set_threaded_drawing (operation, threaded);
+  g_signal_connect (operation, "draw-page", G_CALLBACK (draw_page), NULL);
+
+  timer = g_timer_new ();
+
+  if (gtk_print_operation_run (operation, GTK_PRINT_OPERATION_ACTION_EXPORT,
+                               NULL, &error) == GTK_PRINT_OPERATION_RESULT_ERROR)
+    {
+      g_printerr ("Could not print: %s\n", error->message);
+      exit (1);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  g_timer_destroy (timer);
+  g_object_unref (operation);
+
+  return elapsed;
+}
+
+int
+main (int argc, char **argv)
+{
+  gchar *filename;
+  gdouble elapsed;
+  gint n_pages, fd;
+
+  g_thread_init (NULL);
+  gtk_init (&argc, &argv);
+
+  n_pages = (argc > 1) ? atoi (argv[1]) : N_PAGES;
+
+  fd = g_file_open_tmp ("print-pages-XXXXXX.pdf", &filename, NULL);
+  if (fd < 0)
+    {
+      g_printerr ("Could not create a temporary file\n");
+      return 1;
+    }
+  close (fd);
+
+  elapsed = run (filename, n_pages, FALSE);
+  fprintf (stdout, "main thread: %d pages in %g sec (%g pages/sec)\n",
+           n_pages, elapsed, n_pages / elapsed);
+
+  elapsed = run (filename, n_pages, TRUE);
+  fprintf (stdout, "threaded drawing: %d pages in %g sec (%g pages/sec)\n",
+           n_pages, elapsed, n_pages / elapsed);
+
+  g_unlink (filename);
+  g_free (filename);
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+/* Measures scrolling in a tree view with many rows while the visible
+ * cells are being queried through the accessibility module
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#define N_ROWS 100000
+#define N_COLUMNS 3
+#define N_SCROLLS 1000
+/* The number of cell accessibles kept alive, like an AT would */
+#define N_HELD 256
+
+static GtkListStore *
+create_model (gint n_rows)
+{
+  GtkListStore *store;
+  GtkTreeIter iter;
+  gint i;
+
+  store = gtk_list_store_new (N_COLUMNS, G_TYPE_INT, G_TYPE_STRING, G_TYPE_BOOLEAN);
+
+  for (i = 0; i < n_rows; i++)
+    gtk_list_store_insert_with_values (store, &iter, -1,
+                                       0, i,
+                                       1, "Lorem ipsum",
+                                       2, i % 2,
+                                       -1);
+
+  return store;
+}
+
+static void
+process_events (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+/* Refs the accessibles of the visible cells, dropping the oldest ones */
+static gint
+query_visible_cells (GtkTreeView *tree_view,
+                     AtkObject   *accessible,
+                     AtkObject  **held,
+                     gint        *n_held)
+{
+  GtkTreePath *start, *end;
+  gint row, last, col, n_queries;
+
+  if (!gtk_tree_view_get_visible_range (tree_view, &start, &end))
+    return 0;
+
+  row = gtk_tree_path_get_indices (start)[0];
+  last = gtk_tree_path_get_indices (end)[0];
+  gtk_tree_path_free (start);
+  gtk_tree_path_free (end);
+
+  n_queries = 0;
+  for (; row <= last; row++)
+    for (col = 0; col < N_COLUMNS; col++)
+      {
+        AtkObject **slot = &held[*n_held % N_HELD];
+
+        if (*slot)
+          g_object_unref (*slot);
+        /* The header row comes first */
+        *slot = atk_object_ref_accessible_child (accessible,
+                                                 (row + 1) * N_COLUMNS + col);
+        (*n_held)++;
+        n_queries++;
+      }
+
+  return n_queries;
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkListStore *store;
+  GtkWidget *window, *sw, *tree_view;
+  AtkObject *accessible;
+  AtkObject *held[N_HELD] = { NULL, };
+  GtkTreePath *path;
+  GdkRectangle rect;
+  GTimer *timer;
+  gdouble elapsed;
+  gint n_rows, n_held, n_queries, height, i;
+
+  g_setenv ("GTK_MODULES", "gail", TRUE);
+  gtk_init (&argc, &argv);
+
+  n_rows = (argc > 1) ? atoi (argv[1]) : N_ROWS;
+
+  store = create_model (n_rows);
+
+  tree_view = gtk_tree_view_new_with_model (GTK_TREE_MODEL (store));
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view), -1,
+                                               "Number",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view), -1,
+                                               "Text",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 1,
+                                               NULL);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view), -1,
+                                               "Toggle",
+                                               gtk_cell_renderer_toggle_new (),
+                                               "active", 2,
+                                               NULL);
+
+  window = gtk_offscreen_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 300, 600);
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (window), sw);
+  gtk_container_add (GTK_CONTAINER (sw), tree_view);
+  gtk_widget_show_all (window);
+  process_events ();
+
+  accessible = gtk_widget_get_accessible (tree_view);
+  if (!ATK_IS_TABLE (accessible))
+    {
+      g_printerr ("The accessibility module is not loaded\n");
+      return 1;
+    }
+
+  path = gtk_tree_path_new_from_indices (n_rows - 1, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view), path, NULL, &rect);
+  gtk_tree_path_free (path);
+  height = MAX (rect.y + rect.height, 1);
+
+  timer = g_timer_new ();
+
+  n_held = 0;
+  n_queries = 0;
+  for (i = 0; i < N_SCROLLS; i++)
+    {
+      gtk_tree_view_scroll_to_point (GTK_TREE_VIEW (tree_view),
+                                     -1, g_random_int_range (0, height));
+      process_events ();
+      n_queries += query_visible_cells (GTK_TREE_VIEW (tree_view), accessible,
+                                        held, &n_held);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  fprintf (stdout, "scrolls (%d rows, %d cell queries): %d in %g sec (%g scrolls/sec)\n",
+           n_rows, n_queries, N_SCROLLS, elapsed, N_SCROLLS / elapsed);
+
+  for (i = 0; i < N_HELD; i++)
+    if (held[i])
+      g_object_unref (held[i]);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+  g_timer_destroy (timer);
+
+  return 0;
+}
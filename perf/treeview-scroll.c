@@ -0,0 +1,128 @@
+/* Measures row lookups and scrolling in a tree view with many rows */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <gtk/gtk.h>
+
+#define N_ROWS 1000000
+#define N_LOOKUPS 200000
+#define N_SCROLLS 2000
+
+static GtkListStore *
+create_model (gint n_rows)
+{
+  GtkListStore *store;
+  GValue *values;
+  gint column = 0;
+  gint i;
+
+  store = gtk_list_store_new (1, G_TYPE_INT);
+
+  /* One value per row, the store reads values[i * n_values] */
+  values = g_new0 (GValue, n_rows);
+  for (i = 0; i < n_rows; i++)
+    {
+      g_value_init (&values[i], G_TYPE_INT);
+      g_value_set_int (&values[i], i);
+    }
+
+  gtk_list_store_insert_rows_with_valuesv (store, 0, n_rows,
+                                           &column, values, 1);
+
+  for (i = 0; i < n_rows; i++)
+    g_value_unset (&values[i]);
+  g_free (values);
+
+  return store;
+}
+
+static void
+process_events (void)
+{
+  while (gtk_events_pending ())
+    gtk_main_iteration ();
+}
+
+int
+main (int argc, char **argv)
+{
+  GtkListStore *store;
+  GtkWidget *window, *sw, *tree_view;
+  GtkTreePath *path;
+  GdkRectangle rect;
+  GTimer *timer;
+  gdouble elapsed;
+  gint n_rows, height, i;
+
+  gtk_init (&argc, &argv);
+
+  n_rows = (argc > 1) ? atoi (argv[1]) : N_ROWS;
+
+  timer = g_timer_new ();
+
+  store = create_model (n_rows);
+
+  tree_view = gtk_tree_view_new ();
+  gtk_tree_view_set_fixed_height_mode (GTK_TREE_VIEW (tree_view), TRUE);
+  gtk_tree_view_insert_column_with_attributes (GTK_TREE_VIEW (tree_view), 0,
+                                               "Value",
+                                               gtk_cell_renderer_text_new (),
+                                               "text", 0,
+                                               NULL);
+  gtk_tree_view_column_set_sizing (gtk_tree_view_get_column (GTK_TREE_VIEW (tree_view), 0),
+                                   GTK_TREE_VIEW_COLUMN_FIXED);
+
+  g_timer_start (timer);
+
+  gtk_tree_view_set_model (GTK_TREE_VIEW (tree_view), GTK_TREE_MODEL (store));
+
+  fprintf (stdout, "set model (%d rows): %g sec\n",
+           n_rows, g_timer_elapsed (timer, NULL));
+
+  window = gtk_offscreen_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 300, 600);
+  sw = gtk_scrolled_window_new (NULL, NULL);
+  gtk_container_add (GTK_CONTAINER (window), sw);
+  gtk_container_add (GTK_CONTAINER (sw), tree_view);
+  gtk_widget_show_all (window);
+  process_events ();
+
+  g_timer_start (timer);
+
+  for (i = 0; i < N_LOOKUPS; i++)
+    {
+      path = gtk_tree_path_new_from_indices (g_random_int_range (0, n_rows), -1);
+      gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view), path, NULL, &rect);
+      gtk_tree_path_free (path);
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  fprintf (stdout, "row lookups: %d in %g sec (%g lookups/sec)\n",
+           N_LOOKUPS, elapsed, N_LOOKUPS / elapsed);
+
+  path = gtk_tree_path_new_from_indices (n_rows - 1, -1);
+  gtk_tree_view_get_background_area (GTK_TREE_VIEW (tree_view), path, NULL, &rect);
+  gtk_tree_path_free (path);
+  height = MAX (rect.y + rect.height, 1);
+
+  g_timer_start (timer);
+
+  for (i = 0; i < N_SCROLLS; i++)
+    {
+      gtk_tree_view_scroll_to_point (GTK_TREE_VIEW (tree_view),
+                                     -1, g_random_int_range (0, height));
+      process_events ();
+    }
+
+  elapsed = g_timer_elapsed (timer, NULL);
+
+  fprintf (stdout, "scrolls: %d in %g sec (%g scrolls/sec)\n",
+           N_SCROLLS, elapsed, N_SCROLLS / elapsed);
+
+  gtk_widget_destroy (window);
+  g_object_unref (store);
+  g_timer_destroy (timer);
+
+  return 0;
+}